@@ -0,0 +1,60 @@
+######################################################################
+# 性能基准测试程序（无图形界面）
+# 对曲率计算、牙齿分割各阶段、Laplacian变形、模型读写以及（可选的）MeshFix修复和布尔运算计时，
+# 输出吞吐量、不同线程数下的加速比和内存增量，并可与基准结果文件比较
+######################################################################
+
+QT += core
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = Benchmark
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += \
+    -frounding-math \
+    -std=c++0x \
+    -fopenmp #为了支持OpenMP并行处理而添加此项
+
+DEFINES += TOOTH_SEGMENTATION_HEADLESS #不编译ToothSegmentation中依赖图形界面的交互功能
+
+SOURCES += \
+    main.cpp \
+    ../src/Mesh.cpp \
+    ../src/ProgressReporter.cpp \
+    ../src/ToothSegmentation.cpp \
+    ../src/SpatialIndex.cpp \
+    ../src/GeodesicPathFinder.cpp \
+    ../src/StageProfiler.cpp \
+    ../src/MeshLoader.cpp \
+    ../src/VertexAdjacency.cpp \
+    ../src/MeshAnalysisView.cpp \
+    ../src/CurvatureComputer.cpp \
+    ../src/LaplaceTransform.cpp
+
+HEADERS += \
+    ../include/Mesh.h \
+    ../include/BoundingBox.h \
+    ../include/ProgressReporter.h \
+    ../include/ToothSegmentation.h \
+    ../include/SpatialIndex.h \
+    ../include/GeodesicPathFinder.h \
+    ../include/StageProfiler.h \
+    ../include/MeshLoader.h \
+    ../include/VertexAdjacency.h \
+    ../include/MeshAnalysisView.h \
+    ../include/CurvatureComputer.h \
+    ../include/LaplaceTransform.h
+
+INCLUDEPATH += \
+    ../ \
+    ../include/ \
+    ../lib/eigen/include/ #Eigen库包含路径
+
+LIBS += \
+    -lOpenMeshCore -lOpenMeshTools \ #OpenMesh库文件
+    -lGL \ #Mesh::draw中的OpenGL调用（基准测试中不会被调用，无需显示设备）
+    -lgomp -lpthread \ #为了支持OpenMP并行处理而添加此两项
+    -lgsl -lgslcblas #GSL库文件
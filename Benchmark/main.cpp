@@ -0,0 +1,856 @@
+/*
+  性能基准测试程序（无图形界面）。
+  对每个输入模型及其Loop细分后的版本（--levels），在不同的OpenMP线程数下（--threads）重复（--repeat）运行以下测试项：
+    io           模型写入和读取（WriteMesh、ReadMesh，MeshLoader读取的LoadMesh、LoadMeshCache，只在第一个线程数下运行）
+    curvature    曲率计算（Curvature）
+    segmentation 牙齿分割的各阶段（Segmentation.*，只对文件名以segmentation_开头的模型）
+    laplacian    Laplacian变形的建立和求解（Laplacian.*，只对文件名以laplacian_开头的模型）
+    meshfix      MeshFix修复（MeshFix，需用--meshfix指定meshfix可执行文件，只对不属于以上三类及boolean_的模型）
+    boolean      布尔运算（Boolean.<引擎>.<运算>，需用--boolean指定BooleanBenchmark可执行文件，只对文件名以boolean_开头的模型）
+  每项输出中位数用时、每秒处理的顶点数、相对第一个线程数的加速比和运行期间常驻内存的最大增量，
+  指定--baseline时与之前输出的结果文件逐项比较（基准结果与机器有关，不随代码提供，需先在同一台机器上用-o生成）。
+  计时的各次运行关闭StageProfiler；之后再开启StageProfiler运行一次，只统计内存，不计时。
+
+  用法：Benchmark [选项] [模型文件或目录]...
+*/
+
+#include "include/Mesh.h"
+#include "ToothSegmentation.h"
+#include "CurvatureComputer.h"
+#include "LaplaceTransform.h"
+#include "ProgressReporter.h"
+#include "MeshLoader.h"
+#include "StageProfiler.h"
+
+#include <OpenMesh/Tools/Subdivider/Uniform/LoopT.hh>
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QTextStream>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QMap>
+
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+#include <omp.h>
+
+using namespace SW;
+using namespace std;
+
+class BenchmarkOptions
+{
+public:
+    QStringList inputs;
+    QVector<int> levels; //Loop细分次数，每细分一次顶点数约变为4倍
+    QVector<int> threadNums;
+    int repeatNum;
+    QStringList cases;
+    QString outputFile;
+    QString baselineFile;
+    double tolerance; //与基准相比用时变化超过该比例时标记为slower/faster
+    QString meshFixExecutable;
+    QString booleanExecutable;
+    QString workDir; //细分后的模型和读写测试的临时文件所在目录
+    float moveCuttingPlaneDistance; //牙龈分割平面的移动距离（与批处理程序默认值一致）
+
+    BenchmarkOptions()
+    {
+        inputs << "../data_repaired" << "../MeshFixProj" << "../tets.obj";
+        levels << 0 << 1 << 2;
+        int processorNum = omp_get_num_procs();
+        for(int threadNum = 1; threadNum < processorNum; threadNum *= 2)
+        {
+            threadNums.push_back(threadNum);
+        }
+        threadNums.push_back(processorNum);
+        repeatNum = 3;
+        cases << "io" << "curvature" << "segmentation" << "laplacian" << "meshfix" << "boolean";
+        outputFile = "Benchmark.csv";
+        tolerance = 0.1;
+        workDir = QDir(QDir::tempPath()).filePath(QString("Benchmark-%1").arg(QCoreApplication::applicationPid()));
+        moveCuttingPlaneDistance = -0.2;
+    }
+};
+
+//不输出任何进度信息，避免终端输出影响计时
+class SilentProgressReporter : public ProgressReporter
+{
+public:
+    void setWindowTitle(const QString &) {}
+    void setLabelText(const QString &) {}
+    void setMinimum(int) {}
+    void setMaximum(int) {}
+    void setValue(int) {}
+    void close() {}
+    void showMessage(const QString &, const QString &) {}
+};
+
+//丢弃写入的内容，用于屏蔽LTransform建立矩阵时逐条边的std::cout输出
+class NullStreamBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c)
+    {
+        return c;
+    }
+};
+
+//一个测试项在某个模型、细分次数和线程数下的全部运行结果
+struct BenchmarkResult
+{
+    QString caseName;
+    QString meshName;
+    int level;
+    int vertexNum, faceNum;
+    int threadNum;
+    QVector<qint64> nanoseconds; //每次运行的用时
+    qint64 memoryKB; //各次运行中常驻内存的最大增量，外部程序为-1
+
+    double medianSeconds() const
+    {
+        QVector<qint64> sorted = nanoseconds;
+        std::sort(sorted.begin(), sorted.end());
+        int size = sorted.size();
+        double median = (size % 2 == 1) ? sorted[size / 2] : 0.5 * (sorted[size / 2 - 1] + sorted[size / 2]);
+        return median * 1e-9;
+    }
+
+    double minSeconds() const
+    {
+        return *std::min_element(nanoseconds.begin(), nanoseconds.end()) * 1e-9;
+    }
+};
+
+//当前正在测试的模型、细分次数和线程数
+struct BenchmarkContext
+{
+    QString meshName;
+    int level;
+    int vertexNum, faceNum;
+    int threadNum;
+};
+
+static QVector<BenchmarkResult> sResults;
+
+static void addSample(const BenchmarkContext &context, const QString &caseName, qint64 nanoseconds, qint64 memoryKB)
+{
+    for(int i = sResults.size() - 1; i >= 0; i--)
+    {
+        BenchmarkResult &result = sResults[i];
+        if(result.caseName == caseName && result.meshName == context.meshName && result.level == context.level && result.threadNum == context.threadNum)
+        {
+            result.nanoseconds.push_back(nanoseconds);
+            result.memoryKB = qMax(result.memoryKB, memoryKB);
+            return;
+        }
+    }
+    BenchmarkResult result;
+    result.caseName = caseName;
+    result.meshName = context.meshName;
+    result.level = context.level;
+    result.vertexNum = context.vertexNum;
+    result.faceNum = context.faceNum;
+    result.threadNum = context.threadNum;
+    result.nanoseconds.push_back(nanoseconds);
+    result.memoryKB = memoryKB;
+    sResults.push_back(result);
+}
+
+//只统计内存的运行：更新已有测试项的内存增量，不加入用时
+static void addMemorySample(const BenchmarkContext &context, const QString &caseName, qint64 memoryKB)
+{
+    for(int i = sResults.size() - 1; i >= 0; i--)
+    {
+        BenchmarkResult &result = sResults[i];
+        if(result.caseName == caseName && result.meshName == context.meshName && result.level == context.level && result.threadNum == context.threadNum)
+        {
+            result.memoryKB = qMax(result.memoryKB, memoryKB);
+            return;
+        }
+    }
+}
+
+/*
+  StageProfiler关闭时，对所在作用域内的一次运行计时，析构时将用时加入对应的测试项；
+  StageProfiler开启时不计时（每个子步骤开始和结束时读取内存的开销会计入用时），
+  只打开一个StageProfiler::Scope，被测函数内部子步骤的内存峰值会计入其中，析构时更新测试项的内存增量。
+*/
+class BenchmarkSample
+{
+private:
+    const BenchmarkContext &mContext;
+    QString mCaseName;
+    int mRecordIndex;
+    QElapsedTimer mTimer;
+    StageProfiler::Scope mProfilerScope;
+
+public:
+    BenchmarkSample(const BenchmarkContext &context, const char *caseName)
+        : mContext(context), mCaseName(caseName), mRecordIndex(StageProfiler::isEnabled() ? StageProfiler::records().size() : -1), mProfilerScope(caseName)
+    {
+        mTimer.start();
+    }
+
+    ~BenchmarkSample()
+    {
+        qint64 nanoseconds = mTimer.nsecsElapsed();
+        if(mRecordIndex < 0)
+        {
+            addSample(mContext, mCaseName, nanoseconds, -1);
+            return;
+        }
+        const StageProfiler::Record &record = StageProfiler::records().at(mRecordIndex);
+        qint64 memoryKB = qMax(record.memoryPeakKB, StageProfiler::currentMemoryKB()) - record.memoryStartKB;
+        addMemorySample(mContext, mCaseName, memoryKB);
+    }
+};
+
+static void printUsage()
+{
+    cout << "Usage: Benchmark [options] [mesh file or directory]..." << endl
+         << "  (default inputs: ../data_repaired ../MeshFixProj ../tets.obj)" << endl
+         << "Options:" << endl
+         << "  -o, --output <file>     result CSV file (default: Benchmark.csv)" << endl
+         << "  --baseline <file>       compare with a result CSV file written before" << endl
+         << "  --tolerance <ratio>     relative time change reported as slower/faster (default: 0.1)" << endl
+         << "  --levels <list>         Loop subdivision levels, e.g. 0,1,2 (default: 0,1,2)" << endl
+         << "  --threads <list>        OpenMP thread numbers, e.g. 1,2,4 (default: powers of 2 up to the number of processors)" << endl
+         << "  --repeat <n>            runs of each case, the median time is reported (default: 3)" << endl
+         << "  --cases <list>          io,curvature,segmentation,laplacian,meshfix,boolean (default: all)" << endl
+         << "  --meshfix <executable>  meshfix program used by the meshfix case" << endl
+         << "  --boolean <executable>  BooleanBenchmark program used by the boolean case" << endl
+         << "  --work-dir <dir>        directory for temporary meshes (default: system temporary directory)" << endl
+         << "  -h, --help              show this help" << endl;
+}
+
+static bool parseIntList(const QString &text, QVector<int> &values, int minimum)
+{
+    values.clear();
+    foreach(QString item, text.split(",", QString::SkipEmptyParts))
+    {
+        bool ok = true;
+        int value = item.toInt(&ok);
+        if(!ok || value < minimum)
+        {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return !values.isEmpty();
+}
+
+static bool parseArguments(const QStringList &arguments, BenchmarkOptions &options)
+{
+    QStringList inputs;
+    for(int i = 1; i < arguments.size(); i++)
+    {
+        QString argument = arguments.at(i);
+        bool hasValue = (i + 1 < arguments.size());
+        bool ok = true;
+        if(argument == "-h" || argument == "--help" || (argument.startsWith("-") && !hasValue))
+        {
+            return false;
+        }
+        else if(argument == "-o" || argument == "--output")
+        {
+            options.outputFile = arguments.at(++i);
+        }
+        else if(argument == "--baseline")
+        {
+            options.baselineFile = arguments.at(++i);
+        }
+        else if(argument == "--tolerance")
+        {
+            options.tolerance = arguments.at(++i).toDouble(&ok);
+            if(!ok || options.tolerance < 0)
+            {
+                return false;
+            }
+        }
+        else if(argument == "--levels")
+        {
+            if(!parseIntList(arguments.at(++i), options.levels, 0))
+            {
+                return false;
+            }
+        }
+        else if(argument == "--threads")
+        {
+            if(!parseIntList(arguments.at(++i), options.threadNums, 1))
+            {
+                return false;
+            }
+        }
+        else if(argument == "--repeat")
+        {
+            options.repeatNum = arguments.at(++i).toInt(&ok);
+            if(!ok || options.repeatNum < 1)
+            {
+                return false;
+            }
+        }
+        else if(argument == "--cases")
+        {
+            options.cases = arguments.at(++i).split(",", QString::SkipEmptyParts);
+        }
+        else if(argument == "--meshfix")
+        {
+            options.meshFixExecutable = arguments.at(++i);
+        }
+        else if(argument == "--boolean")
+        {
+            options.booleanExecutable = arguments.at(++i);
+        }
+        else if(argument == "--work-dir")
+        {
+            options.workDir = arguments.at(++i);
+        }
+        else if(argument.startsWith("-"))
+        {
+            return false;
+        }
+        else
+        {
+            inputs.push_back(argument);
+        }
+    }
+    if(!inputs.isEmpty())
+    {
+        options.inputs = inputs;
+    }
+    return true;
+}
+
+//将输入的文件和目录展开为模型文件列表，跳过分割程序输出的各阶段结果（<模型名>.obj.<阶段名>.off）和MeshFix的输出（*_fixed.off）
+static QStringList collectMeshFiles(const QStringList &inputs)
+{
+    QStringList meshFiles;
+    QStringList nameFilters;
+    nameFilters << "*.obj" << "*.off" << "*.ply" << "*.stl";
+    foreach(QString input, inputs)
+    {
+        QFileInfo inputInfo(input);
+        if(inputInfo.isDir())
+        {
+            QDir inputDir(input);
+            foreach(QString fileName, inputDir.entryList(nameFilters, QDir::Files, QDir::Name))
+            {
+                if(fileName.contains(".obj.") || fileName.contains(".off.") || fileName.endsWith("_fixed.off"))
+                {
+                    continue;
+                }
+                meshFiles.push_back(inputDir.filePath(fileName));
+            }
+        }
+        else
+        {
+            meshFiles.push_back(input);
+        }
+    }
+    return meshFiles;
+}
+
+static bool loadMesh(const QString &meshFile, Mesh &mesh)
+{
+    //不读写缓存，避免在输入目录中留下缓存文件
+    if(!MeshLoader::load(meshFile, mesh, false))
+    {
+        cerr << "Error to load " << meshFile.toStdString() << endl;
+        return false;
+    }
+    mesh.computeEntityNumbers();
+    mesh.computeBoundingBox();
+    return true;
+}
+
+//Loop细分level次，得到更大规模的模型
+static void upsampleMesh(Mesh &mesh, int level)
+{
+    if(level > 0)
+    {
+        OpenMesh::Subdivider::Uniform::LoopT<Mesh> loopSubdivider;
+        loopSubdivider.attach(mesh);
+        loopSubdivider(level);
+        loopSubdivider.detach();
+    }
+    if(mesh.has_face_normals() && mesh.has_vertex_normals())
+    {
+        mesh.update_normals();
+    }
+    mesh.computeEntityNumbers();
+    mesh.computeBoundingBox();
+}
+
+static void runMeshIO(const BenchmarkContext &context, const Mesh &mesh, const QString &suffix, const BenchmarkOptions &options)
+{
+    QString tempFile = QDir(options.workDir).filePath("io." + suffix);
+    {
+        BenchmarkSample sample(context, "WriteMesh");
+        if(!OpenMesh::IO::write_mesh(mesh, tempFile.toStdString()))
+        {
+            cerr << "Fail to write " << tempFile.toStdString() << endl;
+        }
+    }
+    {
+        BenchmarkSample sample(context, "ReadMesh");
+        Mesh readMesh;
+        if(!OpenMesh::IO::read_mesh(readMesh, tempFile.toStdString()))
+        {
+            cerr << "Fail to read " << tempFile.toStdString() << endl;
+        }
+    }
+    {
+        BenchmarkSample sample(context, "LoadMesh");
+        Mesh readMesh;
+        if(!MeshLoader::load(tempFile, readMesh, false))
+        {
+            cerr << "Fail to load " << tempFile.toStdString() << endl;
+        }
+    }
+    //先读取一次以写入缓存，再对读取缓存计时
+    Mesh cachedMesh;
+    if(MeshLoader::load(tempFile, cachedMesh))
+    {
+        BenchmarkSample sample(context, "LoadMeshCache");
+        Mesh readMesh;
+        MeshLoader::load(tempFile, readMesh);
+    }
+    QFile::remove(MeshLoader::cacheFilename(tempFile));
+    QFile::remove(tempFile);
+}
+
+static void runCurvature(const BenchmarkContext &context, Mesh &mesh)
+{
+    SilentProgressReporter progress;
+    CurvatureComputer curvatureComputer(mesh);
+    BenchmarkSample sample(context, "Curvature");
+    curvatureComputer.computeCurvature(&progress);
+}
+
+//依次运行分割的全部阶段（与批处理程序相同的自动流程），分别计时
+static void runSegmentation(const BenchmarkContext &context, const Mesh &mesh, const BenchmarkOptions &options)
+{
+    SilentProgressReporter progress;
+    QScopedPointer<ToothSegmentation> toothSegmentation;
+    {
+        BenchmarkSample sample(context, "Segmentation.SetupToothMesh");
+        toothSegmentation.reset(new ToothSegmentation(&progress, mesh));
+    }
+    {
+        BenchmarkSample sample(context, "Segmentation.IdentifyPotentialToothBoundary");
+        toothSegmentation->identifyPotentialToothBoundary(false);
+    }
+    {
+        BenchmarkSample sample(context, "Segmentation.AutomaticCuttingOfGingiva");
+        toothSegmentation->automaticCuttingOfGingiva(false, false, options.moveCuttingPlaneDistance);
+    }
+    {
+        BenchmarkSample sample(context, "Segmentation.BoundarySkeletonExtraction");
+        toothSegmentation->boundarySkeletonExtraction(false);
+    }
+    {
+        BenchmarkSample sample(context, "Segmentation.FindCuttingPoints");
+        toothSegmentation->findCuttingPoints(false);
+    }
+    {
+        BenchmarkSample sample(context, "Segmentation.RefineToothBoundary");
+        toothSegmentation->refineToothBoundary(false);
+    }
+}
+
+/*
+  构造确定的Laplacian变形控制点：以第0个顶点和中间的顶点为中心，各取由近及远（按邻接关系）的若干个顶点作为两组控制点，
+  第一组沿x方向移动包围盒对角线长度的5%，第二组固定不动。
+*/
+static void buildLaplacianControls(Mesh &mesh, QVector< QVector<int> > &selectedVertices, MVector &moveVectors)
+{
+    int groupSize = qBound(5, mesh.mVertexNum / 500, 200);
+    int centerVertices[2] = {0, mesh.mVertexNum / 2};
+    QVector<bool> selected(mesh.mVertexNum, false);
+    selectedVertices.clear();
+    for(int groupIndex = 0; groupIndex < 2; groupIndex++)
+    {
+        QVector<int> group;
+        group.push_back(centerVertices[groupIndex]);
+        selected[centerVertices[groupIndex]] = true;
+        for(int queueIndex = 0; queueIndex < group.size() && group.size() < groupSize; queueIndex++)
+        {
+            Mesh::VertexHandle vertexHandle(group[queueIndex]);
+            for(Mesh::VertexVertexIter vertexVertexIter = mesh.vv_iter(vertexHandle); vertexVertexIter.is_valid() && group.size() < groupSize; vertexVertexIter++)
+            {
+                int neighborIndex = vertexVertexIter.handle().idx();
+                if(!selected[neighborIndex])
+                {
+                    selected[neighborIndex] = true;
+                    group.push_back(neighborIndex);
+                }
+            }
+        }
+        selectedVertices.push_back(group);
+    }
+
+    double diagonal = sqrt(mesh.BBox.size.x * mesh.BBox.size.x + mesh.BBox.size.y * mesh.BBox.size.y + mesh.BBox.size.z * mesh.BBox.size.z);
+    moveVectors.X_arr.clear();
+    moveVectors.Y_arr.clear();
+    moveVectors.Z_arr.clear();
+    moveVectors.X_arr << diagonal * 0.05 << 0;
+    moveVectors.Y_arr << 0 << 0;
+    moveVectors.Z_arr << 0 << 0;
+}
+
+//建立方程（构造函数），第一次求解（需要数值分解），以及控制点不变时的再次求解
+static void runLaplacian(const BenchmarkContext &context, const Mesh &mesh, const QVector< QVector<int> > &selectedVertices, const MVector &moveVectors)
+{
+    Mesh deformedMesh = mesh;
+    NullStreamBuffer nullBuffer;
+    std::streambuf *coutBuffer = cout.rdbuf(&nullBuffer);
+    QScopedPointer<MHW::LTransform> transform;
+    {
+        BenchmarkSample sample(context, "Laplacian.Setup");
+        transform.reset(new MHW::LTransform(deformedMesh, "./", 10000, 0, deformedMesh.n_vertices()));
+        transform->Set_ROI(LAPLACE_ROI_KRING);
+    }
+    {
+        BenchmarkSample sample(context, "Laplacian.Run");
+        transform->Run(deformedMesh, selectedVertices, moveVectors);
+    }
+    MVector doubledMoveVectors = moveVectors;
+    for(int i = 0; i < doubledMoveVectors.X_arr.size(); i++)
+    {
+        doubledMoveVectors.X_arr[i] *= 2;
+    }
+    {
+        BenchmarkSample sample(context, "Laplacian.RunSameControls");
+        transform->Run(deformedMesh, selectedVertices, doubledMoveVectors);
+    }
+    cout.rdbuf(coutBuffer);
+}
+
+//调用外部的meshfix程序修复模型（meshfix将结果写入<模型名>_fixed.off）
+static void runMeshFix(const BenchmarkContext &context, const QString &meshFile, const BenchmarkOptions &options)
+{
+    QProcess meshFix;
+    meshFix.setProcessChannelMode(QProcess::MergedChannels);
+    QElapsedTimer timer;
+    timer.start();
+    meshFix.start(options.meshFixExecutable, QStringList() << meshFile);
+    bool finished = meshFix.waitForFinished(-1);
+    qint64 nanoseconds = timer.nsecsElapsed();
+    if(!finished || meshFix.exitStatus() != QProcess::NormalExit || meshFix.exitCode() != 0)
+    {
+        cerr << "MeshFix failed on " << meshFile.toStdString() << endl;
+        return;
+    }
+    addSample(context, "MeshFix", nanoseconds, -1);
+    QFileInfo meshFileInfo(meshFile);
+    QFile::remove(meshFileInfo.dir().filePath(meshFileInfo.completeBaseName() + "_fixed.off"));
+}
+
+/*
+  调用外部的BooleanBenchmark程序对目录中的每个模型做并/交/差，解析其CSV输出，
+  每行（模型,顶点数,面片数,运算,引擎,秒数,...）记为测试项Boolean.<引擎>.<运算>。
+*/
+static void runBoolean(const QString &meshDir, int level, const BenchmarkOptions &options)
+{
+    QProcess booleanBenchmark;
+    booleanBenchmark.start(options.booleanExecutable, QStringList() << meshDir);
+    if(!booleanBenchmark.waitForFinished(-1) || booleanBenchmark.exitStatus() != QProcess::NormalExit || booleanBenchmark.exitCode() != 0)
+    {
+        cerr << "BooleanBenchmark failed on " << meshDir.toStdString() << endl;
+        return;
+    }
+    QTextStream outputStream(booleanBenchmark.readAllStandardOutput());
+    outputStream.readLine(); //跳过表头
+    while(!outputStream.atEnd())
+    {
+        QStringList fields = outputStream.readLine().split(",");
+        bool ok = false;
+        double seconds = fields.size() > 5 ? fields[5].toDouble(&ok) : 0;
+        if(!ok)
+        {
+            continue; //运算失败（如模型不封闭）
+        }
+        BenchmarkContext context;
+        context.meshName = fields[0];
+        context.level = level;
+        context.vertexNum = fields[1].toInt();
+        context.faceNum = fields[2].toInt();
+        context.threadNum = 1;
+        addSample(context, QString("Boolean.%1.%2").arg(fields[4]).arg(fields[3]), qint64(seconds * 1e9), -1);
+    }
+}
+
+static QString resultKey(const QString &caseName, const QString &meshName, int level, int threadNum)
+{
+    return QString("%1|%2|%3|%4").arg(caseName).arg(meshName).arg(level).arg(threadNum);
+}
+
+//读取之前输出的结果文件中各项的中位数用时
+static bool loadBaseline(const QString &baselineFile, QMap<QString, double> &baselineSeconds)
+{
+    QFile file(baselineFile);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        cerr << "Fail to open file \"" << baselineFile.toStdString() << "\" ." << endl;
+        return false;
+    }
+    QTextStream stream(&file);
+    QStringList header = stream.readLine().split(",");
+    int caseColumn = header.indexOf("case"), meshColumn = header.indexOf("mesh"), levelColumn = header.indexOf("level");
+    int threadColumn = header.indexOf("threads"), secondsColumn = header.indexOf("median_seconds");
+    if(caseColumn < 0 || meshColumn < 0 || levelColumn < 0 || threadColumn < 0 || secondsColumn < 0)
+    {
+        cerr << "Invalid baseline file \"" << baselineFile.toStdString() << "\" ." << endl;
+        return false;
+    }
+    while(!stream.atEnd())
+    {
+        QStringList fields = stream.readLine().split(",");
+        if(fields.size() != header.size())
+        {
+            continue;
+        }
+        QString key = resultKey(fields[caseColumn], fields[meshColumn], fields[levelColumn].toInt(), fields[threadColumn].toInt());
+        baselineSeconds[key] = fields[secondsColumn].toDouble();
+    }
+    return true;
+}
+
+//输出结果文件，返回比基准慢的测试项数
+static int writeResults(const BenchmarkOptions &options, const QMap<QString, double> &baselineSeconds)
+{
+    QFile file(options.outputFile);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        cerr << "Fail to open file \"" << options.outputFile.toStdString() << "\" ." << endl;
+        return 0;
+    }
+
+    //加速比以同一测试项在第一个线程数下的用时为准
+    QMap<QString, double> firstThreadSeconds;
+    for(int i = 0; i < sResults.size(); i++)
+    {
+        const BenchmarkResult &result = sResults[i];
+        QString key = resultKey(result.caseName, result.meshName, result.level, 0);
+        if(!firstThreadSeconds.contains(key))
+        {
+            firstThreadSeconds[key] = result.medianSeconds();
+        }
+    }
+
+    int slowerNum = 0;
+    QTextStream stream(&file);
+    stream << "case,mesh,level,vertices,faces,threads,repeats,median_seconds,min_seconds,vertices_per_second,speedup,memory_kb,baseline_seconds,ratio,status\n";
+    for(int i = 0; i < sResults.size(); i++)
+    {
+        const BenchmarkResult &result = sResults[i];
+        double seconds = result.medianSeconds();
+        double speedup = firstThreadSeconds[resultKey(result.caseName, result.meshName, result.level, 0)] / seconds;
+        stream << result.caseName << "," << result.meshName << "," << result.level << "," << result.vertexNum << "," << result.faceNum << ","
+               << result.threadNum << "," << result.nanoseconds.size() << "," << seconds << "," << result.minSeconds() << ","
+               << result.vertexNum / seconds << "," << speedup << ",";
+        if(result.memoryKB >= 0)
+        {
+            stream << result.memoryKB;
+        }
+        stream << ",";
+
+        QString key = resultKey(result.caseName, result.meshName, result.level, result.threadNum);
+        if(!baselineSeconds.contains(key))
+        {
+            stream << ",," << (options.baselineFile.isEmpty() ? "" : "new") << "\n";
+            continue;
+        }
+        double baseline = baselineSeconds[key];
+        double ratio = seconds / baseline;
+        //相差不足1ms时认为是计时误差
+        QString status = "same";
+        if(ratio > 1 + options.tolerance && seconds - baseline > 1e-3)
+        {
+            status = "slower";
+            slowerNum++;
+            cout << "Slower: " << key.toStdString() << " " << baseline << "s -> " << seconds << "s" << endl;
+        }
+        else if(ratio < 1 - options.tolerance && baseline - seconds > 1e-3)
+        {
+            status = "faster";
+        }
+        stream << baseline << "," << ratio << "," << status << "\n";
+    }
+    stream.flush();
+    file.close();
+    return slowerNum;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    BenchmarkOptions options;
+    if(!parseArguments(app.arguments(), options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    QMap<QString, double> baselineSeconds;
+    if(!options.baselineFile.isEmpty() && !loadBaseline(options.baselineFile, baselineSeconds))
+    {
+        return 1;
+    }
+    if(!QDir().mkpath(options.workDir))
+    {
+        cerr << "Fail to create directory \"" << options.workDir.toStdString() << "\" ." << endl;
+        return 1;
+    }
+    if(options.cases.contains("meshfix") && options.meshFixExecutable.isEmpty())
+    {
+        options.cases.removeAll("meshfix");
+    }
+    if(options.cases.contains("boolean") && options.booleanExecutable.isEmpty())
+    {
+        options.cases.removeAll("boolean");
+    }
+
+    cout << "Processors: " << omp_get_num_procs() << ", repeats: " << options.repeatNum << ", cases: " << options.cases.join(",").toStdString() << endl;
+
+    QStringList booleanMeshFiles; //细分后写入临时目录的布尔运算模型，所有模型处理完后统一交给BooleanBenchmark
+    QStringList meshFiles = collectMeshFiles(options.inputs);
+    foreach(QString meshFile, meshFiles)
+    {
+        QFileInfo meshFileInfo(meshFile);
+        QString meshName = meshFileInfo.fileName();
+        bool isSegmentationMesh = meshName.startsWith("segmentation_");
+        bool isLaplacianMesh = meshName.startsWith("laplacian_");
+        bool isBooleanMesh = meshName.startsWith("boolean_");
+        bool isMeshFixMesh = !isSegmentationMesh && !isLaplacianMesh && !isBooleanMesh;
+
+        Mesh originalMesh;
+        if(!loadMesh(meshFile, originalMesh))
+        {
+            continue;
+        }
+
+        foreach(int level, options.levels)
+        {
+            Mesh mesh = originalMesh;
+            upsampleMesh(mesh, level);
+
+            BenchmarkContext context;
+            context.meshName = meshName;
+            context.level = level;
+            context.vertexNum = mesh.mVertexNum;
+            context.faceNum = mesh.mFaceNum;
+            cout << meshName.toStdString() << " (level " << level << ", " << mesh.mVertexNum << " vertices)" << endl;
+
+            QString levelDir = QDir(options.workDir).filePath(QString("level%1").arg(level));
+            QDir().mkpath(levelDir);
+            QString upsampledMeshFile = QDir(levelDir).filePath(meshFileInfo.completeBaseName() + ".off");
+            if(isBooleanMesh && options.cases.contains("boolean"))
+            {
+                if(OpenMesh::IO::write_mesh(mesh, upsampledMeshFile.toStdString()))
+                {
+                    booleanMeshFiles.push_back(upsampledMeshFile);
+                }
+            }
+
+            QVector< QVector<int> > laplacianSelectedVertices;
+            MVector laplacianMoveVectors;
+            if(isLaplacianMesh && options.cases.contains("laplacian"))
+            {
+                buildLaplacianControls(mesh, laplacianSelectedVertices, laplacianMoveVectors);
+            }
+
+            for(int threadIndex = 0; threadIndex < options.threadNums.size(); threadIndex++)
+            {
+                context.threadNum = options.threadNums[threadIndex];
+                omp_set_num_threads(context.threadNum);
+                //前repeatNum次计时；最后一次开启StageProfiler，只统计内存
+                for(int repeatIndex = 0; repeatIndex <= options.repeatNum; repeatIndex++)
+                {
+                    bool memoryRun = (repeatIndex == options.repeatNum);
+                    StageProfiler::setEnabled(memoryRun);
+                    StageProfiler::reset();
+                    //模型读写和MeshFix不使用OpenMP，只在第一个线程数下运行
+                    if(threadIndex == 0 && options.cases.contains("io"))
+                    {
+                        runMeshIO(context, mesh, meshFileInfo.suffix(), options);
+                    }
+                    if(options.cases.contains("curvature"))
+                    {
+                        runCurvature(context, mesh);
+                    }
+                    if(isSegmentationMesh && options.cases.contains("segmentation"))
+                    {
+                        runSegmentation(context, mesh, options);
+                    }
+                    if(isLaplacianMesh && options.cases.contains("laplacian"))
+                    {
+                        runLaplacian(context, mesh, laplacianSelectedVertices, laplacianMoveVectors);
+                    }
+                    if(threadIndex == 0 && isMeshFixMesh && !memoryRun && options.cases.contains("meshfix"))
+                    {
+                        //未细分时复制原文件，保留OpenMesh读入时丢弃的非流形面等缺陷
+                        if(repeatIndex == 0)
+                        {
+                            bool written = (level == 0 && meshFileInfo.suffix() == "off") ? QFile::copy(meshFile, upsampledMeshFile) : OpenMesh::IO::write_mesh(mesh, upsampledMeshFile.toStdString());
+                            if(!written)
+                            {
+                                cerr << "Fail to write " << upsampledMeshFile.toStdString() << endl;
+                            }
+                        }
+                        runMeshFix(context, upsampledMeshFile, options);
+                    }
+                }
+            }
+            if(!booleanMeshFiles.contains(upsampledMeshFile))
+            {
+                QFile::remove(upsampledMeshFile);
+            }
+        }
+    }
+
+    //布尔运算按细分次数分目录运行
+    foreach(int level, options.levels)
+    {
+        QString levelDir = QDir(options.workDir).filePath(QString("level%1").arg(level));
+        bool hasBooleanMesh = false;
+        foreach(QString booleanMeshFile, booleanMeshFiles)
+        {
+            hasBooleanMesh = hasBooleanMesh || QFileInfo(booleanMeshFile).dir() == QDir(levelDir);
+        }
+        if(hasBooleanMesh)
+        {
+            cout << "Boolean operations (level " << level << ")" << endl;
+            for(int repeatIndex = 0; repeatIndex < options.repeatNum; repeatIndex++)
+            {
+                runBoolean(levelDir, level, options);
+            }
+        }
+    }
+    foreach(QString booleanMeshFile, booleanMeshFiles)
+    {
+        QFile::remove(booleanMeshFile);
+    }
+    foreach(int level, options.levels)
+    {
+        QDir(options.workDir).rmdir(QString("level%1").arg(level));
+    }
+    QDir().rmdir(options.workDir);
+
+    int slowerNum = writeResults(options, baselineSeconds);
+    cout << sResults.size() << " results written to " << options.outputFile.toStdString() << "." << endl;
+    if(slowerNum > 0)
+    {
+        cout << slowerNum << " results are slower than the baseline." << endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+# 布尔运算引擎对比: CGAL Nef多面体 vs libigl mesh_boolean
+# 用法: ./BooleanBenchmark [模型目录(默认../NefSetUnion/data)] > BooleanBenchmark.csv
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt
+
+DEFINES += CGAL_EIGEN3_ENABLED
+QMAKE_CXXFLAGS += -frounding-math -std=c++0x
+
+INCLUDEPATH += /usr/include/eigen3   \
+                             ../lib/libigl_bak/include \
+                             /home/sway/myLibs/CGAL-4.2/include
+
+
+LIBS +=    -lboost_thread   -lboost_program_options  -lboost_filesystem  -lboost_system\
+                 -L/usr/lib/x86_64-linux-gnu/ -lgmp -lmpfr  \
+                -L/home/sway/myLibs/CGAL-4.2/build/lib/ -lCGAL  -lCGAL_Core
+
+SOURCES += \
+    main.cpp
+
+HEADERS +=
@@ -0,0 +1,152 @@
+#include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Polyhedron_3.h>
+#include <CGAL/IO/Polyhedron_iostream.h>
+#include <CGAL/Nef_polyhedron_3.h>
+#include <CGAL/Timer.h>
+
+#include <igl/readOFF.h>
+#include <igl/boolean/mesh_boolean.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef CGAL::Exact_predicates_exact_constructions_kernel Kernel;
+typedef CGAL::Polyhedron_3<Kernel> Polyhedron;
+typedef CGAL::Nef_polyhedron_3<Kernel> Nef_polyhedron;
+typedef Kernel::Vector_3 Vector_3;
+typedef Kernel::Aff_transformation_3 Aff_transformation_3;
+
+//*****************************
+//对目录中的每个.off模型,与其平移(0.1,0.11,0)后的副本做并/交/差(与TransformMode相同的测试方式),
+//分别用Nef多面体和libigl mesh_boolean计时,结果以CSV输出到标准输出;
+//*****************************
+
+struct BenchmarkResult{
+    bool ok;
+    double seconds;
+    int resultVertices;
+    int resultFaces;
+    std::string message;
+};
+
+static const char *operationNames[3] = {"union", "intersection", "difference"};
+
+BenchmarkResult runNef(Polyhedron &P, int operation)
+{
+    BenchmarkResult result = {false, 0, 0, 0, ""};
+    if(!P.is_closed())
+    {
+        result.message = "not closed";
+        return result;
+    }
+    try
+    {
+        CGAL::Timer timer;
+        timer.start();
+        Nef_polyhedron N1(P);
+        Nef_polyhedron N2(P);
+        Aff_transformation_3 aff(CGAL::TRANSLATION, Vector_3(0.1, 0.11, 0, 1));
+        N2.transform(aff);
+        Nef_polyhedron N12;
+        if(operation == 0) N12 = N1.join(N2);
+        else if(operation == 1) N12 = N1.intersection(N2);
+        else N12 = N1.difference(N2);
+        Polyhedron P12;
+        N12.closure().convert_to_polyhedron(P12);
+        timer.stop();
+        result.ok = true;
+        result.seconds = timer.time();
+        result.resultVertices = P12.size_of_vertices();
+        result.resultFaces = P12.size_of_facets();
+    }
+    catch(std::exception &e)
+    {
+        result.message = e.what();
+    }
+    return result;
+}
+
+BenchmarkResult runIgl(const Eigen::MatrixXd &V, const Eigen::MatrixXi &F, int operation)
+{
+    BenchmarkResult result = {false, 0, 0, 0, ""};
+    try
+    {
+        CGAL::Timer timer;
+        timer.start();
+        Eigen::MatrixXd VB = V;
+        VB.col(0).array() += 0.1;
+        VB.col(1).array() += 0.11;
+        igl::MeshBooleanType type = operation == 0 ? igl::MESH_BOOLEAN_TYPE_UNION :
+                                    (operation == 1 ? igl::MESH_BOOLEAN_TYPE_INTERSECT : igl::MESH_BOOLEAN_TYPE_MINUS);
+        Eigen::MatrixXd VC;
+        Eigen::MatrixXi FC;
+        igl::mesh_boolean(V, F, VB, F, type, VC, FC);
+        timer.stop();
+        result.ok = true;
+        result.seconds = timer.time();
+        result.resultVertices = VC.rows();
+        result.resultFaces = FC.rows();
+    }
+    catch(std::exception &e)
+    {
+        result.message = e.what();
+    }
+    return result;
+}
+
+void printResult(const std::string &model, int vertices, int faces, int operation, const char *engine, const BenchmarkResult &result)
+{
+    std::cout << model << "," << vertices << "," << faces << "," << operationNames[operation] << "," << engine << ",";
+    if(result.ok)
+    {
+        std::cout << result.seconds << "," << result.resultVertices << "," << result.resultFaces << "," << std::endl;
+    }
+    else
+    {
+        std::cout << ",,," << result.message << std::endl;
+    }
+}
+
+int main(int argc, char*argv[]) {
+    std::string dataDir = argc > 1 ? argv[1] : "../NefSetUnion/data";
+
+    std::vector<std::string> modelPaths;
+    for(boost::filesystem::directory_iterator it(dataDir); it != boost::filesystem::directory_iterator(); ++it)
+    {
+        if(it->path().extension() == ".off")
+        {
+            modelPaths.push_back(it->path().string());
+        }
+    }
+    std::sort(modelPaths.begin(), modelPaths.end());
+
+    std::cout << "model,vertices,faces,operation,engine,seconds,result_vertices,result_faces,message" << std::endl;
+    for(int i = 0; i < modelPaths.size(); i++)
+    {
+        std::string model = boost::filesystem::path(modelPaths[i]).filename().string();
+
+        Polyhedron P;
+        std::ifstream f(modelPaths[i].c_str());
+        f >> P;
+        Eigen::MatrixXd V;
+        Eigen::MatrixXi F;
+        if(!f || !igl::readOFF(modelPaths[i], V, F) || F.cols() != 3)
+        {
+            std::cerr << "Failed to read triangle mesh " << modelPaths[i] << std::endl;
+            continue;
+        }
+
+        for(int operation = 0; operation < 3; operation++)
+        {
+            printResult(model, V.rows(), F.rows(), operation, "nef", runNef(P, operation));
+            printResult(model, V.rows(), F.rows(), operation, "igl", runIgl(V, F, operation));
+        }
+    }
+    return 0;
+}
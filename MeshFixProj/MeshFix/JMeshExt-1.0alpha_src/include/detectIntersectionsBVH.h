@@ -0,0 +1,76 @@
+#ifndef DETECT_INTERSECTIONS_BVH_H
+/****************************************************************************
+* JMeshExt                                                                  *
+*                                                                           *
+* Self-intersection detection on a flat bounding volume hierarchy.          *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#define DETECT_INTERSECTIONS_BVH_H
+
+#include "exttrimesh.h"
+#include <vector>
+
+#define DI_BVH_MAX_LEAF_SIZE	4
+#define DI_BVH_SAH_BINS		16
+
+// Minimum number of node pairs per thread before the parallel traversal starts
+#define DI_BVH_TASKS_PER_THREAD	64
+
+// Node of the hierarchy. Nodes are stored depth-first: the left child of
+// an inner node immediately follows it, 'right' is the index of the right child.
+// Leaves ('count' > 0) refer to the primitives first ... first+count-1.
+
+class di_bvh_node
+{
+ public:
+ double mp[3], Mp[3];
+ int first, count, right;
+
+ inline bool isLeaf() const {return (count > 0);}
+ inline bool overlaps(const di_bvh_node& n) const
+  {return (mp[0] <= n.Mp[0] && Mp[0] >= n.mp[0] && mp[1] <= n.Mp[1] && Mp[1] >= n.mp[1] && mp[2] <= n.Mp[2] && Mp[2] >= n.mp[2]);}
+ inline double halfArea() const
+  {double x=Mp[0]-mp[0], y=Mp[1]-mp[1], z=Mp[2]-mp[2]; return x*y+y*z+z*x;}
+};
+
+// Bounding volume hierarchy on a set of triangles, built with the binned
+// surface area heuristic. Primitive boxes are stored as separate arrays
+// (one per coordinate bound) in leaf order.
+
+class di_bvh
+{
+ public:
+ std::vector<di_bvh_node> nodes;
+ std::vector<Triangle *> triangles;	// Primitives in leaf order
+ std::vector<double> mx, Mx, my, My, mz, Mz;	// Primitive bounding boxes
+ std::vector<Vertex *> vertices;	// v1(), v2(), v3() of each primitive
+ std::vector<unsigned char> edgeMask;	// Bit i set if edge e(i+1) of the primitive is tested
+
+ di_bvh(List *tris);
+
+ // Select the triangles which intersect other triangles of the hierarchy
+ // exactly as di_cell::di_selectIntersections does on a single cell
+ // containing all the triangles. Runs in parallel; returns the number of
+ // selected triangles.
+ int selectIntersections();
+
+ protected:
+ int build(int first, int count, std::vector<double>& centroids);
+ void collide(int a, int b, std::vector<Triangle *>& hits) const;
+ void testPrimitives(int i, int j, std::vector<Triangle *>& hits) const;
+ bool testEdges(int i, int j, std::vector<Triangle *>& hits) const;
+};
+
+#endif // DETECT_INTERSECTIONS_BVH_H
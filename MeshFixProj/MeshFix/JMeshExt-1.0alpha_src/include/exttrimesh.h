@@ -30,6 +30,8 @@
 
 #include "jmesh.h"
 
+class fs_sparseSystem;
+
 class ExtTriMesh : public Triangulation
 {
  public:
@@ -48,6 +50,7 @@ class ExtTriMesh : public Triangulation
  void    FillHole(Edge *, bool =0);		       // (in "ALGORITHMS/holeFilling.C")
  int refineSelectedHolePatches(Triangle * =NULL);      // (in "ALGORITHMS/holeFilling.C")
  void fairSelection(Triangle * =NULL);		       // (in "ALGORITHMS/holeFilling.C")
+ fs_sparseSystem *fairingSystem(Triangle * =NULL);     // (in "ALGORITHMS/holeFilling.C")
 
  // Misc Algorithms (Implemented in "ALGORITHMS/*.C")
 
@@ -64,6 +67,7 @@ class ExtTriMesh : public Triangulation
  int epsilonSample(double, int =0);
 
  int  selectIntersectingTriangles(UINT16 tri_per_cell=100);
+ int  selectIntersectingTrianglesBVH();
 
  void tagPlanarRegionsBoundaries(double max_distance);
 
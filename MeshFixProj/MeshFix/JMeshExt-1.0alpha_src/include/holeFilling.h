@@ -32,14 +32,27 @@
 #include "matrix.h"
 #include "sparseLSystem.h"
 
-// Sparse linear system
+// Sparse linear system for the fairing of a hole patch.
+// The unknowns are the coordinates of the inner vertices listed in 'vertices'.
 class fs_sparseSystem : public sparseSystem
 {
+ double *solution;
+
  public:
 
- fs_sparseSystem(int s) : sparseSystem(s, 3) {}
+ List vertices;
+
+ fs_sparseSystem(int s) : sparseSystem(s, 3) {solution=NULL;}
+ ~fs_sparseSystem() {delete [] solution;}
+
+ // Solves for x, y and z with a single factorization. Does not access the
+ // mesh, so that different systems can be solved concurrently.
+ bool compute();
+
+ // Moves 'vertices' to the solution found by compute()
+ void apply();
 
- // The following calls 'solve' three times and fills the vertex list with x, y, z results
+ // The following solves the system and fills the vertex list with x, y, z results
  void solve(List *);
 };
 
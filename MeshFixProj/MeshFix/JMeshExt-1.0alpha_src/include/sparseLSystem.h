@@ -45,12 +45,18 @@
 //! B is initially 0. B[i][j] can be set by summing
 //! values through sumKnownTerm(value, row, column).
 //! A solution of the system can be obtained using one column of B trhough
-//! solve(result, which_column_of_B_to_use).
+//! solve(result, which_column_of_B_to_use), or using all the columns at once
+//! through solve(result).
 //! In most geometric algorithms 'kterm_size' is 3, and the searched solution
 //! is the position of some points. In this case, the value of the coordinates
 //! may be retrieved by solving the system three times, once to retrieve the 'x'
 //! coordinates, once for the 'y's and once for the 'z's, using the first, the
 //! second and the third column of B respectively.
+//! A is assembled into a compressed sparse matrix and factored with a sparse
+//! LU decomposition the first time it is needed; the factorization is reused
+//! by the subsequent solves until a coefficient is changed.
+
+class sparseFactorization;
 
 class sparseSystem
 {
@@ -86,16 +92,21 @@ class sparseSystem
  int kterm_size;	//!< Nr. of columns of the known term
  sparseSystemRow *rows;	//!< Rows of the system
  double **known_term;	//!< Actual coefficients of the known term
+ sparseFactorization *factorization;	//!< Cached factorization of A, NULL if not computed yet
+
+ void clearFactorization();
 
  public:
 
  sparseSystem(int s, int k, int n = 0); //!< Constructs an s x n system having a k column-wide known term
  ~sparseSystem();		//!< Destructor
 
- void sumCoefficient(double v, int i, int j) {rows[i].addCoefficient(j, v);} //!< Sums 'v' to A[i][j]
+ void sumCoefficient(double v, int i, int j) {if (factorization != NULL) clearFactorization(); rows[i].addCoefficient(j, v);} //!< Sums 'v' to A[i][j]
  void setKnownTerm(double v, int i, int j) {known_term[j][i] =v;} //!< Sets j'th component of B[i] to 'v' (B[i][j]=v)
  void sumKnownTerm(double v, int i, int j) {known_term[j][i]+=v;} //!< Sums j'th component of B[i] to 'v' (B[i][j]=v)
+ bool factor();	//!< Assembles and factors A (called by solve() if needed). False if A is singular or not square.
  bool solve(double *solution, int j); //!< Solves the system for j'th component of B (j starts from 0). False if fails.
+ bool solve(double *solution); //!< Solves the system for all the columns of B. solution[i*k+j] receives x[i] for the j'th column. False if fails.
  void print(FILE * =stdout);
 };
 
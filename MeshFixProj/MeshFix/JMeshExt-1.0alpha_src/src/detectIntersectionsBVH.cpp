@@ -0,0 +1,437 @@
+/****************************************************************************
+* JMeshExt                                                                  *
+*                                                                           *
+* Self-intersection detection on a flat bounding volume hierarchy.          *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "detectIntersectionsBVH.h"
+#include <float.h>
+#include <algorithm>
+#include "jrs_predicates.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define DI_BVH_INDEX(t) ((j_voidint)((t)->info))
+
+inline double di_bvhOrient3D(Point *p1, Point *p2, Point *p3, Point *p4)
+{
+ return orient3d((double *)(p1), (double *)(p2), (double *)(p3), (double *)(p4));
+}
+
+// Same as di_cell::edgeIntersectsTriangle, but only tells whether 'e'
+// intersects 't' (whose vertices are v1, v2, v3) without computing the
+// intersection point. Uses no static storage, so it can run concurrently
+// once exactinit() was called.
+
+static bool di_bvhEdgeIntersectsTriangle(Edge *e, Triangle *t, Vertex *v1, Vertex *v2, Vertex *v3)
+{
+ if (e == t->e1 || e == t->e2 || e == t->e3) return 0;
+
+ Vertex *v4, *v0;
+ Vertex *pv0, *nv0;
+ Point p, p1, p2;
+ bool h1 = (e->v1 == v1 || e->v1 == v2 || e->v1 == v3);
+ bool h2 = (e->v2 == v1 || e->v2 == v2 || e->v2 == v3);
+
+ if (h1 || h2)
+ {
+  if (h1) {v0 = e->v1; v4 = e->v2;}
+  else {v0 = e->v2; v4 = e->v1;}
+
+  if (di_bvhOrient3D(v1, v2, v3, v4)==0.0)
+  {
+   pv0 = (t->prevVertex(v0));
+   nv0 = (t->nextVertex(v0));
+   p = (*v4)-(*v0);
+   p1 = ((*pv0)-(*v4));
+   p2 = ((*nv0)-(*v4));
+   if (((p1&p)*(p2&p))>0.0) return 0;
+   p = (*pv0)-(*nv0);
+   p2 = (*pv0)-(*v0);
+   if (((p1&p)*(p2&p))>0.0) return 0;
+   return 1;
+  }
+  else return 0;
+ }
+
+ double d1 = di_bvhOrient3D(v1, v2, v3, e->v1);
+ double d2 = di_bvhOrient3D(v1, v2, v3, e->v2);
+
+ if (d1 == 0 && d2 == 0) return 0;
+ if ((d1 > 0 && d2 > 0) || (d1 < 0 && d2 < 0)) return 0;
+
+ double e2 = di_bvhOrient3D(v1, v2, e->v1, e->v2);
+ double e3 = di_bvhOrient3D(v2, v3, e->v1, e->v2);
+ double e1 = di_bvhOrient3D(v3, v1, e->v1, e->v2);
+
+ if (e1==0 && e2==0 && e3==0) return 0;
+
+ return ((e1 >= 0 && e2 >= 0 && e3 >= 0) || (e1 <= 0 && e2 <= 0 && e3 <= 0));
+}
+
+
+// Builds the hierarchy on the triangles in 'tris'. Each edge is assigned to
+// exactly one of its incident triangles, and only if all of its incident
+// triangles are in 'tris' (as in di_cell::di_selectIntersections).
+// The info field of the triangles is used to store their index.
+
+di_bvh::di_bvh(List *tris)
+{
+ Triangle *t, *y;
+ Vertex *v1, *v2, *v3;
+ Node *n;
+ int i, k, nt = tris->numels();
+
+ triangles.resize(nt);
+ mx.resize(nt); Mx.resize(nt);
+ my.resize(nt); My.resize(nt);
+ mz.resize(nt); Mz.resize(nt);
+ vertices.resize(3*nt);
+ edgeMask.resize(nt);
+ std::vector<double> centroids(3*nt);
+
+ i=0; FOREACHVTTRIANGLE(tris, t, n) {MARK_VISIT2(t); t->info = (void *)((j_voidint)(i)); triangles[i++] = t;}
+
+ for (i=0; i<nt; i++)
+ {
+  t = triangles[i];
+  v1 = vertices[3*i] = t->v1(); v2 = vertices[3*i+1] = t->v2(); v3 = vertices[3*i+2] = t->v3();
+  mx[i] = MIN(v1->x, MIN(v2->x, v3->x)); Mx[i] = MAX(v1->x, MAX(v2->x, v3->x));
+  my[i] = MIN(v1->y, MIN(v2->y, v3->y)); My[i] = MAX(v1->y, MAX(v2->y, v3->y));
+  mz[i] = MIN(v1->z, MIN(v2->z, v3->z)); Mz[i] = MAX(v1->z, MAX(v2->z, v3->z));
+  centroids[3*i]   = (mx[i]+Mx[i])*0.5;
+  centroids[3*i+1] = (my[i]+My[i])*0.5;
+  centroids[3*i+2] = (mz[i]+Mz[i])*0.5;
+
+  edgeMask[i] = 0;
+  for (k=0; k<3; k++)
+  {
+   y = (k==0)?(t->t1()):((k==1)?(t->t2()):(t->t3()));
+   if (y==NULL || (IS_VISITED2(y) && i < DI_BVH_INDEX(y))) edgeMask[i] |= (1<<k);
+  }
+ }
+ for (i=0; i<nt; i++) UNMARK_VISIT2(triangles[i]);
+
+ nodes.reserve((nt > 0)?(2*nt):(0));
+ if (nt) build(0, nt, centroids);
+}
+
+
+// Recursively builds the subtree on the primitives first ... first+count-1
+// and returns the index of its root. Primitives are reordered in place.
+
+int di_bvh::build(int first, int count, std::vector<double>& centroids)
+{
+ int i, j, k, b, axis, node = nodes.size();
+ nodes.push_back(di_bvh_node());
+
+ di_bvh_node nd;
+ nd.mp[0] = nd.mp[1] = nd.mp[2] = DBL_MAX;
+ nd.Mp[0] = nd.Mp[1] = nd.Mp[2] = -DBL_MAX;
+ double cm[3] = {DBL_MAX, DBL_MAX, DBL_MAX}, cM[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+ for (i=first; i<first+count; i++)
+ {
+  nd.mp[0] = MIN(nd.mp[0], mx[i]); nd.Mp[0] = MAX(nd.Mp[0], Mx[i]);
+  nd.mp[1] = MIN(nd.mp[1], my[i]); nd.Mp[1] = MAX(nd.Mp[1], My[i]);
+  nd.mp[2] = MIN(nd.mp[2], mz[i]); nd.Mp[2] = MAX(nd.Mp[2], Mz[i]);
+  for (j=0; j<3; j++) {cm[j] = MIN(cm[j], centroids[3*i+j]); cM[j] = MAX(cM[j], centroids[3*i+j]);}
+ }
+ nd.first = first; nd.count = count; nd.right = -1;
+
+ if (count <= DI_BVH_MAX_LEAF_SIZE) {nodes[node] = nd; return node;}
+
+ axis = 0;
+ if (cM[1]-cm[1] > cM[axis]-cm[axis]) axis = 1;
+ if (cM[2]-cm[2] > cM[axis]-cm[axis]) axis = 2;
+ double extent = cM[axis]-cm[axis];
+
+ int mid = first+count/2;
+ if (extent > 0)
+ {
+  // Binned SAH: bin the centroids along the widest axis and pick the
+  // plane minimizing  area(left)*count(left) + area(right)*count(right)
+  di_bvh_node bins[DI_BVH_SAH_BINS];
+  int binCount[DI_BVH_SAH_BINS];
+  double scale = DI_BVH_SAH_BINS/extent;
+  for (b=0; b<DI_BVH_SAH_BINS; b++)
+  {
+   binCount[b] = 0;
+   bins[b].mp[0] = bins[b].mp[1] = bins[b].mp[2] = DBL_MAX;
+   bins[b].Mp[0] = bins[b].Mp[1] = bins[b].Mp[2] = -DBL_MAX;
+  }
+  for (i=first; i<first+count; i++)
+  {
+   b = (int)((centroids[3*i+axis]-cm[axis])*scale);
+   if (b >= DI_BVH_SAH_BINS) b = DI_BVH_SAH_BINS-1;
+   binCount[b]++;
+   bins[b].mp[0] = MIN(bins[b].mp[0], mx[i]); bins[b].Mp[0] = MAX(bins[b].Mp[0], Mx[i]);
+   bins[b].mp[1] = MIN(bins[b].mp[1], my[i]); bins[b].Mp[1] = MAX(bins[b].Mp[1], My[i]);
+   bins[b].mp[2] = MIN(bins[b].mp[2], mz[i]); bins[b].Mp[2] = MAX(bins[b].Mp[2], Mz[i]);
+  }
+
+  double leftCost[DI_BVH_SAH_BINS];
+  di_bvh_node acc = bins[0];
+  int accCount = 0;
+  for (b=0; b<DI_BVH_SAH_BINS-1; b++)
+  {
+   if (b) for (j=0; j<3; j++) {acc.mp[j] = MIN(acc.mp[j], bins[b].mp[j]); acc.Mp[j] = MAX(acc.Mp[j], bins[b].Mp[j]);}
+   accCount += binCount[b];
+   leftCost[b] = (accCount)?(acc.halfArea()*accCount):(0);
+  }
+
+  int bestSplit = -1, leftCount = 0;
+  double bestCost = DBL_MAX, cost;
+  acc = bins[DI_BVH_SAH_BINS-1];
+  accCount = 0;
+  for (b=DI_BVH_SAH_BINS-1; b>0; b--)
+  {
+   if (b<DI_BVH_SAH_BINS-1) for (j=0; j<3; j++) {acc.mp[j] = MIN(acc.mp[j], bins[b].mp[j]); acc.Mp[j] = MAX(acc.Mp[j], bins[b].Mp[j]);}
+   accCount += binCount[b];
+   if (accCount == 0 || accCount == count) continue;
+   cost = leftCost[b-1]+acc.halfArea()*accCount;
+   if (cost < bestCost) {bestCost = cost; bestSplit = b; leftCount = count-accCount;}
+  }
+
+  if (bestSplit > 0)
+  {
+   // Partition the primitives of the bins below 'bestSplit' to the left
+   for (i=first, j=first+count-1; i<=j; )
+   {
+    b = (int)((centroids[3*i+axis]-cm[axis])*scale);
+    if (b >= DI_BVH_SAH_BINS) b = DI_BVH_SAH_BINS-1;
+    if (b < bestSplit) {i++; continue;}
+    std::swap(triangles[i], triangles[j]);
+    std::swap(mx[i], mx[j]); std::swap(Mx[i], Mx[j]);
+    std::swap(my[i], my[j]); std::swap(My[i], My[j]);
+    std::swap(mz[i], mz[j]); std::swap(Mz[i], Mz[j]);
+    std::swap(edgeMask[i], edgeMask[j]);
+    for (k=0; k<3; k++) {std::swap(vertices[3*i+k], vertices[3*j+k]); std::swap(centroids[3*i+k], centroids[3*j+k]);}
+    j--;
+   }
+   mid = first+leftCount;
+  }
+ }
+
+ nodes[node] = nd;
+ nodes[node].count = 0;
+ build(first, mid-first, centroids);
+ nodes[node].right = build(mid, first+count-mid, centroids);
+
+ return node;
+}
+
+
+// Tests the edges assigned to primitive 'i' against the triangle of primitive 'j'.
+// Edges lying completely on one side of the box of 'j' are skipped.
+
+bool di_bvh::testEdges(int i, int j, std::vector<Triangle *>& hits) const
+{
+ Triangle *s = triangles[i], *t = triangles[j];
+ Vertex *a, *b;
+ Edge *e;
+ bool found = 0;
+ int k;
+
+ for (k=0; k<3; k++) if (edgeMask[i] & (1<<k))
+ {
+  e = (k==0)?(s->e1):((k==1)?(s->e2):(s->e3));
+  a = e->v1; b = e->v2;
+  if ((a->x < mx[j] && b->x < mx[j]) || (a->x > Mx[j] && b->x > Mx[j]) ||
+      (a->y < my[j] && b->y < my[j]) || (a->y > My[j] && b->y > My[j]) ||
+      (a->z < mz[j] && b->z < mz[j]) || (a->z > Mz[j] && b->z > Mz[j])) continue;
+  if (di_bvhEdgeIntersectsTriangle(e, t, vertices[3*j], vertices[3*j+1], vertices[3*j+2]))
+  {
+   hits.push_back(t);
+   if (e->t1 != NULL) hits.push_back(e->t1);
+   if (e->t2 != NULL) hits.push_back(e->t2);
+   found = 1;
+  }
+ }
+
+ return found;
+}
+
+void di_bvh::testPrimitives(int i, int j, std::vector<Triangle *>& hits) const
+{
+ if (mx[i] > Mx[j] || Mx[i] < mx[j] || my[i] > My[j] || My[i] < my[j] || mz[i] > Mz[j] || Mz[i] < mz[j]) return;
+ testEdges(i, j, hits);
+ testEdges(j, i, hits);
+}
+
+
+// Tests all the pairs of primitives with one primitive in node 'a' and the
+// other in node 'b'. If a==b each pair of distinct primitives is tested once.
+
+void di_bvh::collide(int a, int b, std::vector<Triangle *>& hits) const
+{
+ const di_bvh_node& na = nodes[a];
+ const di_bvh_node& nb = nodes[b];
+ int i, j;
+
+ if (a == b)
+ {
+  if (na.isLeaf())
+  {
+   for (i=na.first; i<na.first+na.count; i++)
+    for (j=i+1; j<na.first+na.count; j++) testPrimitives(i, j, hits);
+  }
+  else
+  {
+   collide(a+1, a+1, hits);
+   collide(na.right, na.right, hits);
+   collide(a+1, na.right, hits);
+  }
+  return;
+ }
+
+ if (!na.overlaps(nb)) return;
+
+ if (na.isLeaf() && nb.isLeaf())
+ {
+  for (i=na.first; i<na.first+na.count; i++)
+  {
+   // Skip the primitives of 'a' which are outside the box of 'b'
+   if (mx[i] > nb.Mp[0] || Mx[i] < nb.mp[0] || my[i] > nb.Mp[1] || My[i] < nb.mp[1] || mz[i] > nb.Mp[2] || Mz[i] < nb.mp[2]) continue;
+   for (j=nb.first; j<nb.first+nb.count; j++) testPrimitives(i, j, hits);
+  }
+ }
+ else if (nb.isLeaf() || (!na.isLeaf() && na.halfArea() >= nb.halfArea()))
+ {
+  collide(a+1, b, hits);
+  collide(na.right, b, hits);
+ }
+ else
+ {
+  collide(a, b+1, hits);
+  collide(a, nb.right, hits);
+ }
+}
+
+
+int di_bvh::selectIntersections()
+{
+ int i, nt = triangles.size();
+ if (nt == 0) return 0;
+
+ exactinit();
+
+ // Split the self-collision of the root into independent pairs of
+ // nodes, as collide() would do, until there is enough work for all threads.
+ int numThreads = 1;
+#ifdef _OPENMP
+ numThreads = omp_get_max_threads();
+#endif
+ std::vector< std::pair<int, int> > tasks, next;
+ tasks.push_back(std::pair<int, int>(0, 0));
+ bool split = (numThreads > 1);
+ while (split && (int)tasks.size() < numThreads*DI_BVH_TASKS_PER_THREAD)
+ {
+  split = 0;
+  next.clear();
+  for (i=0; i<(int)tasks.size(); i++)
+  {
+   int a = tasks[i].first, b = tasks[i].second;
+   const di_bvh_node& na = nodes[a];
+   const di_bvh_node& nb = nodes[b];
+   if (a == b && !na.isLeaf())
+   {
+    next.push_back(std::pair<int, int>(a+1, a+1));
+    next.push_back(std::pair<int, int>(na.right, na.right));
+    next.push_back(std::pair<int, int>(a+1, na.right));
+    split = 1;
+   }
+   else if (a == b || (na.isLeaf() && nb.isLeaf())) next.push_back(tasks[i]);
+   else if (!na.overlaps(nb)) split = 1;
+   else if (nb.isLeaf() || (!na.isLeaf() && na.halfArea() >= nb.halfArea()))
+   {
+    next.push_back(std::pair<int, int>(a+1, b));
+    next.push_back(std::pair<int, int>(na.right, b));
+    split = 1;
+   }
+   else
+   {
+    next.push_back(std::pair<int, int>(a, b+1));
+    next.push_back(std::pair<int, int>(a, nb.right));
+    split = 1;
+   }
+  }
+  tasks.swap(next);
+ }
+
+ int numTasks = tasks.size();
+ std::vector< std::vector<Triangle *> > hits(numThreads);
+
+#pragma omp parallel for schedule(dynamic)
+ for (i=0; i<numTasks; i++)
+ {
+  int thread = 0;
+#ifdef _OPENMP
+  thread = omp_get_thread_num();
+#endif
+  collide(tasks[i].first, tasks[i].second, hits[thread]);
+  if (thread == 0) JMesh::report_progress("%d %% done   ", (i*100)/numTasks);
+ }
+
+ Triangle *t;
+ int its = 0;
+ for (i=0; i<numThreads; i++)
+  for (std::vector<Triangle *>::iterator it = hits[i].begin(); it != hits[i].end(); ++it)
+   {t = (*it); if (!IS_VISITED(t)) {MARK_VISIT(t); its++;}}
+
+ return its;
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+//                                                                     ||
+////////////////////// Select   Intersections ///////////////////////////
+//                                                                     ||
+/////////////////////////////////////////////////////////////////////////
+
+int ExtTriMesh::selectIntersectingTrianglesBVH()
+{
+ Triangle *t;
+ Vertex *v;
+ Node *n;
+ bool isSelection=0;
+ List *selT = new List;
+
+ JMesh::begin_progress();
+ JMesh::report_progress(NULL);
+
+ FOREACHTRIANGLE(t, n) if (IS_VISITED(t)) {isSelection=1; selT->appendTail(t);}
+ if (!isSelection) {delete(selT); selT=&T;}
+
+ di_bvh *bvh = new di_bvh(selT);
+ JMesh::report_progress(NULL);
+
+ // Deselect everything and select only intersecting triangles
+ deselectTriangles();
+ int its = bvh->selectIntersections();
+ JMesh::end_progress();
+ delete(bvh);
+
+ FOREACHVTTRIANGLE(selT, t, n) t->info = NULL;
+
+ if (its) JMesh::info("%d intersecting triangles have been selected.\n",its);
+ else JMesh::info("No intersections detected.\n");
+
+ if (isSelection) delete(selT);
+ else FOREACHVERTEX(v, n) UNMARK_VISIT(v);
+
+ return its;
+}
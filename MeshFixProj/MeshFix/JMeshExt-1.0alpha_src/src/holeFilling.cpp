@@ -26,6 +26,13 @@
 ****************************************************************************/
 
 #include "holeFilling.h"
+#include <Eigen/Core>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Marks the vertices whose position will change when pending fairing systems are solved
+#define FS_PENDING_BIT	4
 
 
 ////////// Generic method for patching holes. Heuristic. /////////////
@@ -105,15 +112,78 @@ void ExtTriMesh::FillHole(Edge *e, bool refine_and_smooth)
  }
 }
 
+// Marks the inner vertices of a pending fairing system and their neighbors,
+// that is all the vertices whose position or incident edges will change when
+// the system is solved. Marked vertices are appended to 'marked'.
+
+static void fs_markPending(fs_sparseSystem *sps, List *marked)
+{
+ Node *n, *m;
+ Vertex *v, *w;
+ List *vv;
+
+ FOREACHVVVERTEX((&(sps->vertices)), v, n)
+ {
+  if (!IS_BIT(v, FS_PENDING_BIT)) {MARK_BIT(v, FS_PENDING_BIT); marked->appendHead(v);}
+  vv = v->VV();
+  FOREACHVVVERTEX(vv, w, m) if (!IS_BIT(w, FS_PENDING_BIT)) {MARK_BIT(w, FS_PENDING_BIT); marked->appendHead(w);}
+  delete(vv);
+ }
+}
+
+// TRUE if the boundary loop of 'e' has a vertex marked by fs_markPending()
+
+static bool fs_touchesPending(Edge *e)
+{
+ Vertex *v = e->v1, *w = v;
+ do
+ {
+  if (IS_BIT(w, FS_PENDING_BIT)) return true;
+  w = w->nextOnBoundary();
+ } while (w != v);
+ return false;
+}
+
+// Solves the pending fairing systems concurrently, moves their vertices
+// and unmarks the vertices in 'marked'.
+
+static void fs_solvePending(List *systems, List *marked)
+{
+ int i, ns = systems->numels(), failed = 0;
+ fs_sparseSystem **sv = (fs_sparseSystem **)systems->toArray();
+ bool *solved = new bool[ns];
+ Vertex *v;
+
+ // Eigen 3.2 initializes some statics lazily: do it before the threads start
+ Eigen::initParallel();
+#pragma omp parallel for schedule(dynamic) reduction(+:failed)
+ for (i=0; i<ns; i++) if (!(solved[i] = sv[i]->compute())) failed++;
+
+ for (i=0; i<ns; i++)
+ {
+  if (solved[i]) sv[i]->apply();
+  delete sv[i];
+ }
+ if (failed) JMesh::warning("Fill holes: %d fairing systems could not be solved.\n", failed);
+
+ delete [] solved;
+ free(sv);
+ systems->removeNodes();
+ while ((v = (Vertex *)marked->popHead()) != NULL) UNMARK_BIT(v, FS_PENDING_BIT);
+}
+
+
 //// Triangulate Small Boundaries (with less than 'nbe' edges) /////
 
 int ExtTriMesh::fillSmallBoundaries(int nbe, bool refine_patches, bool smooth_patches)
 {
  Vertex *v,*w;
+ Edge *e;
  Triangle *t;
  Node *n;
  int grd, is_selection=0, tbds = 0, pct = 100;
- List bdrs;
+ List bdrs, fairings, pending_vertices;
+ fs_sparseSystem *sps;
 
  JMesh::begin_progress();
  JMesh::report_progress("0%% done ");
@@ -144,15 +214,22 @@ int ExtTriMesh::fillSmallBoundaries(int nbe, bool refine_patches, bool smooth_pa
 
  deselectTriangles();
 
+ // Fairing systems are collected and solved together on multiple threads.
+ // Before patching a hole whose boundary is affected by a pending system, the
+ // pending systems are solved, so that the result does not depend on the deferral.
  pct=0; FOREACHNODE(bdrs, n)
  {
-  if (TriangulateHole((Edge *)n->data) && refine_patches)
+  e = (Edge *)n->data;
+  if (fairings.numels() && fs_touchesPending(e)) fs_solvePending(&fairings, &pending_vertices);
+  if (TriangulateHole(e) && refine_patches)
   {
    t = (Triangle *)T.head()->data;
-   if (!refineSelectedHolePatches(t) && smooth_patches) fairSelection(t);
+   if (!refineSelectedHolePatches(t) && smooth_patches && (sps = fairingSystem(t)) != NULL)
+    {fs_markPending(sps, &pending_vertices); fairings.appendTail(sps);}
   }
   JMesh::report_progress("%d%% done ",((++pct)*100)/bdrs.numels());
  }
+ if (fairings.numels()) fs_solvePending(&fairings, &pending_vertices);
 
  grd = bdrs.numels();
 
@@ -302,23 +379,50 @@ int ExtTriMesh::refineSelectedHolePatches(Triangle *t0)
 // Fairs the inner vertices of the selection using a second-order umbrella operator
 // similar to a boundary constrained bi-laplacian smoothing
 
-void fs_sparseSystem::solve(List *vl)
+bool fs_sparseSystem::compute()
+{
+ if (kterm_size != 3) JMesh::error("fs_sparseSystem::compute(): Known term size is not 3!\n");
+ if (solution == NULL) solution = new double[num_variables*3];
+ return sparseSystem::solve(solution);
+}
+
+void fs_sparseSystem::apply()
 {
- if (kterm_size != 3) JMesh::error("fs_sparseSystem::solve(List *): Known term size is not 3!\n");
  Node *n;
- int i, nv = vl->numels();
- if (nv != num_variables) JMesh::error("fs_sparseSystem::solve(List *): Vertex list size does not match system size!\n");
- double *x = new double[nv];
- sparseSystem::solve(x, 0);
- for(i=0, n=vl->head(); i<nv; i++, n=n->next()) ((Vertex *)n->data)->x = -x[i];
- sparseSystem::solve(x, 1);
- for(i=0, n=vl->head(); i<nv; i++, n=n->next()) ((Vertex *)n->data)->y = -x[i];
- sparseSystem::solve(x, 2);
- for(i=0, n=vl->head(); i<nv; i++, n=n->next()) ((Vertex *)n->data)->z = -x[i];
- delete(x);
+ Vertex *v;
+ int i;
+ if (vertices.numels() != num_variables) JMesh::error("fs_sparseSystem::apply(): Vertex list size does not match system size!\n");
+ // sparseSystem solves A*x=B (OpenNL used to solve A*x=-B, hence no negation here)
+ for (i=0, n=vertices.head(); i<num_variables; i++, n=n->next())
+ {
+  v = (Vertex *)n->data;
+  v->x = solution[i*3]; v->y = solution[i*3+1]; v->z = solution[i*3+2];
+ }
+}
+
+void fs_sparseSystem::solve(List *vl)
+{
+ if (vl->numels() != num_variables) JMesh::error("fs_sparseSystem::solve(List *): Vertex list size does not match system size!\n");
+ if (!compute()) {JMesh::warning("Fill holes: Fairing system could not be solved.\n"); return;}
+ vertices.removeNodes();
+ vertices.appendList(vl);
+ apply();
 }
 
 void ExtTriMesh::fairSelection(Triangle *t0)
+{
+ fs_sparseSystem *sps = fairingSystem(t0);
+ if (sps == NULL) return;
+ if (sps->compute()) sps->apply();
+ else JMesh::warning("Fill holes: Fairing system could not be solved.\n");
+ delete sps;
+}
+
+// Builds the fairing system for the inner vertices of the selection (or of the
+// selected region containing 't0') without solving it. Returns NULL if there
+// are no inner vertices.
+
+fs_sparseSystem *ExtTriMesh::fairingSystem(Triangle *t0)
 {
  Node *n, *m, *o;
  Triangle *t;
@@ -367,14 +471,14 @@ void ExtTriMesh::fairSelection(Triangle *t0)
   else interior_vertices.appendHead(v);
  }
 
- if (!interior_vertices.numels()) return;
+ if (!interior_vertices.numels()) return NULL;
 
  niv = interior_vertices.numels();
- fs_sparseSystem sps(niv);
+ fs_sparseSystem *sps = new fs_sparseSystem(niv);
 
  for(i=0, n=interior_vertices.head(); i<niv; i++, n=n->next()) 
  { 
-  sps.sumCoefficient(1, i, i);
+  sps->sumCoefficient(1, i, i);
   ((Vertex *)n->data)->info = (void *)i;
  }
 
@@ -391,12 +495,12 @@ void ExtTriMesh::fairSelection(Triangle *t0)
    W_j_vicino = e1->length();
    
    // Alec: replaced "int" with "j_voidint"
-   if (IS_VISITED(vicino)) sps.sumCoefficient(-2*W_j_vicino/W_j, j, (j_voidint)vicino->info);
+   if (IS_VISITED(vicino)) sps->sumCoefficient(-2*W_j_vicino/W_j, j, (j_voidint)vicino->info);
    else
    {
-    sps.sumKnownTerm(2*W_j_vicino/W_j*vicino->x, j, 0);
-    sps.sumKnownTerm(2*W_j_vicino/W_j*vicino->y, j, 1);
-    sps.sumKnownTerm(2*W_j_vicino/W_j*vicino->z, j, 2);
+    sps->sumKnownTerm(2*W_j_vicino/W_j*vicino->x, j, 0);
+    sps->sumKnownTerm(2*W_j_vicino/W_j*vicino->y, j, 1);
+    sps->sumKnownTerm(2*W_j_vicino/W_j*vicino->z, j, 2);
    }
    
    FOREACHVEEDGE(vicini2, e2, m)
@@ -405,12 +509,12 @@ void ExtTriMesh::fairSelection(Triangle *t0)
     W_vicino_vicino2 = e2->length();
     peso = W_j_vicino * W_vicino_vicino2 / ( W_j * W_vicino);
     // Alec: replaced "int" with "j_voidint"
-    if (IS_VISITED(vicino2)) sps.sumCoefficient(peso, j, (j_voidint)vicino2->info);
+    if (IS_VISITED(vicino2)) sps->sumCoefficient(peso, j, (j_voidint)vicino2->info);
     else
     {
-     sps.sumKnownTerm(-peso*vicino2->x, j, 0);
-     sps.sumKnownTerm(-peso*vicino2->y, j, 1);
-     sps.sumKnownTerm(-peso*vicino2->z, j, 2);
+     sps->sumKnownTerm(-peso*vicino2->x, j, 0);
+     sps->sumKnownTerm(-peso*vicino2->y, j, 1);
+     sps->sumKnownTerm(-peso*vicino2->z, j, 2);
     }
    }
    delete vicini2;
@@ -418,9 +522,11 @@ void ExtTriMesh::fairSelection(Triangle *t0)
   delete vicini;
  }
 
- sps.solve(&interior_vertices);
+ sps->vertices.joinTailList(&interior_vertices);
 
  FOREACHVVVERTEX((&all_vertices), v, n) UNMARK_VISIT(v);
+
+ return sps;
 }
 
 
@@ -27,6 +27,9 @@
 
 #include "sparseLSystem.h"
 #include "nl.h"
+#include <Eigen/Sparse>
+#include <Eigen/SparseLU>
+#include <vector>
 
 //////////////////////////////////////////////////////////////////////////
 //
@@ -34,6 +37,15 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+// LU factorization of the coefficient matrix, kept between solves
+
+class sparseFactorization
+{
+ public:
+ Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > lu;
+ bool success;
+};
+
 void sparseSystem::sparseSystemRow::addCoefficient(int i, double c)
 {
  Node *n;
@@ -77,6 +89,7 @@ sparseSystem::sparseSystem(int s, int k, int n)
  num_equations = (n==0)?(s):(n);
  num_variables = s;
  kterm_size = k;
+ factorization = NULL;
  rows = new sparseSystemRow[num_equations];
  known_term = new double *[kterm_size];
  int i,j;
@@ -89,48 +102,86 @@ sparseSystem::sparseSystem(int s, int k, int n)
 
 sparseSystem::~sparseSystem()
 {
+ delete factorization;
  delete [] rows;
  delete known_term;
 }
 
 
-// Solves the system for j'th component of B
-bool sparseSystem::solve(double *x, int j)
+void sparseSystem::clearFactorization()
 {
+ delete factorization;
+ factorization = NULL;
+}
+
+// Assembles A in compressed column form and computes its LU factorization.
+// The result is cached until the next change of a coefficient.
+bool sparseSystem::factor()
+{
+ if (factorization != NULL) return factorization->success;
+
  int i;
  Node *n;
  coeffIndexPair *f;
+ std::vector< Eigen::Triplet<double> > coeffs;
 
- nlNewContext();
- nlSolverParameteri(NL_SOLVER, NL_PERM_SUPERLU_EXT);
- nlSolverParameteri(NL_NB_VARIABLES, num_variables);
- nlBegin(NL_SYSTEM);
-
- for (i=0; i<num_variables; i++) nlSetVariable(i, x[i]);
-
- nlBegin(NL_MATRIX);
+ factorization = new sparseFactorization;
+ factorization->success = false;
+ if (num_equations != num_variables) return false;
 
  for (i=0; i<num_equations; i++)
  {
-  nlRowParameterd(NL_RIGHT_HAND_SIDE, known_term[j][i]);
-  nlBegin(NL_ROW);
+  if (rows[i].cips.head() == NULL) return false;
   for (n=rows[i].cips.head(); n!=NULL; n=n->next())
   {
    f = (coeffIndexPair *)n->data;
-   nlCoefficient(f->index, f->coeff);
-  }  
-  nlEnd(NL_ROW);
+   coeffs.push_back(Eigen::Triplet<double>(i, f->index, f->coeff));
+  }
  }
 
- nlEnd(NL_MATRIX);
- nlEnd(NL_SYSTEM);
- bool success = (bool)nlSolve();
+ Eigen::SparseMatrix<double> A(num_equations, num_variables);
+ A.setFromTriplets(coeffs.begin(), coeffs.end());
+ A.makeCompressed();
 
- if (success) for (i=0; i<num_variables; i++) x[i] = nlGetVariable(i);
+ // Empty rows or columns make A singular (and are not handled by SparseLU)
+ for (i=0; i<num_variables; i++) if (A.outerIndexPtr()[i] == A.outerIndexPtr()[i+1]) return false;
 
- nlDeleteContext(nlGetCurrent());
+ factorization->lu.analyzePattern(A);
+ factorization->lu.factorize(A);
+ factorization->success = (factorization->lu.info() == Eigen::Success);
+
+ return factorization->success;
+}
+
+// Solves the system for j'th component of B
+bool sparseSystem::solve(double *x, int j)
+{
+ if (!factor()) return false;
+
+ Eigen::VectorXd sol = factorization->lu.solve(Eigen::Map<Eigen::VectorXd>(known_term[j], num_equations));
+ if (factorization->lu.info() != Eigen::Success) return false;
+
+ for (int i=0; i<num_variables; i++) x[i] = sol(i);
+
+ return true;
+}
+
+// Solves the system for all the components of B with a single factorization
+bool sparseSystem::solve(double *x)
+{
+ int i, j;
+
+ if (!factor()) return false;
+
+ Eigen::MatrixXd B(num_equations, kterm_size);
+ for (j=0; j<kterm_size; j++) B.col(j) = Eigen::Map<Eigen::VectorXd>(known_term[j], num_equations);
+ Eigen::MatrixXd sol = factorization->lu.solve(B);
+ if (factorization->lu.info() != Eigen::Success) return false;
+
+ for (i=0; i<num_variables; i++)
+  for (j=0; j<kterm_size; j++) x[i*kterm_size + j] = sol(i, j);
 
- return success;
+ return true;
 }
 
 void sparseSystem::print(FILE *fp)
@@ -54,6 +54,9 @@ class Edge
  Edge(Vertex *s, Vertex *d);	//!< Constructor
  ~Edge();			//!< Destructor
 
+ void *operator new(size_t);		//!< Allocates the edge from a MemoryPool
+ void operator delete(void *, size_t);	//!< Returns the edge to its MemoryPool
+
  //! TRUE iff edge is properly linked to a Triangulation.
  bool isLinked()	const 	{return (v1 != NULL);}
 
@@ -52,6 +52,9 @@ class Node
  Node *prev() {return n_prev;}	//!< Returns the previous node in the list, possibly NULL
  Node *next() {return n_next;}	//!< Returns the next node in the list, possibly NULL
 
+ void *operator new(size_t);		//!< Allocates the node from a MemoryPool
+ void operator delete(void *, size_t);	//!< Returns the node to its MemoryPool
+
  protected:
  Node *n_prev,*n_next;		//!< Previous and next node pointers
 };
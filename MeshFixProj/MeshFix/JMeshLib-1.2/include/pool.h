@@ -0,0 +1,79 @@
+/****************************************************************************
+* JMeshLib                                                                  *
+*                                                                           *
+* Consiglio Nazionale delle Ricerche                                        *
+* Istituto di Matematica Applicata e Tecnologie Informatiche                *
+* Sezione di Genova                                                         *
+* IMATI-GE / CNR                                                            *
+*                                                                           *
+* Authors: Marco Attene                                                     *
+*                                                                           *
+* Copyright(C) 2006: IMATI-GE / CNR                                         *
+*                                                                           *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef _POOL_H
+#define _POOL_H
+
+#include <stdlib.h>
+
+//! Allocator for objects of a fixed size.
+
+//! Objects are carved out of large chunks of memory, one after the
+//! other, so that objects allocated in sequence (e.g. the elements of
+//! a mesh being loaded) are contiguous in memory. Released objects are
+//! kept in a free list and reused by the next allocations. All the
+//! chunks are returned to the system when no object is alive anymore.
+//! Requests for a size different from the one of the pool are
+//! forwarded to malloc()/free(), so that derived classes still work.
+//! The pool is not thread-safe: objects using it must not be created
+//! or destroyed concurrently.
+//! Classes use a pool by redefining their operators new and delete.
+//! Memory obtained from a pool must be released through 'delete'
+//! (not through free(), List::freeNodes() and the like).
+
+class MemoryPool
+{
+ public :
+
+ //! Creates a pool of objects of 'size' bytes, allocated in chunks of 'chunk_els' objects.
+ MemoryPool(size_t size, int chunk_els =4096);
+
+ //! Returns space for an object of 'size' bytes. \n O(1).
+ void *allocate(size_t size);
+
+ //! Releases the space of an object of 'size' bytes obtained from allocate(). \n O(1), or O(number of chunks) for the last object.
+ void release(void *p, size_t size);
+
+ int numels() const {return num_live;}	//!< Number of objects currently allocated from the pool
+
+ protected :
+
+ size_t el_size;		//!< Size of the objects (rounded to keep alignment)
+ size_t obj_size;		//!< Size requested for the objects
+ int chunk_els;			//!< Objects per chunk
+ void *free_list;		//!< Released objects, linked through their first word
+ char *next_free;		//!< First never-used object in the last chunk
+ char *chunk_end;		//!< End of the last chunk
+ char **chunks;			//!< Allocated chunks
+ int num_chunks, max_chunks;
+ int num_live;
+
+ void newChunk();
+ void freeChunks();
+};
+
+#endif // _POOL_H
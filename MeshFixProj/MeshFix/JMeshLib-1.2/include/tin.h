@@ -90,11 +90,10 @@ class Triangulation
  Triangulation(const Triangle *t, const bool keep_ref =false);
 
  //! Destructor. Frees the memory allocated for all the mesh elements.
- //! Warning! This method uses the freeNodes() method of the class List,
- //! which is not guaranteed to work correctly on systems other than
- //! Linux (see the documentation of List for details).
- //! Assuming that the method works correctly, however, the calling
- //! function is responsible of freeing the memory that was possibly
+ //! Vertices, edges, triangles and list nodes are allocated from memory
+ //! pools (see MemoryPool), so they must always be disposed through
+ //! 'delete' and never through free() or List::freeNodes().
+ //! The calling function is responsible of freeing the memory that was possibly
  //! allocated for objects pointed to by the 'info' field of mesh
  //! elements. Clearly, this must be done before calling the destructor.
  ~Triangulation();
@@ -135,6 +134,7 @@ class Triangulation
 
  int cutAndStitch();	//!< Convert to manifold
  bool CreateIndexedTriangle(ExtVertex **, int, int, int);
+ int CreateIndexedTriangles(ExtVertex **, const int *, int);	//!< Same as CreateIndexedTriangle() on a whole face set, with hashed edge lookup
  int loadIV(const char *);		//!< Loads IV
  int loadVRML1(const char *);		//!< Loads VRML 1.0
  int loadOFF(const char *);		//!< Loads OFF
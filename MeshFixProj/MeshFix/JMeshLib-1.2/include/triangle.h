@@ -50,6 +50,9 @@ class Triangle
 
  Triangle(Edge *, Edge *, Edge *);		//!< Constructor
 
+ void *operator new(size_t);		//!< Allocates the triangle from a MemoryPool
+ void operator delete(void *, size_t);	//!< Returns the triangle to its MemoryPool
+
  bool isLinked() const {return (e1!=NULL);}	//!< TRUE if properly linked
 
  //! Inverts the orientation of the triangle
@@ -61,6 +61,9 @@ class Vertex : public Point
  Vertex(const Point& p);
  ~Vertex();				//!< Destructor
 
+ void *operator new(size_t);		//!< Allocates the vertex from a MemoryPool
+ void operator delete(void *, size_t);	//!< Returns the vertex to its MemoryPool
+
  bool isLinked() const {return (e0!=0);} //!< TRUE iff vertex is not isolated
 
  //! List of adjacent vertices.
@@ -192,6 +195,9 @@ class ExtVertex
  List VE;
 
  ExtVertex(Vertex *a) {v=a;}
+
+ void *operator new(size_t);		//!< Allocates the vertex from a MemoryPool
+ void operator delete(void *, size_t);	//!< Returns the vertex to its MemoryPool
 };
 
 #endif //_VERTEX_H
@@ -27,6 +27,7 @@
 
 #include "edge.h"
 #include "triangle.h"
+#include "pool.h"
 
 //////// Length-based edge comparison for qsort //////////
 
@@ -81,6 +82,14 @@ Edge::~Edge()
 }
 
 
+////////////////// Memory pool /////////////////////////////
+
+static MemoryPool& edgePool() {static MemoryPool p(sizeof(Edge)); return p;}
+
+void *Edge::operator new(size_t s) {return edgePool().allocate(s);}
+void Edge::operator delete(void *p, size_t s) {edgePool().release(p, s);}
+
+
 ////// Returns the unit vector for the edge direction //////
 
 Point Edge::toUnitVector() const
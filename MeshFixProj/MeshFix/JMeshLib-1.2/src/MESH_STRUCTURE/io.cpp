@@ -29,6 +29,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 #define VRML1_HEADER 			"#VRML V1.0 ascii"
@@ -253,24 +256,27 @@ bool Triangulation::CreateIndexedTriangle(ExtVertex **var, int i1, int i2, int i
  {
   if (e3->t1 == NULL && e3->t2 == NULL)
   {
-   E.freeNode(e3);
+   E.removeNode(e3);
    var[i3]->VE.removeNode(e3); var[i1]->VE.removeNode(e3);
    if (var[i3]->v->e0 == e3) var[i3]->v->e0 = NULL;
    if (var[i1]->v->e0 == e3) var[i1]->v->e0 = NULL;
+   delete(e3);
   }
   if (e2->t1 == NULL && e2->t2 == NULL)
   {
-   E.freeNode(e2);
+   E.removeNode(e2);
    var[i2]->VE.removeNode(e2); var[i3]->VE.removeNode(e2);
    if (var[i2]->v->e0 == e2) var[i2]->v->e0 = NULL;
    if (var[i3]->v->e0 == e2) var[i3]->v->e0 = NULL;
+   delete(e2);
   }
   if (e1->t1 == NULL && e1->t2 == NULL)
   {
-   E.freeNode(e1);
+   E.removeNode(e1);
    var[i1]->VE.removeNode(e1); var[i2]->VE.removeNode(e1);
    if (var[i1]->v->e0 == e1) var[i1]->v->e0 = NULL;
    if (var[i2]->v->e0 == e1) var[i2]->v->e0 = NULL;
+   delete(e1);
   }
   return 0;
  }
@@ -278,6 +284,133 @@ bool Triangulation::CreateIndexedTriangle(ExtVertex **var, int i1, int i2, int i
  return 1;
 }
 
+// Vertex index triplets collected by the loaders before the connectivity
+// is built by CreateIndexedTriangles().
+
+class IndexedTriangles
+{
+ public :
+ int *ids, num, max;
+
+ IndexedTriangles() {ids=NULL; num=max=0;}
+ ~IndexedTriangles() {free(ids);}
+
+ void add(int i1, int i2, int i3)
+ {
+  if (num == max)
+  {
+   max = (max)?(max*2):1024;
+   if ((ids = (int *)realloc(ids, sizeof(int)*3*max)) == NULL) JMesh::error("Not enough memory to load the faces.\n");
+  }
+  ids[3*num] = i1; ids[3*num+1] = i2; ids[3*num+2] = i3; num++;
+ }
+};
+
+
+// Slot of the hash table of vertex index pairs (lo < hi, hi == 0 means empty)
+
+typedef struct
+{
+ unsigned int lo, hi;
+ int first, count;
+} ite_slot;
+
+inline unsigned int ite_hash(unsigned int lo, unsigned int hi)
+{
+ unsigned int h = lo*0x9E3779B1 ^ hi*0x85EBCA77;
+ h ^= h>>15; h *= 0x2C1B3C6D; h ^= h>>12;
+ return h;
+}
+
+// Corner following corner 'c' in its triangle
+#define ITE_NEXT(c) (((c)%3 == 2)?((c)-2):((c)+1))
+
+// Below this number of triangles the pairs are resolved by a single thread
+#define ITE_MIN_PARALLEL_TRIANGLES	50000
+
+static inline Edge *newIndexedEdge(List& E, Vertex *v1, Vertex *v2)
+{
+ Edge *e = new Edge(v1, v2);
+ if (v1->e0 == NULL) v1->e0 = e;
+ if (v2->e0 == NULL) v2->e0 = e;
+ E.appendHead(e);
+ return e;
+}
+
+// Creates the 'nt' triangles whose vertices are var[ids[3*i]], var[ids[3*i+1]]
+// and var[ids[3*i+2]]. The result is identical to calling CreateIndexedTriangle()
+// on each triangle in turn, but existing edges are found through a hash table
+// keyed on the sorted vertex index pairs rather than by scanning the VE lists,
+// which are left empty.
+// The hash table is split in as many parts as threads, each part filled by one
+// thread in triangle order, so that a pair shared by more than two triangles is
+// resolved as in the sequential version: the first two triangles share an edge,
+// each of the others gets a new one, and all these edges are marked as visited
+// for cutAndStitch(). Returns the number of created triangles.
+
+int Triangulation::CreateIndexedTriangles(ExtVertex **var, const int *ids, int nt)
+{
+ int i, j, c, nc = nt*3, np = 1;
+ Edge **ce;
+
+ if (nt <= 0) return 0;
+#ifdef _OPENMP
+ if (nt >= ITE_MIN_PARALLEL_TRIANGLES) np = omp_get_max_threads();
+#endif
+
+ unsigned int *hash = (unsigned int *)malloc(sizeof(unsigned int)*nc);
+ int *first = (int *)malloc(sizeof(int)*nc);	// Corner where the pair appears first
+ UBYTE *rank = (UBYTE *)malloc(nc);		// 0, 1, or 2 for the third and later occurrences
+ if (hash == NULL || first == NULL || rank == NULL) JMesh::error("Not enough memory to create the edges.\n");
+
+#pragma omp parallel for schedule(static) num_threads(np)
+ for (i=0; i<nc; i++)
+ {
+  unsigned int a = ids[i], b = ids[ITE_NEXT(i)];
+  hash[i] = (a<b)?(ite_hash(a, b)):(ite_hash(b, a));
+ }
+
+#pragma omp parallel for schedule(static, 1) num_threads(np)
+ for (j=0; j<np; j++)
+ {
+  int k, n = 0, mask = 1;
+  ite_slot *s, *slots;
+
+  for (k=0; k<nc; k++) if ((int)(hash[k]%np) == j) n++;
+  while (mask < n + n/2 + 1) mask <<= 1;
+  if ((slots = (ite_slot *)calloc(mask, sizeof(ite_slot))) == NULL) JMesh::error("Not enough memory to create the edges.\n");
+  mask--;
+
+  for (k=0; k<nc; k++) if ((int)(hash[k]%np) == j)
+  {
+   unsigned int a = ids[k], b = ids[ITE_NEXT(k)], lo = (a<b)?(a):(b), hi = (a<b)?(b):(a);
+   for (s = slots+((hash[k]/np)&mask); s->hi != 0 && (s->lo != lo || s->hi != hi); s = (s == slots+mask)?(slots):(s+1));
+   if (s->hi == 0) {s->lo = lo; s->hi = hi; s->first = k; s->count = 1; first[k] = k; rank[k] = 0;}
+   else {first[k] = s->first; rank[k] = (UBYTE)s->count; if (s->count < 2) s->count++;}
+  }
+  free(slots);
+ }
+ free(hash);
+
+ if ((ce = (Edge **)malloc(sizeof(Edge *)*nc)) == NULL) JMesh::error("Not enough memory to create the edges.\n");
+ for (c=0; c<nc; c+=3)
+ {
+  for (j=c; j<c+3; j++)
+   if (rank[j] == 0) ce[j] = newIndexedEdge(E, var[ids[j]]->v, var[ids[ITE_NEXT(j)]]->v);
+   else if (rank[j] == 1) ce[j] = ce[first[j]];
+   else MARK_VISIT(ce[first[j]]);
+  for (j=c; j<c+3; j++)
+   if (rank[j] == 2) {ce[j] = newIndexedEdge(E, var[ids[j]]->v, var[ids[ITE_NEXT(j)]]->v); MARK_VISIT(ce[j]);}
+  CreateUnorientedTriangle(ce[c], ce[c+1], ce[c+2]);
+ }
+
+ free(ce);
+ free(first);
+ free(rank);
+
+ return nt;
+}
+
 
 // This part is common to all the loaders
 
@@ -335,6 +468,7 @@ int Triangulation::loadVRML1(const char *fname)
  float x,y,z;
  int i,i1,i2,i3,i4,nv=0,triangulate=0;
  Vertex *v;
+ IndexedTriangles faces;
 
  if ((fp = fopen(fname,"r")) == NULL) return IO_CANTOPEN;
 
@@ -358,7 +492,7 @@ int Triangulation::loadVRML1(const char *fname)
   do
   {
    if (i1 == i2 || i2 == i3 || i3 == i1) JMesh::warning("\nloadVRML1: Coincident indexes at face %d! Skipping.\n",i);
-   else if (!CreateIndexedTriangle(var, i1, i2, i3)) JMesh::warning("\nloadVRML1: This shouldn't happen!!! Skipping triangle.\n");
+   else faces.add(i1, i2, i3);
    if (fscanf(fp,"%d,",&i4) != 1) JMesh::error("loadVRML1: Unexpected end of file at face %d!\n",i);
    i2=i3; i3=i4;
    if (i4 != -1) triangulate=1;
@@ -366,6 +500,7 @@ int Triangulation::loadVRML1(const char *fname)
  }
  JMesh::end_progress();
 
+ CreateIndexedTriangles(var, faces.ids, faces.num);
  closeLoadingSession(fp, i, var, (triangulate != 0));
 
  return 0;
@@ -388,6 +523,7 @@ int Triangulation::loadOFF(const char *fname)
  float x,y,z;
  int i,j,i1,i2,i3,i4,nv,nt,ne,triangulate=0;
  Vertex *v;
+ IndexedTriangles faces;
 
  if ((fp = fopen(fname,"rb")) == NULL) return IO_CANTOPEN;
 
@@ -419,7 +555,7 @@ int Triangulation::loadOFF(const char *fname)
    for (j=3; j<=i4; j++)
    {
     if (i1 == i2 || i2 == i3 || i3 == i1) JMesh::warning("\nloadOFF: Coincident indexes at triangle %d! Skipping.\n",i);
-    else if (!CreateIndexedTriangle(var, i1, i2, i3)) JMesh::warning("\nloadOFF: This shouldn't happen!!! Skipping triangle.\n");
+    else faces.add(i1, i2, i3);
     i2 = i3;
     if (j<i4)
     {
@@ -433,6 +569,7 @@ int Triangulation::loadOFF(const char *fname)
 
  JMesh::end_progress();
 
+ CreateIndexedTriangles(var, faces.ids, faces.num);
  closeLoadingSession(fp, i, var, (triangulate != 0));
 
  return 0;
@@ -448,6 +585,7 @@ int Triangulation::loadVRML2(const char *fname)
  float x,y,z;
  int i,i1,i2,i3,i4,nv=0,triangulate=0;
  Vertex *v;
+ IndexedTriangles faces;
 
  if ((fp = fopen(fname,"r")) == NULL) return IO_CANTOPEN;
 
@@ -472,7 +610,7 @@ int Triangulation::loadVRML2(const char *fname)
   do
   {
    if (i1 == i2 || i2 == i3 || i3 == i1) JMesh::warning("\nloadVRML2: Coincident indexes at triangle %d! Skipping.\n",i);
-   else if (!CreateIndexedTriangle(var, i1, i2, i3)) JMesh::warning("\nloadVRML2: This shouldn't happen!!! Skipping triangle.\n");
+   else faces.add(i1, i2, i3);
    if (fscanf(fp,"%d,",&i4) != 1) JMesh::error("loadVRML2: Unexpected end of file at triangle %d!\n",i);
    i2=i3; i3=i4;
    if (i4 != -1) triangulate=1;
@@ -480,6 +618,7 @@ int Triangulation::loadVRML2(const char *fname)
  }
  JMesh::end_progress();
 
+ CreateIndexedTriangles(var, faces.ids, faces.num);
  closeLoadingSession(fp, i, var, (triangulate != 0));
 
  return 0;
@@ -496,6 +635,7 @@ int Triangulation::loadVerTri(const char *fname)
  char vername[256], triname[256];
  Node *n;
  Vertex *v;
+ IndexedTriangles faces;
 
  if (!sameString((char *)(fname+strlen(fname)-4), (char *)".tri")) return IO_UNKNOWN;
 
@@ -534,12 +674,13 @@ int Triangulation::loadVerTri(const char *fname)
    if (i1 < 1 || i2 < 1 || i3 < 1) JMesh::error("\nloadVerTri: Illegal index at triangle %d!\n",i);
    else if (i1 > (numvers) || i2 > (numvers) || i3 > (numvers)) JMesh::error("\nloadVerTri: Index out of bounds at triangle %d!\n",i);
    else if (i1 == i2 || i2 == i3 || i3 == i1) JMesh::warning("\nloadVerTri: Coincident indexes at triangle %d! Skipping.\n",i);
-   else if (!CreateIndexedTriangle(var, i1-1, i2-1, i3-1)) JMesh::warning("\nloadVerTri: This shouldn't happen!!! Skipping triangle.\n");
+   else faces.add(i1-1, i2-1, i3-1);
   }
   else JMesh::error("loadVerTri: Couldn't read %dth triangle !\n",i+1);
 
  JMesh::end_progress();
 
+ CreateIndexedTriangles(var, faces.ids, faces.num);
  closeLoadingSession(fpt, T.numels(), var, 0);
 
  return 0;
@@ -1020,6 +1161,7 @@ int Triangulation::loadPLY(const char *fname)
  FILE *in;
  char keyword[64], formats[24], version[10];
  Vertex *v;
+ IndexedTriangles faces;
  Node *n;
 
  if ((in = fopen(fname,"rb")) == NULL) JMesh::error("Can't open input ply file\n");
@@ -1065,7 +1207,7 @@ int Triangulation::loadPLY(const char *fname)
    for (j=3; j<=i4; j++)
    {
     if (i1 == i2 || i2 == i3 || i3 == i1) JMesh::warning("\nloadPLY: Coincident indexes at triangle %d! Skipping.\n",i);
-    else if (!CreateIndexedTriangle(var, i1, i2, i3)) JMesh::warning("\nloadPLY: This shouldn't happen!!! Skipping triangle.\n");
+    else faces.add(i1, i2, i3);
     i2 = i3;
     if (j<i4)
     {
@@ -1079,6 +1221,7 @@ int Triangulation::loadPLY(const char *fname)
  }
  JMesh::end_progress();
 
+ CreateIndexedTriangles(var, faces.ids, faces.num);
  closeLoadingSession(in, i, var, triangulate);
 
  return 0;
@@ -1156,6 +1299,7 @@ int Triangulation::loadOBJ(const char *fname)
  bool face_section = 0;
  int i=0,i1,i2,i3,nv=0,triangulate=0;
  Vertex *v;
+ IndexedTriangles faces;
  ExtVertex **var=NULL;
 
  if ((fp = fopen(fname,"r")) == NULL) return IO_CANTOPEN;
@@ -1188,7 +1332,7 @@ int Triangulation::loadOBJ(const char *fname)
     do
     {
      if (i1 == i2 || i2 == i3 || i3 == i1) JMesh::warning("\nloadOBJ: Coincident indexes at triangle %d! Skipping.\n",i);
-     else if (!CreateIndexedTriangle(var, i1-1, i2-1, i3-1)) JMesh::warning("\nloadOBJ: This shouldn't happen!!! Skipping triangle.\n");
+     else faces.add(i1-1, i2-1, i3-1);
      i2 = i3;
      while ((c=fgetc(fp)) != EOF && isspace(c) && c != '\n' && c != '\r');
      if (c==EOF) JMesh::error("\nloadOBJ: Unexpected end of file!\n");
@@ -1209,6 +1353,7 @@ int Triangulation::loadOBJ(const char *fname)
 
  JMesh::end_progress();
 
+ CreateIndexedTriangles(var, faces.ids, faces.num);
  closeLoadingSession(fp, i, var, (triangulate!=0));
 
  return 0;
@@ -194,9 +194,13 @@ Triangulation::Triangulation(const Triangle *t0, const bool keep_reference)
 
 Triangulation::~Triangulation()
 {
- T.freeNodes();
- V.freeNodes();
- E.freeNodes();
+ Triangle *t;
+ Edge *e;
+ Vertex *v;
+
+ while ((t = (Triangle *)T.popHead()) != NULL) delete(t);
+ while ((v = (Vertex *)V.popHead()) != NULL) delete(v);
+ while ((e = (Edge *)E.popHead()) != NULL) delete(e);
 }
 
 
@@ -1916,7 +1920,7 @@ Vertex *Triangulation::watsonInsert(Point *p, List *tR, int nt)
  for (i=0, n = T.head(); i<nt; i++)
  {
   t = ((Triangle *)n->data);
-  if (t->e1 == NULL) {tmp = n; n=n->next(); T.freeCell(tmp);}
+  if (t->e1 == NULL) {tmp = n; n=n->next(); T.removeCell(tmp); delete(t);}
   else n=n->next();
  }
 
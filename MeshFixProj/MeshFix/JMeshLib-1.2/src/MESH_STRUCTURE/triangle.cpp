@@ -26,6 +26,7 @@
 ****************************************************************************/
 
 #include "triangle.h"
+#include "pool.h"
 #include <stdlib.h>
 
 //////////////////// Constructor //////////////////////
@@ -40,6 +41,14 @@ Triangle::Triangle(Edge *a, Edge *b, Edge *c)
 }
 
 
+//////////////////// Memory pool //////////////////////
+
+static MemoryPool& trianglePool() {static MemoryPool p(sizeof(Triangle)); return p;}
+
+void *Triangle::operator new(size_t s) {return trianglePool().allocate(s);}
+void Triangle::operator delete(void *p, size_t s) {trianglePool().release(p, s);}
+
+
 //////////////////// Normal vector //////////////////////
 
 Point Triangle::getNormal() const
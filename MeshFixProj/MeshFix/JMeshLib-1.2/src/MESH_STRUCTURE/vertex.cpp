@@ -28,6 +28,7 @@
 #include "vertex.h"
 #include "edge.h"
 #include "triangle.h"
+#include "pool.h"
 #include <stdlib.h>
 #include <errno.h>
 
@@ -68,6 +69,18 @@ Vertex::~Vertex()
 }
 
 
+/////////////// Memory pools ///////////////////////////
+
+static MemoryPool& vertexPool() {static MemoryPool p(sizeof(Vertex)); return p;}
+static MemoryPool& extVertexPool() {static MemoryPool p(sizeof(ExtVertex)); return p;}
+
+void *Vertex::operator new(size_t s) {return vertexPool().allocate(s);}
+void Vertex::operator delete(void *p, size_t s) {vertexPool().release(p, s);}
+
+void *ExtVertex::operator new(size_t s) {return extVertexPool().allocate(s);}
+void ExtVertex::operator delete(void *p, size_t s) {extVertexPool().release(p, s);}
+
+
 /////////////// VE relation ////////////////////////////
 
 List *Vertex::VE() const
@@ -29,6 +29,15 @@
 #include <stdlib.h>
 #include "list.h"
 #include "jqsort.h"
+#include "pool.h"
+
+
+////////////////// Memory pool for the nodes //////////////////
+
+static MemoryPool& nodePool() {static MemoryPool p(sizeof(Node)); return p;}
+
+void *Node::operator new(size_t s) {return nodePool().allocate(s);}
+void Node::operator delete(void *p, size_t s) {nodePool().release(p, s);}
 
 
 // Create a new node containing 'd', and link it to       //
@@ -0,0 +1,102 @@
+/****************************************************************************
+* JMeshLib                                                                  *
+*                                                                           *
+* Consiglio Nazionale delle Ricerche                                        *
+* Istituto di Matematica Applicata e Tecnologie Informatiche                *
+* Sezione di Genova                                                         *
+* IMATI-GE / CNR                                                            *
+*                                                                           *
+* Authors: Marco Attene                                                     *
+*                                                                           *
+* Copyright(C) 2006: IMATI-GE / CNR                                         *
+*                                                                           *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include <new>
+#include "pool.h"
+
+// Objects are aligned as doubles and pointers
+
+#define POOL_ALIGNMENT (sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *))
+
+MemoryPool::MemoryPool(size_t size, int ce)
+{
+ obj_size = size;
+ el_size = ((size+POOL_ALIGNMENT-1)/POOL_ALIGNMENT)*POOL_ALIGNMENT;
+ chunk_els = ce;
+ free_list = NULL;
+ next_free = chunk_end = NULL;
+ chunks = NULL;
+ num_chunks = max_chunks = 0;
+ num_live = 0;
+}
+
+void MemoryPool::newChunk()
+{
+ if (num_chunks == max_chunks)
+ {
+  int nm = (max_chunks)?(max_chunks*2):(16);
+  char **nc = (char **)realloc(chunks, sizeof(char *)*nm);
+  if (nc == NULL) throw std::bad_alloc();
+  chunks = nc; max_chunks = nm;
+ }
+ char *c = (char *)malloc(el_size*chunk_els);
+ if (c == NULL) throw std::bad_alloc();
+ chunks[num_chunks++] = c;
+ next_free = c;
+ chunk_end = c+el_size*chunk_els;
+}
+
+void MemoryPool::freeChunks()
+{
+ for (int i=0; i<num_chunks; i++) free(chunks[i]);
+ free(chunks);
+ chunks = NULL;
+ num_chunks = max_chunks = 0;
+ free_list = NULL;
+ next_free = chunk_end = NULL;
+}
+
+void *MemoryPool::allocate(size_t size)
+{
+ void *p;
+
+ if (size != obj_size)
+ {
+  if ((p = malloc(size)) == NULL) throw std::bad_alloc();
+  return p;
+ }
+
+ if (free_list != NULL) {p = free_list; free_list = *((void **)p);}
+ else
+ {
+  if (next_free == chunk_end) newChunk();
+  p = next_free;
+  next_free += el_size;
+ }
+ num_live++;
+
+ return p;
+}
+
+void MemoryPool::release(void *p, size_t size)
+{
+ if (p == NULL) return;
+ if (size != obj_size) {free(p); return;}
+
+ if ((--num_live) == 0) freeChunks();
+ else {*((void **)p) = free_list; free_list = p;}
+}
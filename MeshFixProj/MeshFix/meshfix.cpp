@@ -2,6 +2,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <jrs_predicates.h>
+#include <float.h>
+#include <vector>
+#include <queue>
+#include <algorithm>
 
 const char *input_filename;
 double epsilon_angle = 0.0;
@@ -214,7 +218,7 @@ bool removeSelfIntersections(ExtTriMesh& tin, int max_iters)
  int n, iter_count = 0;
 
  printf("Removing self-intersections...\n");
- while ((++iter_count) <= max_iters && tin.selectIntersectingTriangles())
+ while ((++iter_count) <= max_iters && tin.selectIntersectingTrianglesBVH())
  {
   for (n=1; n<iter_count; n++) tin.growSelection();
   tin.removeSelectedTriangles();
@@ -266,32 +270,274 @@ bool meshclean(ExtTriMesh& tin, int max_iters = 10, int inner_loops = 3)
 
 
 
-double closestPair(List *bl1, List *bl2, Vertex **closest_on_bl1, Vertex **closest_on_bl2)
+// Boundary vertices of the components to be joined, stored in a kd-tree
+// for closest-vertex queries restricted to other components.
+// Components are merged through a union-find on their labels. A node whose
+// vertices all belong to the same component remembers one of them in 'rep',
+// so that the whole node is skipped when searching from that component.
+
+#define CJ_MAX_LEAF_SIZE 8
+
+class cj_kdtree
 {
- Node *n, *m;
- Vertex *v,*w;
- double adist, mindist = DBL_MAX;
+ public:
+ class node
+ {
+  public:
+  double mp[3], Mp[3];
+  int first, count, right, rep;
+ };
+
+ std::vector<node> nodes;
+ std::vector<Vertex *> verts;	// Points in tree order
+ std::vector<int> ids;		// Index of each point in the input arrays
+ std::vector<double> x, y, z;
+ std::vector<int> comp;		// Component label of each point
+ std::vector<int> parent;	// Union-find on component labels
+
+ cj_kdtree(std::vector<Vertex *>& v, std::vector<int>& c, int numcomps)
+ {
+  int i, n = v.size();
+  verts.swap(v); comp.swap(c);
+  ids.resize(n);
+  for (i=0; i<n; i++) ids[i] = i;
+  parent.resize(numcomps);
+  for (i=0; i<numcomps; i++) parent[i] = i;
+  x.resize(n); y.resize(n); z.resize(n);
+  nodes.reserve((n > 0)?(2*n/CJ_MAX_LEAF_SIZE+1):(0));
+  if (n) build(0, n);
+ }
+
+ int find(int c)
+ {
+  while (parent[c] != c) {parent[c] = parent[parent[c]]; c = parent[c];}
+  return c;
+ }
+
+ // Merges the components of points 'i' and 'j'
+ void merge(int i, int j) {parent[find(comp[i])] = find(comp[j]);}
+
+ // Closest point to 'i' which is not in the component of 'i'. If 'update'
+ // the uniform nodes met during the search are recorded (not thread-safe).
+ // Returns -1 if all the points are in the same component.
+ int nearest(int i, double *dist, bool update)
+ {
+  double p[3] = {x[i], y[i], z[i]};
+  int best = -1;
+  *dist = DBL_MAX;
+  nearest(0, p, find(comp[i]), dist, &best, update);
+  return best;
+ }
+
+ // Appends to 'found' all the points which are not in the component of 'i'
+ // and whose squared distance from 'i' is at most 'dist'.
+ void within(int i, double dist, std::vector<int>& found)
+ {
+  double p[3] = {x[i], y[i], z[i]};
+  within(0, p, find(comp[i]), dist, found);
+ }
+
+ protected:
+ int build(int first, int count)
+ {
+  int i, k, axis, node_id = nodes.size();
+  nodes.push_back(node());
+  node nd;
+  nd.mp[0] = nd.mp[1] = nd.mp[2] = DBL_MAX;
+  nd.Mp[0] = nd.Mp[1] = nd.Mp[2] = -DBL_MAX;
+  nd.first = first; nd.count = count; nd.right = -1; nd.rep = first;
+  for (i=first; i<first+count; i++)
+  {
+   double q[3] = {verts[i]->x, verts[i]->y, verts[i]->z};
+   for (k=0; k<3; k++) {nd.mp[k] = MIN(nd.mp[k], q[k]); nd.Mp[k] = MAX(nd.Mp[k], q[k]);}
+   if (comp[i] != comp[first]) nd.rep = -1;
+  }
+
+  if (count <= CJ_MAX_LEAF_SIZE)
+  {
+   for (i=first; i<first+count; i++) {x[i] = verts[i]->x; y[i] = verts[i]->y; z[i] = verts[i]->z;}
+   nodes[node_id] = nd;
+   return node_id;
+  }
 
- FOREACHVVVERTEX(bl1, v, n)
-  FOREACHVVVERTEX(bl2, w, m)
-   if ((adist = w->squaredDistance(v))<mindist)
+  axis = 0;
+  if (nd.Mp[1]-nd.mp[1] > nd.Mp[axis]-nd.mp[axis]) axis = 1;
+  if (nd.Mp[2]-nd.mp[2] > nd.Mp[axis]-nd.mp[axis]) axis = 2;
+
+  // Median split: sort the points of this node by their coordinate along 'axis'
+  std::vector< std::pair<double, int> > keys(count);
+  for (i=0; i<count; i++)
+   keys[i] = std::pair<double, int>((axis==0)?(verts[first+i]->x):((axis==1)?(verts[first+i]->y):(verts[first+i]->z)), first+i);
+  std::nth_element(keys.begin(), keys.begin()+count/2, keys.end());
+  std::vector<Vertex *> tv(count);
+  std::vector<int> tc(count), ti(count);
+  for (i=0; i<count; i++) {tv[i] = verts[keys[i].second]; tc[i] = comp[keys[i].second]; ti[i] = ids[keys[i].second];}
+  for (i=0; i<count; i++) {verts[first+i] = tv[i]; comp[first+i] = tc[i]; ids[first+i] = ti[i];}
+
+  nd.count = 0;
+  nodes[node_id] = nd;
+  build(first, count/2);
+  nodes[node_id].right = build(first+count/2, count-count/2);
+  return node_id;
+ }
+
+ void nearest(int n, const double *p, int rc, double *dist, int *best, bool update)
+ {
+  node& nd = nodes[n];
+  double d, b = 0.0;
+  int i, k;
+
+  if (nd.rep >= 0 && find(comp[nd.rep]) == rc) return;
+  for (k=0; k<3; k++)
+  {
+   if (p[k] < nd.mp[k]) {d = nd.mp[k]-p[k]; b += d*d;}
+   else if (p[k] > nd.Mp[k]) {d = p[k]-nd.Mp[k]; b += d*d;}
+  }
+  if (b >= *dist) return;
+
+  if (nd.count)
+  {
+   bool uniform = true;
+   int r0 = find(comp[nd.first]);
+   for (i=nd.first; i<nd.first+nd.count; i++)
    {
-	mindist=adist;
-	*closest_on_bl1 = v;
-	*closest_on_bl2 = w;
+    int ri = find(comp[i]);
+    if (ri != r0) uniform = false;
+    if (ri == rc) continue;
+    d = (x[i]-p[0])*(x[i]-p[0])+(y[i]-p[1])*(y[i]-p[1])+(z[i]-p[2])*(z[i]-p[2]);
+    if (d < *dist) {*dist = d; *best = i;}
    }
+   if (update && uniform) nd.rep = nd.first;
+   return;
+  }
+
+  // Visit first the child on the same side of the splitting point
+  int l = n+1, r = nd.right;
+  double cl = 0.0, cr = 0.0;
+  for (k=0; k<3; k++)
+  {
+   if (p[k] < nodes[l].mp[k]) cl += (nodes[l].mp[k]-p[k])*(nodes[l].mp[k]-p[k]);
+   else if (p[k] > nodes[l].Mp[k]) cl += (p[k]-nodes[l].Mp[k])*(p[k]-nodes[l].Mp[k]);
+   if (p[k] < nodes[r].mp[k]) cr += (nodes[r].mp[k]-p[k])*(nodes[r].mp[k]-p[k]);
+   else if (p[k] > nodes[r].Mp[k]) cr += (p[k]-nodes[r].Mp[k])*(p[k]-nodes[r].Mp[k]);
+  }
+  if (cl <= cr) {nearest(l, p, rc, dist, best, update); nearest(r, p, rc, dist, best, update);}
+  else {nearest(r, p, rc, dist, best, update); nearest(l, p, rc, dist, best, update);}
+
+  if (update && nodes[l].rep >= 0 && nodes[r].rep >= 0 && find(comp[nodes[l].rep]) == find(comp[nodes[r].rep]))
+   nodes[n].rep = nodes[l].rep;
+ }
 
- return mindist;
+ void within(int n, const double *p, int rc, double dist, std::vector<int>& found)
+ {
+  node& nd = nodes[n];
+  double d, b = 0.0;
+  int i, k;
+
+  if (nd.rep >= 0 && find(comp[nd.rep]) == rc) return;
+  for (k=0; k<3; k++)
+  {
+   if (p[k] < nd.mp[k]) {d = nd.mp[k]-p[k]; b += d*d;}
+   else if (p[k] > nd.Mp[k]) {d = p[k]-nd.Mp[k]; b += d*d;}
+  }
+  if (b > dist) return;
+
+  if (nd.count)
+  {
+   for (i=nd.first; i<nd.first+nd.count; i++) if (find(comp[i]) != rc)
+   {
+    d = (x[i]-p[0])*(x[i]-p[0])+(y[i]-p[1])*(y[i]-p[1])+(z[i]-p[2])*(z[i]-p[2]);
+    if (d <= dist) found.push_back(i);
+   }
+   return;
+  }
+
+  within(n+1, p, rc, dist, found);
+  within(nd.right, p, rc, dist, found);
+ }
+};
+
+// Candidate pair of boundary vertices for the joining (indices in the kd-tree)
+class cj_pair
+{
+ public:
+ double dist;
+ int i, j;
+
+ cj_pair(double d, int a, int b) : dist(d), i(a), j(b) {}
+ bool operator<(const cj_pair& p) const {return (dist > p.dist || (dist == p.dist && i > p.i));}
+};
+
+// Joins the boundary loops of 'gv' and 'gw' (on different components) through
+// an edge and a pair of triangles, as joinBoundaryLoops(gv, gw, 1, 0, 0) does,
+// but without deselecting the whole mesh each time.
+
+void bridgeBoundaryLoops(ExtTriMesh *tin, Vertex *gv, Vertex *gw)
+{
+ Edge *gve = gv->prevBoundaryEdge();
+ Vertex *gvn = gve->oppositeVertex(gv);
+ Edge *gwe = gw->nextBoundaryEdge();
+ Vertex *gwn = gwe->oppositeVertex(gw);
+
+ Edge *je = tin->CreateEdge(gv, gw);
+ Edge *je1 = tin->CreateEdge(gv, gwn);
+ Edge *je2 = tin->CreateEdge(gwn, gvn);
+
+ tin->CreateTriangle(je, gwe, je1);
+ tin->CreateTriangle(je1, je2, gve);
 }
 
-bool joinClosestComponents(ExtTriMesh *tin)
+// Root of the boundary loop of the boundary vertex 'i'. Roots are the
+// loop vertices coming first in the vertex list.
+
+inline int loopRoot(std::vector<int>& loops, int i)
+{
+ while (loops[i] != i) {loops[i] = loops[loops[i]]; i = loops[i];}
+ return i;
+}
+
+// Number of steps along the boundary from the loop root 'r' to 'v'
+
+int loopStep(Vertex *r, Vertex *v)
 {
-  Vertex *v,*w, *gv, *gw;
+ int k = 0;
+ Vertex *w = r;
+ while (w != v) {w = w->nextOnBoundary(); k++;}
+ return k;
+}
+
+// TRUE if the pair of tree points (a, b) comes before (c, d) in the order
+// the former loop-by-loop search visited them. That search scanned the
+// loops latest-found first, and each loop backwards from the vertex
+// preceding its root, so that among equally close pairs it kept the first
+// one in this order.
+
+bool cjPrecedes(cj_kdtree& tree, std::vector<int>& loops, std::vector<Vertex *>& loopverts, int a, int b, int c, int d)
+{
+ int ra = loopRoot(loops, tree.ids[a]), rb = loopRoot(loops, tree.ids[b]);
+ int rc = loopRoot(loops, tree.ids[c]), rd = loopRoot(loops, tree.ids[d]);
+
+ if (ra != rc) return (ra > rc);
+ if (rb != rd) return (rb > rd);
+ if (a != c) return (loopStep(loopverts[ra], tree.verts[a]) > loopStep(loopverts[ra], tree.verts[c]));
+ return (loopStep(loopverts[rb], tree.verts[b]) > loopStep(loopverts[rb], tree.verts[d]));
+}
+
+// Repeatedly joins the two closest boundary vertices of different components
+// until no such pair exists. Joining does not move or remove boundary vertices,
+// so the closest-pair candidates are computed once in parallel and re-queried
+// only when the two components of a candidate have been merged meanwhile
+// (distances to other components never decrease). Among equally close pairs
+// the one chosen by the former exhaustive search is joined (see cjPrecedes()).
+// Returns the number of joins performed.
+
+int joinClosestComponents(ExtTriMesh *tin)
+{
+  Vertex *v;
   Triangle *t, *s;
   Node *n;
-  List triList, boundary_loops, *one_loop;
-  List **bloops_array;
-  int i, j, numloops;
+  List triList;
+  int i, j, numcomps;
 
   i=0;
   FOREACHVTTRIANGLE((&(tin->T)), t, n) t->info = NULL;
@@ -309,12 +555,13 @@ bool joinClosestComponents(ExtTriMesh *tin)
     if ((s = t->t3()) != NULL && s->info == NULL) {triList.appendHead(s); s->info = (void *)i;}
    }
   }
+  numcomps = i;
 
-  if (i<2)
+  if (numcomps<2)
   {
    FOREACHVTTRIANGLE((&(tin->T)), t, n) t->info = NULL;
 //   JMesh::info("Mesh is a single component. Nothing done.");
-   return false;
+   return 0;
   }
 
   FOREACHVTTRIANGLE((&(tin->T)), t, n)
@@ -322,43 +569,86 @@ bool joinClosestComponents(ExtTriMesh *tin)
    t->v1()->info = t->v2()->info = t->v3()->info = t->info;
   }
 
-  FOREACHVVVERTEX((&(tin->V)), v, n) if (!IS_VISITED2(v) && v->isOnBoundary())
+  std::vector<Vertex *> bverts;
+  std::vector<int> bcomps;
+  FOREACHVVVERTEX((&(tin->V)), v, n) if (v->info != NULL && v->isOnBoundary())
+   {bverts.push_back(v); bcomps.push_back(((j_voidint)v->info)-1);}
+
+  FOREACHVTTRIANGLE((&(tin->T)), t, n) t->info = NULL;
+  FOREACHVVVERTEX((&(tin->V)), v, n) v->info = NULL;
+
+  // Boundary loops, to orient each join as the former loop-by-loop search did
+  int numbv = bverts.size();
+  std::vector<int> loops(numbv, -1);
+  for (i=0; i<numbv; i++) bverts[i]->info = (void *)((j_voidint)(i+1));
+  for (i=0; i<numbv; i++) if (loops[i] < 0)
   {
-   w = v;
-   one_loop = new List;
-   do
-   {
-    one_loop->appendHead(w); MARK_VISIT2(w);
-    w = w->nextOnBoundary();
-   } while (w != v);
-   boundary_loops.appendHead(one_loop);
+   v = bverts[i];
+   do {loops[((j_voidint)v->info)-1] = i; v = v->nextOnBoundary();} while (v != bverts[i]);
   }
-  FOREACHVVVERTEX((&(tin->V)), v, n) UNMARK_VISIT2(v);
+  for (i=0; i<numbv; i++) bverts[i]->info = NULL;
 
-  bloops_array = (List **)boundary_loops.toArray();
-  numloops = boundary_loops.numels();
+  std::vector<Vertex *> loopverts(bverts);
+  cj_kdtree tree(bverts, bcomps, numcomps);
 
-  int numtris = tin->T.numels();
-  double adist, mindist=DBL_MAX;
+  std::vector<int> nn(numbv);
+  std::vector<double> nd(numbv);
+#pragma omp parallel for schedule(dynamic, 256)
+  for (i=0; i<numbv; i++) nn[i] = tree.nearest(i, &nd[i], false);
 
-  gv=NULL;
-  for (i=0; i<numloops; i++)
-   for (j=0; j<numloops; j++)
-	if (((Vertex *)bloops_array[i]->head()->data)->info != ((Vertex *)bloops_array[j]->head()->data)->info)
-	{
-	 adist = closestPair(bloops_array[i], bloops_array[j], &v, &w);
-	 if (adist<mindist) {mindist=adist; gv=v; gw=w;}
-	}
+  std::priority_queue<cj_pair> candidates;
+  for (i=0; i<numbv; i++) if (nn[i] >= 0) candidates.push(cj_pair(nd[i], i, nn[i]));
 
-  if (gv!=NULL) tin->joinBoundaryLoops(gv, gw, 1, 0, 0);
+  int joins = 0, k, gv, gw, li, lj;
+  double d;
+  std::vector<cj_pair> tied;
+  std::vector<int> found;
+  while (!candidates.empty())
+  {
+   cj_pair p = candidates.top();
+   candidates.pop();
 
-  FOREACHVTTRIANGLE((&(tin->T)), t, n) t->info = NULL;
-  FOREACHVVVERTEX((&(tin->V)), v, n) v->info = NULL;
+   // Stale candidate: look for the closest vertex in the remaining components
+   if (tree.find(tree.comp[p.i]) == tree.find(tree.comp[p.j]))
+   {
+    if ((j = tree.nearest(p.i, &d, true)) >= 0) candidates.push(cj_pair(d, p.i, j));
+    continue;
+   }
+
+   // Collect all the vertices as close as 'p' to another component. Both
+   // ends of every closest pair are among them.
+   tied.clear();
+   tied.push_back(p);
+   while (!candidates.empty() && candidates.top().dist == p.dist)
+   {
+    cj_pair q = candidates.top();
+    candidates.pop();
+    if (tree.find(tree.comp[q.i]) != tree.find(tree.comp[q.j])) tied.push_back(q);
+    else if ((j = tree.nearest(q.i, &d, true)) >= 0) candidates.push(cj_pair(d, q.i, j));
+   }
 
-  free(bloops_array);
-  while ((one_loop=(List *)boundary_loops.popHead())!=NULL) delete one_loop;
+   // The first closest pair in the former search order provides 'gv' and 'gw'.
+   // 'gv' is on the latest-found loop among the tied vertices.
+   for (li=-1, k=0; k<(int)tied.size(); k++) li = MAX(li, loopRoot(loops, tree.ids[tied[k].i]));
+   gv = gw = -1;
+   for (k=0; k<(int)tied.size(); k++) if (loopRoot(loops, tree.ids[tied[k].i]) == li)
+   {
+    found.clear();
+    tree.within(tied[k].i, p.dist, found);
+    for (i=0; i<(int)found.size(); i++)
+     if (gv < 0 || cjPrecedes(tree, loops, loopverts, tied[k].i, found[i], gv, gw)) {gv = tied[k].i; gw = found[i];}
+   }
+   lj = loopRoot(loops, tree.ids[gw]);
+
+   bridgeBoundaryLoops(tin, tree.verts[gv], tree.verts[gw]);
+   loops[li] = lj;
+   tree.merge(gv, gw);
+   for (k=0; k<(int)tied.size(); k++) candidates.push(tied[k]);
+   joins++;
+   JMesh::report_progress("Num. components: %d       ", numcomps-joins);
+  }
 
-  return (gv!=NULL);
+  return joins;
 }
 
 
@@ -446,7 +736,7 @@ int main(int argc, char *argv[])
  {
   printf("\nJoining input components ...\n");
   JMesh::begin_progress();
-  while (joinClosestComponents(&tin)) JMesh::report_progress("Num. components: %d       ",tin.shells());
+  joinClosestComponents(&tin);
   JMesh::end_progress();
   tin.deselectTriangles();
  }
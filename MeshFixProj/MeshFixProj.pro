@@ -10,13 +10,15 @@ SOURCES += \
     MeshFix/OpenNL3.2.1/src/NL/nl_api.c \
     MeshFix/OpenNL3.2.1/src/NL/nl_cnc_gpu_cuda.c
 
-QMAKE_CXXFLAGS += -frounding-math
+QMAKE_CXXFLAGS += -frounding-math \
+    -fopenmp #JMeshExt的自相交检测使用OpenMP并行
 
 INCLUDEPATH += /home/sway/MeshFixProj/MeshFix/JMeshExt-1.0alpha_src/include  \
                /home/sway/MeshFixProj/MeshFix/JMeshLib-1.2/include          \
                /home/sway/MeshFixProj/MeshFix/OpenNL3.2.1/src
 
 LIBS += -L/home/sway/MeshFixProj/MeshFix/JMeshExt-1.0alpha_src/lib/ -ljmeshext  \
-        -L/home/sway/MeshFixProj/MeshFix/JMeshLib-1.2/lib/ -ljmesh
+        -L/home/sway/MeshFixProj/MeshFix/JMeshLib-1.2/lib/ -ljmesh  \
+        -lgomp
 
 DEFINES += IS64BITPLATFORM
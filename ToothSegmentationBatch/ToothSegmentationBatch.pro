@@ -0,0 +1,57 @@
+######################################################################
+# 无图形界面的牙齿分割批处理程序
+# 不依赖QtGui/QtWidgets、QGLViewer和OpenGL上下文，可在无显示设备的服务器上运行
+######################################################################
+
+QT += core
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = ToothSegmentationBatch
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += \
+    -frounding-math \
+    -std=c++0x \
+    -fopenmp #为了支持OpenMP并行处理而添加此项
+
+DEFINES += TOOTH_SEGMENTATION_HEADLESS #不编译ToothSegmentation中依赖图形界面的交互功能
+
+SOURCES += \
+    main.cpp \
+    ../src/Mesh.cpp \
+    ../src/ProgressReporter.cpp \
+    ../src/ToothSegmentation.cpp \
+    ../src/SpatialIndex.cpp \
+    ../src/GeodesicPathFinder.cpp \
+    ../src/StageProfiler.cpp \
+    ../src/MeshLoader.cpp \
+    ../src/VertexAdjacency.cpp \
+    ../src/MeshAnalysisView.cpp \
+    ../src/CurvatureComputer.cpp
+
+HEADERS += \
+    ../include/Mesh.h \
+    ../include/BoundingBox.h \
+    ../include/ProgressReporter.h \
+    ../include/ToothSegmentation.h \
+    ../include/SpatialIndex.h \
+    ../include/GeodesicPathFinder.h \
+    ../include/StageProfiler.h \
+    ../include/MeshLoader.h \
+    ../include/VertexAdjacency.h \
+    ../include/MeshAnalysisView.h \
+    ../include/CurvatureComputer.h
+
+INCLUDEPATH += \
+    ../ \
+    ../include/ \
+    ../lib/eigen/include/ #Eigen库包含路径
+
+LIBS += \
+    -lOpenMeshCore -lOpenMeshTools \ #OpenMesh库文件
+    -lGL \ #Mesh::draw中的OpenGL调用（批处理中不会被调用，无需显示设备）
+    -lgomp -lpthread \ #为了支持OpenMP并行处理而添加此两项
+    -lgsl -lgslcblas #GSL库文件
@@ -0,0 +1,435 @@
+/*
+  牙齿分割批处理程序（无图形界面）。
+  对每个输入模型依次执行ToothSegmentation的全部5个阶段，输出各阶段结果模型、最终的顶点标签和各阶段用时。
+  指定--profile时另外输出各阶段及子步骤的耗时、计数和内存报告（<模型>.Profile.json和<模型>.Profile.csv）。
+  指定--benchmark-curvature-fit时不做分割，只对每个模型比较两种曲率拟合方法的耗时和结果差异（CurvatureComputer::benchmarkFitMethods）。
+  多个模型时以多进程并行处理：主进程将每个模型交给一个子进程（即以--worker参数再次运行本程序）处理。
+
+  用法：ToothSegmentationBatch [选项] <模型文件或目录>...
+*/
+
+#include "include/Mesh.h"
+#include "ToothSegmentation.h"
+#include "ProgressReporter.h"
+#include "StageProfiler.h"
+#include "MeshLoader.h"
+#include "CurvatureComputer.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QTextStream>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QTime>
+
+#include <iostream>
+
+#include <omp.h>
+
+using namespace SW;
+using namespace std;
+
+class BatchOptions
+{
+public:
+    QString outputDir; //输出目录，为空时输出到模型所在目录
+    int jobNum; //同时处理的模型数（子进程数）
+    bool flipCuttingPlane; //是否翻转牙龈分割平面
+    bool profile; //是否输出各阶段及子步骤的详细统计报告
+    bool useMeshCache; //是否读写模型的缓存文件（见MeshLoader::cacheFilename）
+    bool benchmarkCurvatureFit; //只比较两种曲率拟合方法，不做分割
+    float moveCuttingPlaneDistance; //牙龈分割平面的移动距离（与MainWindow中默认流程一致，默认为-0.2）
+    bool worker; //内部使用：作为子进程只处理一个模型
+    QStringList inputs;
+
+    BatchOptions()
+    {
+        jobNum = omp_get_num_procs();
+        flipCuttingPlane = false;
+        profile = false;
+        useMeshCache = true;
+        benchmarkCurvatureFit = false;
+        moveCuttingPlaneDistance = -0.2;
+        worker = false;
+    }
+};
+
+static void printUsage()
+{
+    cout << "Usage: ToothSegmentationBatch [options] <mesh file or directory>..." << endl
+         << "Options:" << endl
+         << "  -o, --output <dir>               output directory (default: next to each input mesh)" << endl
+         << "  -j, --jobs <n>                   number of meshes processed in parallel (default: number of processors)" << endl
+         << "  --move-cutting-plane <distance>  gingiva cutting plane offset (default: -0.2)" << endl
+         << "  --flip-cutting-plane             flip the gingiva cutting plane" << endl
+         << "  --profile                        write per-stage timing/counter/memory reports (<mesh>.Profile.json/.csv)" << endl
+         << "  --no-mesh-cache                  do not read or write the cached copy of each input mesh in the user cache directory" << endl
+         << "  --benchmark-curvature-fit        only compare the timing and results of the two curvature fit methods" << endl
+         << "  -h, --help                       show this help" << endl;
+}
+
+static bool parseArguments(const QStringList &arguments, BatchOptions &options)
+{
+    for(int i = 1; i < arguments.size(); i++)
+    {
+        QString argument = arguments.at(i);
+        bool hasValue = (i + 1 < arguments.size());
+        bool ok = true;
+        if(argument == "-o" || argument == "--output")
+        {
+            if(!hasValue)
+            {
+                return false;
+            }
+            options.outputDir = arguments.at(++i);
+        }
+        else if(argument == "-j" || argument == "--jobs")
+        {
+            if(!hasValue)
+            {
+                return false;
+            }
+            options.jobNum = arguments.at(++i).toInt(&ok);
+            if(!ok || options.jobNum < 1)
+            {
+                return false;
+            }
+        }
+        else if(argument == "--move-cutting-plane")
+        {
+            if(!hasValue)
+            {
+                return false;
+            }
+            options.moveCuttingPlaneDistance = arguments.at(++i).toFloat(&ok);
+            if(!ok)
+            {
+                return false;
+            }
+        }
+        else if(argument == "--flip-cutting-plane")
+        {
+            options.flipCuttingPlane = true;
+        }
+        else if(argument == "--profile")
+        {
+            options.profile = true;
+        }
+        else if(argument == "--no-mesh-cache")
+        {
+            options.useMeshCache = false;
+        }
+        else if(argument == "--benchmark-curvature-fit")
+        {
+            options.benchmarkCurvatureFit = true;
+        }
+        else if(argument == "--worker")
+        {
+            options.worker = true;
+        }
+        else if(argument.startsWith("-"))
+        {
+            return false;
+        }
+        else
+        {
+            options.inputs.push_back(argument);
+        }
+    }
+    return !options.inputs.isEmpty();
+}
+
+//将输入的文件和目录展开为模型文件列表
+static QStringList collectMeshFiles(const QStringList &inputs)
+{
+    QStringList meshFiles;
+    QStringList nameFilters;
+    nameFilters << "*.obj" << "*.off" << "*.ply" << "*.stl";
+    foreach(QString input, inputs)
+    {
+        QFileInfo inputInfo(input);
+        if(inputInfo.isDir())
+        {
+            QDir inputDir(input);
+            foreach(QString fileName, inputDir.entryList(nameFilters, QDir::Files, QDir::Name))
+            {
+                meshFiles.push_back(inputDir.filePath(fileName));
+            }
+        }
+        else
+        {
+            meshFiles.push_back(input);
+        }
+    }
+    return meshFiles;
+}
+
+//输出文件的路径前缀（各阶段结果均以此为前缀，与图形界面下以模型路径为前缀一致）
+static QString outputPrefix(const QString &meshFile, const BatchOptions &options)
+{
+    if(options.outputDir.isEmpty())
+    {
+        return meshFile;
+    }
+    return QDir(options.outputDir).filePath(QFileInfo(meshFile).fileName());
+}
+
+static bool loadMesh(const QString &meshFile, Mesh &mesh, bool useMeshCache)
+{
+    StageProfiler::Scope profilerScope("LoadMesh");
+
+    if(!MeshLoader::load(meshFile, mesh, useMeshCache))
+    {
+        cerr << "Error to load " << meshFile.toStdString() << endl;
+        return false;
+    }
+    mesh.computeEntityNumbers();
+    mesh.computeBoundingBox();
+    StageProfiler::addCounter("vertices", mesh.mVertexNum);
+    return true;
+}
+
+//用两种拟合方法分别计算模型的平均曲率，输出耗时及结果差异
+static bool benchmarkCurvatureFit(const QString &meshFile, const BatchOptions &options)
+{
+    ConsoleProgressReporter progress(QFileInfo(meshFile).fileName() + ": ");
+    Mesh mesh(outputPrefix(meshFile, options));
+    if(!loadMesh(meshFile, mesh, options.useMeshCache))
+    {
+        return false;
+    }
+    CurvatureComputer curvatureComputer(mesh);
+    curvatureComputer.benchmarkFitMethods(&progress);
+    return true;
+}
+
+//在当前进程中处理一个模型，各阶段用时写入<前缀>.Timings.csv
+static bool processMesh(const QString &meshFile, const BatchOptions &options)
+{
+    if(options.benchmarkCurvatureFit)
+    {
+        return benchmarkCurvatureFit(meshFile, options);
+    }
+
+    QString prefix = outputPrefix(meshFile, options);
+    ConsoleProgressReporter progress(QFileInfo(meshFile).fileName() + ": ");
+    StageProfiler::setEnabled(options.profile);
+    StageProfiler::reset();
+    QTime totalTime;
+    totalTime.start();
+
+    QVector< QPair<QString, int> > timings; //各阶段名称及用时（ms）
+    QTime time;
+
+    time.start();
+    Mesh mesh(prefix);
+    if(!loadMesh(meshFile, mesh, options.useMeshCache))
+    {
+        return false;
+    }
+    timings.push_back(qMakePair(QString("LoadMesh"), time.elapsed()));
+
+    time.start();
+    ToothSegmentation toothSegmentation(&progress, mesh);
+    timings.push_back(qMakePair(QString("SetupToothMesh"), time.elapsed()));
+
+    time.start();
+    toothSegmentation.identifyPotentialToothBoundary(false);
+    timings.push_back(qMakePair(QString("IdentifyPotentialToothBoundary"), time.elapsed()));
+
+    time.start();
+    toothSegmentation.automaticCuttingOfGingiva(false, options.flipCuttingPlane, options.moveCuttingPlaneDistance);
+    timings.push_back(qMakePair(QString("AutomaticCuttingOfGingiva"), time.elapsed()));
+
+    time.start();
+    toothSegmentation.boundarySkeletonExtraction(false);
+    timings.push_back(qMakePair(QString("BoundarySkeletonExtraction"), time.elapsed()));
+
+    time.start();
+    toothSegmentation.findCuttingPoints(false);
+    timings.push_back(qMakePair(QString("FindCuttingPoints"), time.elapsed()));
+
+    time.start();
+    toothSegmentation.refineToothBoundary(false);
+    timings.push_back(qMakePair(QString("RefineToothBoundary"), time.elapsed()));
+
+    bool labelsSaved = toothSegmentation.saveVertexLabels((prefix + ".Labels.txt").toStdString());
+    timings.push_back(qMakePair(QString("Total"), totalTime.elapsed()));
+
+    if(options.profile)
+    {
+        QString runName = QFileInfo(meshFile).fileName();
+        StageProfiler::writeJson(prefix + ".Profile.json", runName);
+        StageProfiler::writeCsv(prefix + ".Profile.csv", runName);
+    }
+
+    QFile timingFile(prefix + ".Timings.csv");
+    if(!timingFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        cerr << "Fail to open file \"" << timingFile.fileName().toStdString() << "\" ." << endl;
+        return false;
+    }
+    QTextStream timingStream(&timingFile);
+    timingStream << "stage,milliseconds\n";
+    for(int i = 0; i < timings.size(); i++)
+    {
+        timingStream << timings[i].first << "," << timings[i].second << "\n";
+    }
+    timingStream.flush();
+    timingFile.close();
+
+    cout << meshFile.toStdString() << ": done in " << totalTime.elapsed() << "ms." << endl;
+    return labelsSaved;
+}
+
+//启动子进程处理meshFile
+static QProcess* startWorker(const QString &meshFile, const BatchOptions &options, int threadNumPerWorker)
+{
+    QStringList arguments;
+    arguments << "--worker";
+    if(!options.outputDir.isEmpty())
+    {
+        arguments << "--output" << options.outputDir;
+    }
+    arguments << "--move-cutting-plane" << QString::number(options.moveCuttingPlaneDistance);
+    if(options.flipCuttingPlane)
+    {
+        arguments << "--flip-cutting-plane";
+    }
+    if(options.profile)
+    {
+        arguments << "--profile";
+    }
+    if(!options.useMeshCache)
+    {
+        arguments << "--no-mesh-cache";
+    }
+    if(options.benchmarkCurvatureFit)
+    {
+        arguments << "--benchmark-curvature-fit";
+    }
+    arguments << meshFile;
+
+    //各子进程平分处理器，避免OpenMP线程数超过处理器数
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("OMP_NUM_THREADS", QString::number(threadNumPerWorker));
+
+    QProcess *worker = new QProcess();
+    worker->setProcessEnvironment(environment);
+    worker->setProcessChannelMode(QProcess::ForwardedChannels);
+    worker->start(QCoreApplication::applicationFilePath(), arguments);
+    return worker;
+}
+
+//合并各模型的用时到<输出目录>/Timings.csv
+static void mergeTimings(const QStringList &meshFiles, const BatchOptions &options)
+{
+    QString summaryDir = options.outputDir.isEmpty() ? QString(".") : options.outputDir;
+    QFile summaryFile(QDir(summaryDir).filePath("Timings.csv"));
+    if(!summaryFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        cerr << "Fail to open file \"" << summaryFile.fileName().toStdString() << "\" ." << endl;
+        return;
+    }
+    QTextStream summaryStream(&summaryFile);
+    summaryStream << "mesh,stage,milliseconds\n";
+    foreach(QString meshFile, meshFiles)
+    {
+        QFile timingFile(outputPrefix(meshFile, options) + ".Timings.csv");
+        if(!timingFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            continue;
+        }
+        QTextStream timingStream(&timingFile);
+        timingStream.readLine(); //跳过表头
+        while(!timingStream.atEnd())
+        {
+            summaryStream << meshFile << "," << timingStream.readLine() << "\n";
+        }
+    }
+    summaryStream.flush();
+    summaryFile.close();
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    BatchOptions options;
+    if(!parseArguments(app.arguments(), options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if(!options.outputDir.isEmpty() && !QDir().mkpath(options.outputDir))
+    {
+        cerr << "Fail to create output directory \"" << options.outputDir.toStdString() << "\" ." << endl;
+        return 1;
+    }
+
+    QStringList meshFiles = collectMeshFiles(options.inputs);
+
+    //子进程，或只需处理一个模型时，直接在当前进程中处理
+    if(options.worker || options.jobNum == 1 || meshFiles.size() == 1)
+    {
+        int failedNum = 0;
+        foreach(QString meshFile, meshFiles)
+        {
+            if(!processMesh(meshFile, options))
+            {
+                failedNum++;
+            }
+        }
+        if(!options.worker && !options.benchmarkCurvatureFit)
+        {
+            mergeTimings(meshFiles, options);
+        }
+        return failedNum == 0 ? 0 : 1;
+    }
+
+    int jobNum = qMin(options.jobNum, meshFiles.size());
+    int threadNumPerWorker = qMax(1, omp_get_num_procs() / jobNum);
+    QStringList failedMeshFiles;
+    QList< QPair<QProcess*, QString> > runningWorkers;
+    int nextMeshIndex = 0;
+    while(nextMeshIndex < meshFiles.size() || !runningWorkers.isEmpty())
+    {
+        while(nextMeshIndex < meshFiles.size() && runningWorkers.size() < jobNum)
+        {
+            QString meshFile = meshFiles.at(nextMeshIndex++);
+            runningWorkers.push_back(qMakePair(startWorker(meshFile, options, threadNumPerWorker), meshFile));
+        }
+
+        for(int i = 0; i < runningWorkers.size(); i++)
+        {
+            QProcess *worker = runningWorkers[i].first;
+            if(worker->state() != QProcess::NotRunning && !worker->waitForFinished(100))
+            {
+                continue;
+            }
+            if(worker->error() == QProcess::FailedToStart || worker->exitStatus() != QProcess::NormalExit || worker->exitCode() != 0)
+            {
+                failedMeshFiles.push_back(runningWorkers[i].second);
+            }
+            delete worker;
+            runningWorkers.removeAt(i);
+            i--;
+        }
+    }
+
+    if(!options.benchmarkCurvatureFit)
+    {
+        mergeTimings(meshFiles, options);
+    }
+
+    cout << meshFiles.size() - failedMeshFiles.size() << "/" << meshFiles.size() << " meshes segmented." << endl;
+    foreach(QString meshFile, failedMeshFiles)
+    {
+        cerr << "Failed: " << meshFile.toStdString() << endl;
+    }
+    return failedMeshFiles.isEmpty() ? 0 : 1;
+}
@@ -2,11 +2,7 @@
 #define BOOLEANOPERATION_H
 
 #include "Mesh.h"
-enum BooleanOperation{
-    UNION,
-    INTERSECTION,
-    DIFFERENCE,
-};
+#include "BooleanOperationType.h"
 
 #include <igit_geometry/Nef_polyhedron_3.h>
 #include<igit_geometry/Exact_predicates_exact_kernel.h>
@@ -15,6 +11,8 @@ enum BooleanOperation{
 #include<igit_geometry/Union_find.h>
 #include <iostream>
 #include <fstream>
+#include <unordered_map>
+#include <functional>
 #include"include/Mesh.h"
 #include<OpenMesh/Core/Mesh/AttribKernelT.hh>
 #include <OpenMesh/Core/IO/MeshIO.hh>
@@ -34,6 +32,23 @@ struct CGALtoOpenMesh{
     int Openindex;
     Mesh::Point point_axis;
 };
+//按double坐标精确比较的键,用于CGAL转OpenMesh时合并重合点;
+struct CGALtoOpenMeshKey{
+    double x,y,z;
+    CGALtoOpenMeshKey(double xx,double yy,double zz):x(xx+0.0),y(yy+0.0),z(zz+0.0){}//+0.0把-0.0变为0.0,与==比较一致
+    bool operator==(const CGALtoOpenMeshKey &other) const{
+        return x==other.x&&y==other.y&&z==other.z;
+    }
+};
+struct CGALtoOpenMeshKeyHash{
+    size_t operator()(const CGALtoOpenMeshKey &key) const{
+        std::hash<double> hasher;
+        size_t seed=hasher(key.x);
+        seed^=hasher(key.y)+0x9e3779b9+(seed<<6)+(seed>>2);
+        seed^=hasher(key.z)+0x9e3779b9+(seed<<6)+(seed>>2);
+        return seed;
+    }
+};
 template <class HDS>
 class Build_triangle : public CGAL::Modifier_base<HDS> {
 public:
@@ -104,30 +119,36 @@ public:
         else
             std::cout<<"action is wrong !"<<std::endl;
         // CGAL  to  openmesh
-        std::vector<CGALtoOpenMesh> Vector_CGALtoOpenmesh;  //同上，建立容器
+        return PolyhedronToOpenMesh(P12);
+    }
+    //CGAL多面体转OpenMesh;先遍历一次所有点建立CGAL点->OpenMesh索引的映射(坐标相同的点合并),再批量加面;时间与网格大小成线性;
+    Mesh PolyhedronToOpenMesh(const Polyhedron &P){
         Mesh CGAL_to_NewMesh;
-        for( FCI fi = P12.facets_begin(); fi != P12.facets_end(); ++fi){  //遍历输出后的，CGAL所有面
-            std::vector<OpenMesh::VertexHandle> FacePoint;
+        CGAL_to_NewMesh.reserve(P.size_of_vertices(),P.size_of_halfedges()/2,P.size_of_facets());
+        std::unordered_map<CGALtoOpenMeshKey,int,CGALtoOpenMeshKeyHash> Map_PointtoOpenmesh;//坐标->OpenMesh索引
+        std::unordered_map<const void*,int> Map_CGALtoOpenmesh;//CGAL点->OpenMesh索引
+        Map_PointtoOpenmesh.reserve(P.size_of_vertices());
+        Map_CGALtoOpenmesh.reserve(P.size_of_vertices());
+        for(VCI vi=P.vertices_begin();vi!=P.vertices_end();++vi){
+            double x_point=CGAL::to_double(vi->point().x());
+            double y_point=CGAL::to_double(vi->point().y());
+            double z_point=CGAL::to_double(vi->point().z());
+            CGALtoOpenMeshKey key(x_point,y_point,z_point);
+            auto found=Map_PointtoOpenmesh.find(key);
+            int Openindex;
+            if(found!=Map_PointtoOpenmesh.end()){//旧点
+                Openindex=found->second;
+            }else{//新点
+                Openindex=CGAL_to_NewMesh.add_vertex(Mesh::Point(x_point,y_point,z_point)).idx();
+                Map_PointtoOpenmesh[key]=Openindex;
+            }
+            Map_CGALtoOpenmesh[&*vi]=Openindex;
+        }
+        for( FCI fi = P.facets_begin(); fi != P.facets_end(); ++fi){  //遍历输出后的，CGAL所有面
+            OpenMesh::VertexHandle FacePoint[3];
             int f_js=0;//读取面的3各点
             for( HFCC hc = fi->facet_begin();f_js<3;++hc,f_js++){
-                double x_point=CGAL::to_double(hc->vertex()->point().x());
-                double y_point=CGAL::to_double(hc->vertex()->point().y());
-                double z_point=CGAL::to_double(hc->vertex()->point().z());
-                //判断是否是新点，CheckEixstP遍历所有点，对比是否存在。新点返回-1，旧点返回索引号
-                int Check_P =CheckEixstP(Vector_CGALtoOpenmesh,x_point,y_point,z_point);
-                if(Check_P!=-1){//旧点索引号进栈
-                    OpenMesh::VertexHandle old_P(Check_P);
-                    FacePoint.push_back(old_P);
-                }else{//新点
-                    CGALtoOpenMesh P_temp;
-                    P_temp.point_axis[0]=x_point;
-                    P_temp.point_axis[1]=y_point;
-                    P_temp.point_axis[2]=z_point;
-                    OpenMesh::VertexHandle new_P=CGAL_to_NewMesh.add_vertex(P_temp.point_axis);
-                    P_temp.Openindex=new_P.idx();//存索引号
-                    Vector_CGALtoOpenmesh.push_back(P_temp);
-                    FacePoint.push_back(new_P);
-                }
+                FacePoint[f_js]=OpenMesh::VertexHandle(Map_CGALtoOpenmesh[&*(hc->vertex())]);
             }
             CGAL_to_NewMesh.add_face(FacePoint[0],FacePoint[1],FacePoint[2]);//给面添加索引号
         }
@@ -161,18 +182,6 @@ private:
         N12 = N1.difference(N2);
         N12.closure().convert_to_polyhedron(P12);
     }
-    int CheckEixstP( std::vector<CGALtoOpenMesh> & Vector_CGALtoOpenmesh,double xx,double yy,double zz){
-        for(int i=0;i<Vector_CGALtoOpenmesh.size();i++){
-            if(Vector_CGALtoOpenmesh[i].point_axis[0]==xx){
-                if(Vector_CGALtoOpenmesh[i].point_axis[1]==yy){
-                    if(Vector_CGALtoOpenmesh[i].point_axis[2]==zz){
-                        return Vector_CGALtoOpenmesh[i].Openindex;
-                    }
-                }
-            }
-        }
-        return -1;
-    }
 };
 
 
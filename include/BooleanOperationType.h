@@ -0,0 +1,18 @@
+#ifndef BOOLEANOPERATIONTYPE_H
+#define BOOLEANOPERATIONTYPE_H
+
+//*****************************
+//布尔运算类型与引擎;单独成文件,使不依赖CGAL(igit_geometry)的代码也能使用;
+//*****************************
+enum BooleanOperation{
+    UNION,
+    INTERSECTION,
+    DIFFERENCE,
+};
+
+enum BooleanEngine{
+    NEF_POLYHEDRON_ENGINE,//CGAL Nef多面体(精确构造核),见TransformMode
+    IGL_MESH_BOOLEAN_ENGINE,//libigl自相交重网格化+缠绕数标记,见IglMeshBoolean.h;需以CONFIG+=igl_boolean编译
+};
+
+#endif // BOOLEANOPERATIONTYPE_H
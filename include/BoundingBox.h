@@ -9,13 +9,21 @@
 //  Created by sway on 6/12/15.
 //  Copyright (c) 2015 None. All rights reserved.
 //
-#include"QGLViewer/qglviewer.h"
 class BoundingBox {
 
 public:
+    //简单的三维向量（原为qglviewer::Vec，改为自定义类型使Mesh不再依赖QGLViewer，可在无图形界面的环境下使用）
+    class Vec {
+    public:
+        Vec() : x(0.0), y(0.0), z(0.0) {}
+        double x;
+        double y;
+        double z;
+    };
+
     BoundingBox(){}
     ~BoundingBox(){}
-    qglviewer::Vec origin;
-    qglviewer::Vec size;
+    Vec origin;
+    Vec size;
 };
 #endif // BOUNDINGBOX_H
@@ -4,29 +4,42 @@
 #include <iostream>
 #include <vector>
 
-#include <QProgressDialog>
+#include <QObject>
 #include <QVector>
+#include <QAtomicInt>
 
 #include <Eigen/Geometry>
 #include <Eigen/Dense>
 #include <Eigen/SparseCholesky>
 
 #include "Mesh.h"
+#include "MeshAnalysisView.h"
+#include "ProgressReporter.h"
 
 using namespace SW;
 using namespace std;
 
 #define KRING
 
+//LDLT分解中最小主元与最大主元之比低于该值时认为法方程病态，改用SVD求解
+#define QUADRIC_FIT_MIN_PIVOT_RATIO 1e-10
+
 /*
   由IGL库中principal_ccurvature.cpp中的同名类修改而来。
   其中searchType固定为K_RING_SEARCH，normalType固定为AVERAGE。
-  原类使用std::vector存储mesh数据，现改用OpenMesh半边数据结构，并加入OpenMP并行计算。
+  原类使用std::vector存储mesh数据，现改用MeshAnalysisView（顶点按Morton码重新编号的坐标、法向数组和CSR邻接表），并加入OpenMP并行计算。
 */
 class CurvatureComputer : public QObject
 {
     Q_OBJECT
 
+public:
+    enum FitMethod
+    {
+        FIT_NORMAL_EQUATION, //法方程+LDLT，平均曲率由形状算子的迹直接得到（默认）
+        FIT_SVD //JacobiSVD+SelfAdjointEigenSolver（原实现）
+    };
+
 private:
     class Quadric
     {
@@ -99,7 +112,40 @@ private:
             return 2.0*c();
         }
 
-        inline static Quadric fit(const QVector<Mesh::Point> &vv)
+        //累加5x5法方程(A^T*A)x=A^T*b，用定长LDLT分解求解，全程无堆内存分配；法方程病态时退回fitSVD
+        inline static Quadric fit(const vector<Mesh::Point> &vv)
+        {
+            assert(vv.size() >= 5);
+
+            Eigen::Matrix<double, 5, 5> AtA = Eigen::Matrix<double, 5, 5>::Zero();
+            Eigen::Matrix<double, 5, 1> Atb = Eigen::Matrix<double, 5, 1>::Zero();
+            Eigen::Matrix<double, 5, 1> row;
+
+            for(vector<Mesh::Point>::const_iterator vpi = vv.begin(); vpi != vv.end(); vpi++)
+            {
+                double u = (*vpi)[0];
+                double v = (*vpi)[1];
+                double n = (*vpi)[2];
+
+                row << u*u, u*v, v*v, u, v;
+                AtA.noalias() += row * row.transpose();
+                Atb.noalias() += row * n;
+            }
+
+            Eigen::LDLT< Eigen::Matrix<double, 5, 5> > ldlt(AtA);
+            Eigen::Matrix<double, 5, 1> pivots = ldlt.vectorD();
+            if(ldlt.info() != Eigen::Success || pivots.minCoeff() <= pivots.cwiseAbs().maxCoeff() * QUADRIC_FIT_MIN_PIVOT_RATIO)
+            {
+                return fitSVD(vv);
+            }
+
+            Eigen::Matrix<double, 5, 1> sol = ldlt.solve(Atb);
+
+            return Quadric(sol(0), sol(1), sol(2), sol(3), sol(4));
+        }
+
+        //对超定方程组A*x=b直接做JacobiSVD，数值最稳定但较慢（原实现）
+        inline static Quadric fitSVD(const vector<Mesh::Point> &vv)
         {
             int vvSize = vv.size();
             assert(vvSize >= 5);
@@ -110,7 +156,7 @@ private:
 
             Mesh::Point tempPoint;
             int c = 0;
-            for(QVector<Mesh::Point>::const_iterator vpi = vv.begin(); vpi != vv.end(); vpi++, c++)
+            for(vector<Mesh::Point>::const_iterator vpi = vv.begin(); vpi != vv.end(); vpi++, c++)
             {
                 tempPoint = *vpi;
                 float u = tempPoint[0];
@@ -132,67 +178,64 @@ private:
         }
     };
 
-    class comparer
-    {
-    public:
-        inline bool operator() (const pair<Mesh::VertexHandle, float> &lhs, const pair<Mesh::VertexHandle, float> &rhs) const
-        {
-            return lhs.second > rhs.second;
-        }
-    };
-
-    Mesh mMesh; //要计算曲率的Mesh
+    MeshAnalysisView mView; //要计算曲率的Mesh的分析视图，以下顶点索引均为视图索引（mCurvature等结果数组除外）
 
     int mKRing; //使用某顶点的mKRing邻域计算曲率
     float mSphere; //使用某顶点为圆心，mSphere为半径的球内顶点计算曲率
     bool mLocalMode; //使用该顶点处法向量(true)还是kRing邻域内法向量的平均值(false)
     bool mProjectionPlaneCheck; // Check collected vertices on tangent plane
+    FitMethod mFitMethod; //二次曲面拟合及曲率计算方法
 
-    QVector<float> mCurvature;
+    QVector<float> mCurvature; //按网格顶点索引排列
     QVector<bool> mCurvatureComputed; //whether current vertex's curvature has been correctly computed
 
-    class ThreadArguments
+    //每个线程独占的临时缓冲区，在该线程负责的所有顶点间重复使用，避免逐顶点分配内存
+    class ThreadBuffer
     {
     public:
-        CurvatureComputer *curvatureComputer;
-        QVector<Mesh::VertexHandle> *vertices;
-        int startVertexIndex;
-        int endVertexIndex;
-        int *completedVertexNum;
+        VertexAdjacency::SearchBuffer search; //邻域搜索的访问标记和队列
+        vector<int> vv; //邻域顶点
+        vector<int> vvtmp; //投影平面检查后的邻域顶点
+        vector<Mesh::Point> points; //邻域顶点在局部坐标系下的坐标
     };
 
 public:
-    CurvatureComputer(Mesh &mesh);
+    CurvatureComputer(const Mesh &mesh);
 
-    void computeCurvature(QProgressDialog *progress);
+    void computeCurvature(ProgressReporter *progress);
 
-    void getResult(QVector<float> &curvature, QVector<bool> &computed);
+    //只重新计算邻域（mKRing邻域或mSphere球）与移动过的顶点相交的顶点处的曲率，用于局部编辑后的增量更新
+    //mesh为已移动顶点后的网格（拓扑须与建立时相同），先由其刷新视图中移动顶点的坐标和法向；
+    //affectedVertexHandles返回被重新计算的顶点，curvature和computed与之一一对应
+    void recomputeCurvature(const Mesh &mesh, const QVector<Mesh::VertexHandle> &movedVertexHandles, QVector<Mesh::VertexHandle> &affectedVertexHandles, QVector<float> &curvature, QVector<bool> &computed);
 
-private:
-    static void* threadFun(void *arg);
+    void setFitMethod(FitMethod fitMethod);
 
-    void computeCurvature(QVector<Mesh::VertexHandle> &vertices, int startVertexIndex, int endVertexIndex, int *completedVertexNum);
+    //分别用两种拟合方法计算所有顶点的曲率，输出耗时及两者结果的差异，用于验证精度和比较速度
+    void benchmarkFitMethods(ProgressReporter *progress);
 
-    inline void getKRing(const Mesh::VertexHandle &centerVertexHandle, const int k, QVector<Mesh::VertexHandle> &vv);
+    void getResult(QVector<float> &curvature, QVector<bool> &computed);
 
-    inline void getSphere(const Mesh::VertexHandle &centerVertexHandle, const float r, const int min, QVector<Mesh::VertexHandle> &vv);
+private:
+    //计算单个顶点处的曲率，返回是否计算成功（各线程使用各自的buffer，可并行调用）
+    bool computeCurvature(int vertexIndex, ThreadBuffer &buffer, float &curvature);
 
-    inline float getAverageEdge(QProgressDialog *progress);
+    //获取曲率会受movedVertices移动影响的所有顶点
+    void getAffectedVertices(const QVector<int> &movedVertices, ThreadBuffer &buffer, QVector<int> &affectedVertices);
 
-    inline void applyProjOnPlane(const Mesh::Normal &ppn, const QVector<Mesh::VertexHandle> &vin, QVector<Mesh::VertexHandle> &vout);
+    inline void applyProjOnPlane(const Mesh::Normal &ppn, const vector<int> &vin, vector<int> &vout);
 
-    inline void getAverageNormal(const Mesh::VertexHandle &centerVertexHandle, const QVector<Mesh::VertexHandle> &vv, Mesh::Normal &normal);
+    inline void getAverageNormal(int centerVertexIndex, const vector<int> &vv, Mesh::Normal &normal);
 
-    inline void computeReferenceFrame(const Mesh::VertexHandle &centerVertexHandle, const Mesh::Normal &normal, QVector<Mesh::Point> &ref);
+    inline void computeReferenceFrame(int centerVertexIndex, const Mesh::Normal &normal, QVector<Mesh::Point> &ref);
 
     inline Mesh::Point project(const Mesh::Point &v, const Mesh::Point &vp, const Mesh::Normal &ppn);
 
-    inline void fitQuadric(const Mesh::Point &v, const QVector<Mesh::Point> &ref, const QVector<Mesh::VertexHandle> &vv, Quadric *q);
+    inline void fitQuadric(const Mesh::Point &v, const QVector<Mesh::Point> &ref, const vector<int> &vv, vector<Mesh::Point> &points, Quadric *q);
 
     inline float finalEigenStuff(Quadric &q);
 
-signals:
-    void progressValueChanged(int value);
+    inline float finalEigenStuffSolver(Quadric &q);
 
 };
 
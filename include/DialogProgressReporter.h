@@ -0,0 +1,35 @@
+#ifndef DIALOGPROGRESSREPORTER_H
+#define DIALOGPROGRESSREPORTER_H
+
+#include "ProgressReporter.h"
+
+#include <QObject>
+#include <QProgressDialog>
+
+//图形界面下的ProgressReporter，用模态QProgressDialog显示进度，用QMessageBox显示提示信息
+class DialogProgressReporter : public QObject, public ProgressReporter
+{
+private:
+    QWidget *mParentWidget;
+    QProgressDialog *mProgress;
+
+public:
+    //以parentWidget为父对象，随parentWidget一起销毁
+    DialogProgressReporter(QWidget *parentWidget);
+
+    void setWindowTitle(const QString &title);
+
+    void setLabelText(const QString &text);
+
+    void setMinimum(int minimum);
+
+    void setMaximum(int maximum);
+
+    void setValue(int value);
+
+    void close();
+
+    void showMessage(const QString &title, const QString &text);
+};
+
+#endif // DIALOGPROGRESSREPORTER_H
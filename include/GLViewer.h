@@ -14,6 +14,7 @@
 #include "include/LaplaceTransform.h"
 #include "QGLViewer/qglviewer.h"
 #include "include/Shader.h"
+#include "include/MeshRenderer.h"
 
 #include <QObject>
 #include <QMouseEvent>
@@ -82,6 +83,9 @@ public:
 
     void removeAllMeshes();
 
+    //第index个模型被直接修改(如getMesh后修改)后调用，下次绘制时将变化的数据同步到VBO
+    void updateMesh(int index);
+
     //为了解决每次重新构建项目时都需要注释ui_mainwindow.h中的两行的问题，添加下面两个空方法
     void setFrameShape(QFrame::Shape){}
     void setFrameShadow(QFrame::Shadow){}
@@ -108,6 +112,8 @@ protected:
     void setLighting(void);
     void initGLSL();
     void setMeshMaterial();
+    //画拉普拉斯变形中选中的控制点
+    void drawSelectedVertices(Mesh &mesh);
 
 
 public slots:
@@ -138,6 +144,9 @@ private:
     static SW::Shader m_shader;
     float m_length;
     QVector<Mesh> meshes;
+    //每个模型对应的VBO绘制器；removeAllMeshes后保留，重新添加模型时只上传变化的数据
+    QVector<MeshRenderer *> mMeshRenderers;
+    QVector<bool> mMeshChanged;
 
     bool displayVertices;
     bool displayWireFrame;
@@ -0,0 +1,59 @@
+#ifndef GEODESICPATHFINDER_H
+#define GEODESICPATHFINDER_H
+
+#include "Mesh.h"
+#include "VertexAdjacency.h"
+
+#include <QVector>
+
+#include <vector>
+
+using namespace SW;
+
+/*
+  网格边图上的加权最短路径搜索（A*，启发函数为到终点的直线距离）。
+  边(u, v)的代价为边长乘以终点v的权值，权值必须不小于1（保证启发函数不高估）。
+  距离、前驱和访问标记数组在多次搜索之间复用，访问标记用递增的搜索序号区分，不需要每次清零；
+  因此一个对象不能被多个线程同时使用，并行搜索时每个线程各建一个对象。
+*/
+class GeodesicPathFinder
+{
+private:
+    struct HeapNode
+    {
+        float priority; //已走距离+启发距离
+        int vertexIndex;
+
+        //std::push_heap默认是大顶堆，这里反过来比较以得到小顶堆
+        inline bool operator<(const HeapNode &other) const
+        {
+            return priority > other.priority;
+        }
+    };
+
+    const Mesh &mMesh;
+    const VertexAdjacency &mAdjacency;
+    const QVector<float> &mVertexWeights;
+
+    QVector<float> mDistances;
+    QVector<int> mPreviousVertices;
+    QVector<int> mSearchStamps; //顶点最近一次被访问时的搜索序号
+    QVector<bool> mClosed; //在当前搜索中（mSearchStamps等于mSearchStamp时）是否已确定最短距离
+    int mSearchStamp;
+    std::vector<HeapNode> mHeap;
+
+    qint64 mSearchNum; //累计搜索次数
+    qint64 mSearchedVertexNum; //累计出堆（确定最短距离）的顶点数
+
+public:
+    GeodesicPathFinder(const Mesh &mesh, const VertexAdjacency &adjacency, const QVector<float> &vertexWeights);
+
+    //搜索从sourceVertexIndex到targetVertexIndex的最短路径，path依次为路径上的顶点（包含两个端点），找不到路径时返回false
+    bool findPath(int sourceVertexIndex, int targetVertexIndex, QVector<int> &path);
+
+    qint64 searchNum() const;
+
+    qint64 searchedVertexNum() const;
+};
+
+#endif // GEODESICPATHFINDER_H
@@ -0,0 +1,20 @@
+#ifndef IGLMESHBOOLEAN_H
+#define IGLMESHBOOLEAN_H
+
+#include "Mesh.h"
+#include "BooleanOperationType.h"
+
+//*****************************
+//基于libigl的布尔运算:先对两个模型做自相交重网格化,再按缠绕数(winding number)标记保留的面;
+//只用过滤核(filtered kernel)判断,不需要把整个模型转为Nef多面体,比TransformMode快且省内存;
+//此文件不能包含BooleanOperation.h(igit_geometry与libigl使用的CGAL不能在同一编译单元中同时出现);
+//*****************************
+namespace SW
+{
+
+//与TransformMode保持一致:第二个模型先平移(0.1,0.11,0)再做运算;
+Mesh iglMeshBoolean(const Mesh &mesh1, const Mesh &mesh2, BooleanOperation type);
+
+}
+
+#endif // IGLMESHBOOLEAN_H
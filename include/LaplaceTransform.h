@@ -9,11 +9,19 @@
 #include<iostream>
 #include"include/Mesh.h"
 #include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
 #include <Eigen/Dense>
 #include<vector>
 #include <math.h>
 #include<time.h>
 
+//*****************************
+//局部(ROI)变形的默认邻域环数:只在控制点的k邻域内建立方程求解,k邻域之外的点固定不动;
+//每次拖动的计算量只与ROI大小有关,与整个模型的点数无关;
+//改为0(或调用LTransform::Set_ROI(0))则对整个模型求解;
+//*****************************
+#define LAPLACE_ROI_KRING 10
+
 namespace MHW
 {
 
@@ -31,19 +39,31 @@ public:
     int LMT_point_size;
     Eigen::SparseMatrix<double> spMat;//临接矩阵//构造拉普拉斯矩阵;
     Eigen::SparseMatrix<double> spMat_L;//拉普拉斯坐标系;
-    Eigen::SparseMatrix<double> *spMat_C;//选择矩阵;
+    std::vector<int> spMat_C_index;//选择矩阵(对角阵)中为1的行,即当前分解所对应的控制点索引;
     Eigen::SparseMatrix<double> spMat_V;//原坐标系;
+    Eigen::MatrixXd Mat_V;//原坐标系(稠密,用于构建控制点坐标矩阵);
     //  Eigen::SparseMatrix<double> spMat_U;//控制点坐标矩阵;
     Eigen::SparseMatrix<double> spMat_F;//整体位置保持控制矩阵;
     std::vector<double> DMat;//对角矩阵;
 
-    Eigen::MatrixXd  FC_spMat_A;//解方程AX=b的A项
+    Eigen::SparseMatrix<double> FC_spMat_A_base;//spMat^T*spMat+spMat_F,与控制点无关,构造时计算一次;
+    Eigen::SparseMatrix<double> FC_spMat_A;//解方程AX=b的A项(稀疏,非零元结构与FC_spMat_A_base相同);
+    Eigen::MatrixXd FC_spMat_B_L;//spMat^T*spMat_L,与控制点无关,构造时计算一次;
     Eigen::MatrixXd   FC_spMat_B_N3;////解方程AX=b的项
-    Eigen::LLT<Eigen::MatrixXd> lltOfA;//解方程用到的
+    Eigen::SimplicialLDLT< Eigen::SparseMatrix<double> > ldltOfA;//稀疏Cholesky分解;符号分析只在构造时做一次,控制点集合改变时才重新做数值分解;
+
+    int ROI_KRing;//ROI变形的邻域环数,0表示整体变形;
+    std::vector<int> ROI_Vertex;//ROI内点的全局索引,下标即ROI内的局部索引;
+    std::vector<int> ROI_LocalIndex;//全局索引->ROI内的局部索引,不在ROI内为-1;
+    Eigen::MatrixXd ROI_Mat_V;//ROI内点的原坐标;
+    Eigen::MatrixXd ROI_B_L;//ROI内的spMat^T*spMat_L(边界固定),控制点集合改变时计算一次;
+    Eigen::SimplicialLDLT< Eigen::SparseMatrix<double> > ldltOfROI;//ROI内方程的Cholesky分解;
+
+    void Set_ROI(int kRing);//设置ROI变形的邻域环数,0表示整体变形;
 
     void Run(SW::Mesh &Mesh, QVector<QVector<int> > Select_P_Array, SW::MVector MoveVectors);
     void Create_spMat_L();//拉普拉斯坐标系;
-    void Create_NewMatrix_V(SW::Mesh &Mesh,Eigen::SparseMatrix<double> &spMat_C,Eigen::SparseMatrix<double> &spMat_U,Eigen::SparseMatrix<double> &spMat_F);//输出新坐标系;
+    void Create_NewMatrix_V(SW::Mesh &Mesh,Eigen::MatrixXd &spMat_U);//输出新坐标系;
 private:
 
     void Create_DMat();//整体位置保持控制矩阵;
@@ -54,11 +74,18 @@ private:
     //构造函数调用
     //*****************************
     void Create_spMat_V();//原坐标系;
-    void Create_spMat_U(Eigen::SparseMatrix<double> &spMat_U);//控制点坐标矩阵;
-    void Create_spMat_C();//选择矩阵;
+    void Create_spMat_U(Eigen::MatrixXd &spMat_U);//控制点坐标矩阵;
+    void Create_spMat_C();//选择矩阵,并对A做数值分解;
+    bool Is_spMat_C_changed();//控制点集合是否与当前分解所用的不同;
     void Create_spMat_F();//整体位置保持控制矩阵;
     void Create_spMat();//构建拉普拉斯系数矩阵;
 
+    //*****************************
+    //ROI变形
+    //*****************************
+    void Create_ROI(SW::Mesh &Mesh);//提取控制点的k邻域并分解ROI内的方程;
+    void Create_NewMatrix_V_ROI(SW::Mesh &Mesh);//只求解并更新ROI内的点;
+
 };
 
 
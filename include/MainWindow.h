@@ -34,6 +34,7 @@
 
 #include"basicType.h"
 #include "ToothSegmentation.h"
+#include "ToothSegmentationHistory.h"
 #include"BooleanOperation.h"
 
 class QVBoxLayout;
@@ -70,6 +71,16 @@ public:
         return mCurrentProcessMode;
     }
 
+    void setBooleanEngine(BooleanEngine engine){
+        mBooleanEngine = engine;
+        actionBooleanEngineNefPolyhedron->setChecked(engine == NEF_POLYHEDRON_ENGINE);
+        actionBooleanEngineIglMeshBoolean->setChecked(engine == IGL_MESH_BOOLEAN_ENGINE);
+    }
+
+    BooleanEngine getBooleanEngine() const{
+        return mBooleanEngine;
+    }
+
 protected:
 
     virtual void keyPressEvent(QKeyEvent *);
@@ -85,6 +96,8 @@ protected slots:
     void doActionUnion();
     void doActionIntersection();
     void doActionDifference();
+    void doActionBooleanEngineNefPolyhedron();
+    void doActionBooleanEngineIglMeshBoolean();
 
     // Laplacian transformation
     void doActionLaplacianDeformation(bool checked);
@@ -118,6 +131,7 @@ public slots:
 private:
     void setAllManualOperationActionUnChecked();
     void setOtherManualOperationActionUnChecked(QAction *checkedAction);
+    void writeToothSegmentationProfile(); //输出牙齿分割各阶段统计报告（需通过环境变量启用）
 
 signals:
 
@@ -126,11 +140,11 @@ private:
     ProcessMode mCurrentProcessMode;
     Mesh mOriginalMeshForSegmentation;
     Mesh m_OrignalMeshForBooleanOpearion[2];
+    BooleanEngine mBooleanEngine;
 
     ToothSegmentation *mToothSegmentation;
     QVector<QAction *> mToothSegmentationManualOperationActions;
-    QVector<ToothSegmentation> mToothSegmentationHistory;
-    int mToothSegmentationUsingIndexInHistory;
+    ToothSegmentationHistory mToothSegmentationHistory; //牙齿分割的撤销/重做历史
 
 };
 
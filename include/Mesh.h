@@ -9,6 +9,9 @@
 //  Copyright (c) 2015 None. All rights reserved.
 //
 
+#include <QString>
+#include <QVector>
+
 #include <OpenMesh/Core/IO/MeshIO.hh>
 #include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
 #include "include/BoundingBox.h"
@@ -88,6 +91,8 @@ public:
     // 0--vertices 1-- wireframe 2-- flatLine
     // void draw(int flag); //mhw改201509079
 
+    //画OpenGL原点和BoundingBox（使用MeshRenderer绘制模型时由GLViewer调用）
+    void drawDecorations();
 
 private:
     //画OpenGL原点
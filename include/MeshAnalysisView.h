@@ -0,0 +1,171 @@
+#ifndef MESHANALYSISVIEW_H
+#define MESHANALYSISVIEW_H
+
+#include "Mesh.h"
+#include "VertexAdjacency.h"
+
+#include <QVector>
+
+#include <vector>
+
+using namespace SW;
+
+/*
+  网格的只读分析视图，供曲率计算、区域生长、k邻域查询、形态学操作等只按顶点访问的算法使用。
+  顶点坐标和法向按分量分别存储在连续数组中（SoA），1邻域为CSR邻接表（VertexAdjacency），
+  遍历时不再经过半边结构和分散的属性数组。
+  建立时可将顶点按Morton码（空间填充曲线）重新编号，使空间上相邻的顶点在数组中也相邻；
+  视图中的顶点编号（视图索引）与网格顶点索引通过meshIndex()/viewIndex()互相转换，
+  计算结果可用toMeshOrder()按网格顶点顺序写回。
+  只依赖建立时的网格数据：顶点移动后需调用updateGeometry()，拓扑改变后需重新build()。
+*/
+class MeshAnalysisView
+{
+private:
+    QVector<float> mPositionX, mPositionY, mPositionZ;
+    QVector<float> mNormalX, mNormalY, mNormalZ; //与OpenMesh的update_normals()结果相同（面法向之和单位化）
+    VertexAdjacency mAdjacency; //使用视图索引
+    QVector<int> mViewToMesh; //视图索引对应的网格顶点索引，未重新编号时为空
+    QVector<int> mMeshToView; //网格顶点索引对应的视图索引，未重新编号时为空
+    Mesh::Point mBoundingBoxMin, mBoundingBoxMax;
+
+public:
+    MeshAnalysisView();
+
+    //由mesh建立视图，reorder为true时按Morton码重新编号顶点
+    void build(const Mesh &mesh, bool reorder = false);
+
+    //顶点移动后（拓扑不变）重新读取坐标并计算法向
+    void updateGeometry(const Mesh &mesh);
+
+    //只有movedVertexHandles移动时，只重新读取这些顶点的坐标，并重新计算它们及其1邻域的法向（包围盒只扩大不缩小）
+    void updateGeometry(const Mesh &mesh, const QVector<Mesh::VertexHandle> &movedVertexHandles);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    inline int vertexNum() const
+    {
+        return mPositionX.size();
+    }
+
+    inline bool isReordered() const
+    {
+        return !mViewToMesh.isEmpty();
+    }
+
+    inline const VertexAdjacency &adjacency() const
+    {
+        return mAdjacency;
+    }
+
+    inline int meshIndex(int viewIndex) const
+    {
+        return isReordered() ? mViewToMesh.at(viewIndex) : viewIndex;
+    }
+
+    inline int viewIndex(int meshIndex) const
+    {
+        return isReordered() ? mMeshToView.at(meshIndex) : meshIndex;
+    }
+
+    inline Mesh::VertexHandle vertexHandle(int viewIndex) const
+    {
+        return Mesh::VertexHandle(meshIndex(viewIndex));
+    }
+
+    inline Mesh::Point point(int viewIndex) const
+    {
+        return Mesh::Point(mPositionX.at(viewIndex), mPositionY.at(viewIndex), mPositionZ.at(viewIndex));
+    }
+
+    inline Mesh::Normal normal(int viewIndex) const
+    {
+        return Mesh::Normal(mNormalX.at(viewIndex), mNormalY.at(viewIndex), mNormalZ.at(viewIndex));
+    }
+
+    //坐标和法向的各分量数组（按视图索引），component为0、1、2分别对应x、y、z
+    inline const float *positions(int component) const
+    {
+        return (component == 0 ? mPositionX : (component == 1 ? mPositionY : mPositionZ)).constData();
+    }
+
+    inline const float *normals(int component) const
+    {
+        return (component == 0 ? mNormalX : (component == 1 ? mNormalY : mNormalZ)).constData();
+    }
+
+    //包围盒的最小、最大顶点
+    inline const Mesh::Point &boundingBoxMin() const
+    {
+        return mBoundingBoxMin;
+    }
+
+    inline const Mesh::Point &boundingBoxMax() const
+    {
+        return mBoundingBoxMax;
+    }
+
+    //centerIndex的k邻域（含自身），见VertexAdjacency::kRing
+    inline void kRing(int centerIndex, int k, VertexAdjacency::SearchBuffer &buffer, std::vector<int> &ring) const
+    {
+        mAdjacency.kRing(centerIndex, k, buffer, ring);
+    }
+
+    //沿网格扩展，取与centerIndex的欧氏距离小于radius的顶点；不足minNum个时按距离由近到远补足
+    void sphere(int centerIndex, float radius, int minNum, VertexAdjacency::SearchBuffer &buffer, std::vector<int> &neighborhood) const;
+
+    //按视图索引排列的数组转换为按网格顶点索引排列，及其逆转换
+    template<typename T>
+    void toMeshOrder(const QVector<T> &viewValues, QVector<T> &meshValues) const
+    {
+        if(!isReordered())
+        {
+            meshValues = viewValues;
+            return;
+        }
+        int vertexNum = this->vertexNum();
+        meshValues.resize(vertexNum);
+        const T *source = viewValues.constData();
+        T *target = meshValues.data();
+        const int *viewToMesh = mViewToMesh.constData();
+#pragma omp parallel for schedule(static)
+        for(int viewIndex = 0; viewIndex < vertexNum; viewIndex++)
+        {
+            target[viewToMesh[viewIndex]] = source[viewIndex];
+        }
+    }
+
+    template<typename T>
+    void toViewOrder(const QVector<T> &meshValues, QVector<T> &viewValues) const
+    {
+        if(!isReordered())
+        {
+            viewValues = meshValues;
+            return;
+        }
+        int vertexNum = this->vertexNum();
+        viewValues.resize(vertexNum);
+        const T *source = meshValues.constData();
+        T *target = viewValues.data();
+        const int *viewToMesh = mViewToMesh.constData();
+#pragma omp parallel for schedule(static)
+        for(int viewIndex = 0; viewIndex < vertexNum; viewIndex++)
+        {
+            target[viewIndex] = source[viewToMesh[viewIndex]];
+        }
+    }
+
+private:
+    //读取坐标（按当前编号）和包围盒
+    void gatherPositions(const Mesh &mesh);
+
+    //由当前坐标计算各顶点按Morton码排序后的顺序
+    void computeMortonOrder(QVector<int> &vertexOrder) const;
+
+    //计算面法向并累加为顶点法向
+    void computeNormals(const Mesh &mesh);
+};
+
+#endif // MESHANALYSISVIEW_H
@@ -0,0 +1,49 @@
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include "Mesh.h"
+
+#include <QString>
+#include <QVector>
+
+using namespace SW;
+
+/*
+  模型文件的快速读取。
+  *.obj和*.off（不带颜色、法向等附加数据的纯文本格式）将文件映射到内存后按行分块，用OpenMP并行解析数字；
+  二进制*.stl直接读取面片数组，用哈希表合并重合的顶点；其他格式（*.ply、ASCII STL、COFF等）仍由OpenMesh读取。
+  读取成功后在用户缓存目录（cacheDirectory()）中写入二进制缓存（顶点坐标、三角形索引和顶点法向），
+  之后再打开同一文件（大小和以毫秒计的修改时间未变）时直接映射缓存文件建立网格，不再解析文本。
+  建立网格时add_face失败的面（非流形）与OpenMesh相同，复制其顶点后作为孤立面加入。
+*/
+class MeshLoader
+{
+private:
+    //解析得到的三角网格数据，多边形已按扇形三角化
+    struct MeshData
+    {
+        QVector<float> positions; //每个顶点3个坐标
+        QVector<int> triangles; //每个三角形3个顶点索引
+    };
+
+    static bool parseObj(const char *data, qint64 size, MeshData &meshData);
+    static bool parseOff(const char *data, qint64 size, MeshData &meshData);
+    static bool parseBinaryStl(const char *data, qint64 size, MeshData &meshData);
+
+    static void buildMesh(const float *positions, int vertexNum, const int *triangles, int triangleNum, Mesh &mesh);
+
+    static bool readCache(const QString &filename, Mesh &mesh);
+    static bool writeCache(const QString &filename, const Mesh &mesh);
+
+public:
+    //读取filename到mesh（mesh中原有的数据被清除），useCache为false时不读写缓存文件
+    static bool load(const QString &filename, Mesh &mesh, bool useCache = true);
+
+    //缓存文件所在目录（Qt5为QStandardPaths::CacheLocation下的meshcache目录，取不到时使用临时目录）
+    static QString cacheDirectory();
+
+    //filename对应的缓存文件名（<模型文件名>.<绝对路径的哈希>.meshcache）
+    static QString cacheFilename(const QString &filename);
+};
+
+#endif // MESHLOADER_H
@@ -0,0 +1,65 @@
+#ifndef MESHRENDERER_H
+#define MESHRENDERER_H
+
+#include "Mesh.h"
+
+#include <QVector>
+
+#include <GL/gl.h>
+
+using namespace SW;
+
+/*
+  模型的VBO绘制器（保留模式）。
+  update()把模型的顶点坐标、法向量、颜色、三角形索引和边索引整理成数组，与上次上传的数组逐项比较，
+  只重新上传发生变化的部分（例如paintClassifiedBoundary之后只上传颜色），绘制时不再遍历模型。
+  flatLine模式另用一组各面片顶点不共享的数组，每个面片使用其面片法向量和顶点颜色的平均值（与Mesh::draw相同）。
+  调用update()、draw()和析构时，需保证绘制所用的OpenGL上下文为当前上下文。
+*/
+class MeshRenderer
+{
+private:
+    enum BufferType{POSITION_BUFFER, NORMAL_BUFFER, COLOR_BUFFER, FACE_INDEX_BUFFER, EDGE_INDEX_BUFFER,
+                    FLAT_POSITION_BUFFER, FLAT_NORMAL_BUFFER, FLAT_COLOR_BUFFER, BUFFER_NUM};
+
+    GLuint mBuffers[BUFFER_NUM];
+    int mBufferBytes[BUFFER_NUM]; //各缓冲区当前已分配的字节数
+    bool mBuffersCreated;
+
+    //上次上传的数据，用于判断哪些属性发生了变化
+    QVector<GLfloat> mPositions;
+    QVector<GLfloat> mNormals;
+    QVector<GLfloat> mColors;
+    QVector<GLuint> mFaceIndices;
+    QVector<GLuint> mEdgeIndices;
+
+public:
+    MeshRenderer();
+    ~MeshRenderer();
+
+    //同步模型数据，只上传变化的属性
+    void update(const Mesh &mesh);
+
+    //0--vertices 1--wireframe 2--flatLine，与Mesh::draw的flag相同
+    void draw(int flag);
+
+    //删除所有缓冲区
+    void release();
+
+private:
+    MeshRenderer(const MeshRenderer &);
+    MeshRenderer &operator=(const MeshRenderer &);
+
+    //由顶点坐标和三角形索引计算顶点法向量（相邻面片法向量按面积加权平均）
+    void computeNormals();
+
+    //由顶点坐标和三角形索引生成flatLine模式下各面片的顶点坐标和面片法向量，并上传
+    void uploadFlatGeometry();
+
+    //由顶点颜色和三角形索引生成flatLine模式下各面片的颜色（顶点颜色的平均值），并上传
+    void uploadFlatColors();
+
+    void uploadBuffer(BufferType type, GLenum target, const void *data, int bytes);
+};
+
+#endif // MESHRENDERER_H
@@ -0,0 +1,58 @@
+#ifndef PROGRESSREPORTER_H
+#define PROGRESSREPORTER_H
+
+#include <QString>
+
+/*
+  进度及提示信息的输出接口。
+  ToothSegmentation和CurvatureComputer只通过此接口报告进度和提示信息，不直接依赖QProgressDialog和QMessageBox，
+  从而可以在没有图形界面的环境（如批处理命令行程序）下运行。
+  图形界面下使用DialogProgressReporter，命令行下使用ConsoleProgressReporter。
+*/
+class ProgressReporter
+{
+public:
+    virtual ~ProgressReporter() {}
+
+    virtual void setWindowTitle(const QString &title) = 0;
+
+    virtual void setLabelText(const QString &text) = 0;
+
+    virtual void setMinimum(int minimum) = 0;
+
+    virtual void setMaximum(int maximum) = 0;
+
+    virtual void setValue(int value) = 0;
+
+    virtual void close() = 0;
+
+    //显示提示信息（图形界面下弹出对话框）
+    virtual void showMessage(const QString &title, const QString &text) = 0;
+};
+
+//将阶段名称和提示信息输出到终端，忽略逐顶点的进度值
+class ConsoleProgressReporter : public ProgressReporter
+{
+private:
+    QString mPrefix; //输出的每行信息的前缀（如正在处理的文件名，多个进程同时输出时便于区分）
+    QString mLabelText;
+
+public:
+    ConsoleProgressReporter(const QString &prefix = QString());
+
+    void setWindowTitle(const QString &title);
+
+    void setLabelText(const QString &text);
+
+    void setMinimum(int minimum);
+
+    void setMaximum(int maximum);
+
+    void setValue(int value);
+
+    void close();
+
+    void showMessage(const QString &title, const QString &text);
+};
+
+#endif // PROGRESSREPORTER_H
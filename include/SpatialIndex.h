@@ -0,0 +1,73 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include "Mesh.h"
+
+#include <QVector>
+#include <QPoint>
+#include <QPair>
+
+using namespace SW;
+
+/*
+  点集的k近邻/半径搜索索引（kd树）。
+  建立时只对点的索引数组排序（每层按包围盒最长轴取中位数划分），不复制或移动点本身；
+  成员都是QVector，拷贝时隐式共享，随ToothSegmentation一起拷贝（撤销历史等）几乎没有开销。
+  所有查询都是只读的，可以在多个线程中同时进行，批量查询接口内部用OpenMP并行。
+  二维点（屏幕坐标）按z=0的三维点处理。
+*/
+class SpatialIndex
+{
+private:
+    struct Node
+    {
+        int begin, end; //该节点包含的点在mPointIndices中的范围
+        int left, right; //子节点在mNodes中的位置，叶子节点为-1
+        int splitAxis;
+        float splitValue;
+    };
+
+    QVector<Mesh::Point> mPoints;
+    QVector<int> mPointIndices; //按kd树划分重排后的点索引
+    QVector<Node> mNodes; //mNodes[0]为根节点
+
+    static const int LEAF_SIZE = 8; //叶子节点最多包含的点数
+
+public:
+    SpatialIndex();
+
+    //对points建立索引（之前的索引被替换）
+    void build(const QVector<Mesh::Point> &points);
+    void build(const QVector<QPoint> &points);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    int size() const;
+
+    //距离query最近的点的索引，索引为空时返回-1
+    int nearest(const Mesh::Point &query) const;
+
+    //距离query最近的k个点的索引（按距离从近到远排列）
+    void kNearest(const Mesh::Point &query, int k, QVector<int> &result) const;
+
+    //距离query不超过radius的所有点的索引（不排序）
+    void radiusSearch(const Mesh::Point &query, float radius, QVector<int> &result) const;
+
+    //批量k近邻搜索（querys中每个点的前k个最近点，并行计算）
+    QVector< QVector<int> > kNearestNeighbours(int k, const QVector<Mesh::Point> &querys) const;
+    QVector< QVector<int> > kNearestNeighbours(int k, const QVector<QPoint> &querys) const;
+
+    //批量半径搜索（并行计算）
+    QVector< QVector<int> > radiusNeighbours(float radius, const QVector<Mesh::Point> &querys) const;
+
+private:
+    int buildNode(int begin, int end);
+
+    void kNearest(int nodeIndex, const Mesh::Point &query, int k, QVector< QPair<float, int> > &heap) const;
+
+    void radiusSearch(int nodeIndex, const Mesh::Point &query, float squaredRadius, QVector<int> &result) const;
+};
+
+#endif // SPATIALINDEX_H
@@ -0,0 +1,91 @@
+#ifndef STAGEPROFILER_H
+#define STAGEPROFILER_H
+
+#include <QString>
+#include <QVector>
+#include <QPair>
+#include <QElapsedTimer>
+
+/*
+  牙齿分割各阶段及其子步骤的耗时、计数和内存统计。
+  在需要统计的函数开头定义一个StageProfiler::Scope，离开作用域时自动记录耗时，嵌套的Scope记为子步骤；
+  addCounter将计数累加到最内层的Scope上（如访问的顶点数、迭代次数、kNN查询次数）。
+  内存为进程常驻内存，在Scope开始、结束及每次addCounter时采样，Scope的峰值包含其子步骤中的采样。
+  默认关闭，关闭时Scope和addCounter只判断一次静态bool，几乎没有开销。
+  只能在主线程（OpenMP并行区域之外）使用，并行区域内的计数先归约再调用addCounter。
+*/
+class StageProfiler
+{
+public:
+    struct Record
+    {
+        QString name; //各层Scope名称以"/"连接，如"RefineToothBoundary/ConnectContourSections"
+        int depth;
+        qint64 startNanoseconds; //相对于reset()的开始时间
+        qint64 elapsedNanoseconds;
+        qint64 memoryStartKB, memoryEndKB, memoryPeakKB;
+        QVector< QPair<QString, qint64> > counters;
+    };
+
+    class Scope
+    {
+    private:
+        int mRecordIndex; //未启用时为-1
+
+    public:
+        explicit Scope(const char *name)
+        {
+            mRecordIndex = sEnabled ? begin(name) : -1;
+        }
+
+        ~Scope()
+        {
+            if(mRecordIndex >= 0)
+            {
+                end(mRecordIndex);
+            }
+        }
+    };
+
+private:
+    static bool sEnabled;
+    static QVector<Record> sRecords;
+    static QVector<int> sOpenRecordIndices; //当前未结束的Scope（由外到内）
+    static QElapsedTimer sTimer;
+
+    static int begin(const char *name);
+    static void end(int recordIndex);
+    static void addCounterImpl(const char *name, qint64 value);
+    static void sampleMemory();
+
+public:
+    static void setEnabled(bool enabled);
+
+    static inline bool isEnabled()
+    {
+        return sEnabled;
+    }
+
+    //清空已有记录，重新开始计时（每处理一个模型调用一次）
+    static void reset();
+
+    static inline void addCounter(const char *name, qint64 value)
+    {
+        if(sEnabled)
+        {
+            addCounterImpl(name, value);
+        }
+    }
+
+    static const QVector<Record>& records();
+
+    //当前进程常驻内存和峰值常驻内存（KB），不支持的平台返回0
+    static qint64 currentMemoryKB();
+    static qint64 peakMemoryKB();
+
+    //输出报告，runName为本次运行的名称（如模型文件名）
+    static bool writeJson(const QString &filename, const QString &runName);
+    static bool writeCsv(const QString &filename, const QString &runName);
+};
+
+#endif // STAGEPROFILER_H
@@ -2,8 +2,22 @@
 #define TOOTHSEGMENTATION_H
 
 #include "Mesh.h"
+#include "ProgressReporter.h"
+#include "SpatialIndex.h"
+#include "VertexAdjacency.h"
 
-#include <QProgressDialog>
+#include <QObject>
+#include <QPoint>
+
+//定义TOOTH_SEGMENTATION_HEADLESS时不编译依赖OpenGL和Qt图形界面的交互功能（鼠标编辑、自定义鼠标形状等），
+//只保留可在无图形界面环境下运行的分割流程（见ToothSegmentationBatch）
+#ifndef TOOTH_SEGMENTATION_HEADLESS
+class QWidget;
+class QMouseEvent;
+class QKeyEvent;
+#endif
+
+class CurvatureComputer;
 
 using namespace SW;
 using namespace std;
@@ -12,6 +26,8 @@ class ToothSegmentation : public QObject
 {
     Q_OBJECT
 
+    friend class ToothSegmentationHistory; //撤销/重做时需要直接读写顶点属性和分割状态
+
 public:
     enum BoundaryVertexType
     {
@@ -62,8 +78,10 @@ public:
     };
 
 private:
+#ifndef TOOTH_SEGMENTATION_HEADLESS
     QWidget *mParentWidget;
-    QProgressDialog *mProgress;
+#endif
+    ProgressReporter *mProgress; //进度及提示信息输出，不归ToothSegmentation所有
 
     Mesh mToothMesh; //牙齿模型网格
     Mesh mTempToothMesh; //用于保存ToothMesh的临时状态
@@ -106,6 +124,10 @@ private:
 
     QVector<Mesh::Point> mToothMeshVertices;
     QVector<Mesh::VertexHandle> mToothMeshVertexHandles;
+    SpatialIndex mToothMeshVertexIndex; //mToothMeshVertices的近邻搜索索引（第一次搜索时建立，顶点坐标改变时清空）
+    VertexAdjacency mToothMeshAdjacency; //mToothMesh的顶点邻接表（第一次使用时建立，只依赖拓扑，更换模型时清空）
+    VertexAdjacency::SearchBuffer mKRingSearchBuffer; //getKRing的访问标记和队列（只是临时缓冲区，不随copyFrom复制）
+    CurvatureComputer *mCurvatureComputer; //computeCurvature中建立并保留，移动顶点后用于增量更新曲率（不随copyFrom复制，更换模型时删除）
 
     QVector<Mesh::VertexHandle> mErrorRegionVertexHandles; //记录属于ERROR_REGION的顶点
 
@@ -115,12 +137,19 @@ private:
     QVector<QPoint> mMouseTrack; //鼠标拖动轨迹
 
 public:
+#ifndef TOOTH_SEGMENTATION_HEADLESS
+    //图形界面下使用，进度和提示信息显示在parentWidget之上的对话框中
     ToothSegmentation(QWidget *parentWidget, const Mesh &toothMesh);
+#endif
+
+    ToothSegmentation(ProgressReporter *progress, const Mesh &toothMesh);
 
     ToothSegmentation();
 
     ToothSegmentation(const ToothSegmentation &toothSegmentation);
 
+    ~ToothSegmentation();
+
     ToothSegmentation& operator=(const ToothSegmentation &toothSegmentation);
 
     void copyFrom(const ToothSegmentation &toothSegmentation);
@@ -144,8 +173,10 @@ public:
     //6. Refine tooth boundary
     void refineToothBoundary(bool loadStateFromFile);
 
+#ifndef TOOTH_SEGMENTATION_HEADLESS
     //设置自定义鼠标形状
     void setCustomCursor(CursorType cursorType);
+#endif
 
     //获取程序当前运行进度
     ProgramScheduleValues getProgramSchedule();
@@ -156,6 +187,9 @@ public:
     //是否显示ExtraMesh
     bool shouldShowExtraMesh();
 
+    //保存每个顶点的分割标签（每行一个整数：非边界区域为其NonBoundaryRegionType，边界点为-3）
+    bool saveVertexLabels(string filename);
+
 private:
     void setToothMesh(const Mesh &toothMesh);
 
@@ -177,6 +211,9 @@ private:
     //计算曲率
     void computeCurvature();
 
+    //mToothMesh中部分顶点移动后，只重新计算邻域与movedVertexHandles相交的顶点处的曲率，并写入到Mesh
+    void updateCurvature(const QVector<Mesh::VertexHandle> &movedVertexHandles);
+
     //将曲率转换成灰度，再转换成伪彩色，将伪彩色信息写入到顶点颜色属性
     void curvature2PseudoColor();
 
@@ -192,9 +229,6 @@ private:
     //边界点着色
     void paintBoundaryVertices();
 
-    //边界点分类，classifiedBoundaryVertexNum返回各类边界点数量
-    void classifyBoundaryVertex(int *classifiedBoundaryVertexNum);
-
     //分类后的边界点着色
     void paintClassifiedBoundaryVertices();
 
@@ -204,7 +238,7 @@ private:
     //标记牙龈区域，返回牙龈区域个数，可据此判断是否需要对牙龈分割平面进行翻转
     int markNonBoundaryRegion();
 
-    //区域生长，返回该区域的顶点数量。如果regionType为TEMP_REGION，则只计算该区域的顶点数量，visited属性不变为true，也就是说可以再次进行区域生长；如果regionType为FILL_BOUNDARY_REGION，则将此区域填充为边界
+    //区域生长（经过所有相连的非边界点，与visited属性无关），返回该区域的顶点数量。如果regionType为TEMP_REGION，则只计算该区域的顶点数量，不修改任何属性；如果regionType为FILL_BOUNDARY_REGION，则将此区域填充为边界
     int regionGrowing(Mesh::VertexHandle vertexHandle, int regionType);
 
     //非边界区域分类着色
@@ -225,17 +259,17 @@ private:
     //创建一个平面，存放在mExtraMesh中（point：平面过一点，normal：平面法向量，size：平面正方形边长）
     void createPlaneInExtraMesh(Mesh::Point point, Mesh::Normal normal, float size);
 
-    //保存当前状态（stateSymbol：要保存的状态的标志，返回是否保存成功）
-    bool saveState(string stateSymbol);
+    //保存当前状态（stateSymbol：要保存的状态的标志，compress：是否压缩各列数据，返回是否保存成功）
+    bool saveState(string stateSymbol, bool compress = false);
 
     //读取保存的状态（stateSymbol：要读取的状态的标志，返回是否读取成功）
     bool loadState(string stateSymbol);
 
-    //基于PCL的3维点云K近邻搜索（querys中各点到points的最近距离），TODO 将工程中用到的所有STL转换为QTL
-    QVector< QVector<int> > kNearestNeighbours(int Knn, const QVector<Mesh::Point> &querys, const QVector<Mesh::Point> &points);
+    //mToothMeshVertices的近邻搜索索引，索引已清空（模型顶点坐标改变）时重新建立
+    const SpatialIndex &toothMeshVertexIndex();
 
-    //基于PCL的2维点云K近邻搜索（querys中各点到points的最近距离）
-    QVector< QVector<int> > kNearestNeighbours(int Knn, const QVector<QPoint> &querys, const QVector<QPoint> &points);
+    //mToothMesh的顶点邻接表，未建立或顶点数不一致时重新建立
+    const VertexAdjacency &toothMeshAdjacency();
 
     //分类后的边界着色
     void paintClassifiedBoundary();
@@ -264,24 +298,21 @@ private:
     //计算两个向量夹角的cot值
     float cot(const Mesh::Point &vector1, const Mesh::Point &vector2) const;*/
 
+#ifndef TOOTH_SEGMENTATION_HEADLESS
     //将屏幕2维坐标转换为模型3维坐标
     inline Mesh::Point screenCoordinate2Model3DCoordinate(const int screenX, const int screenY);
 
-    //将模型3维坐标转换为屏幕2维坐标
-    inline void model3DCoordinate2ScreenCoordinate(const Mesh::Point modelPoint, int &screenX, int &screenY, float &depth);
-
     //计算两点之间距离
     inline float distance(Mesh::Point point1, Mesh::Point point2);
 
-    //判断某顶点是否可见
-    inline bool isVisiable(Mesh::VertexHandle vertexHandle);
-
-    //根据mMouseTrack获取鼠标拖动时选中的所有可见的顶点
+    //根据mMouseTrack获取鼠标拖动时选中的所有可见的顶点（通过VisibilityBuffer一次计算所有顶点的屏幕坐标和可见性）
     QVector<Mesh::VertexHandle> getSelectedVertices();
+#endif
 
     //更新程序运行状态
     void updateProgramSchedule(ProgramScheduleValues programSchedule);
 
+#ifndef TOOTH_SEGMENTATION_HEADLESS
 public slots:
     //鼠标右键点击显示顶点属性信息
     void mousePressEventShowVertexAttributes(QMouseEvent *e);
@@ -306,6 +337,7 @@ public slots:
 
     //按键“Ctrl” + “+/-”调整鼠标(画笔)半径（用于添加或去除边界点）（在automaticCuttingOfGingiva之后使用）
     void keyPressEventChangeMouseRadius(QKeyEvent *e);
+#endif
 
 signals:
     //通知主窗口类保存历史状态，以便撤销操作
@@ -0,0 +1,116 @@
+#ifndef TOOTHSEGMENTATIONHISTORY_H
+#define TOOTHSEGMENTATIONHISTORY_H
+
+#include "ToothSegmentation.h"
+
+#include <QList>
+#include <QVector>
+#include <QSharedPointer>
+
+/*
+  牙齿分割的撤销/重做历史。
+  自动执行的步骤（可能改变所有状态）保存为完整的检查点（ToothSegmentation副本）；
+  手动操作（添加/去除边界点、删除错误区域、删除错误轮廓段）只改变顶点属性和颜色，只记录发生变化的顶点在操作前后的属性值。
+  相邻两步之间撤销/重做只需修改发生变化的顶点；每隔若干个增量记录保存一个检查点，历史记录数超过上限时丢弃最早的记录，以限制内存占用。
+*/
+class ToothSegmentationHistory
+{
+private:
+    //手动操作会改变的顶点属性
+    struct VertexState
+    {
+        bool isToothBoundary;
+        int boundaryVertexType;
+        int nonBoundaryRegionType;
+        bool regionGrowingVisited;
+        int boundaryType;
+        int searchContourSectionVisited;
+        Mesh::Color color;
+
+        bool operator!=(const VertexState &other) const;
+    };
+
+    struct VertexChange
+    {
+        int vertexIndex;
+        VertexState before;
+        VertexState after;
+    };
+
+    //顶点属性之外的状态（数据量与边界点数相当）
+    struct SegmentationState
+    {
+        ToothSegmentation::ProgramScheduleValues programSchedule;
+        int boundaryVertexNum;
+        int toothNum;
+        Mesh::Point gingivaCuttingPlanePoint;
+        Mesh::Normal gingivaCuttingPlaneNormal;
+        bool gingivaCuttingPlaneComputed;
+        QVector<Mesh::VertexHandle> cuttingPointHandles;
+        QVector<Mesh::VertexHandle> jointPointHandles;
+        QVector< QVector<Mesh::VertexHandle> > contourSections;
+        QVector<Mesh::VertexHandle> errorRegionVertexHandles;
+        ToothSegmentation::CursorType cursorType;
+        int circleCursorRadius;
+    };
+
+    struct Entry
+    {
+        QSharedPointer<ToothSegmentation> checkpoint; //为空时为增量记录
+        QVector<VertexChange> vertexChanges; //相对于上一条记录发生变化的顶点
+        SegmentationState state; //此记录之后的状态
+    };
+
+    QList<Entry> mEntries;
+    int mCurrentIndex; //当前状态对应的记录
+    QSharedPointer<ToothSegmentation> mInitialState; //最初的状态（丢弃早期记录后仍保留，用于退出分割时恢复模型）
+    QVector<VertexState> mCurrentVertexStates; //当前状态下所有顶点的属性，用于计算下一条增量记录
+
+    int mCheckpointInterval; //每隔多少条增量记录保存一个检查点
+    int mMaxEntryNum; //历史记录数上限
+
+public:
+    ToothSegmentationHistory(int checkpointInterval = 20, int maxEntryNum = 100);
+
+    //清空历史，并将toothSegmentation作为最初的状态
+    void reset(const ToothSegmentation &toothSegmentation);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    //保存完整的检查点（用于自动执行的步骤）
+    void saveCheckpoint(const ToothSegmentation &toothSegmentation);
+
+    //保存增量记录（用于手动操作，只记录发生变化的顶点）
+    void saveDelta(const ToothSegmentation &toothSegmentation);
+
+    //撤销，返回是否有可撤销的记录
+    bool undo(ToothSegmentation &toothSegmentation);
+
+    //重做，返回是否有可重做的记录
+    bool redo(ToothSegmentation &toothSegmentation);
+
+    //恢复到最初的状态
+    void restoreInitialState(ToothSegmentation &toothSegmentation) const;
+
+private:
+    void moveTo(ToothSegmentation &toothSegmentation, int targetIndex);
+
+    //丢弃当前记录之后（已撤销）的记录
+    void removeRedoEntries();
+
+    //记录数超过上限时丢弃最早的记录（保证第一条记录为检查点）
+    void removeOldEntries();
+
+    int deltaNumSinceCheckpoint() const;
+
+    VertexState captureVertexState(const ToothSegmentation &toothSegmentation, const Mesh::VertexHandle &vertexHandle) const;
+    void captureVertexStates(const ToothSegmentation &toothSegmentation, QVector<VertexState> &vertexStates) const;
+    void applyVertexState(ToothSegmentation &toothSegmentation, int vertexIndex, const VertexState &vertexState);
+
+    SegmentationState captureSegmentationState(const ToothSegmentation &toothSegmentation) const;
+    void applySegmentationState(ToothSegmentation &toothSegmentation, const SegmentationState &state) const;
+};
+
+#endif // TOOTHSEGMENTATIONHISTORY_H
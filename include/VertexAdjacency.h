@@ -0,0 +1,93 @@
+#ifndef VERTEXADJACENCY_H
+#define VERTEXADJACENCY_H
+
+#include "Mesh.h"
+
+#include <QVector>
+
+#include <vector>
+#include <utility>
+
+using namespace SW;
+
+/*
+  网格顶点的邻接表（CSR压缩存储）。
+  顶点v的邻域点为mNeighbors[mOffsets[v]]到mNeighbors[mOffsets[v + 1] - 1]，顺序与vv_iter遍历顺序相同，
+  因此依赖邻域点环绕顺序的算法（如边界点分类中统计邻域点类型变化次数）结果与直接使用vv_iter一致。
+  只依赖网格拓扑，顶点移动后不需要重新建立；成员都是QVector，拷贝时隐式共享。
+*/
+class VertexAdjacency
+{
+public:
+    //各线程独占的邻域搜索缓冲区，在多次搜索间重复使用（访问标记按轮次区分，无需每次清零）
+    class SearchBuffer
+    {
+    public:
+        QVector<unsigned int> visitedStamp; //等于visitedEpoch表示在本次搜索中已访问
+        unsigned int visitedEpoch;
+        std::vector< std::pair<int, int> > queue; //广度优先搜索队列（顶点索引，距离）
+
+        SearchBuffer() : visitedEpoch(0) {}
+
+        //开始一次新的搜索
+        inline void nextEpoch(int vertexNum)
+        {
+            if(visitedStamp.size() != vertexNum)
+            {
+                visitedStamp.fill(0, vertexNum);
+                visitedEpoch = 0;
+            }
+            visitedEpoch++;
+            if(visitedEpoch == 0) //计数回绕时清零一次
+            {
+                visitedStamp.fill(0);
+                visitedEpoch = 1;
+            }
+        }
+    };
+
+private:
+    QVector<int> mOffsets; //大小为顶点数+1
+    QVector<int> mNeighbors;
+    QVector<bool> mIsMeshBoundary; //顶点是否位于模型边界（空洞边缘）
+
+public:
+    VertexAdjacency();
+
+    void build(const Mesh &mesh);
+
+    //按vertexOrder重新编号顶点后建立：新编号i对应网格中的顶点vertexOrder[i]，邻域点也使用新编号（vertexOrder为空时不重新编号）
+    void build(const Mesh &mesh, const QVector<int> &vertexOrder);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    int vertexNum() const;
+
+    //顶点vertexIndex的邻域点数
+    inline int neighborNum(int vertexIndex) const
+    {
+        return mOffsets.at(vertexIndex + 1) - mOffsets.at(vertexIndex);
+    }
+
+    //顶点vertexIndex的邻域点数组（共neighborNum(vertexIndex)个）
+    inline const int *neighbors(int vertexIndex) const
+    {
+        return mNeighbors.constData() + mOffsets.at(vertexIndex);
+    }
+
+    inline bool isMeshBoundary(int vertexIndex) const
+    {
+        return mIsMeshBoundary.at(vertexIndex);
+    }
+
+    //广度优先搜索vertexIndex的k邻域（含自身），按搜索顺序追加到ring，顺序与逐层遍历vv_iter相同
+    void kRing(int vertexIndex, int k, SearchBuffer &buffer, std::vector<int> &ring) const;
+
+    //用并查集（OpenMP并行）标记连通分量，连通时不经过excludedVertices中为true的点。
+    //componentRoots[v]为v所在分量中索引最小的顶点（被排除的点为-1），componentSizes[root]为该分量的顶点数，返回分量个数
+    int labelComponents(const std::vector<bool> &excludedVertices, QVector<int> &componentRoots, QVector<int> &componentSizes) const;
+};
+
+#endif // VERTEXADJACENCY_H
@@ -0,0 +1,47 @@
+#ifndef VISIBILITYBUFFER_H
+#define VISIBILITYBUFFER_H
+
+#include "Mesh.h"
+
+#include <QVector>
+#include <QPoint>
+
+#include <Eigen/Dense>
+
+using namespace SW;
+
+/*
+  当前视图的可见性缓冲区。
+  capture()从当前OpenGL上下文中一次性读取模型视图矩阵、投影矩阵、视口和整个深度缓冲区，
+  之后所有顶点的投影、反投影和可见性判断都在CPU上完成，不再逐顶点调用gluProject和glReadPixels。
+  计算方法与gluProject/gluUnProject相同，判断结果与原先逐顶点读取深度的方法一致。
+*/
+class VisibilityBuffer
+{
+private:
+    Eigen::Matrix4d mModelviewProjection; //投影矩阵*模型视图矩阵
+    Eigen::Matrix4d mModelviewProjectionInverse;
+    int mViewport[4];
+    QVector<float> mDepth; //整个视口的深度缓冲区，按行存储，第0行为视口最下方一行（与glReadPixels一致）
+
+public:
+    VisibilityBuffer();
+
+    //读取当前OpenGL上下文的矩阵、视口和深度缓冲区（调用时需保证对应的上下文为当前上下文）
+    void capture();
+
+    //将模型三维坐标转换为屏幕二维坐标（原点在左上角）及深度，返回该点是否落在视口内
+    bool project(const Mesh::Point &modelPoint, int &screenX, int &screenY, float &depth) const;
+
+    //将屏幕二维坐标处深度缓冲区中的点反投影为模型三维坐标
+    Mesh::Point unproject(int screenX, int screenY) const;
+
+    //一次计算所有点的屏幕二维坐标和可见性：若深度缓冲区中该点所在像素对应的三维点与该点距离不超过visibleDistance，则认为可见
+    void projectAll(const QVector<Mesh::Point> &modelPoints, float visibleDistance, QVector<QPoint> &screenPositions, QVector<bool> &visible) const;
+
+private:
+    //窗口坐标(winX, winY)（原点在左下角）处的深度值，超出视口时返回false
+    inline bool depthAt(int winX, int winY, float &depth) const;
+};
+
+#endif // VISIBILITYBUFFER_H
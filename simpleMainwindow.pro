@@ -20,8 +20,19 @@ SOURCES += \
     src/Mesh.cpp \
     src/Shader.cpp \
     src/ToothSegmentation.cpp \
+    src/ToothSegmentationHistory.cpp \
+    src/SpatialIndex.cpp \
+    src/GeodesicPathFinder.cpp \
+    src/StageProfiler.cpp \
+    src/MeshLoader.cpp \
+    src/VertexAdjacency.cpp \
+    src/MeshAnalysisView.cpp \
     src/CurvatureComputer.cpp \
     src/LaplaceTransform.cpp \
+    src/ProgressReporter.cpp \
+    src/DialogProgressReporter.cpp \
+    src/VisibilityBuffer.cpp \
+    src/MeshRenderer.cpp \
     lib/igit_geometry/src/assertions.cpp \
     lib/igit_geometry/src/io.cpp \
     lib/igit_geometry/src/kernel.cpp \
@@ -35,9 +46,22 @@ HEADERS += \
     include/Mesh.h \
     include/Shader.h \
     include/ToothSegmentation.h \
+    include/ToothSegmentationHistory.h \
+    include/SpatialIndex.h \
+    include/GeodesicPathFinder.h \
+    include/StageProfiler.h \
+    include/MeshLoader.h \
+    include/VertexAdjacency.h \
+    include/MeshAnalysisView.h \
     include/CurvatureComputer.h \
     include/BooleanOperation.h \
+    include/BooleanOperationType.h \
+    include/IglMeshBoolean.h \
     include/LaplaceTransform.h \
+    include/ProgressReporter.h \
+    include/DialogProgressReporter.h \
+    include/VisibilityBuffer.h \
+    include/MeshRenderer.h \
     include/basicType.h
 
 equals(QT_MAJOR_VERSION, 5){
@@ -48,8 +72,7 @@ INCLUDEPATH += \
                                      /usr/include/qt5/QtGui \
                                     include/ \
                                      lib/igit_geometry/include/ \#My_CGAL库包含路径
-                                     lib/eigen/include/  \#Eigen库包含路径
-                                     /usr/local/include/pcl-1.7/ #PCL库包含路径
+                                     lib/eigen/include/  #Eigen库包含路径
 }
 
 equals(QT_MAJOR_VERSION, 4){
@@ -62,8 +85,7 @@ INCLUDEPATH += \
     /usr/include/qt4/QtXml/ \
    include/ \
    lib/igit_geometry/include/ \#IGITG_GEOMETRY库包含路径
-    lib/eigen/include/ \ #Eigen库包含路径
-    /usr/include/pcl-1.7/ #PCL库包含路径  Add your own path here!!!!!
+    lib/eigen/include/ #Eigen库包含路径
 }
 
 LIBS += \
@@ -71,8 +93,16 @@ LIBS += \
     -lQGLViewer -lglut -lGL -lGLU \ #libQGLViewer和freeglut库文件
     -lOpenMeshCore -lOpenMeshTools \ #OpenMesh库文件
     -lgomp -lpthread \ #为了支持OpenMP并行处理而添加此两项
-    -lgsl -lgslcblas -lboost_thread  -lgmp -lmpfr \ #GSL库文件
-     -L/usr/local/lib -lpcl_kdtree #PCL库文件
+    -lgsl -lgslcblas -lboost_thread  -lgmp -lmpfr #GSL库文件
+
+# 使用libigl的布尔运算引擎(IGL_MESH_BOOLEAN_ENGINE): qmake CONFIG+=igl_boolean
+# libigl的CGAL模块需要完整的CGAL库(不是igit_geometry),IglMeshBoolean.cpp中不能包含igit_geometry头文件
+igl_boolean {
+DEFINES += IGL_MESH_BOOLEAN
+SOURCES += src/IglMeshBoolean.cpp
+INCLUDEPATH += lib/libigl_bak/include/
+LIBS += -lCGAL -lCGAL_Core
+}
 
 FORMS += \
     ui_template/mainwindow.ui
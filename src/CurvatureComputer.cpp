@@ -2,12 +2,10 @@
 
 #include <iostream>
 #include <cmath>
-#include <queue>
 
 #include <QVector>
 #include <QTime>
 
-#include <pthread.h>
 #include <omp.h>
 
 #define MIN(a,b) ((a)<(b)?(a):(b))
@@ -15,319 +13,348 @@
 
 using namespace std;
 
-CurvatureComputer::CurvatureComputer(Mesh &mesh)
+CurvatureComputer::CurvatureComputer(const Mesh &mesh)
 {
-    mMesh = mesh;
-    if(!mMesh.has_face_normals())
-    {
-        mMesh.request_face_normals();
-    }
-    if(!mMesh.has_vertex_normals())
-    {
-        mMesh.request_vertex_normals();
-    }
-
-    mMesh.update_normals();
+    //视图中的法向与update_normals()的结果相同，无需复制mesh再计算法向
+    mView.build(mesh, true);
     mLocalMode = true;
     mProjectionPlaneCheck = true;
-    mKRing = MAX(ceil((float)mMesh.mVertexNum / 50000), 2);
-    mMesh.computeBoundingBox();
-    mSphere = (mMesh.BBox.size.x + mMesh.BBox.size.y + mMesh.BBox.size.z) / 3 * 0.02;
+    mFitMethod = FIT_NORMAL_EQUATION;
+    mKRing = MAX(ceil((float)mView.vertexNum() / 50000), 2);
+    Mesh::Point size = mView.boundingBoxMax() - mView.boundingBoxMin();
+    mSphere = ((double)size[0] + size[1] + size[2]) / 3 * 0.02;
 }
 
-void CurvatureComputer::computeCurvature(QProgressDialog *progress)
+void CurvatureComputer::computeCurvature(ProgressReporter *progress)
 {
     QTime time;
 
-    int vertexNum = mMesh.mVertexNum;
+    int vertexNum = mView.vertexNum();
 
     if(vertexNum <= 0)
     {
         return;
     }
 
-    mCurvature.resize(vertexNum);
-    mCurvatureComputed.resize(vertexNum);
-
-    time.start();
-    QVector<Mesh::VertexHandle> vertices;
-    vertices.reserve(vertexNum);
-    for(Mesh::VertexIter vertexIter = mMesh.vertices_begin(); vertexIter != mMesh.vertices_end(); vertexIter++)
-    {
-        vertices.push_back(*vertexIter);
-    }
-    cout << "创建所有顶点的线性索引 用时：" << time.elapsed() << "ms." << endl;
+    QVector<float> curvature(vertexNum); //按视图索引排列，计算完成后转换为按网格顶点索引排列
+    QVector<bool> curvatureComputed(vertexNum);
 
-    int completedVertexNum = 0; //已计算完的顶点数目
+    QAtomicInt completedVertexNum(0); //已计算完的顶点数目，由各线程原子递增
     progress->setLabelText(tr("Computing curvature..."));
     progress->setMinimum(0);
     progress->setMaximum(vertexNum);
     progress->setValue(0);
-    connect(this, SIGNAL(progressValueChanged(int)), progress, SLOT(setValue(int)));
 
     time.start();
 
-    /*//并行计算
+    //并行计算：各线程持有独立的ThreadBuffer，顶点按小块动态分配给空闲线程以平衡负载
+    //视图中的顶点按Morton码排列，同一块中的顶点空间上相邻，其邻域在各数组中也大多相邻
+    //进度只由主线程（即调用本函数的线程，图形界面下为GUI线程）更新，其余线程只递增计数
+    float *curvatureData = curvature.data();
+    bool *curvatureComputedData = curvatureComputed.data();
     int procNum = omp_get_num_procs(); //处理器数量
-    pthread_t *threadIDs = new pthread_t[procNum];
-    int sectionLength = ceil((float)vertexNum / procNum); //各线程负责计算的点的数量
-//#pragma omp parallel for num_threads(procNum)
-    for(int i = 0; i < procNum; i++)
+#pragma omp parallel num_threads(procNum)
     {
-        ThreadArguments arguments;
-        arguments.curvatureComputer = this;
-        arguments.vertices = &vertices;
-        arguments.startVertexIndex = sectionLength * i;
-        arguments.endVertexIndex = MIN(sectionLength * (i + 1), vertexNum);
-        arguments.completedVertexNum = &completedVertexNum;
-
-        if(pthread_create(&threadIDs[i], NULL, threadFun, &arguments))
+        ThreadBuffer buffer;
+        bool isMasterThread = (omp_get_thread_num() == 0);
+        int masterComputedNum = 0;
+
+#pragma omp for schedule(dynamic, 64)
+        for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
         {
-            cerr << "Error to create thread." << endl;
+            curvatureComputedData[vertexIndex] = computeCurvature(vertexIndex, buffer, curvatureData[vertexIndex]);
+            int completed = completedVertexNum.fetchAndAddRelaxed(1) + 1;
+            if(isMasterThread && (masterComputedNum++ % 256 == 0))
+            {
+                progress->setValue(completed);
+            }
         }
     }
-    sleep(5);
-    for(int i = 0; i < procNum; i++)
-    {
-        pthread_join(threadIDs[i], NULL);
-    }
-    delete[] threadIDs;*/
+    progress->setValue(vertexNum);
 
-    //串行计算
-    computeCurvature(vertices, 0, vertexNum, &completedVertexNum);
+    mView.toMeshOrder(curvature, mCurvature);
+    mView.toMeshOrder(curvatureComputed, mCurvatureComputed);
 
     cout << "计算所有顶点的曲率 用时：" << time.elapsed() << "ms." << endl;
 }
 
-void* CurvatureComputer::threadFun(void *arg)
+bool CurvatureComputer::computeCurvature(int vertexIndex, ThreadBuffer &buffer, float &curvature)
 {
-    ThreadArguments arguments = *((ThreadArguments *)arg);
-    arguments.curvatureComputer->computeCurvature(*(arguments.vertices), arguments.startVertexIndex, arguments.endVertexIndex, arguments.completedVertexNum);
-}
-
-void CurvatureComputer::computeCurvature(QVector<Mesh::VertexHandle> &vertices, int startVertexIndex, int endVertexIndex, int *completedVertexNum)
-{
-    for(int vertexIndex = startVertexIndex; vertexIndex < endVertexIndex; vertexIndex++)
-    {
-        Mesh::Point tempVertex = mMesh.point(vertices[vertexIndex]);
+    Mesh::Point tempVertex = mView.point(vertexIndex);
 
-        QVector<Mesh::VertexHandle> vv;
-        QVector<Mesh::VertexHandle> vvtmp;
+    vector<int> &vv = buffer.vv;
+    vector<int> &vvtmp = buffer.vvtmp;
+    vv.clear();
+    vvtmp.clear();
 
 #ifdef KRING
-        getKRing(vertices[vertexIndex], mKRing, vv);
+    mView.kRing(vertexIndex, mKRing, buffer.search, vv);
 #else
-        getSphere(vertices[vertexIndex], mSphere, 6, vv);
+    mView.sphere(vertexIndex, mSphere, 6, buffer.search, vv);
 #endif
 
-        if(vv.size() < 6)
-        {
-            cerr << "Could not compute curvature of vertex No." << vertexIndex << " . coordinate: " << tempVertex << endl;
-            mCurvatureComputed[vertexIndex] = false;
-            continue;
-        }
+    if(vv.size() < 6)
+    {
+#pragma omp critical(CurvatureComputerLog)
+        cerr << "Could not compute curvature of vertex No." << mView.meshIndex(vertexIndex) << " . coordinate: " << tempVertex << endl;
+        return false;
+    }
 
-        if(mProjectionPlaneCheck)
+    if(mProjectionPlaneCheck)
+    {
+        applyProjOnPlane(mView.normal(vertexIndex), vv, vvtmp);
+        if(vvtmp.size() >= 6 && vvtmp.size() < vv.size())
         {
-            applyProjOnPlane(mMesh.normal(vertices[vertexIndex]), vv, vvtmp);
-            if(vvtmp.size() >= 6 && vvtmp.size() < vv.size())
+            vv.swap(vvtmp);
+            if(vv.size() < 6)
             {
-                vv = vvtmp;
-                if(vv.size() < 6)
-                {
-                    cerr << "Could not compute curvature of vertex No." << vertexIndex << " . coordinate: " << tempVertex << endl;
-                    mCurvatureComputed[vertexIndex] = false;
-                    continue;
-                }
+#pragma omp critical(CurvatureComputerLog)
+                cerr << "Could not compute curvature of vertex No." << mView.meshIndex(vertexIndex) << " . coordinate: " << tempVertex << endl;
+                return false;
             }
         }
+    }
 
-        Mesh::Normal normal;
-        getAverageNormal(vertices[vertexIndex], vv, normal);
-
-        QVector<Mesh::Point> ref(3);
-        computeReferenceFrame(vertices[vertexIndex], normal, ref);
-
-        Quadric q;
-        fitQuadric(tempVertex, ref, vv, &q);
-        mCurvature[vertexIndex] = finalEigenStuff(q);
-        mCurvatureComputed[vertexIndex] = true;
+    Mesh::Normal normal;
+    getAverageNormal(vertexIndex, vv, normal);
 
-//#pragma omp critical //TODO 不知道这句放在这里管不管用
-        (*completedVertexNum)++;
+    QVector<Mesh::Point> ref(3);
+    computeReferenceFrame(vertexIndex, normal, ref);
 
-        emit progressValueChanged(*completedVertexNum);
-    }
+    Quadric q;
+    fitQuadric(tempVertex, ref, vv, buffer.points, &q);
+    curvature = finalEigenStuff(q);
+    return true;
 }
 
-void CurvatureComputer::getResult(QVector<float> &curvature, QVector<bool> &computed)
+void CurvatureComputer::recomputeCurvature(const Mesh &mesh, const QVector<Mesh::VertexHandle> &movedVertexHandles, QVector<Mesh::VertexHandle> &affectedVertexHandles, QVector<float> &curvature, QVector<bool> &computed)
 {
-    curvature.resize(mCurvature.size());
-    curvature.swap(mCurvature);
-    computed.resize(mCurvatureComputed.size());
-    computed.swap(mCurvatureComputed);
-}
+    QTime time;
+    time.start();
 
-inline void CurvatureComputer::getKRing(const Mesh::VertexHandle &centerVertexHandle, const int k, QVector<Mesh::VertexHandle> &vv)
-{
-    int bufSize = mMesh.mVertexNum;
-    vv.reserve(bufSize);
-    bool* visited = (bool*)calloc(bufSize, sizeof(bool));
+    mView.updateGeometry(mesh, movedVertexHandles);
 
-    QVector< pair<Mesh::VertexHandle, int> > queue;
-    queue.reserve(bufSize);
-    queue.push_back(pair<Mesh::VertexHandle, int>(centerVertexHandle, 0));
-    visited[centerVertexHandle.idx()] = true;
+    QVector<int> movedVertices(movedVertexHandles.size());
+    for(int i = 0; i < movedVertexHandles.size(); i++)
+    {
+        movedVertices[i] = mView.viewIndex(movedVertexHandles[i].idx());
+    }
 
-    Mesh::VertexHandle tempVertexHandle;
-    int tempDistance;
-    while(!queue.empty())
+    ThreadBuffer searchBuffer;
+    QVector<int> affectedVertices;
+    getAffectedVertices(movedVertices, searchBuffer, affectedVertices);
+
+    int affectedVertexNum = affectedVertices.size();
+    affectedVertexHandles.resize(affectedVertexNum);
+    curvature.resize(affectedVertexNum);
+    computed.resize(affectedVertexNum);
+    const int *vertexIndices = affectedVertices.constData();
+    Mesh::VertexHandle *vertexHandles = affectedVertexHandles.data();
+    float *curvatureData = curvature.data();
+    bool *computedData = computed.data();
+
+#pragma omp parallel num_threads(omp_get_num_procs())
     {
-        tempVertexHandle = queue.front().first;
-        tempDistance = queue.front().second;
-        queue.pop_front();
-        vv.push_back(tempVertexHandle);
-        if(tempDistance < k)
+        ThreadBuffer buffer;
+
+#pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < affectedVertexNum; i++)
         {
-            for(Mesh::VertexVertexIter vertexVertexIter = mMesh.vv_iter(tempVertexHandle); vertexVertexIter.is_valid(); vertexVertexIter++)
-            {
-                if(!visited[vertexVertexIter->idx()])
-                {
-                    queue.push_back(pair<Mesh::VertexHandle, int>(*vertexVertexIter, tempDistance + 1));
-                    visited[vertexVertexIter->idx()] = true;
-                }
-            }
+            vertexHandles[i] = mView.vertexHandle(vertexIndices[i]);
+            computedData[i] = computeCurvature(vertexIndices[i], buffer, curvatureData[i]);
         }
     }
 
-    free(visited);
+    cout << "局部更新" << affectedVertexNum << "个顶点的曲率 用时：" << time.elapsed() << "ms." << endl;
 }
 
-inline void CurvatureComputer::getSphere(const Mesh::VertexHandle &centerVertexHandle, const float r, const int min, QVector<Mesh::VertexHandle> &vv)
+void CurvatureComputer::getAffectedVertices(const QVector<int> &movedVertices, ThreadBuffer &buffer, QVector<int> &affectedVertices)
 {
-    int bufSize = mMesh.mVertexNum;
-    vv.reserve(bufSize);
-    bool* visited = (bool*)calloc(bufSize, sizeof(bool));
-
-    QVector<Mesh::VertexHandle> queue;
-    queue.reserve(bufSize);
-    queue.push_back(centerVertexHandle);
-    visited[centerVertexHandle.idx()] = true;
-
-    Mesh::Point me = mMesh.point(centerVertexHandle);
-    priority_queue< pair<Mesh::VertexHandle, float>, vector< pair<Mesh::VertexHandle, float> >, comparer > extraCandidates;
-    Mesh::VertexHandle toVisit;
-    Mesh::VertexHandle neighbor;
-    Mesh::Point neigh;
-    float distance;
-    while(!queue.empty())
+    const VertexAdjacency &adjacency = mView.adjacency();
+    buffer.search.nextEpoch(mView.vertexNum());
+    unsigned int *visitedStamp = buffer.search.visitedStamp.data();
+    const unsigned int epoch = buffer.search.visitedEpoch;
+
+    //顶点移动后，其1邻域内顶点的法向量也会改变，而法向量参与了投影平面检查和局部坐标系的计算，因此这些顶点都作为搜索起点
+    vector< pair<int, int> > &queue = buffer.search.queue;
+    queue.clear();
+    for(QVector<int>::const_iterator vi = movedVertices.begin(); vi != movedVertices.end(); vi++)
     {
-        toVisit=queue.front();
-        queue.pop_front();
-        vv.push_back(toVisit);
-        for(Mesh::VertexVertexIter vertexVertexIter = mMesh.vv_iter(toVisit); vertexVertexIter.is_valid(); vertexVertexIter++)
+        if(visitedStamp[*vi] != epoch)
         {
-            neighbor = *vertexVertexIter;
-            if(!visited[neighbor.idx()])
+            queue.push_back(pair<int, int>(*vi, 0));
+            visitedStamp[*vi] = epoch;
+        }
+        const int *neighbors = adjacency.neighbors(*vi);
+        int neighborNum = adjacency.neighborNum(*vi);
+        for(int i = 0; i < neighborNum; i++)
+        {
+            if(visitedStamp[neighbors[i]] != epoch)
             {
-                neigh = mMesh.point(neighbor);
-                distance = (me - neigh).norm();
-                if(distance < r)
-                {
-                    queue.push_back(neighbor);
-                }
-                else if(vv.size() < min)
+                queue.push_back(pair<int, int>(neighbors[i], 0));
+                visitedStamp[neighbors[i]] = epoch;
+            }
+        }
+    }
+
+#ifdef KRING
+    //k邻域关系是对称的：顶点v的mKRing邻域包含起点s，当且仅当s的mKRing邻域包含v
+    int tempVertexIndex;
+    int tempDistance;
+    for(size_t queueHead = 0; queueHead < queue.size(); queueHead++)
+    {
+        tempVertexIndex = queue[queueHead].first;
+        tempDistance = queue[queueHead].second;
+        affectedVertices.push_back(tempVertexIndex);
+        if(tempDistance < mKRing)
+        {
+            const int *neighbors = adjacency.neighbors(tempVertexIndex);
+            int neighborNum = adjacency.neighborNum(tempVertexIndex);
+            for(int i = 0; i < neighborNum; i++)
+            {
+                if(visitedStamp[neighbors[i]] != epoch)
                 {
-                    extraCandidates.push(pair<Mesh::VertexHandle, float>(neighbor, distance));
+                    queue.push_back(pair<int, int>(neighbors[i], tempDistance + 1));
+                    visitedStamp[neighbors[i]] = epoch;
                 }
-                visited[neighbor.idx()] = true;
             }
         }
     }
-
-    while (!extraCandidates.empty() && vv.size() < min)
+#else
+    //球邻域：从各起点出发沿网格扩展，保留与出发起点距离小于2*mSphere的顶点（留出余量，覆盖sphere中补足min个顶点时越出球外的情况）
+    //queue中的第二个int记录该顶点是由哪个起点（在queue中的下标）扩展得到的
+    for(size_t i = 0; i < queue.size(); i++)
+    {
+        queue[i].second = i;
+    }
+    int tempVertexIndex;
+    int seedIndex;
+    for(size_t queueHead = 0; queueHead < queue.size(); queueHead++)
     {
-        pair<Mesh::VertexHandle, float> cand = extraCandidates.top();
-        extraCandidates.pop();
-        vv.push_back(cand.first);
-        for(Mesh::VertexVertexIter vertexVertexIter = mMesh.vv_iter(cand.first); vertexVertexIter.is_valid(); vertexVertexIter++)
+        tempVertexIndex = queue[queueHead].first;
+        seedIndex = queue[queueHead].second;
+        affectedVertices.push_back(tempVertexIndex);
+        Mesh::Point seed = mView.point(queue[seedIndex].first);
+        const int *neighbors = adjacency.neighbors(tempVertexIndex);
+        int neighborNum = adjacency.neighborNum(tempVertexIndex);
+        for(int i = 0; i < neighborNum; i++)
         {
-            neighbor = *vertexVertexIter;
-            if(!visited[neighbor.idx()])
+            if(visitedStamp[neighbors[i]] != epoch && (mView.point(neighbors[i]) - seed).norm() < 2.0 * mSphere)
             {
-                neigh = mMesh.point(neighbor);
-                distance = (me - neigh).norm();
-                extraCandidates.push(pair<Mesh::VertexHandle, float>(neighbor, distance));
-                visited[neighbor.idx()] = true;
+                queue.push_back(pair<int, int>(neighbors[i], seedIndex));
+                visitedStamp[neighbors[i]] = epoch;
             }
         }
     }
+#endif
+}
 
-    free(visited);
+void CurvatureComputer::setFitMethod(FitMethod fitMethod)
+{
+    mFitMethod = fitMethod;
 }
 
-inline float CurvatureComputer::getAverageEdge(QProgressDialog *progress)
+void CurvatureComputer::benchmarkFitMethods(ProgressReporter *progress)
 {
-    float edgeLengthSum = 0;
-    int edgeIndex = 0;
-    Mesh::HalfedgeHandle hh1, hh2;
-    Mesh::VertexHandle vh1, vh2;
+    QTime time;
+    FitMethod originalFitMethod = mFitMethod;
+    FitMethod otherFitMethod = (originalFitMethod == FIT_SVD) ? FIT_NORMAL_EQUATION : FIT_SVD;
+    int vertexNum = mView.vertexNum();
 
-    progress->setLabelText(tr("Computing curvature(compute average edge)..."));
-    progress->setMinimum(0);
-    progress->setMaximum(mMesh.mFaceNum);
-    progress->setValue(0);
-    for(Mesh::EdgeIter edgeIter = mMesh.edges_begin(); edgeIter != mMesh.edges_end(); edgeIter++)
+    //先用另一种方法计算，最后用当前方法计算，使mCurvature中保留的是当前方法的结果
+    mFitMethod = otherFitMethod;
+    time.start();
+    computeCurvature(progress);
+    int otherElapsed = time.elapsed();
+    QVector<float> otherCurvature = mCurvature;
+    QVector<bool> otherCurvatureComputed = mCurvatureComputed;
+
+    mFitMethod = originalFitMethod;
+    time.start();
+    computeCurvature(progress);
+    int originalElapsed = time.elapsed();
+
+    int comparedVertexNum = 0;
+    int computedMismatchNum = 0;
+    double errorSum = 0.0;
+    float errorMax = 0.0;
+    float curvatureMin = 1000000.0, curvatureMax = -1000000.0;
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        if(mCurvatureComputed[vertexIndex] != otherCurvatureComputed[vertexIndex])
+        {
+            computedMismatchNum++;
+            continue;
+        }
+        if(!mCurvatureComputed[vertexIndex])
+        {
+            continue;
+        }
+        float error = fabs(mCurvature[vertexIndex] - otherCurvature[vertexIndex]);
+        errorSum += error;
+        errorMax = MAX(errorMax, error);
+        curvatureMin = MIN(curvatureMin, otherCurvature[vertexIndex]);
+        curvatureMax = MAX(curvatureMax, otherCurvature[vertexIndex]);
+        comparedVertexNum++;
+    }
+
+    int svdElapsed = (originalFitMethod == FIT_SVD) ? originalElapsed : otherElapsed;
+    int normalEquationElapsed = (originalFitMethod == FIT_SVD) ? otherElapsed : originalElapsed;
+    cout << "曲率拟合方法比较（" << vertexNum << "个顶点）：" << endl;
+    cout << "  JacobiSVD 用时：" << svdElapsed << "ms." << endl;
+    cout << "  法方程+LDLT 用时：" << normalEquationElapsed << "ms." << endl;
+    cout << "  计算成功与否不一致的顶点数：" << computedMismatchNum << endl;
+    if(comparedVertexNum > 0)
     {
-        progress->setValue(edgeIndex);
-        hh1 = mMesh.halfedge_handle(edgeIter, 0);
-        hh2 = mMesh.halfedge_handle(edgeIter, 1);
-        vh1 = mMesh.to_vertex_handle(hh1);
-        vh2 = mMesh.to_vertex_handle(hh2);
-        edgeLengthSum += (mMesh.point(vh1) - mMesh.point(vh2)).length();
-        edgeIndex++;
+        cout << "  平均曲率绝对误差：平均 " << errorSum / comparedVertexNum << "，最大 " << errorMax
+             << "（曲率范围 [" << curvatureMin << ", " << curvatureMax << "]）" << endl;
     }
+}
 
-    return (edgeLengthSum / mMesh.mFaceNum);
+void CurvatureComputer::getResult(QVector<float> &curvature, QVector<bool> &computed)
+{
+    curvature.resize(mCurvature.size());
+    curvature.swap(mCurvature);
+    computed.resize(mCurvatureComputed.size());
+    computed.swap(mCurvatureComputed);
 }
 
-inline void CurvatureComputer::applyProjOnPlane(const Mesh::Normal &ppn, const QVector<Mesh::VertexHandle> &vin, QVector<Mesh::VertexHandle> &vout)
+inline void CurvatureComputer::applyProjOnPlane(const Mesh::Normal &ppn, const vector<int> &vin, vector<int> &vout)
 {
     int vinSize = vin.size();
     vout.reserve(vinSize);
-    Mesh::Normal tempNormal;
-    for(QVector<Mesh::VertexHandle>::const_iterator vpi = vin.begin(); vpi != vin.end(); vpi++)
+    for(vector<int>::const_iterator vpi = vin.begin(); vpi != vin.end(); vpi++)
     {
-        tempNormal = mMesh.normal(*vpi);
-        if((tempNormal | ppn) > 0.0f)
+        if((mView.normal(*vpi) | ppn) > 0.0f)
         {
             vout.push_back(*vpi);
         }
     }
 }
 
-inline void CurvatureComputer::getAverageNormal(const Mesh::VertexHandle &centerVertexHandle, const QVector<Mesh::VertexHandle> &vv, Mesh::Normal &normal)
+inline void CurvatureComputer::getAverageNormal(int centerVertexIndex, const vector<int> &vv, Mesh::Normal &normal)
 {
     if(mLocalMode)
     {
-        normal = mMesh.normal(centerVertexHandle);
+        normal = mView.normal(centerVertexIndex);
     }
     else
     {
-        for(QVector<Mesh::VertexHandle>::const_iterator vpi = vv.begin(); vpi != vv.end(); vpi++)
+        for(vector<int>::const_iterator vpi = vv.begin(); vpi != vv.end(); vpi++)
         {
-            normal += mMesh.normal(*vpi);
+            normal += mView.normal(*vpi);
         }
     }
 
     normal.normalize();
 }
 
-inline void CurvatureComputer::computeReferenceFrame(const Mesh::VertexHandle &centerVertexHandle, const Mesh::Normal &normal, QVector<Mesh::Point> &ref)
+inline void CurvatureComputer::computeReferenceFrame(int centerVertexIndex, const Mesh::Normal &normal, QVector<Mesh::Point> &ref)
 {
-    Mesh::Point longest_v = mMesh.point(mMesh.vv_iter(centerVertexHandle));
+    //第一个邻域点（与vv_iter的第一个点相同）
+    Mesh::Point longest_v = mView.point(mView.adjacency().neighbors(centerVertexIndex)[0]);
 
-    Mesh::Point centerVertex = mMesh.point(centerVertexHandle);
+    Mesh::Point centerVertex = mView.point(centerVertexIndex);
     longest_v = (project(centerVertex, longest_v, normal) - centerVertex).normalized();
 
     Mesh::Point y_axis = (normal % longest_v).normalized();
@@ -341,25 +368,51 @@ inline Mesh::Point CurvatureComputer::project(const Mesh::Point &v, const Mesh::
     return (vp - (ppn * ((vp - v) | (ppn))));
 }
 
-inline void CurvatureComputer::fitQuadric(const Mesh::Point &v, const QVector<Mesh::Point> &ref, const QVector<Mesh::VertexHandle> &vv, Quadric *q)
+inline void CurvatureComputer::fitQuadric(const Mesh::Point &v, const QVector<Mesh::Point> &ref, const vector<int> &vv, vector<Mesh::Point> &points, Quadric *q)
 {
-    QVector<Mesh::Point> points;
-    points.reserve(vv.size());
+    points.clear();
 
     Mesh::Point vTang;
-    for(QVector<Mesh::VertexHandle>::const_iterator vpi = vv.begin(); vpi != vv.end(); vpi++)
+    for(vector<int>::const_iterator vpi = vv.begin(); vpi != vv.end(); vpi++)
     {
-        vTang = mMesh.point(*vpi) - v;
+        vTang = mView.point(*vpi) - v;
 
         float x = vTang | ref[0];
         float y = vTang | ref[1];
         float z = vTang | ref[2];
         points.push_back(Mesh::Point(x, y, z));
     }
-    *q = Quadric::fit(points);
+    *q = (mFitMethod == FIT_SVD) ? Quadric::fitSVD(points) : Quadric::fit(points);
 }
 
 inline float CurvatureComputer::finalEigenStuff(Quadric &q)
+{
+    if(mFitMethod == FIT_SVD)
+    {
+        return finalEigenStuffSolver(q);
+    }
+
+    float a = q.a();
+    float b = q.b();
+    float c = q.c();
+    float d = q.d();
+    float e = q.e();
+
+    float E = 1.0 + d*d;
+    float F = d*e;
+    float G = 1.0 + e*e;
+
+    float nz = 1.0 / sqrt(1.0 + d*d + e*e); //法向量(-d, -e, 1)单位化后的z分量
+
+    float L = 2.0 * a * nz;
+    float M = b * nz;
+    float N = 2 * c * nz;
+
+    //平均曲率为形状算子两特征值之和的一半（取负），即其迹的一半，无需求特征值
+    return -((L*G - M*F) + (N*E - M*F)) / (E*G - F*F) * 0.5;
+}
+
+inline float CurvatureComputer::finalEigenStuffSolver(Quadric &q)
 {
     float a = q.a();
     float b = q.b();
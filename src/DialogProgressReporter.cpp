@@ -0,0 +1,50 @@
+#include "DialogProgressReporter.h"
+
+#include <QMessageBox>
+
+DialogProgressReporter::DialogProgressReporter(QWidget *parentWidget) : QObject(parentWidget)
+{
+    mParentWidget = parentWidget;
+    mProgress = new QProgressDialog(mParentWidget);
+    mProgress->setMinimumSize(400, 80);
+    //mProgress->setCancelButtonText(tr("cancel"));
+    mProgress->setCancelButton(0); //不显示“取消”按钮
+    mProgress->setMinimumDuration(0);
+    mProgress->setWindowModality(Qt::WindowModal);
+    mProgress->setAutoClose(false);
+}
+
+void DialogProgressReporter::setWindowTitle(const QString &title)
+{
+    mProgress->setWindowTitle(title);
+}
+
+void DialogProgressReporter::setLabelText(const QString &text)
+{
+    mProgress->setLabelText(text);
+}
+
+void DialogProgressReporter::setMinimum(int minimum)
+{
+    mProgress->setMinimum(minimum);
+}
+
+void DialogProgressReporter::setMaximum(int maximum)
+{
+    mProgress->setMaximum(maximum);
+}
+
+void DialogProgressReporter::setValue(int value)
+{
+    mProgress->setValue(value);
+}
+
+void DialogProgressReporter::close()
+{
+    mProgress->close();
+}
+
+void DialogProgressReporter::showMessage(const QString &title, const QString &text)
+{
+    QMessageBox::information(mParentWidget, title, text);
+}
@@ -114,7 +114,10 @@ SW::GLViewer::GLViewer(QWidget *parent0, const QGLWidget *parent1, Qt::WindowFla
 
 SW::GLViewer::~GLViewer()
 {
-
+    //删除VBO时需要当前上下文
+    makeCurrent();
+    qDeleteAll(mMeshRenderers);
+    mMeshRenderers.clear();
 }
 
 //NON CLASS METHOD
@@ -353,10 +356,20 @@ void SW::GLViewer::draw()
     drawAxises(0.1, m_length);
     glPushAttrib( GL_ALL_ATTRIB_BITS );
     setMeshMaterial();
-    foreach(SW::Mesh mesh, meshes){
+    for(int meshIndex = 0; meshIndex < meshes.size(); meshIndex++){
+        if(meshIndex >= mMeshRenderers.size()){
+            mMeshRenderers.push_back(new MeshRenderer());
+        }
+        if(mMeshChanged[meshIndex]){
+            mMeshRenderers[meshIndex]->update(meshes[meshIndex]);
+            mMeshChanged[meshIndex] = false;
+        }
         glPushMatrix();
         //mesh.draw(displayType);//mhw改201509079
-        mesh.draw(displayType,Select_P_Array,MoveVectors);
+        //mesh.draw(displayType,Select_P_Array,MoveVectors);//立即模式，已改为VBO绘制
+        meshes[meshIndex].drawDecorations();
+        mMeshRenderers[meshIndex]->draw(displayType);
+        drawSelectedVertices(meshes[meshIndex]);
         glPopMatrix();
     }
     glPopAttrib();
@@ -522,6 +535,7 @@ void SW::GLViewer::mouseMoveEvent(QMouseEvent *e){
         if((fabs(MoveVectors.Z_arr[Cur_choose_P])+fabs(MoveVectors.X_arr[Cur_choose_P])+fabs(MoveVectors.Y_arr[Cur_choose_P]))<2){
             //MHW::LTransform TryL(this->meshes[0],"./",10000,0,this->meshes[0].n_vertices());
             Do_L.P->Run(this->meshes[0],Select_P_Array,MoveVectors);
+            updateMesh(0);
 
             meshes[0].writeModel("tets.obj");
             updateGL();
@@ -770,6 +784,7 @@ void SW::GLViewer::toggleMovePoints(bool checked){
 void SW::GLViewer::toggleModelReset(){
 
     meshes[0]=Do_L.P->objMesh;
+    updateMesh(0);
     for(int i=0;i<MoveVectors.X_arr.size();i++){
         MoveVectors.X_arr[i]=0;
         MoveVectors.Y_arr[i]=0;
@@ -783,6 +798,7 @@ void SW::GLViewer::toggleModelReset(){
 void SW::GLViewer::addMesh(const Mesh &mesh){
 
     meshes.append(mesh);
+    mMeshChanged.append(true);
 }
 
 int SW::GLViewer::getMeshNum(){
@@ -795,6 +811,30 @@ Mesh & SW::GLViewer::getMesh(int index){
 
 void SW::GLViewer::removeAllMeshes(){
     meshes.clear();
+    mMeshChanged.clear();
+}
+
+void SW::GLViewer::updateMesh(int index){
+    mMeshChanged[index] = true;
+}
+
+void SW::GLViewer::drawSelectedVertices(Mesh &mesh){
+    if(Select_P_Array.isEmpty()){
+        return;
+    }
+    glPointSize(5);
+    glColor3f(0.0f, 0.0f, 1.0f);
+    glBegin(GL_POINTS);
+    for(int i = 0; i < Select_P_Array.size(); i++){
+        for(int j = 0; j < Select_P_Array[i].size(); j++){
+            if(Select_P_Array[i][j] < 0 || Select_P_Array[i][j] >= mesh.n_vertices()){
+                continue;
+            }
+            Mesh::Point v = mesh.point(Mesh::VertexHandle(Select_P_Array[i][j]));
+            glVertex3f(v[0]+(0.001*MoveVectors.X_arr[i]), v[1]+(0.001*MoveVectors.Y_arr[i]), v[2]);
+        }
+    }
+    glEnd();
 }
 
 
@@ -0,0 +1,117 @@
+#include "GeodesicPathFinder.h"
+
+#include <algorithm>
+#include <limits.h>
+
+GeodesicPathFinder::GeodesicPathFinder(const Mesh &mesh, const VertexAdjacency &adjacency, const QVector<float> &vertexWeights)
+    : mMesh(mesh), mAdjacency(adjacency), mVertexWeights(vertexWeights)
+{
+    int vertexNum = mAdjacency.vertexNum();
+    mDistances.resize(vertexNum);
+    mPreviousVertices.resize(vertexNum);
+    mSearchStamps.fill(0, vertexNum);
+    mClosed.fill(false, vertexNum);
+    mSearchStamp = 0;
+    mSearchNum = 0;
+    mSearchedVertexNum = 0;
+}
+
+bool GeodesicPathFinder::findPath(int sourceVertexIndex, int targetVertexIndex, QVector<int> &path)
+{
+    path.clear();
+
+    //搜索序号溢出时才真正清空访问标记
+    if(mSearchStamp == INT_MAX)
+    {
+        mSearchStamps.fill(0);
+        mSearchStamp = 0;
+    }
+    mSearchStamp++;
+    mSearchNum++;
+
+    float *distances = mDistances.data();
+    int *previousVertices = mPreviousVertices.data();
+    int *searchStamps = mSearchStamps.data();
+    bool *closed = mClosed.data();
+    const float *vertexWeights = mVertexWeights.constData();
+    Mesh::Point targetVertex = mMesh.point(Mesh::VertexHandle(targetVertexIndex));
+
+    distances[sourceVertexIndex] = 0.0;
+    previousVertices[sourceVertexIndex] = -1;
+    searchStamps[sourceVertexIndex] = mSearchStamp;
+    closed[sourceVertexIndex] = false;
+    mHeap.clear();
+    HeapNode sourceNode = {(mMesh.point(Mesh::VertexHandle(sourceVertexIndex)) - targetVertex).norm(), sourceVertexIndex};
+    mHeap.push_back(sourceNode);
+
+    bool found = false;
+    while(!mHeap.empty())
+    {
+        std::pop_heap(mHeap.begin(), mHeap.end());
+        int vertexIndex = mHeap.back().vertexIndex;
+        mHeap.pop_back();
+        if(closed[vertexIndex]) //同一顶点可能多次入堆，只处理第一次出堆
+        {
+            continue;
+        }
+        closed[vertexIndex] = true;
+        mSearchedVertexNum++;
+        if(vertexIndex == targetVertexIndex)
+        {
+            found = true;
+            break;
+        }
+
+        Mesh::Point vertex = mMesh.point(Mesh::VertexHandle(vertexIndex));
+        const int *neighbors = mAdjacency.neighbors(vertexIndex);
+        int neighborNum = mAdjacency.neighborNum(vertexIndex);
+        for(int i = 0; i < neighborNum; i++)
+        {
+            int neighborVertexIndex = neighbors[i];
+            if(searchStamps[neighborVertexIndex] == mSearchStamp && closed[neighborVertexIndex])
+            {
+                continue;
+            }
+            Mesh::Point neighborVertex = mMesh.point(Mesh::VertexHandle(neighborVertexIndex));
+            float distance = distances[vertexIndex] + (neighborVertex - vertex).norm() * vertexWeights[neighborVertexIndex];
+            if(searchStamps[neighborVertexIndex] != mSearchStamp) //本次搜索中第一次访问该顶点
+            {
+                searchStamps[neighborVertexIndex] = mSearchStamp;
+                closed[neighborVertexIndex] = false;
+            }
+            else if(distance >= distances[neighborVertexIndex])
+            {
+                continue;
+            }
+            distances[neighborVertexIndex] = distance;
+            previousVertices[neighborVertexIndex] = vertexIndex;
+            HeapNode neighborNode = {distance + (neighborVertex - targetVertex).norm(), neighborVertexIndex};
+            mHeap.push_back(neighborNode);
+            std::push_heap(mHeap.begin(), mHeap.end());
+        }
+    }
+
+    if(!found)
+    {
+        return false;
+    }
+
+    //从终点沿前驱回溯，再反转为从起点到终点的顺序
+    for(int vertexIndex = targetVertexIndex; vertexIndex != -1; vertexIndex = previousVertices[vertexIndex])
+    {
+        path.push_back(vertexIndex);
+    }
+    std::reverse(path.begin(), path.end());
+
+    return true;
+}
+
+qint64 GeodesicPathFinder::searchNum() const
+{
+    return mSearchNum;
+}
+
+qint64 GeodesicPathFinder::searchedVertexNum() const
+{
+    return mSearchedVertexNum;
+}
@@ -0,0 +1,99 @@
+#include "IglMeshBoolean.h"
+
+#include <igl/boolean/mesh_boolean.h>
+#include <Eigen/Core>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+void meshToMatrices(const SW::Mesh &mesh, Eigen::MatrixXd &V, Eigen::MatrixXi &F)
+{
+    V.resize(mesh.n_vertices(), 3);
+    for(SW::Mesh::ConstVertexIter vertexIter = mesh.vertices_begin(); vertexIter != mesh.vertices_end(); vertexIter++)
+    {
+        SW::Mesh::Point point = mesh.point(*vertexIter);
+        V(vertexIter->idx(), 0) = point[0];
+        V(vertexIter->idx(), 1) = point[1];
+        V(vertexIter->idx(), 2) = point[2];
+    }
+    F.resize(mesh.n_faces(), 3);
+    int faceIndex = 0;
+    for(SW::Mesh::ConstFaceIter faceIter = mesh.faces_begin(); faceIter != mesh.faces_end(); faceIter++, faceIndex++)
+    {
+        int i = 0;
+        for(SW::Mesh::ConstFaceVertexIter faceVertexIter = mesh.cfv_iter(*faceIter); faceVertexIter.is_valid() && i < 3; faceVertexIter++, i++)
+        {
+            F(faceIndex, i) = faceVertexIter->idx();
+        }
+    }
+}
+
+SW::Mesh matricesToMesh(const Eigen::MatrixXd &V, const Eigen::MatrixXi &F)
+{
+    SW::Mesh mesh;
+    mesh.reserve(V.rows(), V.rows() + F.rows(), F.rows());
+    for(int i = 0; i < V.rows(); i++)
+    {
+        mesh.add_vertex(SW::Mesh::Point(V(i, 0), V(i, 1), V(i, 2)));
+    }
+
+    //与MeshLoader相同：add_face失败的面（非流形）先记下，最后复制其顶点作为孤立面加入
+    std::vector<int> failedFaces;
+    for(int i = 0; i < F.rows(); i++)
+    {
+        if(!mesh.add_face(OpenMesh::VertexHandle(F(i, 0)), OpenMesh::VertexHandle(F(i, 1)), OpenMesh::VertexHandle(F(i, 2))).is_valid())
+        {
+            failedFaces.push_back(i);
+        }
+    }
+    if(!failedFaces.empty())
+    {
+        std::cerr << "iglMeshBoolean: " << failedFaces.size() << " faces failed, adding them as isolated faces" << std::endl;
+    }
+    for(size_t i = 0; i < failedFaces.size(); i++)
+    {
+        OpenMesh::VertexHandle isolatedVertexHandles[3];
+        for(int j = 0; j < 3; j++)
+        {
+            isolatedVertexHandles[j] = mesh.add_vertex(mesh.point(OpenMesh::VertexHandle(F(failedFaces[i], j))));
+        }
+        mesh.add_face(isolatedVertexHandles[0], isolatedVertexHandles[1], isolatedVertexHandles[2]);
+    }
+    return mesh;
+}
+
+}
+
+SW::Mesh SW::iglMeshBoolean(const Mesh &mesh1, const Mesh &mesh2, BooleanOperation type)
+{
+    Eigen::MatrixXd VA, VB, VC;
+    Eigen::MatrixXi FA, FB, FC;
+    meshToMatrices(mesh1, VA, FA);
+    meshToMatrices(mesh2, VB, FB);
+
+    //与TransformMode一致,第二个模型平移(0.1,0.11,0)
+    VB.col(0).array() += 0.1;
+    VB.col(1).array() += 0.11;
+
+    igl::MeshBooleanType iglType;
+    switch(type)
+    {
+    case UNION:
+        iglType = igl::MESH_BOOLEAN_TYPE_UNION;
+        break;
+    case INTERSECTION:
+        iglType = igl::MESH_BOOLEAN_TYPE_INTERSECT;
+        break;
+    case DIFFERENCE:
+        iglType = igl::MESH_BOOLEAN_TYPE_MINUS;
+        break;
+    default:
+        std::cerr << "iglMeshBoolean: unknown boolean operation " << type << std::endl;
+        return Mesh();
+    }
+
+    igl::mesh_boolean(VA, FA, VB, FB, iglType, VC, FC);
+    return matricesToMesh(VC, FC);
+}
@@ -20,8 +20,8 @@ LTransform::LTransform(SW::Mesh Mesh,std::string Mesh_Path_Save,int Ww, double F
     W=Ww;
     F=Ff;
     LMT_point_size=0;
+    ROI_KRing=0;
     std::vector<double> DMat;//对角矩阵;
-    spMat_C=NULL;
 
     //    Eigen::SparseMatrix<double> *spMat_C_tem= new Eigen::SparseMatrix<double> (Npoint,Npoint);
     //    spMat_C=*()
@@ -30,6 +30,13 @@ LTransform::LTransform(SW::Mesh Mesh,std::string Mesh_Path_Save,int Ww, double F
     Create_spMat_L();
     Create_spMat_F();
 
+    //*****************************
+    //与控制点无关的部分只计算一次;A的非零元结构不随控制点改变(控制点只改变对角元),因此符号分析只做一次;
+    //*****************************
+    FC_spMat_A_base=(spMat.transpose()*spMat)+spMat_F;
+    FC_spMat_B_L=Eigen::MatrixXd(spMat.transpose()*spMat_L);
+    ldltOfA.analyzePattern(FC_spMat_A_base);
+
     //connect(this, SIGNAL(selected_changed()), this, SLOT(updateLaplacian()));
 
     // emit selected_changed();
@@ -39,19 +46,26 @@ LTransform::LTransform(SW::Mesh Mesh,std::string Mesh_Path_Save,int Ww, double F
 
 void LTransform::Run(SW::Mesh &Mesh,QVector<QVector<int> > Select_P_Array, SW::MVector MoveVectors){
 
-    Eigen::SparseMatrix<double> spMat_U(Mpoint,3);
+    Eigen::MatrixXd spMat_U(Mpoint,3);
 
 
     LMT_point=objMesh.Get_limitP_fM(Select_P_Array,MoveVectors);
-    if(LMT_point_size!=LMT_point.size()){
+    if(ROI_KRing>0){
+        //ROI变形:控制点集合改变时重新提取ROI并分解,拖动时只在ROI内回代求解;
+        if(Is_spMat_C_changed()){
+            LMT_point_size=LMT_point.size();
+            Create_ROI(Mesh);
+        }
+        Create_NewMatrix_V_ROI(Mesh);
+        return;
+    }
+    //只有控制点集合改变时才重新做数值分解,拖动控制点时只需回代求解;
+    if(Is_spMat_C_changed()){
         LMT_point_size=LMT_point.size();
         Create_spMat_C();
-        Create_spMat_U(spMat_U);
-        Create_NewMatrix_V(Mesh,*(spMat_C),spMat_U,spMat_F);
-    }else{
-        Create_spMat_U(spMat_U);
-        Create_NewMatrix_V(Mesh,*(spMat_C),spMat_U,spMat_F);
     }
+    Create_spMat_U(spMat_U);
+    Create_NewMatrix_V(Mesh,spMat_U);
 
     // Create_NewMatrix_V(SW::Mesh& Mesh, Eigen::SparseMatrix &spMat_C, Eigen::SparseMatrix &spMat_U){
 
@@ -79,11 +93,15 @@ void LTransform::Create_spMat_V(){
     //遍历输出所有坐标位置;构建笛卡尔坐标矩阵;
     //*****************************
     qDebug() <<"START:spMat_V.insert"<< endl;
+    Mat_V.resize(Mpoint,3);
     for(auto it=objMesh.vertices_begin();it!=objMesh.vertices_end();++it){//MHW::Mesh::VertexIter
         auto point=objMesh.point(it.handle());//OpenMesh::Vec3f
         spMat_V.insert(it.handle().idx(),0) =point[0];
         spMat_V.insert(it.handle().idx(),1) =point[1];
         spMat_V.insert(it.handle().idx(),2) =point[2];
+        Mat_V(it.handle().idx(),0)=point[0];
+        Mat_V(it.handle().idx(),1)=point[1];
+        Mat_V(it.handle().idx(),2)=point[2];
 
         // std::cout<<"x"<<point[0]<<"____y"<<point[1]<<"____z"<<point[2]<<std::endl;
     }
@@ -218,6 +236,18 @@ void LTransform::Create_spMat_L(){
     spMat_L=spMat*spMat_V;//构造拉普拉斯坐标系;//??????????????????????????
 }
 
+bool LTransform::Is_spMat_C_changed(){
+    if(spMat_C_index.size()!=LMT_point.size()){
+        return true;
+    }
+    for(int i=0;i<LMT_point.size();i++){
+        if(spMat_C_index[i]!=LMT_point[i].index){
+            return true;
+        }
+    }
+    return false;
+}
+
 void LTransform::Create_spMat_C(){
 
     //*****************************
@@ -226,52 +256,41 @@ void LTransform::Create_spMat_C(){
     //LMT_point必须已赋值
     //求解笛卡尔坐标;1.构建选择矩阵spMat_C;控制点的索引;
     //*****************************
+    //spMat_C为对角阵,W*spMat_C只改变A的对角元,A_base中对角元均已存在,故不改变非零元结构;
+    //*****************************
     qDebug() <<"START:spMat_C.insert"<< endl;
-    delete spMat_C;
-    spMat_C= new Eigen::SparseMatrix<double> (Mpoint,Mpoint);
-
+    spMat_C_index.resize(LMT_point.size());
+    FC_spMat_A=FC_spMat_A_base;
     for(int i=0;i<LMT_point.size();i++){
-        spMat_C->insert(LMT_point[i].index,LMT_point[i].index)=1;
-
+        spMat_C_index[i]=LMT_point[i].index;
+        FC_spMat_A.coeffRef(LMT_point[i].index,LMT_point[i].index)+=W;
     }
-
-
     qDebug() <<"END:spMat_C.insert"<< endl;
     //*****************************
-    FC_spMat_A=(spMat.transpose()*spMat)+((W*(*spMat_C))+spMat_F);//计算Ax=b中的A
-    lltOfA.compute(FC_spMat_A);//计算X=A`b的A`
+    ldltOfA.factorize(FC_spMat_A);//计算X=A`b的A`(只做数值分解)
+    if(ldltOfA.info()!=Eigen::Success){
+        std::cout<<"error: factorize FC_spMat_A failed"<<std::endl;
+    }
     //*****************************
 }
 
-void LTransform::Create_spMat_U(Eigen::SparseMatrix<double> &spMat_U){
+void LTransform::Create_spMat_U(Eigen::MatrixXd &spMat_U){
     //*****************************
     //2015-06-29 TYPE=Notes
     //*****************************
     //求解笛卡尔坐标;2.构建控制点矩阵spMat_U;
     //*****************************
-    //spMat_U=spMat_V;
-
+    //非控制点取原坐标,控制点取目标坐标;
     //*****************************
-    qDebug() <<"START:spMat_U.insert"<< endl;
+    spMat_U=Mat_V;
     for(int i=0;i<LMT_point.size();i++){
 
-        spMat_U.insert(LMT_point[i].index,0)=LMT_point[i].X;
-        spMat_U.insert(LMT_point[i].index,1)=LMT_point[i].Y;
-        spMat_U.insert(LMT_point[i].index,2)=LMT_point[i].Z;
+        spMat_U(LMT_point[i].index,0)=LMT_point[i].X;
+        spMat_U(LMT_point[i].index,1)=LMT_point[i].Y;
+        spMat_U(LMT_point[i].index,2)=LMT_point[i].Z;
 
     }
 
-
-    for (int k=0; k<spMat_V.outerSize(); ++k)
-        for (Eigen::SparseMatrix<double>::InnerIterator it(spMat_V,k); it; ++it){
-
-            if(!objMesh.is_limitP(LMT_point,it.row())){
-                spMat_U.insert(it.row(),it.col())=it.value();
-            }
-
-        }
-    qDebug() <<"END:spMat_U.insert"<< endl;
-
 }//控制点坐标矩阵;
 
 void LTransform::Create_spMat_F(){
@@ -284,7 +303,7 @@ void LTransform::Create_spMat_F(){
 }//整体位置保持控制矩阵;
 
 
-void LTransform::Create_NewMatrix_V(SW::Mesh& Mesh,Eigen::SparseMatrix<double> &spMat_C, Eigen::SparseMatrix<double> &spMat_U,Eigen::SparseMatrix<double> &spMat_F){
+void LTransform::Create_NewMatrix_V(SW::Mesh& Mesh,Eigen::MatrixXd &spMat_U){
 
     //*****************************
     //    Eigen::SparseMatrix<double> FC_spMat_A;//待求矩阵X的前一项
@@ -303,7 +322,11 @@ void LTransform::Create_NewMatrix_V(SW::Mesh& Mesh,Eigen::SparseMatrix<double> &
     //FC_spMat_A=(spMat.transpose()*spMat)+(W*spMat_C);
     //FC_spMat_B_N3=(spMat.transpose()*spMat_L)+(W*spMat_C*spMat_U);
     // FC_spMat_A=(spMat.transpose()*spMat)+((W*spMat_C)+spMat_F);
-    FC_spMat_B_N3=(spMat.transpose()*spMat_L)+(((W*spMat_C)+spMat_F)*spMat_U);
+    //(W*spMat_C)+spMat_F为对角阵,直接按行累加;
+    FC_spMat_B_N3=FC_spMat_B_L+(F*spMat_U);
+    for(int i=0;i<LMT_point.size();i++){
+        FC_spMat_B_N3.row(LMT_point[i].index)+=W*spMat_U.row(LMT_point[i].index);
+    }
 
 
     //*************************************************************
@@ -315,7 +338,7 @@ void LTransform::Create_NewMatrix_V(SW::Mesh& Mesh,Eigen::SparseMatrix<double> &
 
 
 
-    VV=lltOfA.solve(FC_spMat_B_N3);
+    VV=ldltOfA.solve(FC_spMat_B_N3);
     //Solve_Cholesky(FC_spMat_A,FC_spMat_B_N3);
 
 
@@ -382,7 +405,131 @@ void LTransform::Create_NewMatrix_V(SW::Mesh& Mesh,Eigen::SparseMatrix<double> &
 
 }
 
+void LTransform::Set_ROI(int kRing){
+    ROI_KRing=kRing;
+    spMat_C_index.clear();//下次Run时重新分解;
+}
+
+void LTransform::Create_ROI(SW::Mesh &Mesh){
+    //*****************************
+    //LMT_point必须已赋值
+    //1.还原上一次ROI内的点(新的ROI可能不再包含它们);
+    //*****************************
+    for(int i=0;i<ROI_Vertex.size();i++){
+        OpenMesh::VertexHandle OldPoint(ROI_Vertex[i]);
+        auto Tem_Point=Mesh.point(OldPoint);
+        Tem_Point[0]=Mat_V(ROI_Vertex[i],0);
+        Tem_Point[1]=Mat_V(ROI_Vertex[i],1);
+        Tem_Point[2]=Mat_V(ROI_Vertex[i],2);
+        Mesh.set_point(OldPoint,Tem_Point);
+        ROI_LocalIndex[ROI_Vertex[i]]=-1;
+    }
+    ROI_Vertex.clear();
+    if(ROI_LocalIndex.size()!=Mpoint){
+        ROI_LocalIndex.assign(Mpoint,-1);
+    }
+
+    //*****************************
+    //2.从控制点出发按环扩展ROI_KRing环;
+    //*****************************
+    spMat_C_index.resize(LMT_point.size());
+    for(int i=0;i<LMT_point.size();i++){
+        int index=LMT_point[i].index;
+        spMat_C_index[i]=index;
+        if(ROI_LocalIndex[index]<0){
+            ROI_LocalIndex[index]=ROI_Vertex.size();
+            ROI_Vertex.push_back(index);
+        }
+    }
+    int ringBegin=0;
+    for(int ring=0;ring<ROI_KRing;ring++){
+        int ringEnd=ROI_Vertex.size();
+        for(int i=ringBegin;i<ringEnd;i++){
+            for(SW::Mesh::VertexVertexIter vertexVertexIter=objMesh.vv_iter(OpenMesh::VertexHandle(ROI_Vertex[i]));vertexVertexIter.is_valid();vertexVertexIter++){
+                int index=vertexVertexIter->idx();
+                if(ROI_LocalIndex[index]<0){
+                    ROI_LocalIndex[index]=ROI_Vertex.size();
+                    ROI_Vertex.push_back(index);
+                }
+            }
+        }
+        ringBegin=ringEnd;
+    }
+
+    //*****************************
+    //3.构建ROI内的方程;ROI之外的点固定为原坐标;
+    //*****************************
+    //ROI内第i行:L_II*x_I+L_IB*V_B=L_II*V_I+L_IB*V_B,即L_II*x_I=L_II*V_I;
+    //A=L_II^T*L_II+F*I+W*C;b=L_II^T*L_II*V_I+(F*I+W*C)*U;
+    //*****************************
+    int Npoint_ROI=ROI_Vertex.size();
+    std::vector< Eigen::Triplet<double> > tripletList;
+    ROI_Mat_V.resize(Npoint_ROI,3);
+    for(int i=0;i<Npoint_ROI;i++){
+        ROI_Mat_V.row(i)=Mat_V.row(ROI_Vertex[i]);
+        //spMat为对称矩阵,第ROI_Vertex[i]列即第ROI_Vertex[i]行;
+        for(Eigen::SparseMatrix<double>::InnerIterator it(spMat,ROI_Vertex[i]);it;++it){
+            int j=ROI_LocalIndex[it.row()];
+            if(j>=0){
+                tripletList.push_back(Eigen::Triplet<double>(i,j,it.value()));
+            }
+        }
+    }
+    Eigen::SparseMatrix<double> spMat_ROI(Npoint_ROI,Npoint_ROI);
+    spMat_ROI.setFromTriplets(tripletList.begin(),tripletList.end());
+
+    Eigen::SparseMatrix<double> FC_spMat_A_ROI=spMat_ROI.transpose()*spMat_ROI;
+    for(int i=0;i<Npoint_ROI;i++){
+        FC_spMat_A_ROI.coeffRef(i,i)+=F;
+    }
+    for(int i=0;i<LMT_point.size();i++){
+        int index=ROI_LocalIndex[LMT_point[i].index];
+        FC_spMat_A_ROI.coeffRef(index,index)+=W;
+    }
+    ROI_B_L=spMat_ROI.transpose()*(spMat_ROI*ROI_Mat_V);
+
+    ldltOfROI.compute(FC_spMat_A_ROI);
+    if(ldltOfROI.info()!=Eigen::Success){
+        std::cout<<"error: factorize FC_spMat_A_ROI failed"<<std::endl;
+    }
+    qDebug() <<"ROI vertices:"<<Npoint_ROI<< endl;
+}
+
+void LTransform::Create_NewMatrix_V_ROI(SW::Mesh &Mesh){
+    int Npoint_ROI=ROI_Vertex.size();
+    if(Npoint_ROI==0){
+        return;
+    }
+    //*****************************
+    //控制点坐标矩阵(ROI内)
+    //*****************************
+    Eigen::MatrixXd spMat_U=ROI_Mat_V;
+    for(int i=0;i<LMT_point.size();i++){
+        int index=ROI_LocalIndex[LMT_point[i].index];
+        spMat_U(index,0)=LMT_point[i].X;
+        spMat_U(index,1)=LMT_point[i].Y;
+        spMat_U(index,2)=LMT_point[i].Z;
+    }
+    Eigen::MatrixXd FC_spMat_B_ROI=ROI_B_L+(F*spMat_U);
+    for(int i=0;i<LMT_point.size();i++){
+        int index=ROI_LocalIndex[LMT_point[i].index];
+        FC_spMat_B_ROI.row(index)+=W*spMat_U.row(index);
+    }
+
+    Eigen::MatrixXd VV=ldltOfROI.solve(FC_spMat_B_ROI);
+
+    for(int i=0;i<Npoint_ROI;i++){
+        OpenMesh::VertexHandle NewPoint(ROI_Vertex[i]);
+        auto Tem_Point=Mesh.point(NewPoint);
+        Tem_Point[0]=VV(i,0);
+        Tem_Point[1]=VV(i,1);
+        Tem_Point[2]=VV(i,2);
+        Mesh.set_point(NewPoint,Tem_Point);
+    }
+}
+
 void Do_LTransform::startL(QVector<SW::Mesh>&M){
     meshes=M;
     P  =new MHW::LTransform(meshes[0],"./",10000,0,meshes[0].n_vertices());
+    P->Set_ROI(LAPLACE_ROI_KRING);
 }
@@ -6,8 +6,14 @@
 #include<QGridLayout>
 #include<QProgressDialog>
 #include <QTime>
+#include <QFileInfo>
 
 #include "ToothSegmentation.h"
+#include "StageProfiler.h"
+#include "MeshLoader.h"
+#ifdef IGL_MESH_BOOLEAN
+#include "IglMeshBoolean.h"
+#endif
 
 using namespace std;
 
@@ -16,6 +22,9 @@ SW::MainWindow::MainWindow()
 {
     setupUi(this);
 
+    //设置环境变量TOOTH_SEGMENTATION_PROFILE后，每完成一步牙齿分割即输出各阶段统计报告（<模型>.Profile.json/.csv）
+    StageProfiler::setEnabled(!qgetenv("TOOTH_SEGMENTATION_PROFILE").isEmpty());
+
     // load mesh
     connect(actionOpen, SIGNAL(triggered()), this, SLOT(doActionOpen()) );
 
@@ -41,6 +50,13 @@ SW::MainWindow::MainWindow()
     connect(actionIntersection, SIGNAL(triggered()), this, SLOT(doActionIntersection()));
     connect(actionDifference, SIGNAL(triggered()), this, SLOT(doActionDifference()));
 
+    // boolean engine
+    QActionGroup *booleanEngineActionGroup = new QActionGroup(this);
+    booleanEngineActionGroup->addAction(actionBooleanEngineNefPolyhedron);
+    booleanEngineActionGroup->addAction(actionBooleanEngineIglMeshBoolean);
+    connect(actionBooleanEngineNefPolyhedron, SIGNAL(triggered()), this, SLOT(doActionBooleanEngineNefPolyhedron()));
+    connect(actionBooleanEngineIglMeshBoolean, SIGNAL(triggered()), this, SLOT(doActionBooleanEngineIglMeshBoolean()));
+
     // displaye mode
     connect(actionDisplayVertices, SIGNAL(triggered()), gv, SLOT(toggleDisplayVertices()));
     connect(actionDisplayWireFrame, SIGNAL(triggered()), gv, SLOT(toggleDisplayWireFrame()));
@@ -80,6 +96,14 @@ SW::MainWindow::MainWindow()
 
     mCurrentProcessMode = NONE;
 
+#ifdef IGL_MESH_BOOLEAN
+    setBooleanEngine(IGL_MESH_BOOLEAN_ENGINE);
+#else
+    setBooleanEngine(NEF_POLYHEDRON_ENGINE);
+    //未以CONFIG+=igl_boolean编译时不能选择libigl引擎
+    actionBooleanEngineIglMeshBoolean->setEnabled(false);
+#endif
+
 }
 ///////////////////////////////////////////////////////////////////////////////////
 SW::MainWindow::~MainWindow()
@@ -101,21 +125,14 @@ void SW::MainWindow::doActionOpen()
 
         statusBar()->showMessage(tr("Loading Mesh from ") + filePath);
 
+        //模型旁有未过期的缓存时直接读取缓存，否则解析模型文件并写入缓存
         Mesh mesh(filePath);
-        OpenMesh::IO::Options options;
-        options += OpenMesh::IO::Options::VertexColor;
-        options += OpenMesh::IO::Options::ColorFloat; //TODO ColorFloat只支持*.off和*.ply格式的模型，但是经测试还是读不到颜色信息，不知为何
-        if(!OpenMesh::IO::read_mesh(mesh, filePath.toStdString().c_str(), options))
+        if(!MeshLoader::load(filePath, mesh))
         {
             QMessageBox::information(this, tr("Error"), tr("Error to load ") + filePath);
             return;
         }
 
-        // If the file did not provide vertex normals, then calculate them
-        if (mesh.has_face_normals() && mesh.has_vertex_normals()){
-            mesh.update_normals(); // let the mesh update the normals
-        }
-
         //计算顶点数、面片数、边数
         mesh.computeEntityNumbers();
 
@@ -281,8 +298,8 @@ void SW::MainWindow::doAcationReset(){
         actionToothSegmentationAutomaticCuttingOfGingivaMoveCuttingPlaneUp->setEnabled(false);
         actionToothSegmentationAutomaticCuttingOfGingivaMoveCuttingPlaneDown->setEnabled(false);
 
-        if(mToothSegmentationHistory.size()>0){
-            mToothSegmentation->copyFrom(mToothSegmentationHistory.at(0));
+        if(!mToothSegmentationHistory.isEmpty()){
+            mToothSegmentationHistory.restoreInitialState(*mToothSegmentation);
             //更新显示
             gv->removeAllMeshes();
             gv->addMesh(mToothSegmentation->getToothMesh());
@@ -349,8 +366,8 @@ void SW::MainWindow::doActionToolthSegmentation(bool checked){
         disconnect(mToothSegmentation, SIGNAL(onSaveHistory()), this, SLOT(saveToothSegmentationHistory()));
         disconnect(mToothSegmentation, SIGNAL(onProgramScheduleChanged(int)), this, SLOT(changeToolbarButtonStatusAccordingToToothSegmentationProgramSchedule(int)));
 
-        if(mToothSegmentationHistory.size()>0){
-            mToothSegmentation->copyFrom(mToothSegmentationHistory.at(0));
+        if(!mToothSegmentationHistory.isEmpty()){
+            mToothSegmentationHistory.restoreInitialState(*mToothSegmentation);
             //更新显示
             gv->removeAllMeshes();
             gv->addMesh(mToothSegmentation->getToothMesh());
@@ -366,6 +383,14 @@ void SW::MainWindow::doActionToolthSegmentation(bool checked){
     gv->updateGL();
 }
 
+void SW::MainWindow::doActionBooleanEngineNefPolyhedron(){
+    setBooleanEngine(NEF_POLYHEDRON_ENGINE);
+}
+
+void SW::MainWindow::doActionBooleanEngineIglMeshBoolean(){
+    setBooleanEngine(IGL_MESH_BOOLEAN_ENGINE);
+}
+
 void SW::MainWindow::doActionBooleanOperation(bool checked){
 
     if(checked){
@@ -411,7 +436,7 @@ void SW::MainWindow::doActionToothSegmentationAutomaticCuttingOfGingivaMoveCutti
     time.start();
     mToothSegmentation->automaticCuttingOfGingiva(false, false, 0.05);
     cout << "ToothSegmentationAutomaticCuttingOfGingivaMoveCuttingPlaneUp 用时：" << time.elapsed() / 1000 << "s." << endl;
-    saveToothSegmentationHistory();
+    mToothSegmentationHistory.saveCheckpoint(*mToothSegmentation);
 
     gv->removeAllMeshes();
     gv->addMesh(mToothSegmentation->getToothMesh());
@@ -434,7 +459,7 @@ void SW::MainWindow::doActionToothSegmentationAutomaticCuttingOfGingivaFlipCutti
     time.start();
     mToothSegmentation->automaticCuttingOfGingiva(false, true, 0.0);
     cout << "ToothSegmentationAutomaticCuttingOfGingivaFlipCuttingPlane 用时：" << time.elapsed() / 1000 << "s." << endl;
-    saveToothSegmentationHistory();
+    mToothSegmentationHistory.saveCheckpoint(*mToothSegmentation);
 
     gv->removeAllMeshes();
     gv->addMesh(mToothSegmentation->getToothMesh());
@@ -457,7 +482,7 @@ void SW::MainWindow::doActionToothSegmentationAutomaticCuttingOfGingivaMoveCutti
     time.start();
     mToothSegmentation->automaticCuttingOfGingiva(false, false, -0.05);
     cout << "ToothSegmentationAutomaticCuttingOfGingivaMoveCuttingPlaneDown 用时：" << time.elapsed() / 1000 << "s." << endl;
-    saveToothSegmentationHistory();
+    mToothSegmentationHistory.saveCheckpoint(*mToothSegmentation);
 
     gv->removeAllMeshes();
     gv->addMesh(mToothSegmentation->getToothMesh());
@@ -733,6 +758,18 @@ void SW::MainWindow::setOtherManualOperationActionUnChecked(QAction *checkedActi
         }
     }
 }
+
+void SW::MainWindow::writeToothSegmentationProfile()
+{
+    if(!StageProfiler::isEnabled() || mToothSegmentation == NULL)
+    {
+        return;
+    }
+    QString meshName = mOriginalMeshForSegmentation.MeshName;
+    QString runName = QFileInfo(meshName).fileName();
+    StageProfiler::writeJson(meshName + ".Profile.json", runName);
+    StageProfiler::writeCsv(meshName + ".Profile.csv", runName);
+}
 // main tooth segmentation program
 void SW::MainWindow::doActionToothSegmentationProgramControl()
 {
@@ -741,10 +778,9 @@ void SW::MainWindow::doActionToothSegmentationProgramControl()
 
     if(mToothSegmentation == NULL) {
         mOriginalMeshForSegmentation = gv->getMesh(0);
+        StageProfiler::reset();
         mToothSegmentation = new ToothSegmentation(this, gv->getMesh(0));
-        mToothSegmentationHistory.clear();
-        mToothSegmentationHistory.push_back(*mToothSegmentation);
-        mToothSegmentationUsingIndexInHistory = 0;
+        mToothSegmentationHistory.reset(*mToothSegmentation);
         connect(mToothSegmentation, SIGNAL(onSaveHistory()), this, SLOT(saveToothSegmentationHistory()));
         connect(mToothSegmentation, SIGNAL(onProgramScheduleChanged(int)), this, SLOT(changeToolbarButtonStatusAccordingToToothSegmentationProgramSchedule(int)));
     }
@@ -754,7 +790,8 @@ void SW::MainWindow::doActionToothSegmentationProgramControl()
     case ToothSegmentation::SCHEDULE_START:
         mToothSegmentation->identifyPotentialToothBoundary(false);
         mToothSegmentation->automaticCuttingOfGingiva(false, false, -0.2);
-        saveToothSegmentationHistory();
+        mToothSegmentationHistory.saveCheckpoint(*mToothSegmentation);
+        writeToothSegmentationProfile();
         gv->removeAllMeshes();
         gv->addMesh(mToothSegmentation->getToothMesh());
         if(mToothSegmentation->shouldShowExtraMesh())
@@ -770,7 +807,8 @@ void SW::MainWindow::doActionToothSegmentationProgramControl()
     case ToothSegmentation::SCHEDULE_AutomaticCuttingOfGingiva_FINISHED:
         mToothSegmentation->boundarySkeletonExtraction(false);
         mToothSegmentation->findCuttingPoints(false);
-        saveToothSegmentationHistory();
+        mToothSegmentationHistory.saveCheckpoint(*mToothSegmentation);
+        writeToothSegmentationProfile();
         gv->removeAllMeshes();
         gv->addMesh(mToothSegmentation->getToothMesh());
         if(mToothSegmentation->shouldShowExtraMesh())
@@ -785,7 +823,8 @@ void SW::MainWindow::doActionToothSegmentationProgramControl()
         break;
     case ToothSegmentation::SCHEDULE_FindCuttingPoints_FINISHED:
         mToothSegmentation->refineToothBoundary(false);
-        saveToothSegmentationHistory();
+        mToothSegmentationHistory.saveCheckpoint(*mToothSegmentation);
+        writeToothSegmentationProfile();
         gv->removeAllMeshes();
         gv->addMesh(mToothSegmentation->getToothMesh());
         if(mToothSegmentation->shouldShowExtraMesh()) {
@@ -810,12 +849,8 @@ void SW::MainWindow::keyPressEvent(QKeyEvent *e)
         switch(e->key())
         {
         case Qt::Key_Z: //"Z"（撤销）
-            if(mToothSegmentationUsingIndexInHistory > 0)
+            if(mToothSegmentation && mToothSegmentationHistory.undo(*mToothSegmentation))
             {
-                mToothSegmentationUsingIndexInHistory--;
-                //*mToothSegmentation = *(mToothSegmentationHistory.data() + mToothSegmentationUsingIndexInHistory);
-                //memcpy(mToothSegmentation, mToothSegmentationHistory.data() + mToothSegmentationUsingIndexInHistory, sizeof(ToothSegmentation));
-                mToothSegmentation->copyFrom(mToothSegmentationHistory.at(mToothSegmentationUsingIndexInHistory));
 
                 //更新显示
                 gv->removeAllMeshes();
@@ -831,10 +866,8 @@ void SW::MainWindow::keyPressEvent(QKeyEvent *e)
             }
             break;
         case Qt::Key_R: //"R"（重做）
-            if(mToothSegmentationUsingIndexInHistory < (mToothSegmentationHistory.size() - 1))
+            if(mToothSegmentation && mToothSegmentationHistory.redo(*mToothSegmentation))
             {
-                mToothSegmentationUsingIndexInHistory++;
-                mToothSegmentation->copyFrom(mToothSegmentationHistory.at(mToothSegmentationUsingIndexInHistory));
 
                 //更新显示
                 gv->removeAllMeshes();
@@ -857,6 +890,13 @@ Mesh SW::MainWindow::boolOperation(BooleanOperation type){
 
     m_OrignalMeshForBooleanOpearion[0] = gv->getMesh(0) ;
     m_OrignalMeshForBooleanOpearion[1] = gv->getMesh(1) ;
+    if(mBooleanEngine == IGL_MESH_BOOLEAN_ENGINE){
+#ifdef IGL_MESH_BOOLEAN
+        return iglMeshBoolean(gv->getMesh(0), gv->getMesh(1), type);
+#else
+        cerr << "IGL_MESH_BOOLEAN_ENGINE is not compiled in (qmake CONFIG+=igl_boolean), using Nef polyhedra." << endl;
+#endif
+    }
     TransformMode bool_operation(gv->getMesh(0),gv->getMesh(1));
     Mesh result;
     switch (type) {
@@ -878,12 +918,8 @@ Mesh SW::MainWindow::boolOperation(BooleanOperation type){
 
 void SW::MainWindow::saveToothSegmentationHistory()
 {
-    if(mToothSegmentationUsingIndexInHistory != (mToothSegmentationHistory.size() - 1))
-    {
-        mToothSegmentationHistory.remove(mToothSegmentationUsingIndexInHistory + 1, mToothSegmentationHistory.size() - mToothSegmentationUsingIndexInHistory - 1);
-    }
-    mToothSegmentationHistory.push_back(*mToothSegmentation);
-    mToothSegmentationUsingIndexInHistory++;
+    //手动操作只改变部分顶点的属性，只保存发生变化的顶点
+    mToothSegmentationHistory.saveDelta(*mToothSegmentation);
 }
 
 void SW::MainWindow::changeToolbarButtonStatusAccordingToToothSegmentationProgramSchedule(int programSchedule)
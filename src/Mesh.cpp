@@ -1,5 +1,7 @@
 #include"include/Mesh.h"
 
+#include <GL/gl.h>
+
 using namespace SW;
 //************************************************************//
 //2015/09/07
@@ -430,6 +432,12 @@ void Mesh::draw(int flag,   QVector< QVector<int> > Select_P_Array,MVector MoveV
 
 
 
+void Mesh::drawDecorations()
+{
+    drawOrigin();
+    drawBoundingBox();
+}
+
 void Mesh::drawOrigin()
 {
     glPushMatrix();
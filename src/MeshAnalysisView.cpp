@@ -0,0 +1,299 @@
+#include "MeshAnalysisView.h"
+
+#include <queue>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+//Morton码每个坐标分量的位数（3个分量共30位）
+const int MORTON_BITS = 10;
+
+//将value的低10位分散到每3位中的最低位
+inline unsigned int spreadBits(unsigned int value)
+{
+    value &= 0x3ff;
+    value = (value | (value << 16)) & 0x030000ff;
+    value = (value | (value << 8)) & 0x0300f00f;
+    value = (value | (value << 4)) & 0x030c30c3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+//将坐标在[min, min + size]内量化到MORTON_BITS位
+inline unsigned int quantize(float value, float min, float size)
+{
+    if(size <= 0.0f)
+    {
+        return 0;
+    }
+    const unsigned int maxCell = (1u << MORTON_BITS) - 1;
+    unsigned int cell = (unsigned int)((value - min) / size * maxCell);
+    return cell > maxCell ? maxCell : cell;
+}
+
+class DistanceGreater
+{
+public:
+    inline bool operator() (const std::pair<int, float> &lhs, const std::pair<int, float> &rhs) const
+    {
+        return lhs.second > rhs.second;
+    }
+};
+}
+
+MeshAnalysisView::MeshAnalysisView()
+{
+}
+
+void MeshAnalysisView::build(const Mesh &mesh, bool reorder)
+{
+    clear();
+    gatherPositions(mesh);
+
+    //按Morton码重新编号后再按新编号读取一次坐标
+    if(reorder && vertexNum() > 0)
+    {
+        computeMortonOrder(mViewToMesh);
+        int vertexNum = this->vertexNum();
+        mMeshToView.resize(vertexNum);
+        for(int viewIndex = 0; viewIndex < vertexNum; viewIndex++)
+        {
+            mMeshToView[mViewToMesh.at(viewIndex)] = viewIndex;
+        }
+        gatherPositions(mesh);
+    }
+
+    mAdjacency.build(mesh, mViewToMesh);
+    computeNormals(mesh);
+}
+
+void MeshAnalysisView::updateGeometry(const Mesh &mesh)
+{
+    assert((int)mesh.n_vertices() == vertexNum());
+    gatherPositions(mesh);
+    computeNormals(mesh);
+}
+
+void MeshAnalysisView::updateGeometry(const Mesh &mesh, const QVector<Mesh::VertexHandle> &movedVertexHandles)
+{
+    assert((int)mesh.n_vertices() == vertexNum());
+
+    //顶点移动后，其所在面的法向改变，这些面上的顶点（即其1邻域）的法向都要重新计算
+    std::vector<int> normalVertices;
+    for(int i = 0; i < movedVertexHandles.size(); i++)
+    {
+        int movedIndex = viewIndex(movedVertexHandles[i].idx());
+        const Mesh::Point &tempPoint = mesh.point(movedVertexHandles[i]);
+        mPositionX[movedIndex] = tempPoint[0];
+        mPositionY[movedIndex] = tempPoint[1];
+        mPositionZ[movedIndex] = tempPoint[2];
+        mBoundingBoxMin.minimize(tempPoint);
+        mBoundingBoxMax.maximize(tempPoint);
+
+        normalVertices.push_back(movedIndex);
+        const int *neighbors = mAdjacency.neighbors(movedIndex);
+        int neighborNum = mAdjacency.neighborNum(movedIndex);
+        normalVertices.insert(normalVertices.end(), neighbors, neighbors + neighborNum);
+    }
+    std::sort(normalVertices.begin(), normalVertices.end());
+    normalVertices.erase(std::unique(normalVertices.begin(), normalVertices.end()), normalVertices.end());
+
+    //与computeNormals()的累加顺序相同，结果与整体更新逐位一致
+    for(std::vector<int>::const_iterator vi = normalVertices.begin(); vi != normalVertices.end(); vi++)
+    {
+        Mesh::Normal tempNormal(0.0, 0.0, 0.0);
+        for(Mesh::ConstVertexFaceIter vertexFaceIter = mesh.cvf_iter(vertexHandle(*vi)); vertexFaceIter.is_valid(); vertexFaceIter++)
+        {
+            tempNormal += mesh.calc_face_normal(*vertexFaceIter);
+        }
+        Mesh::Scalar norm = tempNormal.length();
+        if(norm != 0.0)
+        {
+            tempNormal *= (Mesh::Scalar(1.0) / norm);
+        }
+        mNormalX[*vi] = tempNormal[0];
+        mNormalY[*vi] = tempNormal[1];
+        mNormalZ[*vi] = tempNormal[2];
+    }
+}
+
+void MeshAnalysisView::clear()
+{
+    mPositionX.clear();
+    mPositionY.clear();
+    mPositionZ.clear();
+    mNormalX.clear();
+    mNormalY.clear();
+    mNormalZ.clear();
+    mAdjacency.clear();
+    mViewToMesh.clear();
+    mMeshToView.clear();
+    mBoundingBoxMin = Mesh::Point(0.0, 0.0, 0.0);
+    mBoundingBoxMax = Mesh::Point(0.0, 0.0, 0.0);
+}
+
+bool MeshAnalysisView::isEmpty() const
+{
+    return mPositionX.isEmpty();
+}
+
+void MeshAnalysisView::sphere(int centerIndex, float radius, int minNum, VertexAdjacency::SearchBuffer &buffer, std::vector<int> &neighborhood) const
+{
+    buffer.nextEpoch(vertexNum());
+    unsigned int *visitedStamp = buffer.visitedStamp.data();
+    const unsigned int epoch = buffer.visitedEpoch;
+
+    std::vector< std::pair<int, int> > &queue = buffer.queue;
+    queue.clear();
+    queue.push_back(std::pair<int, int>(centerIndex, 0));
+    visitedStamp[centerIndex] = epoch;
+
+    Mesh::Point center = point(centerIndex);
+    std::priority_queue< std::pair<int, float>, std::vector< std::pair<int, float> >, DistanceGreater > extraCandidates;
+    float distance;
+    for(size_t queueHead = 0; queueHead < queue.size(); queueHead++)
+    {
+        int toVisit = queue[queueHead].first;
+        neighborhood.push_back(toVisit);
+        const int *neighborVertices = mAdjacency.neighbors(toVisit);
+        int neighborVertexNum = mAdjacency.neighborNum(toVisit);
+        for(int i = 0; i < neighborVertexNum; i++)
+        {
+            int neighbor = neighborVertices[i];
+            if(visitedStamp[neighbor] != epoch)
+            {
+                distance = (center - point(neighbor)).norm();
+                if(distance < radius)
+                {
+                    queue.push_back(std::pair<int, int>(neighbor, 0));
+                }
+                else if((int)neighborhood.size() < minNum)
+                {
+                    extraCandidates.push(std::pair<int, float>(neighbor, distance));
+                }
+                visitedStamp[neighbor] = epoch;
+            }
+        }
+    }
+
+    while(!extraCandidates.empty() && (int)neighborhood.size() < minNum)
+    {
+        std::pair<int, float> candidate = extraCandidates.top();
+        extraCandidates.pop();
+        neighborhood.push_back(candidate.first);
+        const int *neighborVertices = mAdjacency.neighbors(candidate.first);
+        int neighborVertexNum = mAdjacency.neighborNum(candidate.first);
+        for(int i = 0; i < neighborVertexNum; i++)
+        {
+            int neighbor = neighborVertices[i];
+            if(visitedStamp[neighbor] != epoch)
+            {
+                distance = (center - point(neighbor)).norm();
+                extraCandidates.push(std::pair<int, float>(neighbor, distance));
+                visitedStamp[neighbor] = epoch;
+            }
+        }
+    }
+}
+
+void MeshAnalysisView::gatherPositions(const Mesh &mesh)
+{
+    int vertexNum = mesh.n_vertices();
+    mPositionX.resize(vertexNum);
+    mPositionY.resize(vertexNum);
+    mPositionZ.resize(vertexNum);
+    float *x = mPositionX.data();
+    float *y = mPositionY.data();
+    float *z = mPositionZ.data();
+    const int *viewToMesh = mViewToMesh.constData();
+    bool reordered = isReordered();
+
+#pragma omp parallel for schedule(static)
+    for(int viewIndex = 0; viewIndex < vertexNum; viewIndex++)
+    {
+        const Mesh::Point &tempPoint = mesh.point(mesh.vertex_handle(reordered ? viewToMesh[viewIndex] : viewIndex));
+        x[viewIndex] = tempPoint[0];
+        y[viewIndex] = tempPoint[1];
+        z[viewIndex] = tempPoint[2];
+    }
+
+    if(vertexNum == 0)
+    {
+        mBoundingBoxMin = Mesh::Point(0.0, 0.0, 0.0);
+        mBoundingBoxMax = Mesh::Point(0.0, 0.0, 0.0);
+        return;
+    }
+    mBoundingBoxMin = mBoundingBoxMax = Mesh::Point(x[0], y[0], z[0]);
+    for(int viewIndex = 1; viewIndex < vertexNum; viewIndex++)
+    {
+        mBoundingBoxMin.minimize(Mesh::Point(x[viewIndex], y[viewIndex], z[viewIndex]));
+        mBoundingBoxMax.maximize(Mesh::Point(x[viewIndex], y[viewIndex], z[viewIndex]));
+    }
+}
+
+void MeshAnalysisView::computeMortonOrder(QVector<int> &vertexOrder) const
+{
+    int vertexNum = this->vertexNum();
+    const float *x = mPositionX.constData();
+    const float *y = mPositionY.constData();
+    const float *z = mPositionZ.constData();
+    Mesh::Point size = mBoundingBoxMax - mBoundingBoxMin;
+
+    //Morton码相同的顶点保持原有顺序
+    std::vector< std::pair<unsigned int, int> > codes(vertexNum);
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        unsigned int cellX = quantize(x[vertexIndex], mBoundingBoxMin[0], size[0]);
+        unsigned int cellY = quantize(y[vertexIndex], mBoundingBoxMin[1], size[1]);
+        unsigned int cellZ = quantize(z[vertexIndex], mBoundingBoxMin[2], size[2]);
+        codes[vertexIndex] = std::pair<unsigned int, int>(spreadBits(cellX) | (spreadBits(cellY) << 1) | (spreadBits(cellZ) << 2), vertexIndex);
+    }
+    std::sort(codes.begin(), codes.end());
+
+    vertexOrder.resize(vertexNum);
+    for(int viewIndex = 0; viewIndex < vertexNum; viewIndex++)
+    {
+        vertexOrder[viewIndex] = codes[viewIndex].second;
+    }
+}
+
+void MeshAnalysisView::computeNormals(const Mesh &mesh)
+{
+    int vertexNum = this->vertexNum();
+    int faceNum = mesh.n_faces();
+    mNormalX.resize(vertexNum);
+    mNormalY.resize(vertexNum);
+    mNormalZ.resize(vertexNum);
+
+    //面法向和顶点法向的计算方式与update_normals()完全相同（顶点处按vf_iter顺序累加），结果逐位一致
+    QVector<Mesh::Normal> faceNormals(faceNum);
+    Mesh::Normal *faceNormalData = faceNormals.data();
+#pragma omp parallel for schedule(static)
+    for(int faceIndex = 0; faceIndex < faceNum; faceIndex++)
+    {
+        faceNormalData[faceIndex] = mesh.calc_face_normal(mesh.face_handle(faceIndex));
+    }
+
+    float *normalX = mNormalX.data();
+    float *normalY = mNormalY.data();
+    float *normalZ = mNormalZ.data();
+#pragma omp parallel for schedule(static)
+    for(int viewIndex = 0; viewIndex < vertexNum; viewIndex++)
+    {
+        Mesh::Normal tempNormal(0.0, 0.0, 0.0);
+        for(Mesh::ConstVertexFaceIter vertexFaceIter = mesh.cvf_iter(vertexHandle(viewIndex)); vertexFaceIter.is_valid(); vertexFaceIter++)
+        {
+            tempNormal += faceNormalData[vertexFaceIter->idx()];
+        }
+        Mesh::Scalar norm = tempNormal.length();
+        if(norm != 0.0)
+        {
+            tempNormal *= (Mesh::Scalar(1.0) / norm);
+        }
+        normalX[viewIndex] = tempNormal[0];
+        normalY[viewIndex] = tempNormal[1];
+        normalZ[viewIndex] = tempNormal[2];
+    }
+}
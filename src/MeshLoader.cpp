@@ -0,0 +1,902 @@
+#include "MeshLoader.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QCryptographicHash>
+#if QT_VERSION >= 0x050000
+#include <QStandardPaths>
+#endif
+
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <vector>
+#include <unordered_map>
+
+#include <omp.h>
+
+namespace
+{
+
+//缓存文件头，其后依次为顶点坐标（float×3）、三角形顶点索引（int×3）和顶点法向（float×3）
+struct CacheHeader
+{
+    quint32 magic;
+    quint32 version;
+    qint64 sourceSize; //模型文件的大小和修改时间（毫秒），与当前文件不一致时缓存失效
+    qint64 sourceModified;
+    qint32 vertexNum;
+    qint32 triangleNum;
+};
+
+const quint32 CACHE_MAGIC = 0x48534d53; //"SMSH"
+const quint32 CACHE_VERSION = 2;
+
+//OBJ中的负数（相对）索引在分块解析时还不知道之前各块的顶点数，先记为(块内顶点数+索引-RELATIVE_INDEX_BASE)，合并时再加上块的顶点偏移
+const int RELATIVE_INDEX_BASE = 1 << 30;
+
+const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+//按换行符划分的一段文本（只包含完整的行）
+struct TextChunk
+{
+    const char *begin, *end;
+
+    TextChunk() : begin(NULL), end(NULL) {}
+    TextChunk(const char *begin, const char *end) : begin(begin), end(end) {}
+};
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+//跳过行内的空白
+inline const char* skipSpaces(const char *p, const char *end)
+{
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+        p++;
+    }
+    return p;
+}
+
+//跳过空白（包括换行）和#开头的注释行
+inline const char* skipSpacesAndComments(const char *p, const char *end)
+{
+    while(p < end)
+    {
+        if(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        {
+            p++;
+        }
+        else if(*p == '#')
+        {
+            const char *newline = (const char*)memchr(p, '\n', end - p);
+            p = (newline == NULL) ? end : newline + 1;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return p;
+}
+
+inline const char* lineEnd(const char *p, const char *end)
+{
+    const char *newline = (const char*)memchr(p, '\n', end - p);
+    return (newline == NULL) ? end : newline;
+}
+
+//该行在p之后是否还有（注释以外的）内容
+inline bool hasMoreData(const char *p, const char *end)
+{
+    p = skipSpaces(p, end);
+    return p < end && *p != '#';
+}
+
+/*
+  解析[p, end)开头的十进制浮点数，约定与std::from_chars相同：成功时返回数字之后的位置，失败时返回NULL。
+  有效数字最多取19位，用不超过1e22的10的幂（可精确表示）乘除，结果转为float后与strtof一致（极少数舍入边界情况除外）。
+  不支持inf、nan和十六进制，遇到时解析失败，由调用者改用OpenMesh读取。
+*/
+const char* parseFloat(const char *p, const char *end, float &value)
+{
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+    quint64 mantissa = 0;
+    int exponent = 0, significantDigitNum = 0;
+    bool hasDigit = false;
+    for(; p < end && isDigit(*p); p++)
+    {
+        hasDigit = true;
+        if(significantDigitNum < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa > 0)
+            {
+                significantDigitNum++;
+            }
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+    if(p < end && *p == '.')
+    {
+        for(p++; p < end && isDigit(*p); p++)
+        {
+            hasDigit = true;
+            if(significantDigitNum < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa > 0)
+                {
+                    significantDigitNum++;
+                }
+                exponent--;
+            }
+        }
+    }
+    if(!hasDigit)
+    {
+        return NULL;
+    }
+    if(p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        bool negativeExponent = false;
+        if(q < end && (*q == '-' || *q == '+'))
+        {
+            negativeExponent = (*q == '-');
+            q++;
+        }
+        if(q < end && isDigit(*q))
+        {
+            int exponentValue = 0;
+            for(; q < end && isDigit(*q); q++)
+            {
+                if(exponentValue < 10000)
+                {
+                    exponentValue = exponentValue * 10 + (*q - '0');
+                }
+            }
+            exponent += negativeExponent ? -exponentValue : exponentValue;
+            p = q;
+        }
+    }
+
+    double result = (double)mantissa;
+    if(exponent < 0)
+    {
+        result = (exponent >= -22) ? result / POWERS_OF_TEN[-exponent] : result * pow(10.0, exponent);
+    }
+    else if(exponent > 0)
+    {
+        result = (exponent <= 22) ? result * POWERS_OF_TEN[exponent] : result * pow(10.0, exponent);
+    }
+    value = (float)(negative ? -result : result);
+    return p;
+}
+
+//解析[p, end)开头的十进制整数，成功时返回数字之后的位置，失败时返回NULL
+const char* parseInt(const char *p, const char *end, int &value)
+{
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+    if(p >= end || !isDigit(*p))
+    {
+        return NULL;
+    }
+    qint64 result = 0;
+    for(; p < end && isDigit(*p); p++)
+    {
+        if(result < RELATIVE_INDEX_BASE)
+        {
+            result = result * 10 + (*p - '0');
+        }
+    }
+    if(result >= RELATIVE_INDEX_BASE)
+    {
+        return NULL;
+    }
+    value = negative ? -(int)result : (int)result;
+    return p;
+}
+
+//解析一行中的3个坐标，该行还有其他数据（如顶点颜色）时返回false
+bool parsePosition(const char *p, const char *end, float *position)
+{
+    for(int i = 0; i < 3; i++)
+    {
+        p = parseFloat(skipSpaces(p, end), end, position[i]);
+        if(p == NULL)
+        {
+            return false;
+        }
+    }
+    return !hasMoreData(p, end);
+}
+
+//将[begin, end)划分为大致等长的chunkNum段，每段在换行符之后结束
+QVector<TextChunk> splitLines(const char *begin, const char *end, int chunkNum)
+{
+    QVector<TextChunk> chunks;
+    qint64 size = end - begin;
+    const char *chunkBegin = begin;
+    for(int i = 1; i <= chunkNum && chunkBegin < end; i++)
+    {
+        const char *chunkEnd = begin + size * i / chunkNum;
+        if(chunkEnd < chunkBegin)
+        {
+            chunkEnd = chunkBegin;
+        }
+        if(chunkEnd < end)
+        {
+            chunkEnd = lineEnd(chunkEnd, end);
+            if(chunkEnd < end)
+            {
+                chunkEnd++;
+            }
+        }
+        chunks.push_back(TextChunk(chunkBegin, chunkEnd));
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+//多边形按扇形三角化（与TriMesh::add_face对多边形的处理相同）
+inline void appendPolygon(const QVector<int> &polygon, QVector<int> &triangles)
+{
+    for(int i = 1; i + 1 < polygon.size(); i++)
+    {
+        triangles.push_back(polygon[0]);
+        triangles.push_back(polygon[i]);
+        triangles.push_back(polygon[i + 1]);
+    }
+}
+
+//按块的顺序拼接各块的解析结果
+void concatenate(const QVector< QVector<float> > &chunkValues, QVector<float> &values)
+{
+    QVector<int> offsets(chunkValues.size() + 1, 0);
+    for(int i = 0; i < chunkValues.size(); i++)
+    {
+        offsets[i + 1] = offsets[i] + chunkValues[i].size();
+    }
+    values.resize(offsets.back());
+    float *valuesData = values.data();
+    #pragma omp parallel for
+    for(int i = 0; i < chunkValues.size(); i++)
+    {
+        if(!chunkValues[i].isEmpty())
+        {
+            memcpy(valuesData + offsets[i], chunkValues[i].constData(), chunkValues[i].size() * sizeof(float));
+        }
+    }
+}
+
+void concatenate(const QVector< QVector<int> > &chunkValues, QVector<int> &values, QVector<int> &offsets)
+{
+    offsets.fill(0, chunkValues.size() + 1);
+    for(int i = 0; i < chunkValues.size(); i++)
+    {
+        offsets[i + 1] = offsets[i] + chunkValues[i].size();
+    }
+    values.resize(offsets.back());
+    int *valuesData = values.data();
+    #pragma omp parallel for
+    for(int i = 0; i < chunkValues.size(); i++)
+    {
+        if(!chunkValues[i].isEmpty())
+        {
+            memcpy(valuesData + offsets[i], chunkValues[i].constData(), chunkValues[i].size() * sizeof(int));
+        }
+    }
+}
+
+//二进制STL中合并顶点用的键，按float坐标精确比较
+struct PositionKey
+{
+    float x, y, z;
+
+    PositionKey(const float *position) : x(position[0] + 0.0f), y(position[1] + 0.0f), z(position[2] + 0.0f) {} //+0.0f把-0.0f变为0.0f
+
+    bool operator==(const PositionKey &other) const
+    {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+struct PositionKeyHash
+{
+    size_t operator()(const PositionKey &key) const
+    {
+        quint32 bits[3];
+        memcpy(bits, &key, sizeof(bits));
+        size_t seed = bits[0];
+        seed ^= bits[1] + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= bits[2] + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
+}
+
+QString MeshLoader::cacheDirectory()
+{
+#if QT_VERSION >= 0x050000
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+#else
+    QString directory; //Qt4中对应的QDesktopServices::storageLocation属于QtGui，批处理程序不链接QtGui
+#endif
+    if(directory.isEmpty())
+    {
+        directory = QDir::tempPath();
+    }
+    return directory + "/meshcache";
+}
+
+QString MeshLoader::cacheFilename(const QString &filename)
+{
+    //不同目录下的同名模型由绝对路径的哈希区分
+    QFileInfo sourceInfo(filename);
+    QByteArray pathHash = QCryptographicHash::hash(sourceInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex();
+    return cacheDirectory() + "/" + sourceInfo.fileName() + "." + QString::fromLatin1(pathHash) + ".meshcache";
+}
+
+bool MeshLoader::load(const QString &filename, Mesh &mesh, bool useCache)
+{
+    if(useCache && readCache(filename, mesh))
+    {
+        return true;
+    }
+
+    MeshData meshData;
+    bool parsed = false;
+    QFile file(filename);
+    if(file.open(QIODevice::ReadOnly) && file.size() > 0)
+    {
+        const char *data = (const char*)file.map(0, file.size());
+        if(data != NULL)
+        {
+            QString suffix = QFileInfo(filename).suffix().toLower();
+            if(suffix == "obj")
+            {
+                parsed = parseObj(data, file.size(), meshData);
+            }
+            else if(suffix == "off")
+            {
+                parsed = parseOff(data, file.size(), meshData);
+            }
+            else if(suffix == "stl")
+            {
+                parsed = parseBinaryStl(data, file.size(), meshData);
+            }
+            file.unmap((uchar*)data);
+        }
+    }
+    file.close();
+
+    bool cacheable = true;
+    if(parsed)
+    {
+        buildMesh(meshData.positions.constData(), meshData.positions.size() / 3, meshData.triangles.constData(), meshData.triangles.size() / 3, mesh);
+    }
+    else
+    {
+        //其他格式，或带颜色、法向等附加数据的文件，由OpenMesh读取；这些附加数据不能存入缓存
+        OpenMesh::IO::Options readOptions;
+        readOptions += OpenMesh::IO::Options::VertexColor;
+        readOptions += OpenMesh::IO::Options::ColorFloat;
+        if(!OpenMesh::IO::read_mesh(mesh, filename.toStdString(), readOptions))
+        {
+            return false;
+        }
+        cacheable = !readOptions.vertex_has_color() && !readOptions.vertex_has_normal() && !readOptions.vertex_has_texcoord() && !readOptions.face_has_color();
+    }
+
+    if(mesh.has_face_normals() && mesh.has_vertex_normals())
+    {
+        mesh.update_normals();
+    }
+    else if(mesh.has_face_normals())
+    {
+        mesh.update_face_normals();
+    }
+
+    if(useCache && cacheable && mesh.n_vertices() > 0)
+    {
+        writeCache(filename, mesh);
+    }
+    return true;
+}
+
+/*
+  各块并行解析出顶点和三角形，再按块的顺序拼接，并把相对索引换算为全局索引。
+  只处理v和f行，其余行（vn、vt、g、usemtl、注释等）忽略，与OpenMesh不读取法向和纹理坐标时的结果相同。
+*/
+bool MeshLoader::parseObj(const char *data, qint64 size, MeshData &meshData)
+{
+    QVector<TextChunk> chunks = splitLines(data, data + size, omp_get_max_threads() * 4);
+    int chunkNum = chunks.size();
+    QVector< QVector<float> > chunkPositions(chunkNum);
+    QVector< QVector<int> > chunkTriangles(chunkNum);
+    QVector<int> chunkVertexNums(chunkNum, 0);
+    QVector<int> chunkHasRelativeIndex(chunkNum, 0);
+    QVector<int> chunkFailed(chunkNum, 0); //各块分别记录是否解析失败，并行循环结束后再合并
+    int *chunkFailedData = chunkFailed.data();
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int chunkIndex = 0; chunkIndex < chunkNum; chunkIndex++)
+    {
+        QVector<float> &positions = chunkPositions[chunkIndex];
+        QVector<int> &triangles = chunkTriangles[chunkIndex];
+        QVector<int> polygon;
+        bool failed = false;
+        const char *end = chunks[chunkIndex].end;
+        for(const char *line = chunks[chunkIndex].begin; line < end && !failed; )
+        {
+            const char *currentLineEnd = lineEnd(line, end);
+            const char *p = skipSpaces(line, currentLineEnd);
+            line = currentLineEnd + 1;
+            if(currentLineEnd - p < 2 || (p[1] != ' ' && p[1] != '\t'))
+            {
+                continue;
+            }
+            if(p[0] == 'v')
+            {
+                float position[3];
+                if(!parsePosition(p + 2, currentLineEnd, position))
+                {
+                    failed = true;
+                    break;
+                }
+                positions.push_back(position[0]);
+                positions.push_back(position[1]);
+                positions.push_back(position[2]);
+            }
+            else if(p[0] == 'f')
+            {
+                polygon.clear();
+                for(p += 2; hasMoreData(p, currentLineEnd); )
+                {
+                    int index = 0;
+                    p = parseInt(skipSpaces(p, currentLineEnd), currentLineEnd, index);
+                    if(p == NULL || index == 0)
+                    {
+                        failed = true;
+                        break;
+                    }
+                    if(index > 0)
+                    {
+                        polygon.push_back(index - 1);
+                    }
+                    else
+                    {
+                        polygon.push_back(positions.size() / 3 + index - RELATIVE_INDEX_BASE);
+                        chunkHasRelativeIndex[chunkIndex] = 1;
+                    }
+                    //跳过纹理坐标和法向索引（v/vt/vn、v//vn）
+                    while(p < currentLineEnd && *p != ' ' && *p != '\t' && *p != '\r')
+                    {
+                        p++;
+                    }
+                }
+                if(failed || polygon.size() < 3)
+                {
+                    failed = true;
+                    break;
+                }
+                appendPolygon(polygon, triangles);
+            }
+        }
+        chunkVertexNums[chunkIndex] = positions.size() / 3;
+        chunkFailedData[chunkIndex] = failed;
+    }
+    if(chunkFailed.contains(1))
+    {
+        return false;
+    }
+
+    concatenate(chunkPositions, meshData.positions);
+    QVector<int> triangleOffsets;
+    concatenate(chunkTriangles, meshData.triangles, triangleOffsets);
+    chunkPositions.clear();
+    chunkTriangles.clear();
+
+    QVector<int> vertexOffsets(chunkNum, 0);
+    for(int i = 1; i < chunkNum; i++)
+    {
+        vertexOffsets[i] = vertexOffsets[i - 1] + chunkVertexNums[i - 1];
+    }
+    int vertexNum = meshData.positions.size() / 3;
+    int *triangles = meshData.triangles.data();
+    #pragma omp parallel for
+    for(int chunkIndex = 0; chunkIndex < chunkNum; chunkIndex++)
+    {
+        for(int i = triangleOffsets[chunkIndex]; i < triangleOffsets[chunkIndex + 1]; i++)
+        {
+            if(chunkHasRelativeIndex[chunkIndex] && triangles[i] < 0)
+            {
+                triangles[i] += vertexOffsets[chunkIndex] + RELATIVE_INDEX_BASE;
+            }
+            if(triangles[i] < 0 || triangles[i] >= vertexNum)
+            {
+                chunkFailedData[chunkIndex] = 1;
+            }
+        }
+    }
+    return !chunkFailed.contains(1) && vertexNum > 0;
+}
+
+/*
+  只处理以"OFF"开头的纯文本格式（COFF、NOFF、二进制OFF等由OpenMesh读取）。
+  第一遍并行统计每块中的数据行（非空、非注释）数，得到每块第一行的全局行号；
+  第二遍并行解析，全局行号小于顶点数的为顶点行（直接写入坐标数组），之后的为面行。
+*/
+bool MeshLoader::parseOff(const char *data, qint64 size, MeshData &meshData)
+{
+    const char *end = data + size;
+    const char *p = skipSpacesAndComments(data, end);
+    if(end - p < 3 || memcmp(p, "OFF", 3) != 0 || (end - p > 3 && !isspace((unsigned char)p[3])))
+    {
+        return false;
+    }
+    int vertexNum = 0, faceNum = 0, edgeNum = 0;
+    p = parseInt(skipSpacesAndComments(p + 3, end), end, vertexNum);
+    if(p == NULL || (p = parseInt(skipSpacesAndComments(p, end), end, faceNum)) == NULL || vertexNum <= 0 || faceNum < 0)
+    {
+        return false;
+    }
+    const char *countLineEnd = lineEnd(p, end);
+    if(hasMoreData(p, countLineEnd) && parseInt(skipSpaces(p, countLineEnd), countLineEnd, edgeNum) == NULL)
+    {
+        return false;
+    }
+    const char *body = (countLineEnd < end) ? countLineEnd + 1 : end;
+
+    QVector<TextChunk> chunks = splitLines(body, end, omp_get_max_threads() * 4);
+    int chunkNum = chunks.size();
+    QVector<int> chunkLineNums(chunkNum + 1, 0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int chunkIndex = 0; chunkIndex < chunkNum; chunkIndex++)
+    {
+        int lineNum = 0;
+        const char *chunkEnd = chunks[chunkIndex].end;
+        for(const char *line = chunks[chunkIndex].begin; line < chunkEnd; )
+        {
+            const char *currentLineEnd = lineEnd(line, chunkEnd);
+            if(hasMoreData(line, currentLineEnd))
+            {
+                lineNum++;
+            }
+            line = currentLineEnd + 1;
+        }
+        chunkLineNums[chunkIndex + 1] = lineNum;
+    }
+    for(int i = 0; i < chunkNum; i++)
+    {
+        chunkLineNums[i + 1] += chunkLineNums[i];
+    }
+    if(chunkLineNums.back() < vertexNum + faceNum)
+    {
+        return false;
+    }
+
+    meshData.positions.resize(vertexNum * 3);
+    float *positions = meshData.positions.data();
+    QVector< QVector<int> > chunkTriangles(chunkNum);
+    QVector<int> chunkFailed(chunkNum, 0); //各块分别记录是否解析失败，并行循环结束后再合并
+    int *chunkFailedData = chunkFailed.data();
+    #pragma omp parallel for schedule(dynamic)
+    for(int chunkIndex = 0; chunkIndex < chunkNum; chunkIndex++)
+    {
+        int lineIndex = chunkLineNums[chunkIndex];
+        if(lineIndex >= vertexNum + faceNum)
+        {
+            continue;
+        }
+        QVector<int> &triangles = chunkTriangles[chunkIndex];
+        QVector<int> polygon;
+        bool failed = false;
+        const char *chunkEnd = chunks[chunkIndex].end;
+        for(const char *line = chunks[chunkIndex].begin; line < chunkEnd && lineIndex < vertexNum + faceNum && !failed; )
+        {
+            const char *currentLineEnd = lineEnd(line, chunkEnd);
+            const char *p = line;
+            line = currentLineEnd + 1;
+            if(!hasMoreData(p, currentLineEnd))
+            {
+                continue;
+            }
+            if(lineIndex < vertexNum)
+            {
+                if(!parsePosition(p, currentLineEnd, positions + lineIndex * 3))
+                {
+                    failed = true;
+                }
+            }
+            else
+            {
+                int polygonSize = 0;
+                p = parseInt(skipSpaces(p, currentLineEnd), currentLineEnd, polygonSize);
+                if(p == NULL || polygonSize < 3)
+                {
+                    failed = true;
+                    break;
+                }
+                polygon.resize(polygonSize);
+                for(int i = 0; i < polygonSize && p != NULL; i++)
+                {
+                    p = parseInt(skipSpaces(p, currentLineEnd), currentLineEnd, polygon[i]);
+                    if(p != NULL && (polygon[i] < 0 || polygon[i] >= vertexNum))
+                    {
+                        p = NULL;
+                    }
+                }
+                if(p == NULL)
+                {
+                    failed = true;
+                    break;
+                }
+                appendPolygon(polygon, triangles); //面颜色等其余数据忽略
+            }
+            lineIndex++;
+        }
+        chunkFailedData[chunkIndex] = failed;
+    }
+    if(chunkFailed.contains(1))
+    {
+        return false;
+    }
+    QVector<int> triangleOffsets;
+    concatenate(chunkTriangles, meshData.triangles, triangleOffsets);
+    return true;
+}
+
+//二进制STL：80字节文件头，4字节面片数，每个面片50字节（法向、3个顶点坐标和2字节属性）；文件大小不符时按ASCII STL处理（由OpenMesh读取）
+bool MeshLoader::parseBinaryStl(const char *data, qint64 size, MeshData &meshData)
+{
+    if(size < 84)
+    {
+        return false;
+    }
+    quint32 facetNum = 0;
+    memcpy(&facetNum, data + 80, 4);
+    if(84 + 50 * (qint64)facetNum != size)
+    {
+        return false;
+    }
+
+    std::unordered_map<PositionKey, int, PositionKeyHash> vertexIndices;
+    vertexIndices.reserve(facetNum / 2 + 3);
+    meshData.positions.clear();
+    meshData.triangles.clear();
+    meshData.positions.reserve(facetNum * 3 / 2 + 9);
+    meshData.triangles.reserve(facetNum * 3);
+    for(quint32 facetIndex = 0; facetIndex < facetNum; facetIndex++)
+    {
+        float facet[9];
+        memcpy(facet, data + 84 + 50 * (qint64)facetIndex + 12, sizeof(facet));
+        int triangle[3];
+        for(int i = 0; i < 3; i++)
+        {
+            std::pair<std::unordered_map<PositionKey, int, PositionKeyHash>::iterator, bool> inserted =
+                    vertexIndices.insert(std::make_pair(PositionKey(facet + i * 3), (int)(meshData.positions.size() / 3)));
+            if(inserted.second)
+            {
+                meshData.positions.push_back(facet[i * 3]);
+                meshData.positions.push_back(facet[i * 3 + 1]);
+                meshData.positions.push_back(facet[i * 3 + 2]);
+            }
+            triangle[i] = inserted.first->second;
+        }
+        //与OpenMesh读取STL时相同，跳过退化的面片
+        if(triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0])
+        {
+            meshData.triangles.push_back(triangle[0]);
+            meshData.triangles.push_back(triangle[1]);
+            meshData.triangles.push_back(triangle[2]);
+        }
+    }
+    return !meshData.positions.isEmpty();
+}
+
+void MeshLoader::buildMesh(const float *positions, int vertexNum, const int *triangles, int triangleNum, Mesh &mesh)
+{
+    mesh.clear();
+    mesh.reserve(vertexNum, triangleNum * 3 / 2, triangleNum);
+    std::vector<Mesh::VertexHandle> vertexHandles(vertexNum);
+    for(int i = 0; i < vertexNum; i++)
+    {
+        vertexHandles[i] = mesh.add_vertex(Mesh::Point(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]));
+    }
+
+    //与OpenMesh的ImporterT相同：有重复顶点或add_face失败的面先记下，最后复制其顶点作为孤立面加入
+    QVector<int> failedTriangles;
+    for(int i = 0; i < triangleNum; i++)
+    {
+        const int *triangle = triangles + i * 3;
+        if(triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0]
+                || !mesh.add_face(vertexHandles[triangle[0]], vertexHandles[triangle[1]], vertexHandles[triangle[2]]).is_valid())
+        {
+            failedTriangles.push_back(i);
+        }
+    }
+    if(!failedTriangles.isEmpty())
+    {
+        omerr() << failedTriangles.size() << " faces failed, adding them as isolated faces\n";
+    }
+    for(int i = 0; i < failedTriangles.size(); i++)
+    {
+        const int *triangle = triangles + failedTriangles[i] * 3;
+        Mesh::VertexHandle isolatedVertexHandles[3];
+        for(int j = 0; j < 3; j++)
+        {
+            Mesh::Point point = mesh.point(vertexHandles[triangle[j]]);
+            isolatedVertexHandles[j] = mesh.add_vertex(point);
+        }
+        mesh.add_face(isolatedVertexHandles[0], isolatedVertexHandles[1], isolatedVertexHandles[2]);
+    }
+}
+
+bool MeshLoader::readCache(const QString &filename, Mesh &mesh)
+{
+    QFileInfo sourceInfo(filename);
+    QFile cacheFile(cacheFilename(filename));
+    if(!sourceInfo.exists() || !cacheFile.open(QIODevice::ReadOnly) || cacheFile.size() < (qint64)sizeof(CacheHeader))
+    {
+        return false;
+    }
+    const uchar *data = cacheFile.map(0, cacheFile.size());
+    if(data == NULL)
+    {
+        return false;
+    }
+    CacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    bool valid = header.magic == CACHE_MAGIC && header.version == CACHE_VERSION
+            && header.sourceSize == sourceInfo.size() && header.sourceModified == sourceInfo.lastModified().toMSecsSinceEpoch()
+            && header.vertexNum > 0 && header.triangleNum >= 0
+            && cacheFile.size() == (qint64)sizeof(header) + (qint64)header.vertexNum * 24 + (qint64)header.triangleNum * 12;
+    if(valid)
+    {
+        const float *positions = (const float*)(data + sizeof(header));
+        const int *triangles = (const int*)(positions + header.vertexNum * 3);
+        const float *normals = (const float*)(triangles + header.triangleNum * 3);
+        for(qint64 i = 0; i < (qint64)header.triangleNum * 3 && valid; i++)
+        {
+            valid = (triangles[i] >= 0 && triangles[i] < header.vertexNum);
+        }
+        if(valid)
+        {
+            buildMesh(positions, header.vertexNum, triangles, header.triangleNum, mesh);
+            valid = ((int)mesh.n_vertices() == header.vertexNum);
+        }
+        if(valid && mesh.has_vertex_normals())
+        {
+            for(int i = 0; i < header.vertexNum; i++)
+            {
+                mesh.set_normal(Mesh::VertexHandle(i), Mesh::Normal(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]));
+            }
+        }
+        if(valid && mesh.has_face_normals())
+        {
+            mesh.update_face_normals();
+        }
+    }
+    cacheFile.unmap((uchar*)data);
+    cacheFile.close();
+    return valid;
+}
+
+bool MeshLoader::writeCache(const QString &filename, const Mesh &mesh)
+{
+    QFileInfo sourceInfo(filename);
+    CacheHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.sourceSize = sourceInfo.size();
+    header.sourceModified = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.vertexNum = mesh.n_vertices();
+    header.triangleNum = mesh.n_faces();
+
+    QVector<float> positions(header.vertexNum * 3);
+    QVector<int> triangles(header.triangleNum * 3);
+    QVector<Mesh::Normal> faceNormals(header.triangleNum);
+    QVector<float> normals(header.vertexNum * 3);
+    float *positionsData = positions.data();
+    int *trianglesData = triangles.data();
+    Mesh::Normal *faceNormalsData = faceNormals.data();
+    float *normalsData = normals.data();
+
+    #pragma omp parallel for
+    for(int i = 0; i < header.vertexNum; i++)
+    {
+        Mesh::Point point = mesh.point(Mesh::VertexHandle(i));
+        positionsData[i * 3] = point[0];
+        positionsData[i * 3 + 1] = point[1];
+        positionsData[i * 3 + 2] = point[2];
+    }
+
+    int invalidFaceNum = 0; //不是三角形的面数
+    #pragma omp parallel for reduction(+:invalidFaceNum)
+    for(int i = 0; i < header.triangleNum; i++)
+    {
+        int j = 0;
+        for(Mesh::ConstFaceVertexIter faceVertexIter = mesh.cfv_iter(Mesh::FaceHandle(i)); faceVertexIter.is_valid(); ++faceVertexIter, j++)
+        {
+            if(j < 3)
+            {
+                trianglesData[i * 3 + j] = faceVertexIter.handle().idx();
+            }
+        }
+        if(j != 3)
+        {
+            invalidFaceNum++;
+            continue;
+        }
+        faceNormalsData[i] = mesh.calc_face_normal(Mesh::FaceHandle(i));
+    }
+    if(invalidFaceNum > 0)
+    {
+        return false;
+    }
+
+    //与update_normals()相同：相邻面法向之和再单位化
+    #pragma omp parallel for
+    for(int i = 0; i < header.vertexNum; i++)
+    {
+        Mesh::Normal normal(0, 0, 0);
+        for(Mesh::ConstVertexFaceIter vertexFaceIter = mesh.cvf_iter(Mesh::VertexHandle(i)); vertexFaceIter.is_valid(); ++vertexFaceIter)
+        {
+            normal += faceNormalsData[vertexFaceIter.handle().idx()];
+        }
+        float length = normal.length();
+        if(length != 0)
+        {
+            normal /= length;
+        }
+        normalsData[i * 3] = normal[0];
+        normalsData[i * 3 + 1] = normal[1];
+        normalsData[i * 3 + 2] = normal[2];
+    }
+
+    //先写入临时文件再改名，避免其他进程读到不完整的缓存
+    QString cacheFile = cacheFilename(filename);
+    if(!QDir().mkpath(cacheDirectory()))
+    {
+        return false;
+    }
+    QFile file(cacheFile + ".tmp");
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    bool written = file.write((const char*)&header, sizeof(header)) == (qint64)sizeof(header)
+            && file.write((const char*)positionsData, positions.size() * sizeof(float)) == (qint64)(positions.size() * sizeof(float))
+            && file.write((const char*)trianglesData, triangles.size() * sizeof(int)) == (qint64)(triangles.size() * sizeof(int))
+            && file.write((const char*)normalsData, normals.size() * sizeof(float)) == (qint64)(normals.size() * sizeof(float));
+    file.close();
+    if(!written)
+    {
+        file.remove();
+        return false;
+    }
+    QFile::remove(cacheFile);
+    return file.rename(cacheFile);
+}
@@ -0,0 +1,281 @@
+#include "MeshRenderer.h"
+
+#include <math.h>
+
+#define BUFFER_OFFSET(offset) ((GLvoid*)(offset))
+
+MeshRenderer::MeshRenderer()
+{
+    mBuffersCreated = false;
+    for(int i = 0; i < BUFFER_NUM; i++)
+    {
+        mBuffers[i] = 0;
+        mBufferBytes[i] = 0;
+    }
+}
+
+MeshRenderer::~MeshRenderer()
+{
+    release();
+}
+
+void MeshRenderer::release()
+{
+    if(mBuffersCreated)
+    {
+        glDeleteBuffers(BUFFER_NUM, mBuffers);
+        mBuffersCreated = false;
+    }
+    for(int i = 0; i < BUFFER_NUM; i++)
+    {
+        mBuffers[i] = 0;
+        mBufferBytes[i] = 0;
+    }
+    mPositions.clear();
+    mNormals.clear();
+    mColors.clear();
+    mFaceIndices.clear();
+    mEdgeIndices.clear();
+}
+
+void MeshRenderer::update(const Mesh &mesh)
+{
+    if(!mBuffersCreated)
+    {
+        glGenBuffers(BUFFER_NUM, mBuffers);
+        mBuffersCreated = true;
+    }
+
+    int vertexNum = mesh.n_vertices();
+
+    //拓扑（三角形索引）
+    QVector<GLuint> faceIndices;
+    faceIndices.reserve(mesh.n_faces() * 3);
+    for(Mesh::ConstFaceIter faceIter = mesh.faces_begin(); faceIter != mesh.faces_end(); faceIter++)
+    {
+        for(Mesh::ConstFaceVertexIter faceVertexIter = mesh.cfv_iter(*faceIter); faceVertexIter.is_valid(); faceVertexIter++)
+        {
+            faceIndices.push_back(faceVertexIter->idx());
+        }
+    }
+    bool topologyChanged = (faceIndices != mFaceIndices);
+    if(topologyChanged)
+    {
+        mFaceIndices.swap(faceIndices);
+        uploadBuffer(FACE_INDEX_BUFFER, GL_ELEMENT_ARRAY_BUFFER, mFaceIndices.constData(), mFaceIndices.size() * sizeof(GLuint));
+
+        mEdgeIndices.resize(mesh.n_edges() * 2);
+        int edgeIndex = 0;
+        for(Mesh::ConstEdgeIter edgeIter = mesh.edges_begin(); edgeIter != mesh.edges_end(); edgeIter++, edgeIndex++)
+        {
+            mEdgeIndices[edgeIndex * 2] = mesh.to_vertex_handle(mesh.halfedge_handle(*edgeIter, 0)).idx();
+            mEdgeIndices[edgeIndex * 2 + 1] = mesh.to_vertex_handle(mesh.halfedge_handle(*edgeIter, 1)).idx();
+        }
+        uploadBuffer(EDGE_INDEX_BUFFER, GL_ELEMENT_ARRAY_BUFFER, mEdgeIndices.constData(), mEdgeIndices.size() * sizeof(GLuint));
+    }
+
+    //顶点坐标，坐标或拓扑改变时需重新计算法向量
+    QVector<GLfloat> positions(vertexNum * 3);
+    for(Mesh::ConstVertexIter vertexIter = mesh.vertices_begin(); vertexIter != mesh.vertices_end(); vertexIter++)
+    {
+        Mesh::Point point = mesh.point(*vertexIter);
+        int index = vertexIter->idx() * 3;
+        positions[index] = point[0];
+        positions[index + 1] = point[1];
+        positions[index + 2] = point[2];
+    }
+    if(topologyChanged || positions != mPositions)
+    {
+        mPositions.swap(positions);
+        uploadBuffer(POSITION_BUFFER, GL_ARRAY_BUFFER, mPositions.constData(), mPositions.size() * sizeof(GLfloat));
+        computeNormals();
+        uploadBuffer(NORMAL_BUFFER, GL_ARRAY_BUFFER, mNormals.constData(), mNormals.size() * sizeof(GLfloat));
+        uploadFlatGeometry();
+    }
+
+    //顶点颜色，没有颜色属性时为白色
+    QVector<GLfloat> colors(vertexNum * 3, 1.0f);
+    if(mesh.has_vertex_colors())
+    {
+        for(Mesh::ConstVertexIter vertexIter = mesh.vertices_begin(); vertexIter != mesh.vertices_end(); vertexIter++)
+        {
+            Mesh::Color color = mesh.color(*vertexIter);
+            int index = vertexIter->idx() * 3;
+            colors[index] = color[0];
+            colors[index + 1] = color[1];
+            colors[index + 2] = color[2];
+        }
+    }
+    if(topologyChanged || colors != mColors)
+    {
+        mColors.swap(colors);
+        uploadBuffer(COLOR_BUFFER, GL_ARRAY_BUFFER, mColors.constData(), mColors.size() * sizeof(GLfloat));
+        uploadFlatColors();
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void MeshRenderer::draw(int flag)
+{
+    if(!mBuffersCreated || mPositions.isEmpty())
+    {
+        return;
+    }
+
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffers[POSITION_BUFFER]);
+    glVertexPointer(3, GL_FLOAT, 0, BUFFER_OFFSET(0));
+    glEnableClientState(GL_VERTEX_ARRAY);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffers[NORMAL_BUFFER]);
+    glNormalPointer(GL_FLOAT, 0, BUFFER_OFFSET(0));
+    glEnableClientState(GL_NORMAL_ARRAY);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffers[COLOR_BUFFER]);
+    glColorPointer(3, GL_FLOAT, 0, BUFFER_OFFSET(0));
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    switch(flag)
+    {
+    case 0:
+        glPointSize(5);
+        glDrawArrays(GL_POINTS, 0, mPositions.size() / 3);
+        break;
+    case 1:
+        //边为白色，再画顶点
+        glDisableClientState(GL_COLOR_ARRAY);
+        glColor3f(1.0f, 1.0f, 1.0f);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mBuffers[EDGE_INDEX_BUFFER]);
+        glDrawElements(GL_LINES, mEdgeIndices.size(), GL_UNSIGNED_INT, BUFFER_OFFSET(0));
+        glEnableClientState(GL_COLOR_ARRAY);
+        glPointSize(5);
+        glDrawArrays(GL_POINTS, 0, mPositions.size() / 3);
+        break;
+    case 2:
+        //面片顶点不共享，每个面片使用面片法向量和平均颜色
+        glBindBuffer(GL_ARRAY_BUFFER, mBuffers[FLAT_POSITION_BUFFER]);
+        glVertexPointer(3, GL_FLOAT, 0, BUFFER_OFFSET(0));
+        glBindBuffer(GL_ARRAY_BUFFER, mBuffers[FLAT_NORMAL_BUFFER]);
+        glNormalPointer(GL_FLOAT, 0, BUFFER_OFFSET(0));
+        glBindBuffer(GL_ARRAY_BUFFER, mBuffers[FLAT_COLOR_BUFFER]);
+        glColorPointer(3, GL_FLOAT, 0, BUFFER_OFFSET(0));
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glDrawArrays(GL_TRIANGLES, 0, mFaceIndices.size());
+        break;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glPopClientAttrib();
+}
+
+void MeshRenderer::computeNormals()
+{
+    mNormals.fill(0.0f, mPositions.size());
+    for(int i = 0; i + 2 < mFaceIndices.size(); i += 3)
+    {
+        const GLfloat *p0 = mPositions.constData() + mFaceIndices[i] * 3;
+        const GLfloat *p1 = mPositions.constData() + mFaceIndices[i + 1] * 3;
+        const GLfloat *p2 = mPositions.constData() + mFaceIndices[i + 2] * 3;
+        GLfloat e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        GLfloat e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        //叉积的模为面积的两倍，直接累加即为按面积加权
+        GLfloat faceNormal[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        for(int j = 0; j < 3; j++)
+        {
+            GLfloat *normal = mNormals.data() + mFaceIndices[i + j] * 3;
+            normal[0] += faceNormal[0];
+            normal[1] += faceNormal[1];
+            normal[2] += faceNormal[2];
+        }
+    }
+    for(int i = 0; i < mNormals.size(); i += 3)
+    {
+        GLfloat length = sqrt(mNormals[i] * mNormals[i] + mNormals[i + 1] * mNormals[i + 1] + mNormals[i + 2] * mNormals[i + 2]);
+        if(length > 0)
+        {
+            mNormals[i] /= length;
+            mNormals[i + 1] /= length;
+            mNormals[i + 2] /= length;
+        }
+    }
+}
+
+void MeshRenderer::uploadFlatGeometry()
+{
+    int flatVertexNum = mFaceIndices.size();
+    QVector<GLfloat> flatPositions(flatVertexNum * 3);
+    QVector<GLfloat> flatNormals(flatVertexNum * 3);
+    for(int i = 0; i + 2 < flatVertexNum; i += 3)
+    {
+        const GLfloat *p0 = mPositions.constData() + mFaceIndices[i] * 3;
+        const GLfloat *p1 = mPositions.constData() + mFaceIndices[i + 1] * 3;
+        const GLfloat *p2 = mPositions.constData() + mFaceIndices[i + 2] * 3;
+        GLfloat e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        GLfloat e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        GLfloat faceNormal[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        GLfloat length = sqrt(faceNormal[0] * faceNormal[0] + faceNormal[1] * faceNormal[1] + faceNormal[2] * faceNormal[2]);
+        if(length > 0)
+        {
+            faceNormal[0] /= length;
+            faceNormal[1] /= length;
+            faceNormal[2] /= length;
+        }
+        for(int j = 0; j < 3; j++)
+        {
+            const GLfloat *point = mPositions.constData() + mFaceIndices[i + j] * 3;
+            GLfloat *flatPosition = flatPositions.data() + (i + j) * 3;
+            GLfloat *flatNormal = flatNormals.data() + (i + j) * 3;
+            for(int k = 0; k < 3; k++)
+            {
+                flatPosition[k] = point[k];
+                flatNormal[k] = faceNormal[k];
+            }
+        }
+    }
+    uploadBuffer(FLAT_POSITION_BUFFER, GL_ARRAY_BUFFER, flatPositions.constData(), flatPositions.size() * sizeof(GLfloat));
+    uploadBuffer(FLAT_NORMAL_BUFFER, GL_ARRAY_BUFFER, flatNormals.constData(), flatNormals.size() * sizeof(GLfloat));
+}
+
+void MeshRenderer::uploadFlatColors()
+{
+    int flatVertexNum = mFaceIndices.size();
+    QVector<GLfloat> flatColors(flatVertexNum * 3);
+    for(int i = 0; i + 2 < flatVertexNum; i += 3)
+    {
+        GLfloat faceColor[3] = {0.0f, 0.0f, 0.0f};
+        for(int j = 0; j < 3; j++)
+        {
+            const GLfloat *color = mColors.constData() + mFaceIndices[i + j] * 3;
+            faceColor[0] += color[0];
+            faceColor[1] += color[1];
+            faceColor[2] += color[2];
+        }
+        for(int j = 0; j < 3; j++)
+        {
+            GLfloat *flatColor = flatColors.data() + (i + j) * 3;
+            flatColor[0] = faceColor[0] / 3.0f;
+            flatColor[1] = faceColor[1] / 3.0f;
+            flatColor[2] = faceColor[2] / 3.0f;
+        }
+    }
+    uploadBuffer(FLAT_COLOR_BUFFER, GL_ARRAY_BUFFER, flatColors.constData(), flatColors.size() * sizeof(GLfloat));
+}
+
+void MeshRenderer::uploadBuffer(BufferType type, GLenum target, const void *data, int bytes)
+{
+    glBindBuffer(target, mBuffers[type]);
+    if(bytes == mBufferBytes[type])
+    {
+        glBufferSubData(target, 0, bytes, data);
+    }
+    else
+    {
+        //颜色可能频繁修改，其他属性只在模型改变时上传
+        glBufferData(target, bytes, data, (type == COLOR_BUFFER || type == FLAT_COLOR_BUFFER) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        mBufferBytes[type] = bytes;
+    }
+}
@@ -0,0 +1,47 @@
+#include "ProgressReporter.h"
+
+#include <iostream>
+
+using namespace std;
+
+ConsoleProgressReporter::ConsoleProgressReporter(const QString &prefix)
+{
+    mPrefix = prefix;
+}
+
+void ConsoleProgressReporter::setWindowTitle(const QString &title)
+{
+    cout << mPrefix.toStdString() << title.toStdString() << endl;
+}
+
+void ConsoleProgressReporter::setLabelText(const QString &text)
+{
+    //同一阶段内会反复设置相同的文字，只在改变时输出
+    if(text != mLabelText)
+    {
+        mLabelText = text;
+        cout << mPrefix.toStdString() << "  " << text.toStdString() << endl;
+    }
+}
+
+void ConsoleProgressReporter::setMinimum(int minimum)
+{
+}
+
+void ConsoleProgressReporter::setMaximum(int maximum)
+{
+}
+
+void ConsoleProgressReporter::setValue(int value)
+{
+}
+
+void ConsoleProgressReporter::close()
+{
+    mLabelText.clear();
+}
+
+void ConsoleProgressReporter::showMessage(const QString &title, const QString &text)
+{
+    cout << mPrefix.toStdString() << "[" << title.toStdString() << "] " << QString(text).replace('\n', ' ').toStdString() << endl;
+}
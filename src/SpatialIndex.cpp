@@ -0,0 +1,291 @@
+#include "SpatialIndex.h"
+#include "StageProfiler.h"
+
+#include <QPair>
+
+#include <algorithm>
+
+namespace
+{
+
+//按某一坐标轴比较点的索引（用于nth_element取中位数）
+struct AxisLess
+{
+    const Mesh::Point *points;
+    int axis;
+
+    AxisLess(const Mesh::Point *points, int axis) : points(points), axis(axis) {}
+
+    bool operator()(int index1, int index2) const
+    {
+        return points[index1][axis] < points[index2][axis];
+    }
+};
+
+inline float squaredDistance(const Mesh::Point &point1, const Mesh::Point &point2)
+{
+    float x_ = point1[0] - point2[0];
+    float y_ = point1[1] - point2[1];
+    float z_ = point1[2] - point2[2];
+    return x_ * x_ + y_ * y_ + z_ * z_;
+}
+
+inline Mesh::Point toPoint(const QPoint &point)
+{
+    return Mesh::Point(point.x(), point.y(), 0.0f);
+}
+
+}
+
+SpatialIndex::SpatialIndex()
+{
+}
+
+void SpatialIndex::build(const QVector<Mesh::Point> &points)
+{
+    clear();
+    mPoints = points;
+    int pointNum = mPoints.size();
+    if(pointNum == 0)
+    {
+        return;
+    }
+
+    mPointIndices.resize(pointNum);
+    for(int i = 0; i < pointNum; i++)
+    {
+        mPointIndices[i] = i;
+    }
+    mNodes.reserve(2 * (pointNum / LEAF_SIZE + 1));
+    buildNode(0, pointNum);
+}
+
+void SpatialIndex::build(const QVector<QPoint> &points)
+{
+    QVector<Mesh::Point> points3D(points.size());
+    for(int i = 0; i < points.size(); i++)
+    {
+        points3D[i] = toPoint(points[i]);
+    }
+    build(points3D);
+}
+
+void SpatialIndex::clear()
+{
+    mPoints.clear();
+    mPointIndices.clear();
+    mNodes.clear();
+}
+
+bool SpatialIndex::isEmpty() const
+{
+    return mNodes.isEmpty();
+}
+
+int SpatialIndex::size() const
+{
+    return mPoints.size();
+}
+
+int SpatialIndex::buildNode(int begin, int end)
+{
+    int nodeIndex = mNodes.size();
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.left = -1;
+    node.right = -1;
+    node.splitAxis = 0;
+    node.splitValue = 0.0f;
+    mNodes.push_back(node);
+
+    if(end - begin <= LEAF_SIZE)
+    {
+        return nodeIndex;
+    }
+
+    //沿包围盒最长的坐标轴在中位数处划分
+    const Mesh::Point *points = mPoints.constData();
+    int *indices = mPointIndices.data();
+    Mesh::Point minPoint = points[indices[begin]], maxPoint = points[indices[begin]];
+    for(int i = begin + 1; i < end; i++)
+    {
+        minPoint.minimize(points[indices[i]]);
+        maxPoint.maximize(points[indices[i]]);
+    }
+    Mesh::Point extent = maxPoint - minPoint;
+    int splitAxis = 0;
+    if(extent[1] > extent[splitAxis])
+    {
+        splitAxis = 1;
+    }
+    if(extent[2] > extent[splitAxis])
+    {
+        splitAxis = 2;
+    }
+
+    int middle = (begin + end) / 2;
+    std::nth_element(indices + begin, indices + middle, indices + end, AxisLess(points, splitAxis));
+    //子节点建立时会继续重排各自范围内的索引，划分值要在递归之前取出
+    float splitValue = points[indices[middle]][splitAxis];
+
+    int left = buildNode(begin, middle);
+    int right = buildNode(middle, end);
+    //mNodes在递归中可能重新分配，最后再写回子节点信息
+    mNodes[nodeIndex].left = left;
+    mNodes[nodeIndex].right = right;
+    mNodes[nodeIndex].splitAxis = splitAxis;
+    mNodes[nodeIndex].splitValue = splitValue;
+    return nodeIndex;
+}
+
+int SpatialIndex::nearest(const Mesh::Point &query) const
+{
+    QVector<int> result;
+    kNearest(query, 1, result);
+    return result.isEmpty() ? -1 : result[0];
+}
+
+void SpatialIndex::kNearest(const Mesh::Point &query, int k, QVector<int> &result) const
+{
+    result.clear();
+    if(isEmpty() || k <= 0)
+    {
+        return;
+    }
+
+    //heap为按距离排列的最大堆，保存当前找到的最近的k个点
+    QVector< QPair<float, int> > heap;
+    heap.reserve(k + 1);
+    kNearest(0, query, k, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+    result.resize(heap.size());
+    for(int i = 0; i < heap.size(); i++)
+    {
+        result[i] = heap[i].second;
+    }
+}
+
+void SpatialIndex::kNearest(int nodeIndex, const Mesh::Point &query, int k, QVector< QPair<float, int> > &heap) const
+{
+    const Node &node = mNodes.at(nodeIndex);
+    if(node.left < 0)
+    {
+        for(int i = node.begin; i < node.end; i++)
+        {
+            int pointIndex = mPointIndices.at(i);
+            float d = squaredDistance(query, mPoints.at(pointIndex));
+            if(heap.size() < k)
+            {
+                heap.push_back(qMakePair(d, pointIndex));
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if(d < heap.front().first)
+            {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = qMakePair(d, pointIndex);
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        return;
+    }
+
+    //先搜索query所在一侧，另一侧只有在划分平面比当前第k近的点更近时才需要搜索
+    float diff = query[node.splitAxis] - node.splitValue;
+    int nearChild = (diff < 0) ? node.left : node.right;
+    int farChild = (diff < 0) ? node.right : node.left;
+    kNearest(nearChild, query, k, heap);
+    if(heap.size() < k || diff * diff < heap.front().first)
+    {
+        kNearest(farChild, query, k, heap);
+    }
+}
+
+void SpatialIndex::radiusSearch(const Mesh::Point &query, float radius, QVector<int> &result) const
+{
+    result.clear();
+    if(isEmpty() || radius < 0)
+    {
+        return;
+    }
+    radiusSearch(0, query, radius * radius, result);
+}
+
+void SpatialIndex::radiusSearch(int nodeIndex, const Mesh::Point &query, float squaredRadius, QVector<int> &result) const
+{
+    const Node &node = mNodes.at(nodeIndex);
+    if(node.left < 0)
+    {
+        for(int i = node.begin; i < node.end; i++)
+        {
+            int pointIndex = mPointIndices.at(i);
+            if(squaredDistance(query, mPoints.at(pointIndex)) <= squaredRadius)
+            {
+                result.push_back(pointIndex);
+            }
+        }
+        return;
+    }
+
+    float diff = query[node.splitAxis] - node.splitValue;
+    if(diff < 0 || diff * diff <= squaredRadius)
+    {
+        radiusSearch(node.left, query, squaredRadius, result);
+    }
+    if(diff >= 0 || diff * diff <= squaredRadius)
+    {
+        radiusSearch(node.right, query, squaredRadius, result);
+    }
+}
+
+QVector< QVector<int> > SpatialIndex::kNearestNeighbours(int k, const QVector<Mesh::Point> &querys) const
+{
+    int queryNum = querys.size();
+    StageProfiler::addCounter("kNNQueries", queryNum);
+    QVector< QVector<int> > neighbours(queryNum);
+    QVector<int> *neighboursData = neighbours.data();
+    const Mesh::Point *queryData = querys.constData();
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for(int i = 0; i < queryNum; i++)
+    {
+        kNearest(queryData[i], k, neighboursData[i]);
+    }
+
+    return neighbours;
+}
+
+QVector< QVector<int> > SpatialIndex::kNearestNeighbours(int k, const QVector<QPoint> &querys) const
+{
+    int queryNum = querys.size();
+    StageProfiler::addCounter("kNNQueries", queryNum);
+    QVector< QVector<int> > neighbours(queryNum);
+    QVector<int> *neighboursData = neighbours.data();
+    const QPoint *queryData = querys.constData();
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for(int i = 0; i < queryNum; i++)
+    {
+        kNearest(toPoint(queryData[i]), k, neighboursData[i]);
+    }
+
+    return neighbours;
+}
+
+QVector< QVector<int> > SpatialIndex::radiusNeighbours(float radius, const QVector<Mesh::Point> &querys) const
+{
+    int queryNum = querys.size();
+    StageProfiler::addCounter("radiusQueries", queryNum);
+    QVector< QVector<int> > neighbours(queryNum);
+    QVector<int> *neighboursData = neighbours.data();
+    const Mesh::Point *queryData = querys.constData();
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for(int i = 0; i < queryNum; i++)
+    {
+        radiusSearch(queryData[i], radius, neighboursData[i]);
+    }
+
+    return neighbours;
+}
@@ -0,0 +1,234 @@
+#include "StageProfiler.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+
+#include <iostream>
+#include <stdio.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+bool StageProfiler::sEnabled = false;
+QVector<StageProfiler::Record> StageProfiler::sRecords;
+QVector<int> StageProfiler::sOpenRecordIndices;
+QElapsedTimer StageProfiler::sTimer;
+
+namespace
+{
+//JSON字符串转义（名称中只会出现普通字符，这里只处理必须转义的字符）
+QString jsonString(const QString &text)
+{
+    QString escaped = text;
+    escaped.replace("\\", "\\\\");
+    escaped.replace("\"", "\\\"");
+    escaped.replace("\n", "\\n");
+    return "\"" + escaped + "\"";
+}
+
+QString milliseconds(qint64 nanoseconds)
+{
+    return QString::number(nanoseconds / 1e6, 'f', 3);
+}
+}
+
+void StageProfiler::setEnabled(bool enabled)
+{
+    sEnabled = enabled;
+    if(enabled && !sTimer.isValid())
+    {
+        sTimer.start();
+    }
+}
+
+void StageProfiler::reset()
+{
+    sRecords.clear();
+    sOpenRecordIndices.clear();
+    sTimer.start();
+}
+
+const QVector<StageProfiler::Record>& StageProfiler::records()
+{
+    return sRecords;
+}
+
+int StageProfiler::begin(const char *name)
+{
+    Record record;
+    record.name = QString(name);
+    if(!sOpenRecordIndices.isEmpty())
+    {
+        record.name = sRecords.at(sOpenRecordIndices.back()).name + "/" + record.name;
+    }
+    record.depth = sOpenRecordIndices.size();
+    record.startNanoseconds = sTimer.nsecsElapsed();
+    record.elapsedNanoseconds = 0;
+    record.memoryStartKB = currentMemoryKB();
+    record.memoryEndKB = record.memoryStartKB;
+    record.memoryPeakKB = record.memoryStartKB;
+    sRecords.push_back(record);
+    sOpenRecordIndices.push_back(sRecords.size() - 1);
+    return sRecords.size() - 1;
+}
+
+void StageProfiler::end(int recordIndex)
+{
+    //reset()可能在Scope未结束时被调用，此时该Scope的记录已不存在
+    if(sOpenRecordIndices.isEmpty() || sOpenRecordIndices.back() != recordIndex)
+    {
+        return;
+    }
+    sampleMemory();
+    Record &record = sRecords[recordIndex];
+    record.elapsedNanoseconds = sTimer.nsecsElapsed() - record.startNanoseconds;
+    record.memoryEndKB = currentMemoryKB();
+    sOpenRecordIndices.pop_back();
+
+    //子步骤的峰值计入外层
+    if(!sOpenRecordIndices.isEmpty())
+    {
+        Record &parentRecord = sRecords[sOpenRecordIndices.back()];
+        parentRecord.memoryPeakKB = qMax(parentRecord.memoryPeakKB, record.memoryPeakKB);
+    }
+}
+
+void StageProfiler::addCounterImpl(const char *name, qint64 value)
+{
+    sampleMemory();
+    if(sOpenRecordIndices.isEmpty())
+    {
+        return;
+    }
+    QVector< QPair<QString, qint64> > &counters = sRecords[sOpenRecordIndices.back()].counters;
+    for(int i = 0; i < counters.size(); i++)
+    {
+        if(counters[i].first == name)
+        {
+            counters[i].second += value;
+            return;
+        }
+    }
+    counters.push_back(qMakePair(QString(name), value));
+}
+
+void StageProfiler::sampleMemory()
+{
+    if(sOpenRecordIndices.isEmpty())
+    {
+        return;
+    }
+    Record &record = sRecords[sOpenRecordIndices.back()];
+    record.memoryPeakKB = qMax(record.memoryPeakKB, currentMemoryKB());
+}
+
+qint64 StageProfiler::currentMemoryKB()
+{
+#ifdef Q_OS_LINUX
+    //第2个字段为常驻内存页数
+    FILE *statmFile = fopen("/proc/self/statm", "r");
+    if(statmFile == NULL)
+    {
+        return 0;
+    }
+    long totalPageNum = 0, residentPageNum = 0;
+    int readNum = fscanf(statmFile, "%ld %ld", &totalPageNum, &residentPageNum);
+    fclose(statmFile);
+    if(readNum != 2)
+    {
+        return 0;
+    }
+    return (qint64)residentPageNum * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return 0;
+#endif
+}
+
+qint64 StageProfiler::peakMemoryKB()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / 1024; //Mac下单位为字节
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+bool StageProfiler::writeJson(const QString &filename, const QString &runName)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        cerr << "Fail to open file \"" << filename.toStdString() << "\" ." << endl;
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << "{\n";
+    stream << "  \"run\": " << jsonString(runName) << ",\n";
+    stream << "  \"totalMilliseconds\": " << milliseconds(sTimer.isValid() ? sTimer.nsecsElapsed() : 0) << ",\n";
+    stream << "  \"processPeakMemoryKB\": " << peakMemoryKB() << ",\n";
+    stream << "  \"stages\": [";
+    for(int i = 0; i < sRecords.size(); i++)
+    {
+        const Record &record = sRecords.at(i);
+        stream << (i == 0 ? "\n" : ",\n");
+        stream << "    {\"name\": " << jsonString(record.name)
+               << ", \"depth\": " << record.depth
+               << ", \"startMilliseconds\": " << milliseconds(record.startNanoseconds)
+               << ", \"milliseconds\": " << milliseconds(record.elapsedNanoseconds)
+               << ", \"memoryStartKB\": " << record.memoryStartKB
+               << ", \"memoryEndKB\": " << record.memoryEndKB
+               << ", \"memoryPeakKB\": " << record.memoryPeakKB
+               << ", \"counters\": {";
+        for(int j = 0; j < record.counters.size(); j++)
+        {
+            stream << (j == 0 ? "" : ", ") << jsonString(record.counters.at(j).first) << ": " << record.counters.at(j).second;
+        }
+        stream << "}}";
+    }
+    stream << "\n  ]\n}\n";
+    stream.flush();
+    file.close();
+    return true;
+}
+
+bool StageProfiler::writeCsv(const QString &filename, const QString &runName)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        cerr << "Fail to open file \"" << filename.toStdString() << "\" ." << endl;
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << "run,stage,depth,start_ms,milliseconds,memory_start_kb,memory_end_kb,memory_peak_kb,counters\n";
+    for(int i = 0; i < sRecords.size(); i++)
+    {
+        const Record &record = sRecords.at(i);
+        QStringList counters; //计数以"名称=值"的形式用分号分隔，放在同一列中
+        for(int j = 0; j < record.counters.size(); j++)
+        {
+            counters.push_back(record.counters.at(j).first + "=" + QString::number(record.counters.at(j).second));
+        }
+        stream << runName << "," << record.name << "," << record.depth << ","
+               << milliseconds(record.startNanoseconds) << "," << milliseconds(record.elapsedNanoseconds) << ","
+               << record.memoryStartKB << "," << record.memoryEndKB << "," << record.memoryPeakKB << ","
+               << counters.join(";") << "\n";
+    }
+    stream.flush();
+    file.close();
+    return true;
+}
@@ -1,6 +1,10 @@
 #include "ToothSegmentation.h"
 #include "Mesh.h"
+#ifndef TOOTH_SEGMENTATION_HEADLESS
 #include "MainWindow.h"
+#include "DialogProgressReporter.h"
+#include "VisibilityBuffer.h"
+#endif
 
 #include <Eigen/Dense>
 #include <Eigen/Eigenvalues>
@@ -11,21 +15,20 @@
 //#include <igl/invert_diag.h>
 //#include <igl/principal_curvature.h>
 #include "CurvatureComputer.h"
+#include "GeodesicPathFinder.h"
+#include "StageProfiler.h"
 
-#include <QProgressDialog>
 #include <QTime>
-#include <QMessageBox>
 #include <QFile>
+#include <QTextStream>
 #include <QVector>
 
 #include <math.h>
+#include <string.h>
 
 #include <gsl/gsl_spline.h>
 #include <gsl/gsl_statistics_float.h>
 
-#include <pcl/point_cloud.h>
-#include <pcl/kdtree/kdtree_flann.h>
-
 using namespace SW;
 using namespace std;
 using namespace Eigen;
@@ -39,16 +42,12 @@ const string ToothSegmentation::mVPropHandleRegionGrowingVisitedName = "vprop_re
 const string ToothSegmentation::mVPropHandleBoundaryTypeName = "vprop_boundary_type";
 const string ToothSegmentation::mVPropHandleSearchContourSectionVisitedName = "vprop_search_contour_section_visited";
 
+#ifndef TOOTH_SEGMENTATION_HEADLESS
 ToothSegmentation::ToothSegmentation(QWidget *parentWidget, const Mesh &toothMesh)
 {
     mParentWidget = parentWidget;
-    mProgress = new QProgressDialog(mParentWidget);
-    mProgress->setMinimumSize(400, 80);
-    //mProgress->setCancelButtonText(tr("cancel"));
-    mProgress->setCancelButton(0); //不显示“取消”按钮
-    mProgress->setMinimumDuration(0);
-    mProgress->setWindowModality(Qt::WindowModal);
-    mProgress->setAutoClose(false);
+    mProgress = new DialogProgressReporter(mParentWidget);
+    mCurvatureComputer = NULL;
 
     setToothMesh(toothMesh);
 
@@ -58,15 +57,32 @@ ToothSegmentation::ToothSegmentation(QWidget *parentWidget, const Mesh &toothMes
     mCursorType = CURSOR_DEFAULT;
     mCircleCursorRadius = 10;
 }
+#endif
 
-ToothSegmentation::ToothSegmentation()
+ToothSegmentation::ToothSegmentation(ProgressReporter *progress, const Mesh &toothMesh)
 {
+    mProgress = progress;
+    mCurvatureComputer = NULL;
+
+    setToothMesh(toothMesh);
 
+    //mShouldShowExtraMesh = false;
+    mGingivaCuttingPlaneComputed = false;
+    updateProgramSchedule(SCHEDULE_START);
+    mCursorType = CURSOR_DEFAULT;
+    mCircleCursorRadius = 10;
+}
+
+ToothSegmentation::ToothSegmentation()
+{
+    mCurvatureComputer = NULL;
 }
 
 ToothSegmentation::ToothSegmentation(const ToothSegmentation &toothSegmentation)
 {
+#ifndef TOOTH_SEGMENTATION_HEADLESS
     mParentWidget = toothSegmentation.mParentWidget;
+#endif
     mProgress = toothSegmentation.mProgress;
 
     mToothMesh = toothSegmentation.mToothMesh;
@@ -98,6 +114,9 @@ ToothSegmentation::ToothSegmentation(const ToothSegmentation &toothSegmentation)
 
     mToothMeshVertices = toothSegmentation.mToothMeshVertices;
     mToothMeshVertexHandles = toothSegmentation.mToothMeshVertexHandles;
+    mToothMeshVertexIndex = toothSegmentation.mToothMeshVertexIndex;
+    mToothMeshAdjacency = toothSegmentation.mToothMeshAdjacency;
+    mCurvatureComputer = NULL;
 
     mErrorRegionVertexHandles = toothSegmentation.mErrorRegionVertexHandles;
 
@@ -107,6 +126,11 @@ ToothSegmentation::ToothSegmentation(const ToothSegmentation &toothSegmentation)
     mMouseTrack = toothSegmentation.mMouseTrack;
 }
 
+ToothSegmentation::~ToothSegmentation()
+{
+    delete mCurvatureComputer;
+}
+
 ToothSegmentation& ToothSegmentation::operator=(const ToothSegmentation &toothSegmentation)
 {
     *this = ToothSegmentation(toothSegmentation);
@@ -136,6 +160,11 @@ void ToothSegmentation::copyFrom(const ToothSegmentation &toothSegmentation)
 
     mToothMeshVertices = toothSegmentation.mToothMeshVertices;
     mToothMeshVertexHandles = toothSegmentation.mToothMeshVertexHandles;
+    mToothMeshVertexIndex = toothSegmentation.mToothMeshVertexIndex;
+    mToothMeshAdjacency = toothSegmentation.mToothMeshAdjacency;
+    //顶点坐标可能与源对象不同，视图在下次需要时重新建立
+    delete mCurvatureComputer;
+    mCurvatureComputer = NULL;
 
     mErrorRegionVertexHandles = toothSegmentation.mErrorRegionVertexHandles;
 
@@ -147,7 +176,12 @@ void ToothSegmentation::copyFrom(const ToothSegmentation &toothSegmentation)
 
 void ToothSegmentation::setToothMesh(const Mesh &toothMesh)
 {
+    StageProfiler::Scope profilerScope("SetupToothMesh");
+
     mToothMesh = toothMesh;
+    mToothMeshAdjacency.clear();
+    delete mCurvatureComputer;
+    mCurvatureComputer = NULL;
 
     //在Mesh添加自定义属性
     if(!mToothMesh.get_property_handle(mVPropHandleCurvature, mVPropHandleCurvatureName))
@@ -197,6 +231,7 @@ void ToothSegmentation::setToothMesh(const Mesh &toothMesh)
         mToothMeshVertices.push_back(mToothMesh.point(*vertexIter));
         mToothMeshVertexHandles.push_back(*vertexIter);
     }
+    mToothMeshVertexIndex.clear();
 
     //将所有顶点涂白
     mProgress->setWindowTitle(tr("Setup tooth mesh..."));
@@ -218,6 +253,8 @@ void ToothSegmentation::identifyPotentialToothBoundary(bool loadStateFromFile)
 {
     updateProgramSchedule(SCHEDULE_IdentifyPotentialToothBoundary_STARTED);
 
+    StageProfiler::Scope profilerScope("IdentifyPotentialToothBoundary");
+
     mProgress->setWindowTitle(tr("Identify potential tooth boundary..."));
 
     //如果存在之前保存的状态，则读取之
@@ -358,6 +395,7 @@ void ToothSegmentation::identifyPotentialToothBoundary()
 
 void ToothSegmentation::computeCurvature()
 {
+    StageProfiler::Scope profilerScope("ComputeCurvature");
     QTime time;
     time.start();
 
@@ -365,9 +403,11 @@ void ToothSegmentation::computeCurvature()
     QVector<bool> curvatureComputed(mToothMesh.mVertexNum); //记录每个顶点是否被正确计算得到曲率
 
     //计算平均曲率
-    CurvatureComputer curvatureComputer(mToothMesh);
-    curvatureComputer.computeCurvature(mProgress);
-    curvatureComputer.getResult(curvature, curvatureComputed);
+    //保留曲率计算器（及其中的网格视图），之后移动顶点时只需增量更新
+    delete mCurvatureComputer;
+    mCurvatureComputer = new CurvatureComputer(mToothMesh);
+    mCurvatureComputer->computeCurvature(mProgress);
+    mCurvatureComputer->getResult(curvature, curvatureComputed);
 
     cout << "Time elapsed " << time.elapsed() / 1000 << "s. " << "计算平均曲率" << " ended." << endl;
 
@@ -384,6 +424,8 @@ void ToothSegmentation::computeCurvature()
         }
     }
     cout << "Compute curvature finished!\n" << curvatureComputeFailedNum << "/" << mToothMesh.mVertexNum << " vertices failed." << endl;
+    StageProfiler::addCounter("vertices", mToothMesh.mVertexNum);
+    StageProfiler::addCounter("failedVertices", curvatureComputeFailedNum);
 
     //将计算得到的曲率信息写入到Mesh
     vertexIndex = 0;
@@ -401,6 +443,32 @@ void ToothSegmentation::computeCurvature()
     cout << "Time elapsed " << time.elapsed() / 1000 << "s. " << "将曲率信息写入到Mesh" << " ended." << endl;
 }
 
+void ToothSegmentation::updateCurvature(const QVector<Mesh::VertexHandle> &movedVertexHandles)
+{
+    QTime time;
+    time.start();
+
+    QVector<Mesh::VertexHandle> affectedVertexHandles;
+    QVector<float> curvature;
+    QVector<bool> curvatureComputed;
+
+    if(mCurvatureComputer == NULL)
+    {
+        //曲率从状态文件读入或对象由copyFrom恢复时还没有视图，由当前（已移动顶点后的）网格建立
+        mCurvatureComputer = new CurvatureComputer(mToothMesh);
+    }
+    mCurvatureComputer->recomputeCurvature(mToothMesh, movedVertexHandles, affectedVertexHandles, curvature, curvatureComputed);
+
+    //只修改受影响顶点的曲率属性
+    for(int i = 0; i < affectedVertexHandles.size(); i++)
+    {
+        mToothMesh.property(mVPropHandleCurvatureComputed, affectedVertexHandles[i]) = curvatureComputed[i];
+        mToothMesh.property(mVPropHandleCurvature, affectedVertexHandles[i]) = curvature[i];
+    }
+
+    cout << "Time elapsed " << time.elapsed() << "ms. " << "局部更新曲率（" << affectedVertexHandles.size() << "个顶点）" << " ended." << endl;
+}
+
 void ToothSegmentation::curvature2PseudoColor()
 {
     //计算曲率的最大值和最小值
@@ -455,98 +523,88 @@ void ToothSegmentation::computeCurvatureMinAndMax(float &curvatureMin, float &cu
 
 void ToothSegmentation::corrodeBoundary()
 {
-    int neighborNotBoundaryVertexNum; //邻域中非边界点的个数
-    int boundaryVertexIndex = 0;
-    bool *boundaryVertexEliminated = new bool[mBoundaryVertexNum]; //标记对应边界点是否应被剔除
+    StageProfiler::Scope profilerScope("CorrodeBoundary");
+
     mProgress->setLabelText(tr("Corroding boundary..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum(mBoundaryVertexNum * 2);
-    mProgress->setValue(0);
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+
+    const VertexAdjacency &adjacency = toothMeshAdjacency();
+    std::vector<bool> &isToothBoundary = mToothMesh.property(mVPropHandleIsToothBoundary).data_vector();
+    const std::vector<bool> &isToothBoundaryConst = isToothBoundary;
+    int vertexNum = adjacency.vertexNum();
+
+    //先根据当前的边界标记并行计算所有顶点是否应被剔除，再统一写回（与原先两遍遍历的结果相同）
+    QVector<char> boundaryVertexEliminated(vertexNum, 0);
+    char *eliminated = boundaryVertexEliminated.data();
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过非初始边界点（包括未被正确计算出曲率的点，因为在上一步根据曲率阈值确定初始边界的过程中，未被正确计算出曲率的点全部被标记为非初始边界点）
+        if(!isToothBoundaryConst[vertexIndex]) //跳过非初始边界点（包括未被正确计算出曲率的点，因为在上一步根据曲率阈值确定初始边界的过程中，未被正确计算出曲率的点全部被标记为非初始边界点）
         {
             continue;
         }
-        mProgress->setValue(boundaryVertexIndex);
-        //计算邻域中非边界点的个数
-        neighborNotBoundaryVertexNum = 0;
-        for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(*vertexIter); vertexVertexIter.is_valid(); vertexVertexIter++)
+        //邻域中存在非边界点的标记剔除
+        const int *neighbors = adjacency.neighbors(vertexIndex);
+        int neighborNum = adjacency.neighborNum(vertexIndex);
+        for(int i = 0; i < neighborNum; i++)
         {
-            if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
+            if(!isToothBoundaryConst[neighbors[i]])
             {
-                neighborNotBoundaryVertexNum++;
+                eliminated[vertexIndex] = 1;
+                break;
             }
         }
-        //邻域中非边界点的个数大于某值的标记剔除
-        boundaryVertexEliminated[boundaryVertexIndex] = (neighborNotBoundaryVertexNum > 0);
-        boundaryVertexIndex++;
     }
-    boundaryVertexIndex = 0;
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过非初始边界点（包括未被正确计算出曲率的点，因为在上一步根据曲率阈值确定初始边界的过程中，未被正确计算出曲率的点全部被标记为非初始边界点）
-        {
-            continue;
-        }
-        mProgress->setValue(mBoundaryVertexNum + boundaryVertexIndex);
-        //剔除被标记为应删除的边界点
-        if(boundaryVertexEliminated[boundaryVertexIndex])
+        if(eliminated[vertexIndex])
         {
-            mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter) = false;
+            isToothBoundary[vertexIndex] = false;
             mBoundaryVertexNum--;
         }
-        boundaryVertexIndex++;
     }
-    delete []boundaryVertexEliminated;
 }
 
 void ToothSegmentation::dilateBoundary()
 {
-    int neighborBoundaryVertexNum; //邻域中边界点的个数
-    int notBoundaryVertexIndex = 0;
-    bool *boundaryVertexAdded = new bool[mToothMesh.mVertexNum - mBoundaryVertexNum]; //标记对应非边界点是否应被添加为边界点
+    StageProfiler::Scope profilerScope("DilateBoundary");
+
     mProgress->setLabelText(tr("Dilating boundary..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum((mToothMesh.mVertexNum - mBoundaryVertexNum) * 2);
-    mProgress->setValue(0);
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+
+    const VertexAdjacency &adjacency = toothMeshAdjacency();
+    std::vector<bool> &isToothBoundary = mToothMesh.property(mVPropHandleIsToothBoundary).data_vector();
+    const std::vector<bool> &isToothBoundaryConst = isToothBoundary;
+    int vertexNum = adjacency.vertexNum();
+
+    //先根据当前的边界标记并行计算所有顶点是否应被添加，再统一写回（与原先两遍遍历的结果相同）
+    QVector<char> boundaryVertexAdded(vertexNum, 0);
+    char *added = boundaryVertexAdded.data();
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过初始边界点
+        if(isToothBoundaryConst[vertexIndex]) //跳过初始边界点
         {
             continue;
         }
-        mProgress->setValue(notBoundaryVertexIndex);
-        //计算邻域中边界点的个数
-        neighborBoundaryVertexNum = 0;
-        for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(*vertexIter); vertexVertexIter.is_valid(); vertexVertexIter++)
+        //邻域中存在边界点的标记添加
+        const int *neighbors = adjacency.neighbors(vertexIndex);
+        int neighborNum = adjacency.neighborNum(vertexIndex);
+        for(int i = 0; i < neighborNum; i++)
         {
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
+            if(isToothBoundaryConst[neighbors[i]])
             {
-                neighborBoundaryVertexNum++;
+                added[vertexIndex] = 1;
+                break;
             }
         }
-        //邻域中边界点的个数大于某值的标记添加
-        boundaryVertexAdded[notBoundaryVertexIndex] = (neighborBoundaryVertexNum > 0);
-        notBoundaryVertexIndex++;
     }
-    notBoundaryVertexIndex = 0;
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过初始边界点
-        {
-            continue;
-        }
-        mProgress->setValue((mToothMesh.mVertexNum - mBoundaryVertexNum) + notBoundaryVertexIndex);
-        //添加被标记为应添加的非边界点
-        if(boundaryVertexAdded[notBoundaryVertexIndex])
+        if(added[vertexIndex])
         {
-            mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter) = true;
+            isToothBoundary[vertexIndex] = true;
             mBoundaryVertexNum++;
         }
-        notBoundaryVertexIndex++;
     }
-    delete []boundaryVertexAdded;
 }
 
 void ToothSegmentation::paintBoundaryVertices()
@@ -576,6 +634,8 @@ void ToothSegmentation::automaticCuttingOfGingiva(bool loadStateFromFile, bool f
 {
     updateProgramSchedule(SCHEDULE_AutomaticCuttingOfGingiva_STARTED);
 
+    StageProfiler::Scope profilerScope("AutomaticCuttingOfGingiva");
+
     mProgress->setWindowTitle(tr("Automatic cutting Of gingiva..."));
 
     //如果存在之前保存的状态，则读取之
@@ -662,6 +722,8 @@ void ToothSegmentation::automaticCuttingOfGingiva(bool loadStateFromFile, bool f
 
 void ToothSegmentation::automaticCuttingOfGingiva()
 {
+    StageProfiler::Scope profilerScope("ComputeCuttingPlane");
+
     //计算初始边界点质心
     mGingivaCuttingPlanePoint = Mesh::Point(0.0, 0.0, 0.0); //质心点
     float tempCurvature, curvatureSum = 0;
@@ -731,6 +793,8 @@ void ToothSegmentation::boundarySkeletonExtraction(bool loadStateFromFile)
 {
     updateProgramSchedule(SCHEDULE_BoundarySkeletonExtraction_STARTED);
 
+    StageProfiler::Scope profilerScope("BoundarySkeletonExtraction");
+
     mProgress->setWindowTitle(tr("Boundary skeleton extraction..."));
 
     //如果存在之前保存的状态，则读取之
@@ -781,369 +845,464 @@ void ToothSegmentation::boundarySkeletonExtraction(bool loadStateFromFile)
     updateProgramSchedule(SCHEDULE_BoundarySkeletonExtraction_FINISHED);
 }
 
-void ToothSegmentation::boundarySkeletonExtraction()
+namespace
 {
-    //如果之前已经执行过单点宽度边界提取，并且存在属于ERROR_REGION的点，则将这些点还原为边界点
-    if(!mErrorRegionVertexHandles.empty())
-    {
-        for(int i = 0; i < mErrorRegionVertexHandles.size(); i++)
-        {
-            mToothMesh.property(mVPropHandleIsToothBoundary, mErrorRegionVertexHandles.at(i)) = true;
+
+/*
+  边界点分类（单点宽度边界提取中使用），直接在顶点邻接表和OpenMesh属性数组上计算。
+  不位于模型边界的边界点的分类只依赖其1邻域点是否为边界点及非边界邻域点所属的区域，各点互不影响，可以并行计算；
+  删除一批边界点后，只有被删除的点及其1邻域点的分类可能改变，因此只需重新分类这些点（reclassify），
+  各点对分类计数的贡献被记录下来，用以增量更新计数。
+  位于模型边界的边界点的分类依赖其2邻域中其它模型边界点的分类（包括本轮中先被分类的点），
+  因此每次都按顶点索引顺序串行地重新计算（这类点很少）。
+  分类结果和计数与逐点遍历vv_iter的实现完全相同。
+*/
+class BoundaryVertexClassifier
+{
+private:
+    const VertexAdjacency &mAdjacency;
+    const std::vector<bool> &mIsToothBoundary;
+    std::vector<int> &mBoundaryVertexType;
+    const std::vector<int> &mNonBoundaryRegionType;
+    int mTypeNum; //分类计数数组的大小
+
+    QVector<int> mInnerVertexNum; //不位于模型边界的边界点的分类计数
+    QVector<int> mFirstCountedType; //每个顶点计入mInnerVertexNum的类别（-1表示未计入）
+    QVector<int> mSecondCountedType; //孤立点会被计数两次（与原实现一致）
+    QVector<int> mMeshBoundaryVertices; //位于模型边界的顶点（按顶点索引排列）
+    QVector<int> mFrontierStamp; //用于reclassify中对待更新顶点去重
+    int mCurrentStamp;
+
+public:
+    BoundaryVertexClassifier(const VertexAdjacency &adjacency, const std::vector<bool> &isToothBoundary, std::vector<int> &boundaryVertexType, const std::vector<int> &nonBoundaryRegionType, int typeNum)
+        : mAdjacency(adjacency), mIsToothBoundary(isToothBoundary), mBoundaryVertexType(boundaryVertexType), mNonBoundaryRegionType(nonBoundaryRegionType), mTypeNum(typeNum)
+    {
+        int vertexNum = mAdjacency.vertexNum();
+        mInnerVertexNum.fill(0, mTypeNum);
+        mFirstCountedType.fill(-1, vertexNum);
+        mSecondCountedType.fill(-1, vertexNum);
+        mFrontierStamp.fill(0, vertexNum);
+        mCurrentStamp = 0;
+        for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+        {
+            if(mAdjacency.isMeshBoundary(vertexIndex))
+            {
+                mMeshBoundaryVertices.push_back(vertexIndex);
+            }
         }
     }
 
-    mErrorRegionVertexHandles.clear();
-
-    //逐步删除某一类外围点
-    int *classifiedBoundaryVertexNum = new int[mToothNum + DISK_VERTEX_TOOTH];
-    int deleteIterTimes = 0; //迭代次数
-    bool deleteIterationFinished = false;
-
-    //边界点分类
-    classifyBoundaryVertex(classifiedBoundaryVertexNum);
-
-    //测试，保存中间结果
-//    paintAllVerticesWhite();
-//    paintClassifiedBoundaryVertices();
-//    saveToothMesh(mToothMesh.MeshName.toStdString() + ".BoundarySkeletonExtraction.temp.off");
-
-    int diskVertexTypeIndex, diskVertexTypeIndex2;
-    int startCenterAndDiskVertexNum = 0; //迭代前内部点和外围点总数
-    startCenterAndDiskVertexNum += classifiedBoundaryVertexNum[CENTER_VERTEX];
-    for(diskVertexTypeIndex = 0; diskVertexTypeIndex < mToothNum + 1; diskVertexTypeIndex++)
+    //对所有边界点分类，classifiedBoundaryVertexNum返回各类边界点数量
+    void classifyAll(int *classifiedBoundaryVertexNum)
     {
-        startCenterAndDiskVertexNum += classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA + diskVertexTypeIndex];
+        int vertexNum = mAdjacency.vertexNum();
+        int *firstCountedType = mFirstCountedType.data();
+        int *secondCountedType = mSecondCountedType.data();
+#pragma omp parallel for schedule(static)
+        for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+        {
+            classifyInnerVertex(vertexIndex, firstCountedType[vertexIndex], secondCountedType[vertexIndex]);
+        }
+
+        mInnerVertexNum.fill(0, mTypeNum);
+        for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+        {
+            addCount(firstCountedType[vertexIndex], 1);
+            addCount(secondCountedType[vertexIndex], 1);
+        }
+        classifyMeshBoundaryVertices(classifiedBoundaryVertexNum);
     }
-    int centerAndDiskVertexNum;
-    int centerVertexNum;
-    int diskVertexNum;
-    int lastBoundaryVertexNum;
 
-    mProgress->setLabelText(tr("Deleting disk vertices..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum(startCenterAndDiskVertexNum);
-    mProgress->setValue(0);
-    while(true)
+    //边界点changedVertices的边界属性改变后，重新分类受影响的点，classifiedBoundaryVertexNum返回各类边界点数量
+    void reclassify(const QVector<int> &changedVertices, int *classifiedBoundaryVertexNum)
     {
-        lastBoundaryVertexNum = mBoundaryVertexNum;
-        for(diskVertexTypeIndex = 0; diskVertexTypeIndex < mToothNum + 1; diskVertexTypeIndex++)
+        //待更新的点：changedVertices及其1邻域点
+        mCurrentStamp++;
+        QVector<int> frontier;
+        frontier.reserve(changedVertices.size() * 7);
+        for(int i = 0; i < changedVertices.size(); i++)
         {
-            //如果存在此类外围点，则将所有此类外围点删除，然后重新分类
-            if(classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA + diskVertexTypeIndex] != 0)
+            int changedVertex = changedVertices.at(i);
+            addToFrontier(changedVertex, frontier);
+            const int *neighbors = mAdjacency.neighbors(changedVertex);
+            int neighborNum = mAdjacency.neighborNum(changedVertex);
+            for(int j = 0; j < neighborNum; j++)
             {
-                for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
-                {
-                    if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter))
-                    {
-                        continue;
-                    }
-                    if(mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) == (DISK_VERTEX_GINGIVA + diskVertexTypeIndex))
-                    {
-                        mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter) = false;
-                        mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter) = (GINGIVA_REGION + diskVertexTypeIndex);
-                        mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexIter) = true;
-                        mBoundaryVertexNum--;
-                    }
-                }
-
-                classifyBoundaryVertex(classifiedBoundaryVertexNum);
-
-                //测试，保存中间结果
-//                paintAllVerticesWhite();
-//                paintClassifiedBoundaryVertices();
-//                stringstream ss;
-//                ss << deleteIterTimes;
-//                string s = ss.str();
-//                saveToothMesh(mToothMesh.MeshName.toStdString() + ".BoundarySkeletonExtraction.temp" + s + ".off");
-//                QMessageBox::information(mParentWidget, tr("Info"), QString(tr("Temp mesh saved! %1")).arg(deleteIterTimes));
-
-                //计算内部点和外围点数
-                centerVertexNum = classifiedBoundaryVertexNum[CENTER_VERTEX];
-                diskVertexNum = 0;
-                for(diskVertexTypeIndex2 = 0; diskVertexTypeIndex2 < mToothNum + 1; diskVertexTypeIndex2++)
-                {
-                    diskVertexNum += classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA + diskVertexTypeIndex2];
-                }
-                centerAndDiskVertexNum = centerVertexNum + diskVertexNum;
-
-                deleteIterTimes++;
-                mProgress->setLabelText(QString(tr("Deleting disk vertices...\nNo.%1 iteration.\n%2 center vertices left;\n%3 disk vertices left.")).arg(deleteIterTimes).arg(centerVertexNum).arg(diskVertexNum));
-                mProgress->setValue(startCenterAndDiskVertexNum - centerAndDiskVertexNum);
-
-                //判断迭代结束条件
-                if(centerAndDiskVertexNum == 0)
-                {
-                    QMessageBox::information(mParentWidget, tr("Info"), QString(tr("Deleting disk vertices ended!\nTotal %1 iterations.\n%2 center vertices left;\n%3 disk vertices left.")).arg(deleteIterTimes).arg(centerVertexNum).arg(diskVertexNum));
-                    deleteIterationFinished = true;
-                    break;
-                }
-                else if(diskVertexNum == 0) //如果disk vertex已迭代删除完毕，但还残留center vertex，那么将剩下的center vertex设置为非边界点
-                {
-                    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
-                    {
-                        if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过非初始边界点
-                        {
-                            continue;
-                        }
-                        if(mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) != CENTER_VERTEX) //跳过非内部点
-                        {
-                            continue;
-                        }
-                        mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter) = false;
-                        mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter) = ERROR_REGION; //TODO 因为其邻域点均为complex vertex，所以无法判断该点属于哪个非边界区域，若将该点设置为GINGIVA_REGION会影响cutting point的判断，因此暂将该点设置为ERROR_REGION
-                        mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexIter) = true;
-                        mErrorRegionVertexHandles.push_back(*vertexIter);
-                        cout << "残余center point：" << mToothMesh.point(*vertexIter) << endl;
-                        mBoundaryVertexNum--;
-                    }
-                    QMessageBox::information(mParentWidget, tr("Info"), QString(tr("Deleting disk vertices ended!\nTotal %1 iterations.\n%2 center vertices left;\n%3 disk vertices left.\nAll center vertex left have been changed to nonboundary.")).arg(deleteIterTimes).arg(centerVertexNum).arg(diskVertexNum));
-                    deleteIterationFinished = true;
-                    break;
-                }
+                addToFrontier(neighbors[j], frontier);
             }
         }
-        if(deleteIterationFinished)
+
+        int frontierSize = frontier.size();
+        const int *frontierData = frontier.constData();
+        int *firstCountedType = mFirstCountedType.data();
+        int *secondCountedType = mSecondCountedType.data();
+        for(int i = 0; i < frontierSize; i++)
         {
-            break;
+            addCount(firstCountedType[frontierData[i]], -1);
+            addCount(secondCountedType[frontierData[i]], -1);
         }
-        else if(mBoundaryVertexNum == lastBoundaryVertexNum) //如果此轮迭代（所有类型的外围点均迭代1次）没有删除边界点，则退出循环（正常不会出现此情况，此处只是为了防止未知错误发生）
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < frontierSize; i++)
         {
-            cout << "提取边界骨架while循环异常退出！" << endl;
-            break;
+            int vertexIndex = frontierData[i];
+            classifyInnerVertex(vertexIndex, firstCountedType[vertexIndex], secondCountedType[vertexIndex]);
         }
+        for(int i = 0; i < frontierSize; i++)
+        {
+            addCount(firstCountedType[frontierData[i]], 1);
+            addCount(secondCountedType[frontierData[i]], 1);
+        }
+        classifyMeshBoundaryVertices(classifiedBoundaryVertexNum);
     }
 
-    delete[]classifiedBoundaryVertexNum;
-}
-
-void ToothSegmentation::classifyBoundaryVertex(int *classifiedBoundaryVertexNum)
-{
-    for(int i = 0; i < mToothNum + DISK_VERTEX_TOOTH; i++)
+private:
+    inline void addToFrontier(int vertexIndex, QVector<int> &frontier)
     {
-        classifiedBoundaryVertexNum[i] = 0;
+        if(mFrontierStamp[vertexIndex] != mCurrentStamp)
+        {
+            mFrontierStamp[vertexIndex] = mCurrentStamp;
+            frontier.push_back(vertexIndex);
+        }
     }
 
-    int neighborVertexTypeChangeTimes; //某边界点邻域点是否属于边界点这个属性改变（从边界点到非边界点或从非边界点到边界点）的次数
-    int neighborBoundaryVertexNum; //某边界点邻域中边界点数量
-    Mesh::VertexVertexIter tempVvIterBegin; //由于在遍历邻域顶点时需要使用2个迭代器，因此保存初始邻域点
-    int boundaryVertexIndex = 0;
-//    mProgress->setLabelText(tr("Classifying boundary vertices..."));
-//    mProgress->setMinimum(0);
-//    mProgress->setMaximum(mBoundaryVertexNum);
-//    mProgress->setValue(0);
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    inline void addCount(int vertexType, int num)
     {
-        if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过非初始边界点
+        if(vertexType >= 0 && vertexType < mTypeNum)
         {
-            continue;
+            mInnerVertexNum[vertexType] += num;
         }
-//        mProgress->setValue(boundaryVertexIndex);
+    }
 
-        if(mToothMesh.is_boundary(*vertexIter)) //跳过模型边界点（后面单独处理）
+    //对不位于模型边界的边界点分类，firstCountedType和secondCountedType返回该点计入的类别
+    void classifyInnerVertex(int vertexIndex, int &firstCountedType, int &secondCountedType)
+    {
+        firstCountedType = -1;
+        secondCountedType = -1;
+        if(!mIsToothBoundary[vertexIndex] || mAdjacency.isMeshBoundary(vertexIndex)) //跳过非初始边界点和模型边界点（后面单独处理）
         {
-            //mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = DISK_VERTEX_GINGIVA;
-            //classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA]++;
-            boundaryVertexIndex++;
-            continue;
+            return;
         }
 
-        neighborVertexTypeChangeTimes = 0;
-        neighborBoundaryVertexNum = 0;
-        tempVvIterBegin = mToothMesh.vv_iter(*vertexIter);
-        for(Mesh::VertexVertexIter vertexVertexIter = tempVvIterBegin; vertexVertexIter.is_valid(); )
+        //某边界点邻域点是否属于边界点这个属性改变（从边界点到非边界点或从非边界点到边界点）的次数，以及邻域中边界点数量
+        const int *neighbors = mAdjacency.neighbors(vertexIndex);
+        int neighborNum = mAdjacency.neighborNum(vertexIndex);
+        int neighborVertexTypeChangeTimes = 0;
+        int neighborBoundaryVertexNum = 0;
+        for(int i = 0; i < neighborNum; i++)
         {
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter) != mToothMesh.property(mVPropHandleIsToothBoundary, *((++vertexVertexIter).is_valid() ? vertexVertexIter : tempVvIterBegin)))
+            bool isBoundary = mIsToothBoundary[neighbors[i]];
+            if(isBoundary != mIsToothBoundary[neighbors[(i + 1 < neighborNum) ? (i + 1) : 0]])
             {
                 neighborVertexTypeChangeTimes++;
             }
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
+            if(isBoundary)
             {
                 neighborBoundaryVertexNum++;
             }
         }
 
-        //如果为孤立点，则任意判断其为DISK_VERTEX_GINGIVA或DISK_VERTEX_TOOTH（总之要被剔除）（注意：不能直接将其设置为非边界点，因为在删除边界点之后要更新其所属的非边界区域）
+        int &vertexType = mBoundaryVertexType[vertexIndex];
+        //如果为孤立点，则任意判断其为DISK_VERTEX_GINGIVA或DISK_VERTEX_TOOTH（总之要被剔除）
         if(neighborBoundaryVertexNum == 0)
         {
-            mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = DISK_VERTEX_GINGIVA;
-            classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA]++;
-            boundaryVertexIndex++;
-            continue;
+            vertexType = ToothSegmentation::DISK_VERTEX_GINGIVA;
+            firstCountedType = ToothSegmentation::DISK_VERTEX_GINGIVA;
         }
-
-        switch(neighborVertexTypeChangeTimes)
+        else
         {
-        case 0:
-            mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = CENTER_VERTEX;
-            classifiedBoundaryVertexNum[CENTER_VERTEX]++;
-            break;
-        case 2:
-            mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = DISK_VERTEX_GINGIVA;
-            //classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA]++;
-            break;
-        case 4:
-        default:
-            mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = COMPLEX_VERTEX;
-            classifiedBoundaryVertexNum[COMPLEX_VERTEX]++;
-            break;
+            switch(neighborVertexTypeChangeTimes)
+            {
+            case 0:
+                vertexType = ToothSegmentation::CENTER_VERTEX;
+                firstCountedType = ToothSegmentation::CENTER_VERTEX;
+                return;
+            case 2:
+                vertexType = ToothSegmentation::DISK_VERTEX_GINGIVA;
+                break;
+            case 4:
+            default:
+                vertexType = ToothSegmentation::COMPLEX_VERTEX;
+                firstCountedType = ToothSegmentation::COMPLEX_VERTEX;
+                return;
+            }
         }
-        boundaryVertexIndex++;
-    }
 
-    //将外围点分类
-    boundaryVertexIndex = 0;
-    int regionType;
-    int vertexType;
-//    mProgress->setLabelText(tr("Classifying boundary vertices(Disk vertices)..."));
-//    mProgress->setMinimum(0);
-//    mProgress->setMaximum(mBoundaryVertexNum);
-//    mProgress->setValue(0);
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
-    {
-        if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过非初始边界点
-        {
-            continue;
-        }
-        if(mToothMesh.is_boundary(*vertexIter)) //跳过模型边界点（后面单独处理）
-        {
-            continue;
-        }
-//        mProgress->setValue(boundaryVertexIndex);
-        if(mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) != DISK_VERTEX_GINGIVA) //跳过非外围点
-        {
-            boundaryVertexIndex++;
-            continue;
-        }
-        for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(*vertexIter); vertexVertexIter.is_valid(); vertexVertexIter++)
+        //将外围点分类（根据第一个非边界邻域点所属的区域）
+        for(int i = 0; i < neighborNum; i++)
         {
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter)) //跳过初始边界点
+            if(mIsToothBoundary[neighbors[i]]) //跳过初始边界点
             {
                 continue;
             }
-            if(mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexVertexIter) == GINGIVA_REGION)
+            int regionType = mNonBoundaryRegionType[neighbors[i]];
+            if(regionType == ToothSegmentation::GINGIVA_REGION)
             {
-                mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = DISK_VERTEX_GINGIVA;
-                classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA]++;
-                break;
+                vertexType = ToothSegmentation::DISK_VERTEX_GINGIVA;
             }
             else
             {
-                regionType = mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexVertexIter);
-                vertexType = regionType - TOOTH_REGION + DISK_VERTEX_TOOTH;
-                mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = vertexType;
-                classifiedBoundaryVertexNum[vertexType]++;
-                break;
+                vertexType = regionType - ToothSegmentation::TOOTH_REGION + ToothSegmentation::DISK_VERTEX_TOOTH;
             }
+            secondCountedType = vertexType;
+            break;
         }
-        boundaryVertexIndex++;
     }
 
     //模型边界点处理（模型存在空洞时需要此步骤）
-    bool neighborHasNonBoundaryVertex; //某点邻域中是否存在非边界点
-    bool neighborHasDiskVertex; //某点邻域中是否存在disk vertex
-    bool neighborHasComplexVertexNotOnMeshBoundary; //某点邻域中是否存在不位于模型边界的complex vertex
-    bool neighborHasComplexVertexOnMeshBoundary; //某点2邻域中是否存在位于模型边界的complex vertex，TODO 不知道2够不够
-    QVector<Mesh::VertexHandle> neighbor2RingVertexHandles;
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    void classifyMeshBoundaryVertices(int *classifiedBoundaryVertexNum)
     {
-        if(!mToothMesh.is_boundary(*vertexIter)) //跳过非模型边界点
+        for(int i = 0; i < mTypeNum; i++)
         {
-            continue;
+            classifiedBoundaryVertexNum[i] = mInnerVertexNum[i];
         }
-        if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)) //跳过非初始边界点
+
+        for(int meshBoundaryVertexIndex = 0; meshBoundaryVertexIndex < mMeshBoundaryVertices.size(); meshBoundaryVertexIndex++)
         {
-            continue;
-        }
+            int vertexIndex = mMeshBoundaryVertices[meshBoundaryVertexIndex];
+            if(!mIsToothBoundary[vertexIndex]) //跳过非初始边界点
+            {
+                continue;
+            }
 
-        //测试
-//        Mesh::Point testPoint = mToothMesh.point(*vertexIter);
-//        printf("%.6f %.6f %.6f 1.000000 1.000000 0.000000\n", testPoint[0], testPoint[1], testPoint[2]);
+            bool neighborHasNonBoundaryVertex = false; //某点邻域中是否存在非边界点
+            bool neighborHasDiskVertex = false; //某点邻域中是否存在disk vertex
+            bool neighborHasComplexVertexNotOnMeshBoundary = false; //某点邻域中是否存在不位于模型边界的complex vertex
+            bool neighborHasComplexVertexOnMeshBoundary = false; //某点2邻域中是否存在位于模型边界的complex vertex
+            const int *neighbors = mAdjacency.neighbors(vertexIndex);
+            int neighborNum = mAdjacency.neighborNum(vertexIndex);
+            for(int i = 0; i < neighborNum; i++)
+            {
+                int neighbor = neighbors[i];
+                if(!mIsToothBoundary[neighbor])
+                {
+                    neighborHasNonBoundaryVertex = true;
+                    continue;
+                }
+                if(mBoundaryVertexType[neighbor] >= ToothSegmentation::DISK_VERTEX_GINGIVA)
+                {
+                    neighborHasDiskVertex = true;
+                }
+                if(!mAdjacency.isMeshBoundary(neighbor) && mBoundaryVertexType[neighbor] == ToothSegmentation::COMPLEX_VERTEX)
+                {
+                    neighborHasComplexVertexNotOnMeshBoundary = true;
+                }
+            }
+            //2邻域（不含该点本身，重复访问不影响结果）
+            for(int i = 0; i < neighborNum && !neighborHasComplexVertexOnMeshBoundary; i++)
+            {
+                const int *ringNeighbors = mAdjacency.neighbors(neighbors[i]);
+                int ringNeighborNum = mAdjacency.neighborNum(neighbors[i]);
+                for(int j = -1; j < ringNeighborNum; j++)
+                {
+                    int ringVertex = (j < 0) ? neighbors[i] : ringNeighbors[j];
+                    if(ringVertex != vertexIndex
+                            && mIsToothBoundary[ringVertex]
+                            && mAdjacency.isMeshBoundary(ringVertex)
+                            && mBoundaryVertexType[ringVertex] == ToothSegmentation::COMPLEX_VERTEX)
+                    {
+                        neighborHasComplexVertexOnMeshBoundary = true;
+                        break;
+                    }
+                }
+            }
 
-        neighborHasNonBoundaryVertex = false;
-        neighborHasDiskVertex = false;
-        neighborHasComplexVertexNotOnMeshBoundary = false;
-        neighborHasComplexVertexOnMeshBoundary = false;
-        neighbor2RingVertexHandles.clear();
-        for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(*vertexIter); vertexVertexIter.is_valid(); vertexVertexIter++)
-        {
-            if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
+            int vertexType;
+            if(neighborHasComplexVertexNotOnMeshBoundary && !neighborHasComplexVertexOnMeshBoundary)
             {
-                neighborHasNonBoundaryVertex = true;
+                mBoundaryVertexType[vertexIndex] = ToothSegmentation::COMPLEX_VERTEX;
+                classifiedBoundaryVertexNum[ToothSegmentation::COMPLEX_VERTEX]++;
             }
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter)
-                    && mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexVertexIter) >= DISK_VERTEX_GINGIVA)
+            else if(!neighborHasNonBoundaryVertex)
             {
-                neighborHasDiskVertex = true;
+                mBoundaryVertexType[vertexIndex] = ToothSegmentation::CENTER_VERTEX;
+                classifiedBoundaryVertexNum[ToothSegmentation::CENTER_VERTEX]++;
             }
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter)
-                    && !mToothMesh.is_boundary(*vertexVertexIter)
-                    && mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexVertexIter) == COMPLEX_VERTEX)
+            else if(neighborHasDiskVertex) //如果邻域中存在disk vertex，则将该点的BoundaryVertexType设置成与该disk vertex相同
             {
-                neighborHasComplexVertexNotOnMeshBoundary = true;
+                for(int i = 0; i < neighborNum; i++)
+                {
+                    if(!mIsToothBoundary[neighbors[i]] || mBoundaryVertexType[neighbors[i]] < ToothSegmentation::DISK_VERTEX_GINGIVA) //跳过非disk vertex点
+                    {
+                        continue;
+                    }
+                    vertexType = mBoundaryVertexType[neighbors[i]];
+                    mBoundaryVertexType[vertexIndex] = vertexType;
+                    classifiedBoundaryVertexNum[vertexType]++;
+                    break;
+                }
             }
-//            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter)
-//                    && mToothMesh.is_boundary(*vertexVertexIter)
-//                    && mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexVertexIter) == COMPLEX_VERTEX)
-//            {
-//                neighborHasComplexVertexOnMeshBoundary = true;
-//            }
-        }
-        getKRing(*vertexIter, 2, neighbor2RingVertexHandles);
-        neighbor2RingVertexHandles.pop_front();
-        for(int i = 0; i < neighbor2RingVertexHandles.size(); i++)
-        {
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, neighbor2RingVertexHandles.at(i))
-                    && mToothMesh.is_boundary(neighbor2RingVertexHandles.at(i))
-                    && mToothMesh.property(mVPropHandleBoundaryVertexType, neighbor2RingVertexHandles.at(i)) == COMPLEX_VERTEX)
+            else //如果以上条件都不满足，则根据该点相邻的非边界区域设置其BoundaryVertexType
             {
-                neighborHasComplexVertexOnMeshBoundary = true;
+                for(int i = 0; i < neighborNum; i++)
+                {
+                    if(mIsToothBoundary[neighbors[i]])
+                    {
+                        continue;
+                    }
+                    vertexType = mNonBoundaryRegionType[neighbors[i]] - ToothSegmentation::TOOTH_REGION + ToothSegmentation::DISK_VERTEX_TOOTH;
+                    mBoundaryVertexType[vertexIndex] = vertexType;
+                    classifiedBoundaryVertexNum[vertexType]++;
+                    break;
+                }
             }
         }
+    }
+};
+
+}
+
+void ToothSegmentation::boundarySkeletonExtraction()
+{
+    StageProfiler::Scope profilerScope("ExtractSkeleton");
+
+    //如果之前已经执行过单点宽度边界提取，并且存在属于ERROR_REGION的点，则将这些点还原为边界点
+    if(!mErrorRegionVertexHandles.empty())
+    {
+        for(int i = 0; i < mErrorRegionVertexHandles.size(); i++)
+        {
+            mToothMesh.property(mVPropHandleIsToothBoundary, mErrorRegionVertexHandles.at(i)) = true;
+        }
+    }
+
+    mErrorRegionVertexHandles.clear();
+
+    //直接在顶点邻接表和属性数组上操作
+    const VertexAdjacency &adjacency = toothMeshAdjacency();
+    std::vector<bool> &isToothBoundary = mToothMesh.property(mVPropHandleIsToothBoundary).data_vector();
+    std::vector<int> &boundaryVertexType = mToothMesh.property(mVPropHandleBoundaryVertexType).data_vector();
+    std::vector<int> &nonBoundaryRegionType = mToothMesh.property(mVPropHandleNonBoundaryRegionType).data_vector();
+    std::vector<bool> &regionGrowingVisited = mToothMesh.property(mVPropHandleRegionGrowingVisited).data_vector();
+    BoundaryVertexClassifier classifier(adjacency, isToothBoundary, boundaryVertexType, nonBoundaryRegionType, mToothNum + DISK_VERTEX_TOOTH);
+
+    //当前所有边界点（按顶点索引排列，每删除一批边界点后压缩）
+    QVector<int> boundaryVertices;
+    boundaryVertices.reserve(mBoundaryVertexNum);
+    for(int vertexIndex = 0; vertexIndex < adjacency.vertexNum(); vertexIndex++)
+    {
+        if(isToothBoundary[vertexIndex])
+        {
+            boundaryVertices.push_back(vertexIndex);
+        }
+    }
+    QVector<int> deletedVertices; //本次删除的边界点
+
+    //逐步删除某一类外围点
+    int *classifiedBoundaryVertexNum = new int[mToothNum + DISK_VERTEX_TOOTH];
+    int deleteIterTimes = 0; //迭代次数
+    int startBoundaryVertexNum = mBoundaryVertexNum;
+    bool deleteIterationFinished = false;
+
+    //边界点分类
+    classifier.classifyAll(classifiedBoundaryVertexNum);
+
+    int diskVertexTypeIndex, diskVertexTypeIndex2;
+    int startCenterAndDiskVertexNum = 0; //迭代前内部点和外围点总数
+    startCenterAndDiskVertexNum += classifiedBoundaryVertexNum[CENTER_VERTEX];
+    for(diskVertexTypeIndex = 0; diskVertexTypeIndex < mToothNum + 1; diskVertexTypeIndex++)
+    {
+        startCenterAndDiskVertexNum += classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA + diskVertexTypeIndex];
+    }
+    int centerAndDiskVertexNum;
+    int centerVertexNum;
+    int diskVertexNum;
+    int lastBoundaryVertexNum;
+
+    mProgress->setLabelText(tr("Deleting disk vertices..."));
+    mProgress->setMinimum(0);
+    mProgress->setMaximum(startCenterAndDiskVertexNum);
+    mProgress->setValue(0);
+    while(true)
+    {
+        lastBoundaryVertexNum = mBoundaryVertexNum;
+        for(diskVertexTypeIndex = 0; diskVertexTypeIndex < mToothNum + 1; diskVertexTypeIndex++)
+        {
+            //如果存在此类外围点，则将所有此类外围点删除，然后重新分类
+            if(classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA + diskVertexTypeIndex] != 0)
+            {
+                deletedVertices.clear();
+                int remainingBoundaryVertexNum = 0;
+                for(int i = 0; i < boundaryVertices.size(); i++)
+                {
+                    int vertexIndex = boundaryVertices[i];
+                    if(!isToothBoundary[vertexIndex])
+                    {
+                        continue;
+                    }
+                    if(boundaryVertexType[vertexIndex] == (DISK_VERTEX_GINGIVA + diskVertexTypeIndex))
+                    {
+                        isToothBoundary[vertexIndex] = false;
+                        nonBoundaryRegionType[vertexIndex] = (GINGIVA_REGION + diskVertexTypeIndex);
+                        regionGrowingVisited[vertexIndex] = true;
+                        mBoundaryVertexNum--;
+                        deletedVertices.push_back(vertexIndex);
+                    }
+                    else
+                    {
+                        boundaryVertices[remainingBoundaryVertexNum++] = vertexIndex;
+                    }
+                }
+                boundaryVertices.resize(remainingBoundaryVertexNum);
+
+                //只重新分类被删除的点周围的边界点
+                classifier.reclassify(deletedVertices, classifiedBoundaryVertexNum);
+
+                //计算内部点和外围点数
+                centerVertexNum = classifiedBoundaryVertexNum[CENTER_VERTEX];
+                diskVertexNum = 0;
+                for(diskVertexTypeIndex2 = 0; diskVertexTypeIndex2 < mToothNum + 1; diskVertexTypeIndex2++)
+                {
+                    diskVertexNum += classifiedBoundaryVertexNum[DISK_VERTEX_GINGIVA + diskVertexTypeIndex2];
+                }
+                centerAndDiskVertexNum = centerVertexNum + diskVertexNum;
 
-        if(neighborHasComplexVertexNotOnMeshBoundary && !neighborHasComplexVertexOnMeshBoundary)
-        {
-            mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = COMPLEX_VERTEX;
-            classifiedBoundaryVertexNum[COMPLEX_VERTEX]++;
-        }
-        else if(!neighborHasNonBoundaryVertex)
-        {
-            mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = CENTER_VERTEX;
-            classifiedBoundaryVertexNum[CENTER_VERTEX]++;
-        }
-        else if(neighborHasDiskVertex) //如果邻域中存在disk vertex，则将该点的BoundaryVertexType设置成与该disk vertex相同
-        {
-            for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(*vertexIter); vertexVertexIter.is_valid(); vertexVertexIter++)
-            {
-                if(!mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
+                deleteIterTimes++;
+                mProgress->setLabelText(QString(tr("Deleting disk vertices...\nNo.%1 iteration.\n%2 center vertices left;\n%3 disk vertices left.")).arg(deleteIterTimes).arg(centerVertexNum).arg(diskVertexNum));
+                mProgress->setValue(startCenterAndDiskVertexNum - centerAndDiskVertexNum);
+
+                //判断迭代结束条件
+                if(centerAndDiskVertexNum == 0)
                 {
-                    continue;
+                    mProgress->showMessage(tr("Info"), QString(tr("Deleting disk vertices ended!\nTotal %1 iterations.\n%2 center vertices left;\n%3 disk vertices left.")).arg(deleteIterTimes).arg(centerVertexNum).arg(diskVertexNum));
+                    deleteIterationFinished = true;
+                    break;
                 }
-                if(mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexVertexIter) < DISK_VERTEX_GINGIVA) //跳过非disk vertex点
+                else if(diskVertexNum == 0) //如果disk vertex已迭代删除完毕，但还残留center vertex，那么将剩下的center vertex设置为非边界点
                 {
-                    continue;
+                    for(int i = 0; i < boundaryVertices.size(); i++)
+                    {
+                        int vertexIndex = boundaryVertices[i];
+                        if(boundaryVertexType[vertexIndex] != CENTER_VERTEX) //跳过非内部点
+                        {
+                            continue;
+                        }
+                        Mesh::VertexHandle vertexHandle(vertexIndex);
+                        isToothBoundary[vertexIndex] = false;
+                        nonBoundaryRegionType[vertexIndex] = ERROR_REGION; //TODO 因为其邻域点均为complex vertex，所以无法判断该点属于哪个非边界区域，若将该点设置为GINGIVA_REGION会影响cutting point的判断，因此暂将该点设置为ERROR_REGION
+                        regionGrowingVisited[vertexIndex] = true;
+                        mErrorRegionVertexHandles.push_back(vertexHandle);
+                        cout << "残余center point：" << mToothMesh.point(vertexHandle) << endl;
+                        mBoundaryVertexNum--;
+                    }
+                    mProgress->showMessage(tr("Info"), QString(tr("Deleting disk vertices ended!\nTotal %1 iterations.\n%2 center vertices left;\n%3 disk vertices left.\nAll center vertex left have been changed to nonboundary.")).arg(deleteIterTimes).arg(centerVertexNum).arg(diskVertexNum));
+                    deleteIterationFinished = true;
+                    break;
                 }
-                vertexType = mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexVertexIter);
-                mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = vertexType;
-                classifiedBoundaryVertexNum[vertexType]++;
-                break;
             }
         }
-        else //如果以上条件都不满足，则根据该点相邻的非边界区域设置其BoundaryVertexType
+        if(deleteIterationFinished)
         {
-            for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(*vertexIter); vertexVertexIter.is_valid(); vertexVertexIter++)
-            {
-                if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
-                {
-                    continue;
-                }
-                regionType = mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexVertexIter);
-                vertexType = regionType - TOOTH_REGION + DISK_VERTEX_TOOTH;
-                mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = vertexType;
-                classifiedBoundaryVertexNum[vertexType]++;
-                break;
-            }
+            break;
+        }
+        else if(mBoundaryVertexNum == lastBoundaryVertexNum) //如果此轮迭代（所有类型的外围点均迭代1次）没有删除边界点，则退出循环（正常不会出现此情况，此处只是为了防止未知错误发生）
+        {
+            cout << "提取边界骨架while循环异常退出！" << endl;
+            break;
         }
     }
+    StageProfiler::addCounter("iterations", deleteIterTimes);
+    StageProfiler::addCounter("deletedVertices", startBoundaryVertexNum - mBoundaryVertexNum);
+
+    delete[]classifiedBoundaryVertexNum;
 }
 
 void ToothSegmentation::paintClassifiedBoundaryVertices()
@@ -1186,6 +1345,8 @@ void ToothSegmentation::paintClassifiedBoundaryVertices()
 
 void ToothSegmentation::removeBoundaryVertexOnGingiva()
 {
+    StageProfiler::Scope profilerScope("RemoveBoundaryVertexOnGingiva");
+
     float x0, y0, z0; //牙龈分割平面中心点
     x0 = mGingivaCuttingPlanePoint[0];
     y0 = mGingivaCuttingPlanePoint[1];
@@ -1221,33 +1382,33 @@ void ToothSegmentation::removeBoundaryVertexOnGingiva()
 
 int ToothSegmentation::markNonBoundaryRegion()
 {
-    //初始化所有非边界点的NonBoundaryRegionType属性为TOOTH_REGION，RegionGrowingVisited属性为false
-    int vertexIndex = 0;
-    mProgress->setLabelText(tr("Init marking region..."));
+    StageProfiler::Scope profilerScope("MarkNonBoundaryRegion");
+
+    mProgress->setLabelText(tr("Marking region..."));
     mProgress->setMinimum(0);
-    mProgress->setMaximum(mToothMesh.mVertexNum);
+    mProgress->setMaximum(3);
     mProgress->setValue(0);
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
-    {
-        mProgress->setValue(vertexIndex);
-        mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter) = TOOTH_REGION;
-        mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexIter) = false;
-        vertexIndex++;
-    }
+
+    //直接在顶点邻接表和属性数组上操作
+    const VertexAdjacency &adjacency = toothMeshAdjacency();
+    int vertexNum = adjacency.vertexNum();
+    std::vector<bool> &isToothBoundary = mToothMesh.property(mVPropHandleIsToothBoundary).data_vector();
+    std::vector<bool> &regionGrowingVisited = mToothMesh.property(mVPropHandleRegionGrowingVisited).data_vector();
+    std::vector<int> &nonBoundaryRegionType = mToothMesh.property(mVPropHandleNonBoundaryRegionType).data_vector();
+
+    //一次性标记所有非边界点的连通分量及各分量的顶点数（分量以其中索引最小的顶点作为代表）
+    QVector<int> componentRoots, componentSizes;
+    int componentNum = adjacency.labelComponents(isToothBoundary, componentRoots, componentSizes);
+    mProgress->setValue(1);
 
     //如果之前已经执行过单点宽度边界提取，并且存在属于ERROR_REGION的点，则保留这些点的ERROR_REGION属性
-    if(!mErrorRegionVertexHandles.empty())
+    QVector<bool> isErrorRegionVertex(vertexNum, false);
+    for(int i = 0; i < mErrorRegionVertexHandles.size(); i++)
     {
-        for(int i = 0; i < mErrorRegionVertexHandles.size(); i++)
-        {
-            mToothMesh.property(mVPropHandleNonBoundaryRegionType, mErrorRegionVertexHandles.at(i)) = ERROR_REGION;
-        }
+        isErrorRegionVertex[mErrorRegionVertexHandles.at(i).idx()] = true;
     }
 
-    //标记牙龈区域
-    Mesh::Point tempVertex;
-    Mesh::VertexIter vertexIter;
-    int gingivaRegionNum = 0; //记录生长得到的牙龈区域个数，据此判断是否需要对牙龈分割平面进行翻转
+    //判断各非边界点是否位于牙龈分割平面的下方
     float x0, y0, z0; //牙龈分割平面中心点
     x0 = mGingivaCuttingPlanePoint[0];
     y0 = mGingivaCuttingPlanePoint[1];
@@ -1256,127 +1417,137 @@ int ToothSegmentation::markNonBoundaryRegion()
     x1 = mGingivaCuttingPlaneNormal[0];
     y1 = mGingivaCuttingPlaneNormal[1];
     z1 = mGingivaCuttingPlaneNormal[2];
-    for(vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    QVector<bool> isUnderCuttingPlane(vertexNum, false);
+    const int *roots = componentRoots.constData();
+    bool *underCuttingPlane = isUnderCuttingPlane.data();
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter))
+        if(roots[vertexIndex] < 0)
         {
             continue;
         }
-        tempVertex = mToothMesh.point(*vertexIter);
-        if(x1 * (tempVertex[0] - x0) + y1 * (tempVertex[1] - y0) + z1 * (tempVertex[2] - z0) < 0
-                && mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter) != GINGIVA_REGION)
+        Mesh::Point tempVertex = mToothMesh.point(mToothMesh.vertex_handle(vertexIndex));
+        underCuttingPlane[vertexIndex] = (x1 * (tempVertex[0] - x0) + y1 * (tempVertex[1] - y0) + z1 * (tempVertex[2] - z0) < 0);
+    }
+    mProgress->setValue(2);
+
+    //确定各分量的区域类型，尚未确定的分量暂记为ERROR_REGION（只含ERROR_REGION点的分量最终保持此类型）
+    QVector<int> componentRegionTypes(vertexNum, ERROR_REGION);
+
+    //标记牙龈区域：含有位于牙龈分割平面下方的点的分量
+    int gingivaRegionNum = 0; //记录牙龈区域个数，据此判断是否需要对牙龈分割平面进行翻转
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        int root = componentRoots[vertexIndex];
+        if(root >= 0 && isUnderCuttingPlane[vertexIndex] && componentRegionTypes[root] != GINGIVA_REGION)
         {
-            regionGrowing(*vertexIter, GINGIVA_REGION);
+            componentRegionTypes[root] = GINGIVA_REGION;
             gingivaRegionNum++;
         }
     }
 
-    //去除噪声区域+分别标记牙齿区域
+    //去除噪声区域+分别标记牙齿区域（按顶点索引顺序依次编号，与逐个种子点区域生长的编号顺序一致）
     mToothNum = 0; //牙齿标号（数量）
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter)
-                || mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexIter)
-                || mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter) == ERROR_REGION)
+        int root = componentRoots[vertexIndex];
+        if(root < 0 || isErrorRegionVertex[vertexIndex] || componentRegionTypes[root] != ERROR_REGION)
         {
             continue;
         }
-        int regionVertexNum = regionGrowing(*vertexIter, TEMP_REGION);
         //测试，输出该区域顶点数量
-        //cout << "区域顶点数量: " << regionVertexNum << endl;
-        if(regionVertexNum < mToothMesh.mVertexNum * 0.001) //TODO 这个阈值是臆想的，但是达到了效果
+        //cout << "区域顶点数量: " << componentSizes[root] << endl;
+        if(componentSizes[root] < mToothMesh.mVertexNum * 0.001) //TODO 这个阈值是臆想的，但是达到了效果
         {
-            regionGrowing(*vertexIter, FILL_BOUNDARY_REGION); //如果区域小于某个阈值，则将其填充为边界
+            componentRegionTypes[root] = FILL_BOUNDARY_REGION; //如果区域小于某个阈值，则将其填充为边界
         }
         else
         {
-            regionGrowing(*vertexIter, TOOTH_REGION + mToothNum);
+            componentRegionTypes[root] = TOOTH_REGION + mToothNum;
             mToothNum++;
         }
     }
 
-    return gingivaRegionNum;
-}
-
-int ToothSegmentation::regionGrowing(Mesh::VertexHandle seedVertexHandle, int regionType)
-{
-    mToothMesh.property(mVPropHandleRegionGrowingVisited, seedVertexHandle) = true;
-    if(regionType == FILL_BOUNDARY_REGION) //如果regionType为FILL_BOUNDARY_REGION，则将此区域填充为边界
+    //写回各顶点的属性（填充为边界的点NonBoundaryRegionType为TEMP_REGION）
+    const int *regionTypes = componentRegionTypes.constData();
+    const bool *errorRegionVertex = isErrorRegionVertex.constData();
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        mToothMesh.property(mVPropHandleIsToothBoundary, seedVertexHandle) = true;
+        int root = roots[vertexIndex];
+        int regionType = (root < 0) ? (errorRegionVertex[vertexIndex] ? ERROR_REGION : TOOTH_REGION) : regionTypes[root];
+        nonBoundaryRegionType[vertexIndex] = (regionType == FILL_BOUNDARY_REGION) ? TEMP_REGION : regionType;
     }
-    else
+    //std::vector<bool>按位存储，多线程写入不安全，因此串行写入
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
     {
-        mToothMesh.property(mVPropHandleNonBoundaryRegionType, seedVertexHandle) = regionType;
+        int root = componentRoots[vertexIndex];
+        int regionType = (root < 0) ? TOOTH_REGION : componentRegionTypes[root];
+        regionGrowingVisited[vertexIndex] = (root >= 0 && regionType != ERROR_REGION);
+        if(regionType == FILL_BOUNDARY_REGION)
+        {
+            isToothBoundary[vertexIndex] = true;
+        }
     }
+    mProgress->setValue(3);
 
-    int regionVertexNum = 1; //该区域中顶点数量
-    list<Mesh::VertexHandle> seeds; //种子点列表
-    seeds.push_back(seedVertexHandle);
-    while(!seeds.empty())
-    {
-        Mesh::VertexHandle vertexHandle = seeds.front();
-        seeds.pop_front();
-        for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(vertexHandle); vertexVertexIter.is_valid(); vertexVertexIter++)
-        {
-            if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
+    StageProfiler::addCounter("vertices", vertexNum);
+    StageProfiler::addCounter("components", componentNum);
+    StageProfiler::addCounter("gingivaRegions", gingivaRegionNum);
+    StageProfiler::addCounter("toothRegions", mToothNum);
+
+    return gingivaRegionNum;
+}
+
+int ToothSegmentation::regionGrowing(Mesh::VertexHandle seedVertexHandle, int regionType)
+{
+    const VertexAdjacency &adjacency = toothMeshAdjacency();
+    std::vector<bool> &isToothBoundary = mToothMesh.property(mVPropHandleIsToothBoundary).data_vector();
+    std::vector<bool> &regionGrowingVisited = mToothMesh.property(mVPropHandleRegionGrowingVisited).data_vector();
+    std::vector<int> &nonBoundaryRegionType = mToothMesh.property(mVPropHandleNonBoundaryRegionType).data_vector();
+
+    //先找出该区域的所有点（不依赖RegionGrowingVisited属性，所以无需事先还原），再统一修改属性
+    QVector<bool> inRegion(adjacency.vertexNum(), false);
+    QVector<int> regionVertices; //同时作为广度优先搜索的队列
+    inRegion[seedVertexHandle.idx()] = true;
+    regionVertices.push_back(seedVertexHandle.idx());
+    for(int i = 0; i < regionVertices.size(); i++)
+    {
+        int vertexIndex = regionVertices.at(i);
+        const int *neighborVertices = adjacency.neighbors(vertexIndex);
+        int neighborVertexNum = adjacency.neighborNum(vertexIndex);
+        for(int j = 0; j < neighborVertexNum; j++)
+        {
+            int neighborVertexIndex = neighborVertices[j];
+            if(isToothBoundary[neighborVertexIndex] || inRegion[neighborVertexIndex])
             {
                 continue;
             }
-            if(mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexVertexIter))
-            {
-                if(regionType == TEMP_REGION)
-                {
-                    if(mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexVertexIter) == regionType)
-                    {
-                        continue;
-                    }
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexVertexIter) = true;
-            if(regionType == FILL_BOUNDARY_REGION) //如果regionType为FILL_BOUNDARY_REGION，则将此区域填充为边界
-            {
-                mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter) = true;
-            }
-            else
-            {
-                mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexVertexIter) = regionType;
-            }
-            seeds.push_back(*vertexVertexIter);
-            regionVertexNum++;
+            inRegion[neighborVertexIndex] = true;
+            regionVertices.push_back(neighborVertexIndex);
         }
     }
 
-    //如果regionType为TEMP_REGION，则还原该区域所有点的visited为false
-    if(regionType == TEMP_REGION)
+    if(regionType != TEMP_REGION)
     {
-        seeds.clear();
-        seeds.push_back(seedVertexHandle);
-        while(!seeds.empty())
+        for(int i = 0; i < regionVertices.size(); i++)
         {
-            Mesh::VertexHandle vertexHandle = seeds.front();
-            seeds.pop_front();
-            for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(vertexHandle); vertexVertexIter.is_valid(); vertexVertexIter++)
+            int vertexIndex = regionVertices.at(i);
+            regionGrowingVisited[vertexIndex] = true;
+            if(regionType == FILL_BOUNDARY_REGION) //如果regionType为FILL_BOUNDARY_REGION，则将此区域填充为边界
             {
-                if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexVertexIter))
-                {
-                    continue;
-                }
-                if(!mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexVertexIter))
-                {
-                    continue;
-                }
-                mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexVertexIter) = false;
-                seeds.push_back(*vertexVertexIter);
+                isToothBoundary[vertexIndex] = true;
+                nonBoundaryRegionType[vertexIndex] = TEMP_REGION;
+            }
+            else
+            {
+                nonBoundaryRegionType[vertexIndex] = regionType;
             }
         }
     }
 
-    return regionVertexNum;
+    return regionVertices.size();
 }
 
 void ToothSegmentation::paintClassifiedNonBoundaryRegions()
@@ -1440,6 +1611,33 @@ void ToothSegmentation::saveToothMesh(string filename)
     }
 }
 
+bool ToothSegmentation::saveVertexLabels(string filename)
+{
+    QFile labelFile(filename.c_str());
+    if(!labelFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        cout << "Fail to open file \"" << filename << "\" ." << endl;
+        return false;
+    }
+
+    const int boundaryVertexLabel = -3; //边界点的标签（NonBoundaryRegionType中最小值为-2）
+    QTextStream labelStream(&labelFile);
+    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    {
+        if(mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter))
+        {
+            labelStream << boundaryVertexLabel << "\n";
+        }
+        else
+        {
+            labelStream << mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter) << "\n";
+        }
+    }
+    labelStream.flush();
+    labelFile.close();
+    return true;
+}
+
 void ToothSegmentation::saveExtraMesh(string filename)
 {
     OpenMesh::IO::Options options;
@@ -1493,6 +1691,8 @@ void ToothSegmentation::refineToothBoundary(bool loadStateFromFile)
 {
     updateProgramSchedule(SCHEDULE_RefineToothBoundary_STARTED);
 
+    StageProfiler::Scope profilerScope("RefineToothBoundary");
+
     mProgress->setWindowTitle(tr("Refine tooth boundary..."));
 
     refineToothBoundary();
@@ -2032,7 +2232,7 @@ void ToothSegmentation::refineToothBoundary()
 
         //利用K近邻搜索获取mesh上距离插值轮廓最近的顶点集合
         int knn = 4; //对于插值轮廓上的每一个点，在mesh上寻找前k个与其最近的顶点
-        QVector< QVector<int> > searchResult = kNearestNeighbours(knn, contourInterpPoints, mToothMeshVertices);
+        QVector< QVector<int> > searchResult = toothMeshVertexIndex().kNearestNeighbours(knn, contourInterpPoints);
         QVector<Mesh::VertexHandle> interpContour; //插值后映射回mesh的轮廓点集
         for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
         {
@@ -2074,165 +2274,114 @@ void ToothSegmentation::refineToothBoundary()
 
     }*/
 
-    Mesh::Color colorRed(1.0, 0.0, 0.0);
-
-    //分别处理每一个contour section，选取控制点、插值、找近邻区域、细化
-    int contourSectionIndex;
-    mProgress->setLabelText(tr("Interpolating all contour sections..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum(mContourSections.size());
-    mProgress->setValue(0);
-    for(contourSectionIndex = 0; contourSectionIndex < mContourSections.size(); contourSectionIndex++)
-    {
-        mProgress->setValue(contourSectionIndex);
-
-        //选取插值控制点
-        QVector<Mesh::VertexHandle> contourControlVertices; //控制点集
-        int contourVertexNum = mContourSections[contourSectionIndex].size();
-        int controlVertexDistance = 10; //每两个控制点之间的距离
-        if(contourVertexNum < controlVertexDistance * 2 + 1) //如果轮廓太短，则不进行处理
-        {
+    //计算顶点权值：曲率越小（越凹）权值越小，使最短路径沿着牙齿与牙龈、牙齿与牙齿之间的凹陷处走
+    const VertexAdjacency &adjacency = toothMeshAdjacency();
+    int vertexNum = adjacency.vertexNum();
+    float curvatureMin, curvatureMax;
+    computeCurvatureMinAndMax(curvatureMin, curvatureMax);
+    float curvatureThreshold = curvatureMin * 0.02; //与确定初始边界点时的曲率阈值相同，曲率小于此值的顶点权值为1
+    const float curvatureWeight = 4.0; //曲率不小于0的顶点权值为1+curvatureWeight，TODO 此值是臆想的
+    const std::vector<float> &curvature = mToothMesh.property(mVPropHandleCurvature).data_vector();
+    const std::vector<bool> &curvatureComputed = mToothMesh.property(mVPropHandleCurvatureComputed).data_vector();
+    QVector<float> vertexWeights(vertexNum);
+    float *weights = vertexWeights.data();
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        if(curvatureThreshold >= 0) //没有凹陷处，退化为按边长计算的最短路径
+        {
+            weights[vertexIndex] = 1.0;
             continue;
         }
-        for(int contourVertexIndex = 0; contourVertexIndex < contourVertexNum; contourVertexIndex++)
-        {
-            if(contourVertexIndex % controlVertexDistance == 0 || contourVertexIndex == contourVertexNum - 1) //TODO 暂时按照等距离选取控制点
-            {
-                contourControlVertices.push_back(mContourSections[contourSectionIndex].at(contourVertexIndex));
-            }
-        }
-
-        //将插值控制点从Mesh::Point格式转换为GSL库插值函数需要的格式
-        int contourControlVertexNum = contourControlVertices.size();
-        double *t = new double[contourControlVertexNum];
-        double *x = new double[contourControlVertexNum];
-        double *y = new double[contourControlVertexNum];
-        double *z = new double[contourControlVertexNum];
-        Mesh::Point tempContourControlVertex;
-        for(int contourControlVertexIndex = 0; contourControlVertexIndex < contourControlVertexNum; contourControlVertexIndex++)
-        {
-            t[contourControlVertexIndex] = contourControlVertexIndex;
-            tempContourControlVertex = mToothMesh.point(contourControlVertices.at(contourControlVertexIndex));
-            x[contourControlVertexIndex] = tempContourControlVertex[0];
-            y[contourControlVertexIndex] = tempContourControlVertex[1];
-            z[contourControlVertexIndex] = tempContourControlVertex[2];
-        }
-
-        //开始插值
-        gsl_interp_accel *acc = gsl_interp_accel_alloc();
-        gsl_spline *spline = gsl_spline_alloc(gsl_interp_cspline, contourControlVertexNum);
-        int contourInterpPointNum = (contourControlVertexNum - 1) * 100; //TODO 此处插值密度有待自动化计算
-        int contourInterpPointIndex;
-        double *tInterp = new double[contourInterpPointNum];
-        for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
-        {
-            tInterp[contourInterpPointIndex] = contourInterpPointIndex * 0.01;
-        }
-        gsl_spline_init(spline, t, x, contourControlVertexNum);
-        double *xInterp = new double[contourInterpPointNum];
-        for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
-        {
-            xInterp[contourInterpPointIndex] = gsl_spline_eval(spline, tInterp[contourInterpPointIndex], acc);
-        }
-        gsl_spline_init(spline, t, y, contourControlVertexNum);
-        double *yInterp = new double[contourInterpPointNum];
-        for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
-        {
-            yInterp[contourInterpPointIndex] = gsl_spline_eval(spline, tInterp[contourInterpPointIndex], acc);
-        }
-        gsl_spline_init(spline, t, z, contourControlVertexNum);
-        double *zInterp = new double[contourInterpPointNum];
-        for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
-        {
-            zInterp[contourInterpPointIndex] = gsl_spline_eval(spline, tInterp[contourInterpPointIndex], acc);
-        }
-
-        gsl_spline_free(spline);
-        gsl_interp_accel_free(acc);
-        delete[] t;
-        delete[] x;
-        delete[] y;
-        delete[] z;
-        delete[] tInterp;
-
-        //将插值得到的数据转换回Mesh::Point格式
-        QVector<Mesh::Point> contourInterpPoints; //插值得到的轮廓点集
-        Mesh::Point tempContourInterpVertex;
-        for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
+        if(!curvatureComputed[vertexIndex])
         {
-            tempContourInterpVertex[0] = xInterp[contourInterpPointIndex];
-            tempContourInterpVertex[1] = yInterp[contourInterpPointIndex];
-            tempContourInterpVertex[2] = zInterp[contourInterpPointIndex];
-            contourInterpPoints.push_back(tempContourInterpVertex);
+            weights[vertexIndex] = 1.0 + curvatureWeight;
+            continue;
         }
-
-        delete[] xInterp;
-        delete[] yInterp;
-        delete[] zInterp;
-
-        Mesh::VertexHandle tempVertexHandle;
-
-        //测试，将插值得到的轮廓点保存到文件
-        /*mExtraMesh = Mesh();
-        if(!mExtraMesh.has_vertex_colors())
+        float concavity = curvature[vertexIndex] / curvatureThreshold; //曲率小于阈值时大于1，曲率不小于0时不大于0
+        if(concavity > 1.0)
         {
-            mExtraMesh.request_vertex_colors();
+            concavity = 1.0;
         }
-        Mesh::Color colorBlue(0.0, 0.0, 1.0);
-        for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
+        else if(concavity < 0.0)
         {
-            tempVertexHandle = mExtraMesh.add_vertex(contourInterpPoints.at(contourInterpPointIndex));
-            mExtraMesh.set_color(tempVertexHandle, colorBlue);
+            concavity = 0.0;
         }
-        stringstream ss;
-        ss << contourSectionIndex;
-        string contourSectionIndexString = ss.str();
-        saveExtraMesh(mToothMesh.MeshName.toStdString() + ".RefineToothBoundary.Extra.ContourSection" + contourSectionIndexString + "Interp.off");*/
+        weights[vertexIndex] = 1.0 + curvatureWeight * (1.0 - concavity);
+    }
 
-        //利用K近邻搜索获取mesh上距离插值轮廓最近的顶点集合
-        int knn = 2; //对于插值轮廓上的每一个点，在mesh上寻找前k个与其最近的顶点
-        QVector< QVector<int> > searchResult = kNearestNeighbours(knn, contourInterpPoints, mToothMeshVertices);
-        QVector<Mesh::VertexHandle> interpContour; //插值后映射回mesh的轮廓点集
-        for(contourInterpPointIndex = 0; contourInterpPointIndex < contourInterpPointNum; contourInterpPointIndex++)
-        {
-            for(int k = 0; k < knn; k++)
+    //分别处理每一个contour section，选取控制点，用最短路径依次连接相邻控制点（各contour section互不影响，并行处理）
+    mProgress->setLabelText(tr("Connecting all contour sections..."));
+    mProgress->setMinimum(0);
+    mProgress->setMaximum(0);
+    mProgress->setValue(0);
+    int contourSectionNum = mContourSections.size();
+    const int controlVertexDistance = 10; //每两个控制点之间的距离
+    QVector< QVector<int> > refinedContourSections(contourSectionNum); //细化后的轮廓（连续且单点宽度）
+    QVector<int> *refinedContours = refinedContourSections.data();
+    {
+        StageProfiler::Scope profilerScope("ConnectContourSections");
+        qint64 pathSearchNum = 0, searchedVertexNum = 0;
+#pragma omp parallel reduction(+:pathSearchNum, searchedVertexNum)
+        {
+            GeodesicPathFinder pathFinder(mToothMesh, adjacency, vertexWeights); //每个线程复用自己的搜索缓存
+            QVector<int> path;
+#pragma omp for schedule(dynamic, 1)
+            for(int contourSectionIndex = 0; contourSectionIndex < contourSectionNum; contourSectionIndex++)
             {
-                tempVertexHandle = mToothMeshVertexHandles.at(searchResult[contourInterpPointIndex][k]);
-                if(!interpContour.contains(tempVertexHandle))
+                const QVector<Mesh::VertexHandle> &contourSection = mContourSections.at(contourSectionIndex);
+                int contourVertexNum = contourSection.size();
+                if(contourVertexNum < controlVertexDistance * 2 + 1) //如果轮廓太短，则不进行处理
                 {
-                    interpContour.push_back(tempVertexHandle);
+                    continue;
                 }
-            }
-        }
-
-        //将所有近邻顶点设置为边界点
-        int interpContourVertexIndex;
-        for(interpContourVertexIndex = 0; interpContourVertexIndex < interpContour.size(); interpContourVertexIndex++)
-        {
-            mToothMesh.property(mVPropHandleIsToothBoundary, interpContour.at(interpContourVertexIndex)) = true;
-        }
-
-        //测试，将插值后的轮廓点单独保存到文件
-        /*mExtraMesh = Mesh();
-        if(!mExtraMesh.has_vertex_colors())
-        {
-            mExtraMesh.request_vertex_colors();
-        }
-        Mesh::Color colorYellow(1.0, 1.0, 0.0);
-        for(interpContourVertexIndex = 0; interpContourVertexIndex < interpContour.size(); interpContourVertexIndex++)
-        {
-            tempVertexHandle = mExtraMesh.add_vertex(mToothMesh.point(interpContour.at(interpContourVertexIndex)));
-            mExtraMesh.set_color(tempVertexHandle, colorYellow);
+                QVector<int> &refinedContour = refinedContours[contourSectionIndex];
+                refinedContour.push_back(contourSection.front().idx());
+                int previousControlVertexIndex = 0; //上一个控制点在contourSection中的位置
+                for(int contourVertexIndex = 1; contourVertexIndex < contourVertexNum; contourVertexIndex++)
+                {
+                    if(contourVertexIndex % controlVertexDistance != 0 && contourVertexIndex != contourVertexNum - 1) //TODO 暂时按照等距离选取控制点
+                    {
+                        continue;
+                    }
+                    if(pathFinder.findPath(contourSection.at(previousControlVertexIndex).idx(), contourSection.at(contourVertexIndex).idx(), path))
+                    {
+                        for(int i = 1; i < path.size(); i++) //路径起点即上一段的终点，不重复添加
+                        {
+                            refinedContour.push_back(path.at(i));
+                        }
+                    }
+                    else //两个控制点不连通（不应出现），保留原轮廓
+                    {
+                        for(int i = previousControlVertexIndex + 1; i <= contourVertexIndex; i++)
+                        {
+                            refinedContour.push_back(contourSection.at(i).idx());
+                        }
+                    }
+                    previousControlVertexIndex = contourVertexIndex;
+                }
+            }
+            pathSearchNum += pathFinder.searchNum();
+            searchedVertexNum += pathFinder.searchedVertexNum();
         }
-        saveExtraMesh(mToothMesh.MeshName.toStdString() + ".RefineToothBoundary.Extra.ContourSection" + contourSectionIndexString + "InterpNearestRegion.off");*/
+        StageProfiler::addCounter("contourSections", contourSectionNum);
+        StageProfiler::addCounter("pathSearches", pathSearchNum);
+        StageProfiler::addCounter("verticesVisited", searchedVertexNum);
+    }
 
-        //测试，保存显示该轮廓（插值后）的牙齿模型
-        /*paintAllVerticesWhite();
-        for(interpContourVertexIndex = 0; interpContourVertexIndex < interpContour.size(); interpContourVertexIndex++)
+    //将细化后的轮廓点设置为边界点
+    std::vector<bool> &isToothBoundary = mToothMesh.property(mVPropHandleIsToothBoundary).data_vector();
+    for(int contourSectionIndex = 0; contourSectionIndex < contourSectionNum; contourSectionIndex++)
+    {
+        const QVector<int> &refinedContour = refinedContourSections.at(contourSectionIndex);
+        for(int i = 0; i < refinedContour.size(); i++)
         {
-            mToothMesh.set_color(interpContour.at(interpContourVertexIndex), colorRed);
+            if(!isToothBoundary[refinedContour.at(i)])
+            {
+                isToothBoundary[refinedContour.at(i)] = true;
+                mBoundaryVertexNum++;
+            }
         }
-        saveToothMesh(mToothMesh.MeshName.toStdString() + ".RefineToothBoundary.WithContourSection" + contourSectionIndexString + "InterpNearestRegion.off");*/
     }
 
     //测试，保存带平滑轮廓（非单点宽度）的牙齿模型到文件
@@ -2261,6 +2410,7 @@ void ToothSegmentation::refineToothBoundary()
 
     //模板平滑（此步骤通过移动轮廓点的位置，来使得轮廓变得平滑）
     Mesh::Point tempPoint;
+    QVector<Mesh::VertexHandle> movedVertexHandles; //平滑时移动过的顶点，最后据此增量更新曲率
     const int halfWindowSize = 5; //平滑窗口半边长，窗口长度为其2倍加1，TODO 此值要根据模型顶点总数自动调节
     const int windowSize = halfWindowSize * 2 + 1;
     int realHalfWindowSize; //实际的窗口半边长，轮廓两端处窗口放不下时使用
@@ -2269,7 +2419,7 @@ void ToothSegmentation::refineToothBoundary()
     mProgress->setMinimum(0);
     mProgress->setMaximum(mContourSections.size());
     mProgress->setValue(0);
-    for(contourSectionIndex = 0; contourSectionIndex < mContourSections.size(); contourSectionIndex++)
+    for(int contourSectionIndex = 0; contourSectionIndex < mContourSections.size(); contourSectionIndex++)
     {
         mProgress->setValue(contourSectionIndex);
         if(mContourSections[contourSectionIndex].size() < windowSize)
@@ -2296,6 +2446,7 @@ void ToothSegmentation::refineToothBoundary()
             }
             tempPoint /= realWindowSize;
             mToothMesh.set_point(mContourSections[contourSectionIndex].at(contourSectionVertexIndex), tempPoint);
+            movedVertexHandles.push_back(mContourSections[contourSectionIndex].at(contourSectionVertexIndex));
         }
     }
 
@@ -2307,6 +2458,7 @@ void ToothSegmentation::refineToothBoundary()
         mToothMeshVertices.push_back(mToothMesh.point(*vertexIter));
         mToothMeshVertexHandles.push_back(*vertexIter);
     }
+    mToothMeshVertexIndex.clear();
 
     //由于移动了轮廓顶点的位置，其周围可能出现较大的凹凸，因此需要对其周围顶点做平滑
     bool *smoothContourNeighborVisited = (bool*)calloc(mToothMesh.mVertexNum, sizeof(bool));
@@ -2348,8 +2500,11 @@ void ToothSegmentation::refineToothBoundary()
         }
         tempPoint /= neighborVertexHandles.size();
         mToothMesh.set_point(*vertexIter, tempPoint);
+        movedVertexHandles.push_back(*vertexIter);
     }
     free(smoothContourNeighborVisited);
+
+    updateCurvature(movedVertexHandles);
 }
 
 void ToothSegmentation::paintAllVerticesWhite()
@@ -2503,6 +2658,8 @@ void ToothSegmentation::findCuttingPoints(bool loadStateFromFile)
 {
     updateProgramSchedule(SCHEDULE_FindCuttingPoints_STARTED);
 
+    StageProfiler::Scope profilerScope("FindCuttingPoints");
+
     mProgress->setWindowTitle(tr("Finding cutting points..."));
 
     findCuttingPoints();
@@ -2520,7 +2677,139 @@ void ToothSegmentation::findCuttingPoints(bool loadStateFromFile)
     updateProgramSchedule(SCHEDULE_FindCuttingPoints_FINISHED);
 }
 
-bool ToothSegmentation::saveState(string stateSymbol)
+namespace
+{
+
+//状态文件格式（列存储，小端序）：
+//  StateFileHeader：文件头，headerSize记录其实际大小，兼容的新字段只追加在末尾
+//  columnNum个StateFileColumn：列目录
+//  各列数据：每列是一个顶点属性按顶点索引顺序连续存放的数组，起始位置按8字节对齐；压缩时为qCompress后的数据
+//读取时按列id查找，不认识的列直接跳过，文件中没有的列保持原值，因此增删属性后仍能读取其它版本保存的文件；
+//只有不兼容的格式改动才增加STATE_FILE_VERSION
+const char STATE_FILE_MAGIC[8] = {'T', 'S', 'S', 'T', 'A', 'T', 'E', '\0'};
+const quint32 STATE_FILE_VERSION = 1;
+const quint32 STATE_FILE_COMPRESSED = 0x1; //各列数据经过qCompress压缩
+
+enum StateColumnId
+{
+    STATE_COLUMN_CURVATURE = 1,
+    STATE_COLUMN_CURVATURE_COMPUTED = 2,
+    STATE_COLUMN_IS_TOOTH_BOUNDARY = 3,
+    STATE_COLUMN_BOUNDARY_VERTEX_TYPE = 4,
+    STATE_COLUMN_NON_BOUNDARY_REGION_TYPE = 5,
+    STATE_COLUMN_REGION_GROWING_VISITED = 6,
+    STATE_COLUMN_BOUNDARY_TYPE = 7,
+    STATE_COLUMN_COLOR = 8
+};
+
+struct StateFileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 headerSize;
+    quint32 flags;
+    quint32 columnNum;
+    quint64 vertexNum;
+    quint64 meshHash; //网格的哈希值，网格改变后之前保存的状态文件不再有效
+    char stateSymbol[64]; //保存状态时所处的阶段
+    qint32 boundaryVertexNum;
+    qint32 toothNum;
+    float gingivaCuttingPlanePoint[3];
+    float gingivaCuttingPlaneNormal[3];
+};
+
+struct StateFileColumn
+{
+    quint32 id;
+    quint32 elementSize; //每个顶点所占字节数
+    quint64 offset; //列数据在文件中的起始位置
+    quint64 size; //列数据在文件中的字节数
+    quint64 checksum; //列数据（文件中实际存储的字节）的FNV-1a哈希值
+};
+
+quint64 fnv1a64(const void *data, quint64 size, quint64 hash = 14695981039346656037ULL)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for(quint64 i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//网格的哈希值（顶点数、面片数和所有顶点坐标）
+quint64 computeMeshHash(const Mesh &mesh)
+{
+    quint64 vertexNum = mesh.n_vertices();
+    quint64 faceNum = mesh.n_faces();
+    quint64 hash = fnv1a64(&vertexNum, sizeof(vertexNum));
+    hash = fnv1a64(&faceNum, sizeof(faceNum), hash);
+    if(vertexNum > 0)
+    {
+        hash = fnv1a64(mesh.points(), vertexNum * sizeof(Mesh::Point), hash);
+    }
+    return hash;
+}
+
+template <typename T>
+QByteArray propertyToColumn(const std::vector<T> &values)
+{
+    if(values.empty())
+    {
+        return QByteArray();
+    }
+    return QByteArray(reinterpret_cast<const char *>(&values[0]), (int)(values.size() * sizeof(T)));
+}
+
+//std::vector<bool>按位存储，转换成每个顶点1字节
+QByteArray propertyToColumn(const std::vector<bool> &values)
+{
+    QByteArray column((int)values.size(), 0);
+    for(size_t i = 0; i < values.size(); i++)
+    {
+        column[(int)i] = values[i] ? 1 : 0;
+    }
+    return column;
+}
+
+template <typename T>
+void columnToProperty(const char *column, std::vector<T> &values)
+{
+    if(!values.empty())
+    {
+        memcpy(&values[0], column, values.size() * sizeof(T));
+    }
+}
+
+void columnToProperty(const char *column, std::vector<bool> &values)
+{
+    for(size_t i = 0; i < values.size(); i++)
+    {
+        values[i] = (column[i] != 0);
+    }
+}
+
+void appendStateColumn(QVector<StateFileColumn> &columns, QVector<QByteArray> &columnData, quint32 id, quint32 elementSize, const QByteArray &data, bool compress)
+{
+    StateFileColumn column;
+    column.id = id;
+    column.elementSize = elementSize;
+    column.offset = 0;
+    columnData.push_back(compress ? qCompress(data) : data);
+    column.size = columnData.back().size();
+    column.checksum = fnv1a64(columnData.back().constData(), column.size);
+    columns.push_back(column);
+}
+
+quint64 alignTo8(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+}
+
+bool ToothSegmentation::saveState(string stateSymbol, bool compress)
 {
     string stateFileName = mToothMesh.MeshName.toStdString() + "." + stateSymbol + ".State";
     QFile stateFile(stateFileName.c_str());
@@ -2531,46 +2820,68 @@ bool ToothSegmentation::saveState(string stateSymbol)
     }
 
     mProgress->setLabelText(tr("Saving state..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum(mToothMesh.mVertexNum);
-    mProgress->setValue(0);
 
-    stateFile.write((char *)(&mBoundaryVertexNum), sizeof(mBoundaryVertexNum));
-    stateFile.write((char *)(&mGingivaCuttingPlanePoint), sizeof(mGingivaCuttingPlanePoint));
-    stateFile.write((char *)(&mGingivaCuttingPlaneNormal), sizeof(mGingivaCuttingPlaneNormal));
-    stateFile.write((char *)(&mToothNum), sizeof(mToothNum));
+    //每个属性整列取出（OpenMesh属性本身就是按顶点索引连续存放的数组）
+    QVector<StateFileColumn> columns;
+    QVector<QByteArray> columnData;
+    appendStateColumn(columns, columnData, STATE_COLUMN_CURVATURE, sizeof(float), propertyToColumn(mToothMesh.property(mVPropHandleCurvature).data_vector()), compress);
+    appendStateColumn(columns, columnData, STATE_COLUMN_CURVATURE_COMPUTED, 1, propertyToColumn(mToothMesh.property(mVPropHandleCurvatureComputed).data_vector()), compress);
+    appendStateColumn(columns, columnData, STATE_COLUMN_IS_TOOTH_BOUNDARY, 1, propertyToColumn(mToothMesh.property(mVPropHandleIsToothBoundary).data_vector()), compress);
+    appendStateColumn(columns, columnData, STATE_COLUMN_BOUNDARY_VERTEX_TYPE, sizeof(int), propertyToColumn(mToothMesh.property(mVPropHandleBoundaryVertexType).data_vector()), compress);
+    appendStateColumn(columns, columnData, STATE_COLUMN_NON_BOUNDARY_REGION_TYPE, sizeof(int), propertyToColumn(mToothMesh.property(mVPropHandleNonBoundaryRegionType).data_vector()), compress);
+    appendStateColumn(columns, columnData, STATE_COLUMN_REGION_GROWING_VISITED, 1, propertyToColumn(mToothMesh.property(mVPropHandleRegionGrowingVisited).data_vector()), compress);
+    appendStateColumn(columns, columnData, STATE_COLUMN_BOUNDARY_TYPE, sizeof(int), propertyToColumn(mToothMesh.property(mVPropHandleBoundaryType).data_vector()), compress);
+    if(mToothMesh.has_vertex_colors())
+    {
+        appendStateColumn(columns, columnData, STATE_COLUMN_COLOR, sizeof(Mesh::Color), propertyToColumn(mToothMesh.property(mToothMesh.vertex_colors_pph()).data_vector()), compress);
+    }
 
-    float tempCurvature;
-    bool tempCurvatureComputed;
-    bool tempIsToothBoundary;
-    int tempBoundaryVertexType;
-    int tempNonBoundaryRegionType;
-    bool tempRegionGrowingVisited;
-    int tempBoundaryType;
-    Mesh::Color tempColor;
-    int vertexIndex = 0;
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    StateFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STATE_FILE_MAGIC, sizeof(header.magic));
+    header.version = STATE_FILE_VERSION;
+    header.headerSize = sizeof(StateFileHeader);
+    header.flags = compress ? STATE_FILE_COMPRESSED : 0;
+    header.columnNum = columns.size();
+    header.vertexNum = mToothMesh.n_vertices();
+    header.meshHash = computeMeshHash(mToothMesh);
+    strncpy(header.stateSymbol, stateSymbol.c_str(), sizeof(header.stateSymbol) - 1);
+    header.boundaryVertexNum = mBoundaryVertexNum;
+    header.toothNum = mToothNum;
+    for(int i = 0; i < 3; i++)
     {
-        mProgress->setValue(vertexIndex);
-        tempCurvature = mToothMesh.property(mVPropHandleCurvature, *vertexIter);
-        stateFile.write((char *)(&tempCurvature), sizeof(tempCurvature));
-        tempCurvatureComputed = mToothMesh.property(mVPropHandleCurvatureComputed, *vertexIter);
-        stateFile.write((char *)(&tempCurvatureComputed), sizeof(tempCurvatureComputed));
-        tempIsToothBoundary = mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter);
-        stateFile.write((char *)(&tempIsToothBoundary), sizeof(tempIsToothBoundary));
-        tempBoundaryVertexType = mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter);
-        stateFile.write((char *)(&tempBoundaryVertexType), sizeof(tempBoundaryVertexType));
-        tempNonBoundaryRegionType = mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter);
-        stateFile.write((char *)(&tempNonBoundaryRegionType), sizeof(tempNonBoundaryRegionType));
-        tempRegionGrowingVisited = mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexIter);
-        stateFile.write((char *)(&tempRegionGrowingVisited), sizeof(tempRegionGrowingVisited));
-        tempBoundaryType = mToothMesh.property(mVPropHandleBoundaryType, *vertexIter);
-        stateFile.write((char *)(&tempBoundaryType), sizeof(tempBoundaryType));
-        tempColor = mToothMesh.color(*vertexIter);
-        stateFile.write((char *)(&tempColor), sizeof(tempColor));
-        vertexIndex++;
+        header.gingivaCuttingPlanePoint[i] = mGingivaCuttingPlanePoint[i];
+        header.gingivaCuttingPlaneNormal[i] = mGingivaCuttingPlaneNormal[i];
+    }
+
+    quint64 offset = sizeof(StateFileHeader) + columns.size() * sizeof(StateFileColumn);
+    for(int columnIndex = 0; columnIndex < columns.size(); columnIndex++)
+    {
+        offset = alignTo8(offset);
+        columns[columnIndex].offset = offset;
+        offset += columns[columnIndex].size;
+    }
+
+    bool writeSucceeded = (stateFile.write((const char *)(&header), sizeof(header)) == sizeof(header));
+    if(!columns.isEmpty())
+    {
+        qint64 columnsSize = columns.size() * sizeof(StateFileColumn);
+        writeSucceeded = writeSucceeded && (stateFile.write((const char *)columns.constData(), columnsSize) == columnsSize);
+    }
+    const char padding[8] = {0};
+    for(int columnIndex = 0; columnIndex < columns.size() && writeSucceeded; columnIndex++)
+    {
+        qint64 paddingSize = columns[columnIndex].offset - stateFile.pos();
+        writeSucceeded = (stateFile.write(padding, paddingSize) == paddingSize);
+        writeSucceeded = writeSucceeded && (stateFile.write(columnData[columnIndex]) == columnData[columnIndex].size());
     }
     stateFile.close();
+    if(!writeSucceeded)
+    {
+        cout << "Fail to write file \"" << stateFileName << "\" ." << endl;
+        stateFile.remove();
+        return false;
+    }
     return true;
 }
 
@@ -2585,137 +2896,178 @@ bool ToothSegmentation::loadState(string stateSymbol)
     }
 
     mProgress->setLabelText(tr("Loading state..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum(mToothMesh.mVertexNum);
-    mProgress->setValue(0);
-
-    stateFile.read((char *)(&mBoundaryVertexNum), sizeof(mBoundaryVertexNum));
-    stateFile.read((char *)(&mGingivaCuttingPlanePoint), sizeof(mGingivaCuttingPlanePoint));
-    stateFile.read((char *)(&mGingivaCuttingPlaneNormal), sizeof(mGingivaCuttingPlaneNormal));
-    stateFile.read((char *)(&mToothNum), sizeof(mToothNum));
 
-    float tempCurvature;
-    bool tempCurvatureComputed;
-    bool tempIsToothBoundary;
-    int tempBoundaryVertexType;
-    int tempNonBoundaryRegionType;
-    bool tempRegionGrowingVisited;
-    int tempBoundaryType;
-    Mesh::Color tempColor;
-    int vertexIndex = 0;
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    //将整个文件映射到内存，各列数据直接从映射的内存拷贝到OpenMesh属性数组中
+    quint64 fileSize = stateFile.size();
+    const uchar *fileData = (fileSize >= sizeof(StateFileHeader)) ? stateFile.map(0, fileSize) : 0;
+    if(fileData == 0)
     {
-        mProgress->setValue(vertexIndex);
-        stateFile.read((char *)(&tempCurvature), sizeof(tempCurvature));
-        mToothMesh.property(mVPropHandleCurvature, *vertexIter) = tempCurvature;
-        stateFile.read((char *)(&tempCurvatureComputed), sizeof(tempCurvatureComputed));
-        mToothMesh.property(mVPropHandleCurvatureComputed, *vertexIter) = tempCurvatureComputed;
-        stateFile.read((char *)(&tempIsToothBoundary), sizeof(tempIsToothBoundary));
-        mToothMesh.property(mVPropHandleIsToothBoundary, *vertexIter) = tempIsToothBoundary;
-        stateFile.read((char *)(&tempBoundaryVertexType), sizeof(tempBoundaryVertexType));
-        mToothMesh.property(mVPropHandleBoundaryVertexType, *vertexIter) = tempBoundaryVertexType;
-        stateFile.read((char *)(&tempNonBoundaryRegionType), sizeof(tempNonBoundaryRegionType));
-        mToothMesh.property(mVPropHandleNonBoundaryRegionType, *vertexIter) = tempNonBoundaryRegionType;
-        stateFile.read((char *)(&tempRegionGrowingVisited), sizeof(tempRegionGrowingVisited));
-        mToothMesh.property(mVPropHandleRegionGrowingVisited, *vertexIter) = tempRegionGrowingVisited;
-        stateFile.read((char *)(&tempBoundaryType), sizeof(tempBoundaryType));
-        mToothMesh.property(mVPropHandleBoundaryType, *vertexIter) = tempBoundaryType;
-        stateFile.read((char *)(&tempColor), sizeof(tempColor));
-        mToothMesh.set_color(*vertexIter, tempColor);
-        vertexIndex++;
+        cout << "Invalid state file \"" << stateFileName << "\" ." << endl;
+        return false;
     }
-    stateFile.close();
-    return true;
-}
 
-QVector< QVector<int> > ToothSegmentation::kNearestNeighbours(int Knn, const QVector<Mesh::Point> &querys, const QVector<Mesh::Point> &points)
-{
-//    mProgress->setLabelText(tr("Computing k nearest neighbours..."));
-//    mProgress->setMinimum(0);
-//    mProgress->setMaximum(querys.size());
-//    mProgress->setValue(0);
-
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
-
-    // Generate pointcloud data
-    cloud->width = points.size();
-    cloud->height = 1;
-    cloud->points.resize(cloud->width * cloud->height);
-
-    for(size_t i = 0; i < cloud->points.size(); i++)
+    StateFileHeader header;
+    memcpy(&header, fileData, sizeof(header));
+    QString error;
+    if(memcmp(header.magic, STATE_FILE_MAGIC, sizeof(header.magic)) != 0)
     {
-        cloud->points[i].x = points[i][0];
-        cloud->points[i].y = points[i][1];
-        cloud->points[i].z = points[i][2];
+        error = "not a state file (or saved in the old format)";
+    }
+    else if(header.version > STATE_FILE_VERSION)
+    {
+        error = QString("unsupported version %1").arg(header.version);
+    }
+    else if(header.headerSize < sizeof(StateFileHeader) || header.headerSize + (quint64)header.columnNum * sizeof(StateFileColumn) > fileSize)
+    {
+        error = "truncated header";
+    }
+    else if(header.vertexNum != mToothMesh.n_vertices() || header.meshHash != computeMeshHash(mToothMesh))
+    {
+        error = "saved for a different mesh";
+    }
+    else if(strncmp(header.stateSymbol, stateSymbol.c_str(), sizeof(header.stateSymbol)) != 0)
+    {
+        error = "saved at a different stage";
     }
 
-    pcl::KdTreeFLANN<pcl::PointXYZ> kdtree;
-    kdtree.setInputCloud(cloud);
-
-    pcl::PointXYZ query;
-    std::vector<int> pointIdxNKNSearch(Knn);
-    std::vector<float> pointNKNSquaredDistance(Knn);
-
-    QVector<QVector<int> > neighbours(querys.size());
-    for(int i = 0; i < querys.size(); i++)
+    //先校验所有列，全部有效后再写入属性，避免读取失败时留下一半新一半旧的状态
+    QVector<StateFileColumn> columns;
+    QVector<const char *> columnPointers;
+    QVector<QByteArray> uncompressedColumns;
+    uncompressedColumns.reserve(header.columnNum);
+    for(quint32 columnIndex = 0; columnIndex < header.columnNum && error.isEmpty(); columnIndex++)
     {
-//        mProgress->setValue(i);
-        query.x = querys[i][0];
-        query.y = querys[i][1];
-        query.z = querys[i][2];
-        if(kdtree.nearestKSearch(query, Knn, pointIdxNKNSearch, pointNKNSquaredDistance) > 0)
+        StateFileColumn column;
+        memcpy(&column, fileData + header.headerSize + columnIndex * sizeof(StateFileColumn), sizeof(column));
+        if(column.offset > fileSize || column.size > fileSize - column.offset)
+        {
+            error = QString("truncated column %1").arg(column.id);
+        }
+        else if(fnv1a64(fileData + column.offset, column.size) != column.checksum)
         {
-            for(int j=0; j < pointIdxNKNSearch.size(); j++)
+            error = QString("checksum mismatch in column %1").arg(column.id);
+        }
+        else
+        {
+            const char *columnPointer = (const char *)(fileData + column.offset);
+            quint64 columnSize = column.size;
+            if(header.flags & STATE_FILE_COMPRESSED)
+            {
+                uncompressedColumns.push_back(qUncompress((const uchar *)columnPointer, column.size));
+                columnPointer = uncompressedColumns.back().constData();
+                columnSize = uncompressedColumns.back().size();
+            }
+            if(columnSize != header.vertexNum * column.elementSize)
             {
-                neighbours[i].append(pointIdxNKNSearch[j]);
+                error = QString("wrong size of column %1").arg(column.id);
             }
+            columns.push_back(column);
+            columnPointers.push_back(columnPointer);
         }
     }
 
-    return neighbours;
-}
-
-QVector< QVector<int> > ToothSegmentation::kNearestNeighbours(int Knn, const QVector<QPoint> &querys, const QVector<QPoint> &points)
-{
-    pcl::PointCloud<pcl::PointXY>::Ptr cloud(new pcl::PointCloud<pcl::PointXY>);
-
-    // Generate pointcloud data
-    cloud->width = points.size();
-    cloud->height = 1;
-    cloud->points.resize(cloud->width * cloud->height);
-
-    for(size_t i = 0; i < cloud->points.size(); i++)
+    if(!error.isEmpty())
     {
-        cloud->points[i].x = points[i].x();
-        cloud->points[i].y = points[i].y();
+        cout << "Fail to load state file \"" << stateFileName << "\" : " << error.toStdString() << " ." << endl;
+        stateFile.unmap((uchar *)fileData);
+        stateFile.close();
+        return false;
     }
 
-    pcl::KdTreeFLANN<pcl::PointXY> kdtree;
-    kdtree.setInputCloud(cloud);
-
-    pcl::PointXY query;
-    std::vector<int> pointIdxNKNSearch(Knn);
-    std::vector<float> pointNKNSquaredDistance(Knn);
-
-    QVector<QVector<int> > neighbours(querys.size());
-    for(int i = 0; i < querys.size(); i++)
+    for(int columnIndex = 0; columnIndex < columns.size(); columnIndex++)
     {
-        query.x = querys[i].x();
-        query.y = querys[i].y();
-        if(kdtree.nearestKSearch(query, Knn, pointIdxNKNSearch, pointNKNSquaredDistance) > 0)
+        const char *columnPointer = columnPointers[columnIndex];
+        quint32 elementSize = columns[columnIndex].elementSize;
+        switch(columns[columnIndex].id)
         {
-            for(int j=0; j < pointIdxNKNSearch.size(); j++)
+        case STATE_COLUMN_CURVATURE:
+            if(elementSize == sizeof(float))
+            {
+                columnToProperty(columnPointer, mToothMesh.property(mVPropHandleCurvature).data_vector());
+            }
+            break;
+        case STATE_COLUMN_CURVATURE_COMPUTED:
+            if(elementSize == 1)
+            {
+                columnToProperty(columnPointer, mToothMesh.property(mVPropHandleCurvatureComputed).data_vector());
+            }
+            break;
+        case STATE_COLUMN_IS_TOOTH_BOUNDARY:
+            if(elementSize == 1)
+            {
+                columnToProperty(columnPointer, mToothMesh.property(mVPropHandleIsToothBoundary).data_vector());
+            }
+            break;
+        case STATE_COLUMN_BOUNDARY_VERTEX_TYPE:
+            if(elementSize == sizeof(int))
+            {
+                columnToProperty(columnPointer, mToothMesh.property(mVPropHandleBoundaryVertexType).data_vector());
+            }
+            break;
+        case STATE_COLUMN_NON_BOUNDARY_REGION_TYPE:
+            if(elementSize == sizeof(int))
+            {
+                columnToProperty(columnPointer, mToothMesh.property(mVPropHandleNonBoundaryRegionType).data_vector());
+            }
+            break;
+        case STATE_COLUMN_REGION_GROWING_VISITED:
+            if(elementSize == 1)
+            {
+                columnToProperty(columnPointer, mToothMesh.property(mVPropHandleRegionGrowingVisited).data_vector());
+            }
+            break;
+        case STATE_COLUMN_BOUNDARY_TYPE:
+            if(elementSize == sizeof(int))
+            {
+                columnToProperty(columnPointer, mToothMesh.property(mVPropHandleBoundaryType).data_vector());
+            }
+            break;
+        case STATE_COLUMN_COLOR:
+            if(elementSize == sizeof(Mesh::Color) && mToothMesh.has_vertex_colors())
             {
-                neighbours[i].append(pointIdxNKNSearch[j]);
+                columnToProperty(columnPointer, mToothMesh.property(mToothMesh.vertex_colors_pph()).data_vector());
             }
+            break;
+        default: //新版本增加的列，忽略
+            break;
         }
     }
 
-    return neighbours;
+    mBoundaryVertexNum = header.boundaryVertexNum;
+    mToothNum = header.toothNum;
+    for(int i = 0; i < 3; i++)
+    {
+        mGingivaCuttingPlanePoint[i] = header.gingivaCuttingPlanePoint[i];
+        mGingivaCuttingPlaneNormal[i] = header.gingivaCuttingPlaneNormal[i];
+    }
+
+    stateFile.unmap((uchar *)fileData);
+    stateFile.close();
+    return true;
+}
+
+const VertexAdjacency &ToothSegmentation::toothMeshAdjacency()
+{
+    if(mToothMeshAdjacency.isEmpty() || mToothMeshAdjacency.vertexNum() != (int)mToothMesh.n_vertices())
+    {
+        mToothMeshAdjacency.build(mToothMesh);
+    }
+    return mToothMeshAdjacency;
+}
+
+const SpatialIndex &ToothSegmentation::toothMeshVertexIndex()
+{
+    if(mToothMeshVertexIndex.isEmpty() && !mToothMeshVertices.isEmpty())
+    {
+        mToothMeshVertexIndex.build(mToothMeshVertices);
+    }
+    return mToothMeshVertexIndex;
 }
 
 void ToothSegmentation::findCuttingPoints()
 {
+    StageProfiler::Scope profilerScope("ClassifyBoundary");
+
     int boundaryVertexIndex;
 
     //初始化所有顶点的BoundaryType为除CUTTING_POINT之外的任一类型，因为在保证不能存在两个相邻的cutting point时需要知道某顶点是否属于CUTTING_POINT
@@ -2869,6 +3221,8 @@ void ToothSegmentation::paintClassifiedBoundary()
 
 void ToothSegmentation::indexContourSectionsVertices()
 {
+    StageProfiler::Scope profilerScope("IndexContourSections");
+
     if(!mContourSections.empty())
     {
         mContourSections.clear();
@@ -3034,7 +3388,7 @@ void ToothSegmentation::indexContourSectionsVertices()
                         }
                         else //TODO 此情况为出错，如果到达此步需检查
                         {
-                            QMessageBox::information(mParentWidget, tr("Error"), tr("Error finding contour section."));
+                            mProgress->showMessage(tr("Error"), tr("Error finding contour section."));
                             //throw runtime_error("Error finding contour section.");
                             cout << "轮廓段搜索出错点：" << mToothMesh.point(mContourSections[contourSectionIndex].back()) << endl;
                             break;
@@ -3104,7 +3458,7 @@ void ToothSegmentation::indexContourSectionsVertices()
         }
         if(!secondContourVertexAdded)
         {
-            QMessageBox::information(mParentWidget, tr("Error"), tr("Error finding contour section."));
+            mProgress->showMessage(tr("Error"), tr("Error finding contour section."));
             return;
         }
         bool thirdContourVertexAdded = false;
@@ -3128,7 +3482,7 @@ void ToothSegmentation::indexContourSectionsVertices()
         }
         if(!thirdContourVertexAdded)
         {
-            QMessageBox::information(mParentWidget, tr("Error"), tr("Error finding contour section."));
+            mProgress->showMessage(tr("Error"), tr("Error finding contour section."));
             return;
         }
         Mesh::VertexHandle startContourVertex = mContourSections[contourSectionIndex].front(); //目前搜索的轮廓的起始点
@@ -3206,7 +3560,7 @@ void ToothSegmentation::indexContourSectionsVertices()
                 }
                 else //TODO 此情况为出错，如果到达此步需检查
                 {
-                    QMessageBox::information(mParentWidget, tr("Error"), tr("Error finding contour section."));
+                    mProgress->showMessage(tr("Error"), tr("Error finding contour section."));
                     //throw runtime_error("Error finding contour section.");
                     cout << "轮廓段搜索出错点：" << mToothMesh.point(mContourSections[contourSectionIndex].back()) << endl;
                     break;
@@ -3214,42 +3568,20 @@ void ToothSegmentation::indexContourSectionsVertices()
             }
         }
     }
+
+    StageProfiler::addCounter("contourSections", mContourSections.size());
 }
 
 inline void ToothSegmentation::getKRing(const Mesh::VertexHandle &centerVertexHandle, const int k, QVector<Mesh::VertexHandle> &ringVertexHandles)
 {
-    int bufSize = mToothMesh.mVertexNum;
-    ringVertexHandles.reserve(bufSize);
-    bool* visited = (bool*)calloc(bufSize, sizeof(bool));
-
-    QVector< pair<Mesh::VertexHandle, int> > queue; //TODO 换成std::list
-    queue.reserve(bufSize);
-    queue.push_back(pair<Mesh::VertexHandle, int>(centerVertexHandle, 0));
-    visited[centerVertexHandle.idx()] = true;
-
-    Mesh::VertexHandle tempVertexHandle;
-    int tempDistance;
-    while(!queue.empty())
+    //在邻接表上广度优先搜索，访问标记在多次调用间重复使用，不再每次分配并清零整个顶点数组
+    std::vector<int> ringVertices;
+    toothMeshAdjacency().kRing(centerVertexHandle.idx(), k, mKRingSearchBuffer, ringVertices);
+    ringVertexHandles.reserve(ringVertexHandles.size() + ringVertices.size());
+    for(size_t i = 0; i < ringVertices.size(); i++)
     {
-        tempVertexHandle = queue.front().first;
-        tempDistance = queue.front().second;
-        queue.pop_front();
-        ringVertexHandles.push_back(tempVertexHandle);
-        if(tempDistance < k)
-        {
-            for(Mesh::VertexVertexIter vertexVertexIter = mToothMesh.vv_iter(tempVertexHandle); vertexVertexIter.is_valid(); vertexVertexIter++)
-            {
-                if(!visited[vertexVertexIter->idx()])
-                {
-                    queue.push_back(pair<Mesh::VertexHandle, int>(*vertexVertexIter, tempDistance + 1));
-                    visited[vertexVertexIter->idx()] = true;
-                }
-            }
-        }
+        ringVertexHandles.push_back(Mesh::VertexHandle(ringVertices[i]));
     }
-
-    free(visited);
-    visited = NULL;
 }
 
 inline void ToothSegmentation::getKthRing(const Mesh::VertexHandle &centerVertexHandle, const int k, QVector<Mesh::VertexHandle> &ringVertexHandles)
@@ -3457,6 +3789,7 @@ float ToothSegmentation::cot(const Mesh::Point &vector1, const Mesh::Point &vect
     return sqrt(1 - a * a) / a;
 }*/
 
+#ifndef TOOTH_SEGMENTATION_HEADLESS
 inline Mesh::Point ToothSegmentation::screenCoordinate2Model3DCoordinate(const int screenX, const int screenY)
 {
     GLint viewport[4];
@@ -3480,34 +3813,6 @@ inline Mesh::Point ToothSegmentation::screenCoordinate2Model3DCoordinate(const i
     return Mesh::Point((float)posX, (float)posY, (float)posZ);
 }
 
-inline void ToothSegmentation::model3DCoordinate2ScreenCoordinate(const Mesh::Point modelPoint, int &screenX, int &screenY, float &depth)
-{
-    GLint viewport[4];
-    GLdouble modelview[16];
-    GLdouble projection[16];
-    GLdouble winX, winY, winZ; //屏幕二维坐标和深度坐标
-    GLdouble posX, posY, posZ; //模型三维坐标
-    glPushMatrix();
-    GLfloat originalMatrix[16] = { 0 };
-    glGetFloatv(GL_MODELVIEW_MATRIX, originalMatrix);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadMatrixf(originalMatrix);
-    glGetIntegerv(GL_VIEWPORT, viewport);
-    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
-    glGetDoublev(GL_PROJECTION_MATRIX, projection);
-    glPopMatrix();
-    posX = modelPoint[0];
-    posY = modelPoint[1];
-    posZ = modelPoint[2];
-    gluProject(posX, posY, posZ, modelview, projection, viewport, &winX, &winY, &winZ);
-#define round(x) ((int)((x) + 0.5))
-    screenX = round(winX);
-    screenY = viewport[3] - round(winY);
-    glReadPixels(round(winX), round(winY), 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &winZ);
-#undef round(x)
-    depth = (float)winZ;
-}
-
 inline float ToothSegmentation::distance(Mesh::Point point1, Mesh::Point point2)
 {
     float x_ = point1[0] - point2[0];
@@ -3516,62 +3821,37 @@ inline float ToothSegmentation::distance(Mesh::Point point1, Mesh::Point point2)
     return sqrt(x_ * x_ + y_ * y_ + z_ * z_);
 }
 
-inline bool ToothSegmentation::isVisiable(Mesh::VertexHandle vertexHandle)
-{
-    Mesh::Point originalVertex = mToothMesh.point(vertexHandle);
-    int screenX, screenY;
-    float depth;
-    model3DCoordinate2ScreenCoordinate(originalVertex, screenX, screenY, depth);
-    Mesh::Point projectPoint = screenCoordinate2Model3DCoordinate(screenX, screenY);
-    if(distance(projectPoint, originalVertex) > (mToothMesh.BBox.size.x + mToothMesh.BBox.size.y + mToothMesh.BBox.size.z) / 300)
-    {
-        return false;
-    }
-    else
-    {
-        return true;
-    }
-}
-
 QVector<Mesh::VertexHandle> ToothSegmentation::getSelectedVertices()
 {
-    //计算模型上所有顶点在屏幕上的2维坐标
+    //一次读取深度缓冲区，在CPU上计算模型上所有顶点在屏幕上的2维坐标及其是否可见
     mProgress->setLabelText(tr("Computing 2D position of all vertices..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum(mToothMesh.mVertexNum);
-    mProgress->setValue(0);
-    int vertexIndex = 0;
-    Mesh::Point tempVertex;
-    int screenX, screenY;
-    float depth;
+    ((MainWindow*)mParentWidget)->gv->makeCurrent();
+    VisibilityBuffer visibilityBuffer;
+    visibilityBuffer.capture();
     QVector<QPoint> meshVertices2DPos; //所有顶点在屏幕上的2维坐标
-
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
-    {
-        mProgress->setValue(vertexIndex);
-        tempVertex = mToothMesh.point(*vertexIter);
-        model3DCoordinate2ScreenCoordinate(tempVertex, screenX, screenY, depth);
-        meshVertices2DPos.push_back(QPoint(screenX, screenY));
-        vertexIndex++;
-    }
+    QVector<bool> meshVerticesVisible; //所有顶点是否可见
+    float visibleDistance = (mToothMesh.BBox.size.x + mToothMesh.BBox.size.y + mToothMesh.BBox.size.z) / 300;
+    visibilityBuffer.projectAll(mToothMeshVertices, visibleDistance, meshVertices2DPos, meshVerticesVisible);
 
     //对模型上的每个顶点，搜索其屏幕2维坐标到鼠标拖动轨迹的最近距离对应的鼠标位置（用以判断其是否被鼠标选中）
-    QVector< QVector<int> > kNearestSearchResult = kNearestNeighbours(1, meshVertices2DPos, mMouseTrack);
+    //鼠标轨迹每次都不同（点数也很少），在其上建立索引，所有顶点的屏幕坐标作为查询点并行搜索
+    SpatialIndex mouseTrackIndex;
+    mouseTrackIndex.build(mMouseTrack);
+    QVector< QVector<int> > kNearestSearchResult = mouseTrackIndex.kNearestNeighbours(1, meshVertices2DPos);
 
-    //寻找被画笔包围的顶点
+    //寻找被画笔包围的可见顶点
     mProgress->setLabelText(tr("Finding seleted vertices..."));
-    mProgress->setMinimum(0);
-    mProgress->setMaximum(mToothMesh.mVertexNum);
-    mProgress->setValue(0);
-    vertexIndex = 0;
     QVector<Mesh::VertexHandle> selectedVertices;
     QPoint tempVertex2DPoint;
     QPoint tempMousePoint;
     int tempXX, tempYY;
     int rr = mCircleCursorRadius * mCircleCursorRadius;
-    for(Mesh::VertexIter vertexIter = mToothMesh.vertices_begin(); vertexIter != mToothMesh.vertices_end(); vertexIter++)
+    for(int vertexIndex = 0; vertexIndex < mToothMeshVertexHandles.size(); vertexIndex++)
     {
-        mProgress->setValue(vertexIndex);
+        if(!meshVerticesVisible[vertexIndex])
+        {
+            continue;
+        }
         tempVertex2DPoint = meshVertices2DPos.at(vertexIndex);
         tempMousePoint = mMouseTrack.at(kNearestSearchResult[vertexIndex][0]);
 
@@ -3579,18 +3859,7 @@ QVector<Mesh::VertexHandle> ToothSegmentation::getSelectedVertices()
         tempYY = tempVertex2DPoint.y() - tempMousePoint.y();
         if(tempXX * tempXX + tempYY * tempYY < rr)
         {
-            selectedVertices.push_back(*vertexIter);
-        }
-        vertexIndex++;
-    }
-
-    //去掉不可见的点
-    for(int i = 0; i< selectedVertices.size(); i++)
-    {
-        if(!isVisiable(selectedVertices.at(i)))
-        {
-            selectedVertices.remove(i);
-            i--;
+            selectedVertices.push_back(mToothMeshVertexHandles.at(vertexIndex));
         }
     }
 
@@ -3614,7 +3883,7 @@ void ToothSegmentation::mousePressEventShowVertexAttributes(QMouseEvent *e)
     clickedPoint.push_back(screenCoordinate2Model3DCoordinate(x, y));
 
     //判断点击的是模型上的哪个点（通过遍历所有模型上的所有点，找到距离点击位置最近的点，如果该点到点击位置的距离小于某个阈值，则认为该点即为点击位置）
-    QVector< QVector<int> > searchResult = kNearestNeighbours(1, clickedPoint, mToothMeshVertices);
+    QVector< QVector<int> > searchResult = toothMeshVertexIndex().kNearestNeighbours(1, clickedPoint);
     Mesh::Point clickedVertex = mToothMeshVertices.at(searchResult[0][0]);
     Mesh::VertexHandle clickedVertexHandle = mToothMeshVertexHandles.at(searchResult[0][0]);
     if(distance(clickedPoint[0], clickedVertex) > (mToothMesh.BBox.size.x + mToothMesh.BBox.size.y + mToothMesh.BBox.size.z) / 300)
@@ -3792,7 +4061,7 @@ void ToothSegmentation::mousePressEventDeleteErrorToothRegion(QMouseEvent *e)
     clickedPoint.push_back(screenCoordinate2Model3DCoordinate(x, y));
 
     //判断点击的是模型上的哪个点（通过遍历所有模型上的所有点，找到距离点击位置最近的点，如果该点到点击位置的距离小于某个阈值，则认为该点即为点击位置）
-    QVector< QVector<int> > searchResult = kNearestNeighbours(1, clickedPoint, mToothMeshVertices);
+    QVector< QVector<int> > searchResult = toothMeshVertexIndex().kNearestNeighbours(1, clickedPoint);
     Mesh::Point clickedVertex = mToothMeshVertices.at(searchResult[0][0]);
     Mesh::VertexHandle clickedVertexHandle = mToothMeshVertexHandles.at(searchResult[0][0]);
     if(distance(clickedPoint[0], clickedVertex) > (mToothMesh.BBox.size.x + mToothMesh.BBox.size.y + mToothMesh.BBox.size.z) / 300)
@@ -3809,7 +4078,6 @@ void ToothSegmentation::mousePressEventDeleteErrorToothRegion(QMouseEvent *e)
         return;
     }
 
-    regionGrowing(clickedVertexHandle, TEMP_REGION); //将此区域所有点visited属性还原为false
     regionGrowing(clickedVertexHandle, FILL_BOUNDARY_REGION);
 
     paintBoundaryVertices();
@@ -3921,7 +4189,7 @@ void ToothSegmentation::mousePressEventDeleteErrorContourSection(QMouseEvent *e)
     clickedPoint.push_back(screenCoordinate2Model3DCoordinate(x, y));
 
     //判断点击的是模型上的哪个点（通过遍历所有模型上的所有点，找到距离点击位置最近的点，如果该点到点击位置的距离小于某个阈值，则认为该点即为点击位置）
-    QVector< QVector<int> > searchResult = kNearestNeighbours(1, clickedPoint, mToothMeshVertices);
+    QVector< QVector<int> > searchResult = toothMeshVertexIndex().kNearestNeighbours(1, clickedPoint);
     Mesh::Point clickedVertex = mToothMeshVertices.at(searchResult[0][0]);
     Mesh::VertexHandle clickedVertexHandle = mToothMeshVertexHandles.at(searchResult[0][0]);
     if(distance(clickedPoint[0], clickedVertex) > (mToothMesh.BBox.size.x + mToothMesh.BBox.size.y + mToothMesh.BBox.size.z) / 300)
@@ -4168,6 +4436,8 @@ void ToothSegmentation::keyPressEventChangeMouseRadius(QKeyEvent *e)
     }
 }
 
+#endif
+
 ToothSegmentation::ProgramScheduleValues ToothSegmentation::getProgramSchedule()
 {
     return mProgramSchedule;
@@ -0,0 +1,282 @@
+#include "ToothSegmentationHistory.h"
+
+bool ToothSegmentationHistory::VertexState::operator!=(const VertexState &other) const
+{
+    return isToothBoundary != other.isToothBoundary
+            || boundaryVertexType != other.boundaryVertexType
+            || nonBoundaryRegionType != other.nonBoundaryRegionType
+            || regionGrowingVisited != other.regionGrowingVisited
+            || boundaryType != other.boundaryType
+            || searchContourSectionVisited != other.searchContourSectionVisited
+            || color != other.color;
+}
+
+ToothSegmentationHistory::ToothSegmentationHistory(int checkpointInterval, int maxEntryNum)
+{
+    mCheckpointInterval = checkpointInterval;
+    mMaxEntryNum = maxEntryNum;
+    mCurrentIndex = -1;
+}
+
+void ToothSegmentationHistory::reset(const ToothSegmentation &toothSegmentation)
+{
+    clear();
+    mInitialState = QSharedPointer<ToothSegmentation>(new ToothSegmentation(toothSegmentation));
+
+    Entry entry;
+    entry.checkpoint = mInitialState;
+    entry.state = captureSegmentationState(toothSegmentation);
+    mEntries.push_back(entry);
+    mCurrentIndex = 0;
+    captureVertexStates(toothSegmentation, mCurrentVertexStates);
+}
+
+void ToothSegmentationHistory::clear()
+{
+    mEntries.clear();
+    mCurrentIndex = -1;
+    mInitialState.clear();
+    mCurrentVertexStates.clear();
+}
+
+bool ToothSegmentationHistory::isEmpty() const
+{
+    return mEntries.isEmpty();
+}
+
+void ToothSegmentationHistory::saveCheckpoint(const ToothSegmentation &toothSegmentation)
+{
+    if(mEntries.isEmpty())
+    {
+        reset(toothSegmentation);
+        return;
+    }
+    removeRedoEntries();
+
+    Entry entry;
+    entry.checkpoint = QSharedPointer<ToothSegmentation>(new ToothSegmentation(toothSegmentation));
+    entry.state = captureSegmentationState(toothSegmentation);
+    mEntries.push_back(entry);
+    mCurrentIndex++;
+    captureVertexStates(toothSegmentation, mCurrentVertexStates);
+
+    removeOldEntries();
+}
+
+void ToothSegmentationHistory::saveDelta(const ToothSegmentation &toothSegmentation)
+{
+    //顶点数改变或距上一个检查点的增量记录过多时，保存检查点
+    if(mEntries.isEmpty() || (int)toothSegmentation.mToothMesh.n_vertices() != mCurrentVertexStates.size() || deltaNumSinceCheckpoint() + 1 >= mCheckpointInterval)
+    {
+        saveCheckpoint(toothSegmentation);
+        return;
+    }
+    removeRedoEntries();
+
+    Entry entry;
+    VertexChange vertexChange;
+    for(Mesh::ConstVertexIter vertexIter = toothSegmentation.mToothMesh.vertices_begin(); vertexIter != toothSegmentation.mToothMesh.vertices_end(); vertexIter++)
+    {
+        int vertexIndex = vertexIter->idx();
+        VertexState vertexState = captureVertexState(toothSegmentation, *vertexIter);
+        if(vertexState != mCurrentVertexStates[vertexIndex])
+        {
+            vertexChange.vertexIndex = vertexIndex;
+            vertexChange.before = mCurrentVertexStates[vertexIndex];
+            vertexChange.after = vertexState;
+            entry.vertexChanges.push_back(vertexChange);
+            mCurrentVertexStates[vertexIndex] = vertexState;
+        }
+    }
+    entry.state = captureSegmentationState(toothSegmentation);
+    mEntries.push_back(entry);
+    mCurrentIndex++;
+
+    removeOldEntries();
+}
+
+bool ToothSegmentationHistory::undo(ToothSegmentation &toothSegmentation)
+{
+    if(mCurrentIndex <= 0)
+    {
+        return false;
+    }
+    moveTo(toothSegmentation, mCurrentIndex - 1);
+    return true;
+}
+
+bool ToothSegmentationHistory::redo(ToothSegmentation &toothSegmentation)
+{
+    if(mCurrentIndex < 0 || mCurrentIndex >= mEntries.size() - 1)
+    {
+        return false;
+    }
+    moveTo(toothSegmentation, mCurrentIndex + 1);
+    return true;
+}
+
+void ToothSegmentationHistory::restoreInitialState(ToothSegmentation &toothSegmentation) const
+{
+    if(mInitialState)
+    {
+        toothSegmentation.copyFrom(*mInitialState);
+    }
+}
+
+void ToothSegmentationHistory::moveTo(ToothSegmentation &toothSegmentation, int targetIndex)
+{
+    if(targetIndex == mCurrentIndex - 1 && mEntries[mCurrentIndex].checkpoint.isNull())
+    {
+        //撤销一条增量记录：恢复变化顶点操作前的属性
+        const QVector<VertexChange> &vertexChanges = mEntries[mCurrentIndex].vertexChanges;
+        for(int i = 0; i < vertexChanges.size(); i++)
+        {
+            applyVertexState(toothSegmentation, vertexChanges[i].vertexIndex, vertexChanges[i].before);
+        }
+    }
+    else if(targetIndex == mCurrentIndex + 1 && mEntries[targetIndex].checkpoint.isNull())
+    {
+        //重做一条增量记录
+        const QVector<VertexChange> &vertexChanges = mEntries[targetIndex].vertexChanges;
+        for(int i = 0; i < vertexChanges.size(); i++)
+        {
+            applyVertexState(toothSegmentation, vertexChanges[i].vertexIndex, vertexChanges[i].after);
+        }
+    }
+    else
+    {
+        //从目标记录之前最近的检查点恢复，再依次重做其后的增量记录
+        int checkpointIndex = targetIndex;
+        while(mEntries[checkpointIndex].checkpoint.isNull())
+        {
+            checkpointIndex--;
+        }
+        toothSegmentation.copyFrom(*mEntries[checkpointIndex].checkpoint);
+        captureVertexStates(toothSegmentation, mCurrentVertexStates);
+        for(int entryIndex = checkpointIndex + 1; entryIndex <= targetIndex; entryIndex++)
+        {
+            const QVector<VertexChange> &vertexChanges = mEntries[entryIndex].vertexChanges;
+            for(int i = 0; i < vertexChanges.size(); i++)
+            {
+                applyVertexState(toothSegmentation, vertexChanges[i].vertexIndex, vertexChanges[i].after);
+            }
+        }
+    }
+    applySegmentationState(toothSegmentation, mEntries[targetIndex].state);
+    mCurrentIndex = targetIndex;
+}
+
+void ToothSegmentationHistory::removeRedoEntries()
+{
+    while(mEntries.size() > mCurrentIndex + 1)
+    {
+        mEntries.removeLast();
+    }
+}
+
+void ToothSegmentationHistory::removeOldEntries()
+{
+    while(mEntries.size() > mMaxEntryNum)
+    {
+        //丢弃第二个检查点之前的所有记录；若不存在第二个检查点则暂不丢弃（最多再过mCheckpointInterval条记录就会产生新的检查点）
+        int nextCheckpointIndex = 1;
+        while(nextCheckpointIndex < mEntries.size() && mEntries[nextCheckpointIndex].checkpoint.isNull())
+        {
+            nextCheckpointIndex++;
+        }
+        if(nextCheckpointIndex >= mEntries.size() || nextCheckpointIndex > mCurrentIndex)
+        {
+            break;
+        }
+        for(int i = 0; i < nextCheckpointIndex; i++)
+        {
+            mEntries.removeFirst();
+        }
+        mCurrentIndex -= nextCheckpointIndex;
+    }
+}
+
+int ToothSegmentationHistory::deltaNumSinceCheckpoint() const
+{
+    int deltaNum = 0;
+    for(int entryIndex = mCurrentIndex; entryIndex >= 0 && mEntries[entryIndex].checkpoint.isNull(); entryIndex--)
+    {
+        deltaNum++;
+    }
+    return deltaNum;
+}
+
+ToothSegmentationHistory::VertexState ToothSegmentationHistory::captureVertexState(const ToothSegmentation &toothSegmentation, const Mesh::VertexHandle &vertexHandle) const
+{
+    const Mesh &toothMesh = toothSegmentation.mToothMesh;
+    VertexState vertexState;
+    vertexState.isToothBoundary = toothMesh.property(toothSegmentation.mVPropHandleIsToothBoundary, vertexHandle);
+    vertexState.boundaryVertexType = toothMesh.property(toothSegmentation.mVPropHandleBoundaryVertexType, vertexHandle);
+    vertexState.nonBoundaryRegionType = toothMesh.property(toothSegmentation.mVPropHandleNonBoundaryRegionType, vertexHandle);
+    vertexState.regionGrowingVisited = toothMesh.property(toothSegmentation.mVPropHandleRegionGrowingVisited, vertexHandle);
+    vertexState.boundaryType = toothMesh.property(toothSegmentation.mVPropHandleBoundaryType, vertexHandle);
+    vertexState.searchContourSectionVisited = toothMesh.property(toothSegmentation.mVPropHandleSearchContourSectionVisited, vertexHandle);
+    vertexState.color = toothMesh.has_vertex_colors() ? toothMesh.color(vertexHandle) : Mesh::Color(1.0, 1.0, 1.0);
+    return vertexState;
+}
+
+void ToothSegmentationHistory::captureVertexStates(const ToothSegmentation &toothSegmentation, QVector<VertexState> &vertexStates) const
+{
+    vertexStates.resize(toothSegmentation.mToothMesh.n_vertices());
+    for(Mesh::ConstVertexIter vertexIter = toothSegmentation.mToothMesh.vertices_begin(); vertexIter != toothSegmentation.mToothMesh.vertices_end(); vertexIter++)
+    {
+        vertexStates[vertexIter->idx()] = captureVertexState(toothSegmentation, *vertexIter);
+    }
+}
+
+void ToothSegmentationHistory::applyVertexState(ToothSegmentation &toothSegmentation, int vertexIndex, const VertexState &vertexState)
+{
+    Mesh &toothMesh = toothSegmentation.mToothMesh;
+    Mesh::VertexHandle vertexHandle(vertexIndex);
+    toothMesh.property(toothSegmentation.mVPropHandleIsToothBoundary, vertexHandle) = vertexState.isToothBoundary;
+    toothMesh.property(toothSegmentation.mVPropHandleBoundaryVertexType, vertexHandle) = vertexState.boundaryVertexType;
+    toothMesh.property(toothSegmentation.mVPropHandleNonBoundaryRegionType, vertexHandle) = vertexState.nonBoundaryRegionType;
+    toothMesh.property(toothSegmentation.mVPropHandleRegionGrowingVisited, vertexHandle) = vertexState.regionGrowingVisited;
+    toothMesh.property(toothSegmentation.mVPropHandleBoundaryType, vertexHandle) = vertexState.boundaryType;
+    toothMesh.property(toothSegmentation.mVPropHandleSearchContourSectionVisited, vertexHandle) = vertexState.searchContourSectionVisited;
+    if(toothMesh.has_vertex_colors())
+    {
+        toothMesh.set_color(vertexHandle, vertexState.color);
+    }
+    mCurrentVertexStates[vertexIndex] = vertexState;
+}
+
+ToothSegmentationHistory::SegmentationState ToothSegmentationHistory::captureSegmentationState(const ToothSegmentation &toothSegmentation) const
+{
+    SegmentationState state;
+    state.programSchedule = toothSegmentation.mProgramSchedule;
+    state.boundaryVertexNum = toothSegmentation.mBoundaryVertexNum;
+    state.toothNum = toothSegmentation.mToothNum;
+    state.gingivaCuttingPlanePoint = toothSegmentation.mGingivaCuttingPlanePoint;
+    state.gingivaCuttingPlaneNormal = toothSegmentation.mGingivaCuttingPlaneNormal;
+    state.gingivaCuttingPlaneComputed = toothSegmentation.mGingivaCuttingPlaneComputed;
+    state.cuttingPointHandles = toothSegmentation.mCuttingPointHandles;
+    state.jointPointHandles = toothSegmentation.mJointPointHandles;
+    state.contourSections = toothSegmentation.mContourSections;
+    state.errorRegionVertexHandles = toothSegmentation.mErrorRegionVertexHandles;
+    state.cursorType = toothSegmentation.mCursorType;
+    state.circleCursorRadius = toothSegmentation.mCircleCursorRadius;
+    return state;
+}
+
+void ToothSegmentationHistory::applySegmentationState(ToothSegmentation &toothSegmentation, const SegmentationState &state) const
+{
+    toothSegmentation.mProgramSchedule = state.programSchedule;
+    toothSegmentation.mBoundaryVertexNum = state.boundaryVertexNum;
+    toothSegmentation.mToothNum = state.toothNum;
+    toothSegmentation.mGingivaCuttingPlanePoint = state.gingivaCuttingPlanePoint;
+    toothSegmentation.mGingivaCuttingPlaneNormal = state.gingivaCuttingPlaneNormal;
+    toothSegmentation.mGingivaCuttingPlaneComputed = state.gingivaCuttingPlaneComputed;
+    toothSegmentation.mCuttingPointHandles = state.cuttingPointHandles;
+    toothSegmentation.mJointPointHandles = state.jointPointHandles;
+    toothSegmentation.mContourSections = state.contourSections;
+    toothSegmentation.mErrorRegionVertexHandles = state.errorRegionVertexHandles;
+    toothSegmentation.mCursorType = state.cursorType;
+    toothSegmentation.mCircleCursorRadius = state.circleCursorRadius;
+    toothSegmentation.mMouseTrack.clear();
+}
@@ -0,0 +1,220 @@
+#include "VertexAdjacency.h"
+
+namespace
+{
+//查找根节点，同时进行路径减半。
+//合并时总是把索引较大的根挂到索引较小的根下，所以parents[v] <= v，且并发写入parents的值始终是v的某个祖先，多线程同时查找/合并是安全的
+inline int findRoot(int *parents, int vertexIndex)
+{
+    int parent = __atomic_load_n(&parents[vertexIndex], __ATOMIC_RELAXED);
+    while(parent != vertexIndex)
+    {
+        int grandParent = __atomic_load_n(&parents[parent], __ATOMIC_RELAXED);
+        if(grandParent != parent)
+        {
+            __atomic_store_n(&parents[vertexIndex], grandParent, __ATOMIC_RELAXED);
+        }
+        vertexIndex = grandParent;
+        parent = __atomic_load_n(&parents[vertexIndex], __ATOMIC_RELAXED);
+    }
+    return vertexIndex;
+}
+
+inline void unite(int *parents, int vertexIndex1, int vertexIndex2)
+{
+    while(true)
+    {
+        int root1 = findRoot(parents, vertexIndex1);
+        int root2 = findRoot(parents, vertexIndex2);
+        if(root1 == root2)
+        {
+            return;
+        }
+        if(root1 < root2)
+        {
+            int temp = root1;
+            root1 = root2;
+            root2 = temp;
+        }
+        //root1可能已被其它线程挂到别处，此时CAS失败，重新查找
+        if(__sync_bool_compare_and_swap(&parents[root1], root1, root2))
+        {
+            return;
+        }
+        vertexIndex1 = root1;
+        vertexIndex2 = root2;
+    }
+}
+}
+
+VertexAdjacency::VertexAdjacency()
+{
+}
+
+void VertexAdjacency::build(const Mesh &mesh)
+{
+    build(mesh, QVector<int>());
+}
+
+void VertexAdjacency::build(const Mesh &mesh, const QVector<int> &vertexOrder)
+{
+    clear();
+    int vertexNum = mesh.n_vertices();
+    bool reordered = !vertexOrder.isEmpty();
+    assert(!reordered || vertexOrder.size() == vertexNum);
+
+    //网格顶点索引到新编号的映射
+    QVector<int> newIndices;
+    if(reordered)
+    {
+        newIndices.resize(vertexNum);
+        for(int newIndex = 0; newIndex < vertexNum; newIndex++)
+        {
+            newIndices[vertexOrder.at(newIndex)] = newIndex;
+        }
+    }
+
+    //先统计各顶点的邻域点数得到偏移量，再并行填充邻域点
+    mOffsets.resize(vertexNum + 1);
+    mIsMeshBoundary.resize(vertexNum);
+    int *offsets = mOffsets.data();
+    bool *isMeshBoundary = mIsMeshBoundary.data();
+    const int *order = vertexOrder.constData();
+    const int *newIndexData = newIndices.constData();
+
+    offsets[0] = 0;
+#pragma omp parallel for schedule(static)
+    for(int newIndex = 0; newIndex < vertexNum; newIndex++)
+    {
+        Mesh::VertexHandle vertexHandle = mesh.vertex_handle(reordered ? order[newIndex] : newIndex);
+        offsets[newIndex + 1] = mesh.valence(vertexHandle);
+        isMeshBoundary[newIndex] = mesh.is_boundary(vertexHandle);
+    }
+    for(int newIndex = 0; newIndex < vertexNum; newIndex++)
+    {
+        offsets[newIndex + 1] += offsets[newIndex];
+    }
+
+    mNeighbors.resize(offsets[vertexNum]);
+    int *neighborData = mNeighbors.data();
+#pragma omp parallel for schedule(static)
+    for(int newIndex = 0; newIndex < vertexNum; newIndex++)
+    {
+        Mesh::VertexHandle vertexHandle = mesh.vertex_handle(reordered ? order[newIndex] : newIndex);
+        int *neighborVertices = neighborData + offsets[newIndex];
+        for(Mesh::ConstVertexVertexIter vertexVertexIter = mesh.cvv_iter(vertexHandle); vertexVertexIter.is_valid(); vertexVertexIter++)
+        {
+            *neighborVertices++ = reordered ? newIndexData[vertexVertexIter->idx()] : vertexVertexIter->idx();
+        }
+    }
+}
+
+void VertexAdjacency::clear()
+{
+    mOffsets.clear();
+    mNeighbors.clear();
+    mIsMeshBoundary.clear();
+}
+
+bool VertexAdjacency::isEmpty() const
+{
+    return mOffsets.isEmpty();
+}
+
+int VertexAdjacency::vertexNum() const
+{
+    return mOffsets.isEmpty() ? 0 : mOffsets.size() - 1;
+}
+
+void VertexAdjacency::kRing(int vertexIndex, int k, SearchBuffer &buffer, std::vector<int> &ring) const
+{
+    buffer.nextEpoch(vertexNum());
+    unsigned int *visitedStamp = buffer.visitedStamp.data();
+    const unsigned int epoch = buffer.visitedEpoch;
+
+    std::vector< std::pair<int, int> > &queue = buffer.queue;
+    queue.clear();
+    queue.push_back(std::pair<int, int>(vertexIndex, 0));
+    visitedStamp[vertexIndex] = epoch;
+    for(size_t queueHead = 0; queueHead < queue.size(); queueHead++)
+    {
+        int tempVertexIndex = queue[queueHead].first;
+        int tempDistance = queue[queueHead].second;
+        ring.push_back(tempVertexIndex);
+        if(tempDistance < k)
+        {
+            const int *neighborVertices = neighbors(tempVertexIndex);
+            int neighborVertexNum = neighborNum(tempVertexIndex);
+            for(int i = 0; i < neighborVertexNum; i++)
+            {
+                if(visitedStamp[neighborVertices[i]] != epoch)
+                {
+                    queue.push_back(std::pair<int, int>(neighborVertices[i], tempDistance + 1));
+                    visitedStamp[neighborVertices[i]] = epoch;
+                }
+            }
+        }
+    }
+}
+
+int VertexAdjacency::labelComponents(const std::vector<bool> &excludedVertices, QVector<int> &componentRoots, QVector<int> &componentSizes) const
+{
+    int vertexNum = this->vertexNum();
+    QVector<int> parentVector(vertexNum);
+    componentRoots.resize(vertexNum);
+    componentSizes.fill(0, vertexNum);
+    int *parents = parentVector.data();
+    int *roots = componentRoots.data();
+    int *sizes = componentSizes.data();
+
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        parents[vertexIndex] = vertexIndex;
+    }
+
+    //每条边只由索引较大的端点处理一次
+#pragma omp parallel for schedule(dynamic, 1024)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        if(excludedVertices[vertexIndex])
+        {
+            continue;
+        }
+        const int *neighborVertices = neighbors(vertexIndex);
+        int neighborVertexNum = neighborNum(vertexIndex);
+        for(int i = 0; i < neighborVertexNum; i++)
+        {
+            int neighborVertexIndex = neighborVertices[i];
+            if(neighborVertexIndex < vertexIndex && !excludedVertices[neighborVertexIndex])
+            {
+                unite(parents, vertexIndex, neighborVertexIndex);
+            }
+        }
+    }
+
+    //所有合并完成后根节点即为分量中索引最小的顶点，压缩路径并统计分量大小
+    int componentNum = 0;
+#pragma omp parallel for schedule(static) reduction(+:componentNum)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        if(excludedVertices[vertexIndex])
+        {
+            continue;
+        }
+        int root = findRoot(parents, vertexIndex);
+        __atomic_fetch_add(&sizes[root], 1, __ATOMIC_RELAXED);
+        if(root == vertexIndex)
+        {
+            componentNum++;
+        }
+    }
+
+#pragma omp parallel for schedule(static)
+    for(int vertexIndex = 0; vertexIndex < vertexNum; vertexIndex++)
+    {
+        roots[vertexIndex] = excludedVertices[vertexIndex] ? -1 : findRoot(parents, vertexIndex);
+    }
+
+    return componentNum;
+}
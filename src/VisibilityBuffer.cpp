@@ -0,0 +1,112 @@
+#include "VisibilityBuffer.h"
+
+#include <GL/gl.h>
+
+#include <omp.h>
+
+#define round(x) ((int)((x) + 0.5))
+
+VisibilityBuffer::VisibilityBuffer()
+{
+    mModelviewProjection.setIdentity();
+    mModelviewProjectionInverse.setIdentity();
+    mViewport[0] = mViewport[1] = mViewport[2] = mViewport[3] = 0;
+}
+
+void VisibilityBuffer::capture()
+{
+    GLint viewport[4];
+    GLdouble modelview[16];
+    GLdouble projection[16];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+    glGetDoublev(GL_PROJECTION_MATRIX, projection);
+
+    for(int i = 0; i < 4; i++)
+    {
+        mViewport[i] = viewport[i];
+    }
+
+    //OpenGL矩阵按列存储，与Eigen默认存储顺序相同
+    Eigen::Map<Eigen::Matrix4d> modelviewMatrix(modelview);
+    Eigen::Map<Eigen::Matrix4d> projectionMatrix(projection);
+    mModelviewProjection = projectionMatrix * modelviewMatrix;
+    mModelviewProjectionInverse = mModelviewProjection.inverse();
+
+    //一次读取整个视口的深度
+    mDepth.resize(mViewport[2] * mViewport[3]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(mViewport[0], mViewport[1], mViewport[2], mViewport[3], GL_DEPTH_COMPONENT, GL_FLOAT, mDepth.data());
+}
+
+inline bool VisibilityBuffer::depthAt(int winX, int winY, float &depth) const
+{
+    int x = winX - mViewport[0];
+    int y = winY - mViewport[1];
+    if(x < 0 || x >= mViewport[2] || y < 0 || y >= mViewport[3])
+    {
+        return false;
+    }
+    depth = mDepth[y * mViewport[2] + x];
+    return true;
+}
+
+bool VisibilityBuffer::project(const Mesh::Point &modelPoint, int &screenX, int &screenY, float &depth) const
+{
+    //同gluProject
+    Eigen::Vector4d clip = mModelviewProjection * Eigen::Vector4d(modelPoint[0], modelPoint[1], modelPoint[2], 1.0);
+    if(clip(3) == 0.0)
+    {
+        //投影到无穷远处，视为在视口之外（输出也设为视口外的值，调用者可直接使用）
+        screenX = mViewport[0] - 1;
+        screenY = -1;
+        depth = 1.0;
+        return false;
+    }
+    double winX = mViewport[0] + mViewport[2] * (clip(0) / clip(3) + 1.0) / 2.0;
+    double winY = mViewport[1] + mViewport[3] * (clip(1) / clip(3) + 1.0) / 2.0;
+    depth = (clip(2) / clip(3) + 1.0) / 2.0;
+
+    screenX = round(winX);
+    screenY = mViewport[3] - round(winY);
+    return (screenX >= mViewport[0] && screenX < mViewport[0] + mViewport[2] && round(winY) >= mViewport[1] && round(winY) < mViewport[1] + mViewport[3]);
+}
+
+Mesh::Point VisibilityBuffer::unproject(int screenX, int screenY) const
+{
+    //同gluUnProject
+    int winX = screenX;
+    int winY = mViewport[3] - screenY;
+    float winZ = 1.0;
+    depthAt(winX, winY, winZ);
+
+    Eigen::Vector4d ndc(2.0 * (winX - mViewport[0]) / mViewport[2] - 1.0,
+                        2.0 * (winY - mViewport[1]) / mViewport[3] - 1.0,
+                        2.0 * winZ - 1.0,
+                        1.0);
+    Eigen::Vector4d model = mModelviewProjectionInverse * ndc;
+    return Mesh::Point(model(0) / model(3), model(1) / model(3), model(2) / model(3));
+}
+
+void VisibilityBuffer::projectAll(const QVector<Mesh::Point> &modelPoints, float visibleDistance, QVector<QPoint> &screenPositions, QVector<bool> &visible) const
+{
+    int pointNum = modelPoints.size();
+    screenPositions.resize(pointNum);
+    visible.resize(pointNum);
+
+    const Mesh::Point *points = modelPoints.constData();
+    QPoint *positions = screenPositions.data();
+    bool *visibleData = visible.data();
+
+#pragma omp parallel for schedule(static)
+    for(int i = 0; i < pointNum; i++)
+    {
+        int screenX, screenY;
+        float depth;
+        bool insideViewport = project(points[i], screenX, screenY, depth);
+        positions[i] = QPoint(screenX, screenY);
+        visibleData[i] = insideViewport && ((unproject(screenX, screenY) - points[i]).norm() <= visibleDistance);
+    }
+}
+
+#undef round